@@ -26,6 +26,7 @@
 #include <realm/util/features.h>
 #include <realm/util/terminate.hpp>
 #include <realm/util/assert.hpp>
+#include <realm/util/safe_int_ops.hpp>
 
 namespace realm {
 
@@ -110,6 +111,12 @@ public:
     /// this interface.
     bool is_read_only(ref_type) const noexcept;
 
+    /// Returns true if, and only if the immutable part of the memory
+    /// managed by this allocator is a plain (unencrypted) memory mapping of
+    /// a file, such that hints about how it will be accessed reach the page
+    /// cache of the system.
+    bool is_file_mapped() const noexcept;
+
     /// Returns a simple allocator that can be used with free-standing
     /// Realm objects (such as a free-standing table). A
     /// free-standing object is one that is not part of a Group, and
@@ -141,6 +148,8 @@ public:
 protected:
     size_t m_baseline = 0; // Separation line between immutable and mutable refs.
 
+    bool m_file_mapped = false;
+
     Replication* m_replication = nullptr;
 
     ref_type m_debug_watch = 0;
@@ -367,6 +376,11 @@ inline bool Allocator::is_read_only(ref_type ref) const noexcept
     return ref < m_baseline;
 }
 
+inline bool Allocator::is_file_mapped() const noexcept
+{
+    return m_file_mapped;
+}
+
 inline Allocator::Allocator() noexcept
 {
     m_table_versioning_counter = 0;
@@ -40,6 +40,7 @@
 #include <realm/util/scope_exit.hpp>
 #include <realm/array.hpp>
 #include <realm/alloc_slab.hpp>
+#include <realm/impl/map_window_cache.hpp>
 
 using namespace realm;
 using namespace realm::util;
@@ -86,11 +87,28 @@ struct SlabAlloc::MappedFile {
     /// Indicates if attaching to the file was succesfull
     bool m_success = false;
 
+    // Passed to all mappings of the file, see Config::memory_policy
+    int m_map_flags = 0;
+
+    // Applied to all mappings of the file, see Config::memory_policy
+    util::AccessPattern m_access_pattern = util::AccessPattern::Normal;
+
+    // Kept across commits, see GroupWriter
+    _impl::MapWindowCache m_write_windows;
+
     MappedFile() {}
+
+    void advise(const util::File::Map<char>& map) const noexcept
+    {
+        if (m_access_pattern != util::AccessPattern::Normal)
+            util::advise_access(map.get_addr(), map.get_size(), m_access_pattern);
+    }
+
     MappedFile(const MappedFile&) = delete;
     MappedFile& operator=(const MappedFile&) = delete;
     ~MappedFile()
     {
+        m_write_windows.clear();
         m_file.close();
     }
 };
@@ -116,6 +134,11 @@ util::File& SlabAlloc::get_file()
     return m_file_mappings->m_file;
 }
 
+_impl::MapWindowCache& SlabAlloc::get_write_windows()
+{
+    return m_file_mappings->m_write_windows;
+}
+
 
 const SlabAlloc::Header SlabAlloc::empty_file_header = {
     {0, 0}, // top-refs
@@ -187,18 +210,32 @@ private:
     ref_type m_ref;
 };
 
-inline SlabAlloc::Slab::Slab(ref_type r, size_t s)
+inline SlabAlloc::Slab::Slab(ref_type r, size_t s, const util::MemoryPolicy& policy)
     : ref_end(r)
-    , addr(new char[s])
     , size(s)
+    , has_pages(!policy.is_default())
 {
+    if (has_pages) {
+        addr = util::alloc_pages(s, policy); // Throws
+    }
+    else {
+        addr = new char[s]; // Throws
+        std::fill(addr, addr + size, 0);
+    }
     total_slab_allocated.fetch_add(s, std::memory_order_relaxed);
-    std::fill(addr.get(), addr.get() + size, 0);
 }
 
 inline SlabAlloc::Slab::~Slab()
 {
+    if (!addr)
+        return;
     total_slab_allocated.fetch_sub(size, std::memory_order_relaxed);
+    if (has_pages) {
+        util::free_pages(addr, size);
+    }
+    else {
+        delete[] addr;
+    }
 }
 
 void SlabAlloc::detach() noexcept
@@ -213,6 +250,7 @@ void SlabAlloc::detach() noexcept
         case attach_SharedFile:
         case attach_UnsharedFile:
             m_data = 0;
+            m_file_mapped = false;
             m_file_mappings.reset();
             m_local_mappings.reset();
             m_num_local_mappings = 0;
@@ -445,7 +483,7 @@ SlabAlloc::FreeBlock* SlabAlloc::allocate_block(int size)
 
 SlabAlloc::FreeBlock* SlabAlloc::slab_to_entry(const Slab& slab, ref_type ref_start)
 {
-    auto bb = reinterpret_cast<BetweenBlocks*>(slab.addr.get());
+    auto bb = reinterpret_cast<BetweenBlocks*>(slab.addr);
     bb->block_before_size = 0;
     int block_size = static_cast<int>(slab.ref_end - ref_start - 2 * sizeof(BetweenBlocks));
     bb->block_after_size = block_size;
@@ -528,8 +566,13 @@ SlabAlloc::FreeBlock* SlabAlloc::grow_slab_for(int size)
         ref = curr_ref_end;
     }
 
-    // Round upwards to nearest 64k
-    new_size = ((new_size - 1) | (0xFFFF)) + 1;
+    // Round upwards to nearest 64k, or to whole huge pages
+    if (m_cfg.memory_policy.huge_pages != util::MemoryPolicy::HugePages::Default) {
+        new_size = ((new_size - 1) | (util::huge_page_size - 1)) + 1;
+    }
+    else {
+        new_size = ((new_size - 1) | (0xFFFF)) + 1;
+    }
 
     size_t ref_end = ref;
     if (REALM_UNLIKELY(int_add_with_overflow_detect(ref_end, new_size))) {
@@ -538,7 +581,7 @@ SlabAlloc::FreeBlock* SlabAlloc::grow_slab_for(int size)
     }
 
     // Create new slab and add to list of slabs
-    m_slabs.emplace_back(ref_end, new_size); // Throws
+    m_slabs.emplace_back(ref_end, new_size, m_cfg.memory_policy); // Throws
 
     // build a single block from that entry
     return slab_to_entry(m_slabs.back(), ref);
@@ -733,7 +776,7 @@ char* SlabAlloc::do_translate(ref_type ref) const noexcept
         REALM_ASSERT_DEBUG(i != m_slabs.end());
 
         ref_type slab_ref = i == m_slabs.begin() ? m_baseline : (i - 1)->ref_end;
-        addr = i->addr.get() + (ref - slab_ref);
+        addr = i->addr + (ref - slab_ref);
     }
     cache[cache_index].addr = addr;
     cache[cache_index].ref = ref;
@@ -853,6 +896,7 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
         m_data = m_file_mappings->m_initial_mapping.get_addr();
         m_initial_chunk_size = m_file_mappings->m_initial_mapping.get_size();
         m_attach_mode = cfg.is_shared ? attach_SharedFile : attach_UnsharedFile;
+        m_file_mapped = !cfg.encryption_key;
         m_free_space_state = free_space_Invalid;
         if (m_file_mappings->m_num_global_mappings > 0) {
             size_t mapping_index = m_file_mappings->m_num_global_mappings;
@@ -886,6 +930,10 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
         m_file_mappings->m_file.set_encryption_key(cfg.encryption_key);
     }
     File::CloseGuard fcg(m_file_mappings->m_file);
+    if (cfg.memory_policy.huge_pages != util::MemoryPolicy::HugePages::Default)
+        m_file_mappings->m_map_flags = File::map_HugePages;
+    if (cfg.memory_policy.file_access == util::MemoryPolicy::FileAccess::Random && !cfg.encryption_key)
+        m_file_mappings->m_access_pattern = util::AccessPattern::Random;
 
     size_t size = 0;
     // The size of a database file must not exceed what can be encoded in
@@ -929,7 +977,8 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
     }
     ref_type top_ref;
     try {
-        File::Map<char> map(m_file_mappings->m_file, File::access_ReadOnly, size); // Throws
+        File::Map<char> map(m_file_mappings->m_file, File::access_ReadOnly, size,
+                            m_file_mappings->m_map_flags); // Throws
         note_reader_start(this);
         // we'll read header and (potentially) footer
         realm::util::encryption_read_barrier(map, 0, sizeof(Header));
@@ -942,12 +991,14 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
 
         top_ref = get_top_ref(map.get_addr(), size);
 
+        m_file_mappings->advise(map);
         m_data = map.get_addr();
         m_file_mappings->m_initial_mapping = std::move(map);
         m_baseline = size;
         m_initial_chunk_size = size;
         m_file_mappings->m_first_additional_mapping = get_section_index(m_initial_chunk_size);
         m_attach_mode = cfg.is_shared ? attach_SharedFile : attach_UnsharedFile;
+        m_file_mapped = !cfg.encryption_key;
     }
     catch (const DecryptionFailed&) {
         note_reader_end(this);
@@ -1046,7 +1097,9 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
                 // actual size of the file.
                 size = get_upper_section_boundary(size);
                 m_file_mappings->m_file.prealloc(size);
-                m_file_mappings->m_initial_mapping.remap(m_file_mappings->m_file, File::access_ReadOnly, size);
+                m_file_mappings->m_initial_mapping.remap(m_file_mappings->m_file, File::access_ReadOnly, size,
+                                                         m_file_mappings->m_map_flags);
+                m_file_mappings->advise(m_file_mappings->m_initial_mapping);
                 m_data = m_file_mappings->m_initial_mapping.get_addr();
                 m_baseline = size;
                 m_initial_chunk_size = size;
@@ -1260,7 +1313,9 @@ void SlabAlloc::update_reader_view(size_t file_size)
             size_t section_size =
                 get_section_base(1 + k + m_file_mappings->m_first_additional_mapping) - section_start_offset;
             m_file_mappings->m_global_mappings[k] = std::make_shared<const util::File::Map<char>>(
-                m_file_mappings->m_file, section_start_offset, File::access_ReadOnly, section_size);
+                m_file_mappings->m_file, section_start_offset, File::access_ReadOnly, section_size,
+                m_file_mappings->m_map_flags);
+            m_file_mappings->advise(*m_file_mappings->m_global_mappings[k]);
         }
 
         // Share the increased number of mappings. This *must* be a conditional update to ensure
@@ -1383,6 +1438,11 @@ void SlabAlloc::resize_file(size_t new_file_size)
 {
     std::lock_guard<Mutex> lock(m_file_mappings->m_mutex);
     REALM_ASSERT_EX(matches_section_boundary(new_file_size), new_file_size, get_file_path_for_assertions());
+    // The file may already have been extended ahead of time (see
+    // _impl::FileGrower), in which case the new size has been made durable
+    // already, too.
+    if (util::File::SizeType(new_file_size) <= m_file_mappings->m_file.get_size())
+        return;
     m_file_mappings->m_file.prealloc(new_file_size); // Throws
     // resizing is done based on the logical file size. It is ok for the file
     // to actually be bigger, but never smaller.
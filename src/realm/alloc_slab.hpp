@@ -27,6 +27,7 @@
 
 #include <realm/util/features.h>
 #include <realm/util/file.hpp>
+#include <realm/util/memory_policy.hpp>
 #include <realm/alloc.hpp>
 #include <realm/disable_sync_to_disk.hpp>
 
@@ -36,6 +37,12 @@ namespace realm {
 class Group;
 class GroupWriter;
 
+namespace _impl {
+class FileGrower;
+class MapWindowCache;
+class SnapshotCopier;
+}
+
 
 /// Thrown by Group and SharedGroup constructors if the specified file
 /// (or memory buffer) does not appear to contain a valid Realm
@@ -100,6 +107,12 @@ public:
     /// Always initialize the file as if it was a newly
     /// created file and ignore any pre-existing contents. Requires that
     /// Config::session_initiator be true as well.
+    ///
+    /// \var Config::memory_policy
+    /// How slabs are allocated, and how the file is mapped, see
+    /// util::MemoryPolicy. The mappings of a file are shared by all
+    /// allocators of the process which have it open, so only the policy of
+    /// the first one to attach it affects them.
     struct Config {
         bool is_shared = false;
         bool read_only = false;
@@ -109,6 +122,7 @@ public:
         bool clear_file = false;
         bool disable_sync = false;
         const char* encryption_key = nullptr;
+        util::MemoryPolicy memory_policy;
     };
 
     struct Retry {
@@ -218,7 +232,8 @@ public:
     /// access. In non-transactional mode it is the responsibility of the user
     /// to ensure non-concurrent file mutation.
     ///
-    /// This function will call File::sync().
+    /// This function will call File::sync(), unless the file is already at
+    /// least as large as requested, in which case it does nothing.
     ///
     /// It is an error to call this function on an allocator that is not
     /// attached to a file. Doing so will result in undefined behavior.
@@ -378,15 +393,18 @@ private:
     // Slabs table in order of ascending file offsets.
     struct Slab {
         ref_type ref_end;
-        std::unique_ptr<char[]> addr;
+        char* addr;
         size_t size;
+        bool has_pages; // Allocated by util::alloc_pages() rather than new[]
 
-        Slab(ref_type r, size_t s);
-        Slab(Slab&& slab)
+        Slab(ref_type r, size_t s, const util::MemoryPolicy&);
+        Slab(Slab&& slab) noexcept
             : ref_end(slab.ref_end)
-            , addr(std::move(slab.addr))
+            , addr(slab.addr)
             , size(slab.size)
+            , has_pages(slab.has_pages)
         {
+            slab.addr = nullptr;
             slab.size = 0;
         }
         ~Slab();
@@ -599,6 +617,11 @@ private:
     // Gets the path of the attached file, or other relevant debugging info.
     std::string get_file_path_for_assertions() const;
 
+    /// The memory mappings used by GroupWriter to write to the attached file.
+    /// They are shared by all allocators attached to the same file in this
+    /// process, and are only used while holding the write lock.
+    _impl::MapWindowCache& get_write_windows();
+
     class ChunkRefEq;
     class ChunkRefEndEq;
     class SlabRefEndEq;
@@ -616,6 +639,8 @@ private:
     friend class Group;
     friend class SharedGroup;
     friend class GroupWriter;
+    friend class _impl::FileGrower;
+    friend class _impl::SnapshotCopier;
 };
 
 inline void SlabAlloc::internal_invalidate_cache() noexcept
@@ -718,7 +743,7 @@ void SlabAlloc::for_all_free_entries(Func f) const
 {
     ref_type ref = m_baseline;
     for (auto& e : m_slabs) {
-        BetweenBlocks* bb = reinterpret_cast<BetweenBlocks*>(e.addr.get());
+        BetweenBlocks* bb = reinterpret_cast<BetweenBlocks*>(e.addr);
         REALM_ASSERT(bb->block_before_size == 0);
         while (1) {
             int size = bb->block_after_size;
@@ -36,6 +36,7 @@
 #include <realm/array.hpp>
 #include <realm/array_basic.hpp>
 #include <realm/impl/destroy_guard.hpp>
+#include <realm/impl/scan_prefetcher.hpp>
 #include <realm/column.hpp>
 #include <realm/query_conditions.hpp>
 #include <realm/column_string.hpp>
@@ -398,6 +399,11 @@ ref_type Array::do_write_deep(_impl::ArrayWriterBase& out, bool only_if_modified
     new_array.create(type, m_context_flag); // Throws
     _impl::ShallowArrayDestroyGuard dg(&new_array);
 
+    // When exporting, have the children read from the file ahead of the
+    // writing. The leaves of a B+-tree are the bulk of the data.
+    if (!only_if_modified && m_is_inner_bptree_node)
+        _impl::ScanPrefetcher::prefetch_children(*this); // Throws
+
     // First write out all sub-arrays
     size_t n = size();
     for (size_t i = 0; i < n; ++i) {
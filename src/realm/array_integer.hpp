@@ -163,6 +163,13 @@ public:
 
     size_t find_first(value_type value, size_t begin = 0, size_t end = npos) const;
 
+    /// Like find_first<cond>(), except that a null is compared as the
+    /// integer representing it (see null_value()), so it may be found even
+    /// though it does not match, and must be filtered out by the caller. In
+    /// return, the search is vectorized for Greater, Less and NotEqual too.
+    template <class cond>
+    size_t find_first_including_nulls(int64_t value, size_t begin = 0, size_t end = npos) const;
+
 
     // Overwrite Array::bptree_leaf_insert to correctly split nodes.
     ref_type bptree_leaf_insert(size_t ndx, value_type value, TreeInsertBase& state);
@@ -624,6 +631,24 @@ inline size_t ArrayIntNull::find_first(value_type value, size_t begin, size_t en
 {
     return find_first<Equal>(value, begin, end);
 }
+
+template <class cond>
+size_t ArrayIntNull::find_first_including_nulls(int64_t value, size_t begin, size_t end) const
+{
+    if (end == npos)
+        end = size();
+    QueryState<int64_t> state;
+    state.init(act_ReturnFirst, nullptr, 1);
+    // Searched as a plain integer array, skipping the null value at index 0
+    Array::find<cond, act_ReturnFirst>(value, begin + 1, end + 1, 0, &state, Array::CallbackDummy(),
+                                       false /*treat as plain array*/,
+                                       false /*search parameter given in 'value' argument*/);
+
+    if (state.m_match_count > 0)
+        return to_size_t(state.m_state) - 1;
+    else
+        return not_found;
+}
 }
 
 #endif // REALM_ARRAY_INTEGER_HPP
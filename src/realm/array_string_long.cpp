@@ -21,6 +21,8 @@
 #include <realm/impl/destroy_guard.hpp>
 #include <realm/column.hpp>
 
+#include <cstring>
+
 using namespace realm;
 
 
@@ -162,6 +164,45 @@ void ArrayStringLong::find_all(IntegerColumn& result, StringData value, size_t a
 }
 
 
+size_t ArrayStringLong::find_first_containing(StringData needle, const std::array<uint8_t, 256>& charmap,
+                                              size_t begin, size_t end) const noexcept
+{
+    REALM_ASSERT_3(needle.size(), !=, 0);
+    REALM_ASSERT_7(begin, <=, end, &&, end, <=, size());
+    if (begin == end)
+        return not_found;
+
+    // The strings are stored back to back in the blob, each followed by a
+    // terminating zero, and the offsets hold the end of each of them. Null
+    // strings are stored as empty strings.
+    size_t needle_size = needle.size();
+    size_t data_begin = begin == 0 ? 0 : to_size_t(m_offsets.get(begin - 1));
+    size_t data_end = to_size_t(m_offsets.get(end - 1));
+    const char* data = m_blob.get(0);
+    unsigned char last_char = needle[needle_size - 1];
+
+    size_t p = data_begin + needle_size - 1;
+    while (p < data_end) {
+        unsigned char c = data[p];
+        if (c == last_char) {
+            size_t match_begin = p + 1 - needle_size;
+            if (std::memcmp(data + match_begin, needle.data(), needle_size) == 0) {
+                size_t ndx = m_offsets.upper_bound_int(int64_t(match_begin));
+                size_t string_end = to_size_t(m_offsets.get(ndx)) - 1;
+                if (p < string_end)
+                    return ndx;
+                // The match extends past the end of the string it starts in,
+                // and so will every later one starting in that string
+                p = string_end + needle_size;
+                continue;
+            }
+        }
+        p += charmap[c] == 0 ? needle_size : charmap[c];
+    }
+    return not_found;
+}
+
+
 StringData ArrayStringLong::get(const char* header, size_t ndx, Allocator& alloc, bool nullable) noexcept
 {
     ref_type offsets_ref;
@@ -19,6 +19,8 @@
 #ifndef REALM_ARRAY_STRING_LONG_HPP
 #define REALM_ARRAY_STRING_LONG_HPP
 
+#include <array>
+
 #include <realm/array_blob.hpp>
 #include <realm/array_integer.hpp>
 
@@ -76,6 +78,13 @@ public:
     void find_all(IntegerColumn& result, StringData value, size_t add_offset = 0, size_t begin = 0,
                   size_t end = npos) const;
 
+    /// Find the first string in [begin, end) that contains \a needle, which
+    /// must not be empty. Rather than visiting the strings one by one, the
+    /// payload of the whole range is searched in one pass (Boyer-Moore-
+    /// Horspool), using \a charmap as computed by StringNode<Contains>.
+    size_t find_first_containing(StringData needle, const std::array<uint8_t, 256>& charmap, size_t begin,
+                                 size_t end) const noexcept;
+
     /// Get the specified element without the cost of constructing an
     /// array instance. If an array instance is already available, or
     /// you need to get multiple values, then this method will be
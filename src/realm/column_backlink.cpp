@@ -28,6 +28,76 @@
 
 using namespace realm;
 
+namespace {
+
+bool is_sorted_list(const IntegerColumn& backlink_list) noexcept
+{
+    return backlink_list.get_root_array()->get_context_flag();
+}
+
+// Must be called after every modification of a sorted list, since the root
+// array may have been replaced
+void mark_sorted_list(IntegerColumn& backlink_list, bool sorted = true) noexcept
+{
+    backlink_list.get_root_array()->set_context_flag(sorted);
+}
+
+// Versions of the library which do not sort backlink lists append to a list
+// without clearing its mark, so a list marked as sorted may not be. A failed
+// binary search is therefore confirmed by a linear one, and if that finds the
+// backlink, `sorted` is set to false, so that the caller clears the mark.
+size_t find_backlink(const IntegerColumn& backlink_list, int_fast64_t origin_row_ndx, bool& sorted) noexcept
+{
+    if (!sorted)
+        return backlink_list.find_first(origin_row_ndx);
+
+    size_t ndx = backlink_list.lower_bound(origin_row_ndx);
+    if (ndx != backlink_list.size() && backlink_list.get(ndx) == origin_row_ndx)
+        return ndx;
+    ndx = backlink_list.find_first(origin_row_ndx);
+    if (ndx != not_found)
+        sorted = false;
+    return ndx;
+}
+
+bool is_in_order(const IntegerColumn& backlink_list) noexcept
+{
+    size_t size = backlink_list.size();
+    for (size_t i = 1; i < size; ++i) {
+        if (backlink_list.get(i) < backlink_list.get(i - 1))
+            return false;
+    }
+    return true;
+}
+
+void insert_backlink(IntegerColumn& backlink_list, int_fast64_t origin_row_ndx)
+{
+    // If the list is out of order despite its mark, this still inserts the
+    // backlink somewhere, which is all that matters then
+    if (is_sorted_list(backlink_list)) {
+        backlink_list.insert(backlink_list.upper_bound(origin_row_ndx), origin_row_ndx); // Throws
+        mark_sorted_list(backlink_list);
+        return;
+    }
+
+    backlink_list.add(origin_row_ndx); // Throws
+    size_t size = backlink_list.size();
+    if (size > BacklinkColumn::sorted_threshold) {
+        std::vector<int_fast64_t> values;
+        values.reserve(size);
+        for (size_t i = 0; i < size; ++i)
+            values.push_back(backlink_list.get(i));
+        std::sort(values.begin(), values.end());
+        for (size_t i = 0; i < size; ++i)
+            backlink_list.set(i, values[i]); // Throws
+        mark_sorted_list(backlink_list);
+    }
+}
+
+} // anonymous namespace
+
+constexpr size_t BacklinkColumn::sorted_threshold;
+
 
 void BacklinkColumn::add_backlink(size_t row_ndx, size_t origin_row_ndx)
 {
@@ -55,7 +125,7 @@ void BacklinkColumn::add_backlink(size_t row_ndx, size_t origin_row_ndx)
     }
     IntegerColumn backlink_list(get_alloc(), ref); // Throws
     backlink_list.set_parent(this, row_ndx);
-    backlink_list.add(int_fast64_t(origin_row_ndx)); // Throws
+    insert_backlink(backlink_list, int_fast64_t(origin_row_ndx)); // Throws
 }
 
 
@@ -98,6 +168,17 @@ size_t BacklinkColumn::get_backlink(size_t row_ndx, size_t backlink_ndx) const n
 }
 
 
+bool BacklinkColumn::has_sorted_backlinks(size_t row_ndx) const noexcept
+{
+    uint64_t value = IntegerColumn::get_uint(row_ndx);
+    if (value == 0 || (value & 1) != 0)
+        return false;
+
+    ref_type ref = to_ref(value);
+    return Array::get_context_flag_from_header(get_alloc().translate(ref));
+}
+
+
 void BacklinkColumn::remove_one_backlink(size_t row_ndx, size_t origin_row_ndx)
 {
     uint64_t value = IntegerColumn::get_uint(row_ndx);
@@ -117,9 +198,12 @@ void BacklinkColumn::remove_one_backlink(size_t row_ndx, size_t origin_row_ndx)
     IntegerColumn backlink_list(get_alloc(), ref); // Throws
     backlink_list.set_parent(this, row_ndx);
     int_fast64_t value_2 = int_fast64_t(origin_row_ndx);
-    size_t backlink_ndx = backlink_list.find_first(value_2);
+    bool sorted = is_sorted_list(backlink_list);
+    size_t backlink_ndx = find_backlink(backlink_list, value_2, sorted);
     REALM_ASSERT_3(backlink_ndx, !=, not_found);
     backlink_list.erase(backlink_ndx); // Throws
+    if (sorted || is_sorted_list(backlink_list))
+        mark_sorted_list(backlink_list, sorted);
 
     // If there is only one backlink left we can inline it as tagged value
     if (backlink_list.size() == 1) {
@@ -165,10 +249,20 @@ void BacklinkColumn::update_backlink(size_t row_ndx, size_t old_origin_row_ndx,
     IntegerColumn backlink_list(get_alloc(), ref); // Throws
     backlink_list.set_parent(this, row_ndx);
     int_fast64_t value_2 = int_fast64_t(old_origin_row_ndx);
-    size_t backlink_ndx = backlink_list.find_first(value_2);
+    bool sorted = is_sorted_list(backlink_list);
+    size_t backlink_ndx = find_backlink(backlink_list, value_2, sorted);
     REALM_ASSERT_3(backlink_ndx, !=, not_found);
     int_fast64_t value_3 = int_fast64_t(new_origin_row_ndx);
-    backlink_list.set(backlink_ndx, value_3);
+    if (sorted) {
+        // The new value may belong elsewhere in the list
+        backlink_list.erase(backlink_ndx); // Throws
+        backlink_list.insert(backlink_list.upper_bound(value_3), value_3); // Throws
+        mark_sorted_list(backlink_list);
+        return;
+    }
+    backlink_list.set(backlink_ndx, value_3); // Throws
+    if (is_sorted_list(backlink_list))
+        mark_sorted_list(backlink_list, false);
 }
 
 void BacklinkColumn::swap_backlinks(size_t row_ndx, size_t origin_row_ndx_1, size_t origin_row_ndx_2)
@@ -191,16 +285,46 @@ void BacklinkColumn::swap_backlinks(size_t row_ndx, size_t origin_row_ndx_1, siz
     ref_type ref = to_ref(value);
     IntegerColumn backlink_list(get_alloc(), ref); // Throws
     backlink_list.set_parent(this, row_ndx);
+    // Swaps are rare enough to afford confirming the order, see find_backlink()
+    bool sorted = is_sorted_list(backlink_list) && is_in_order(backlink_list);
+    if (sorted) {
+        // Replace every occurrence of each origin row by the other one. Only
+        // the number of occurrences matters, so nothing changes if they are
+        // equal.
+        int_fast64_t origin_1 = int_fast64_t(origin_row_ndx_1);
+        int_fast64_t origin_2 = int_fast64_t(origin_row_ndx_2);
+        size_t begin_1 = backlink_list.lower_bound(origin_1);
+        size_t count_1 = backlink_list.upper_bound(origin_1) - begin_1;
+        size_t begin_2 = backlink_list.lower_bound(origin_2);
+        size_t count_2 = backlink_list.upper_bound(origin_2) - begin_2;
+        if (count_1 == count_2)
+            return;
+        for (size_t i = 0; i < count_1; ++i)
+            backlink_list.erase(backlink_list.lower_bound(origin_1)); // Throws
+        for (size_t i = 0; i < count_2; ++i)
+            backlink_list.erase(backlink_list.lower_bound(origin_2)); // Throws
+        for (size_t i = 0; i < count_2; ++i)
+            backlink_list.insert(backlink_list.lower_bound(origin_1), origin_1); // Throws
+        for (size_t i = 0; i < count_1; ++i)
+            backlink_list.insert(backlink_list.lower_bound(origin_2), origin_2); // Throws
+        mark_sorted_list(backlink_list);
+        return;
+    }
+    bool modified = false;
     size_t num_backlinks = backlink_list.size();
     for (size_t i = 0; i < num_backlinks; ++i) {
         uint64_t r = backlink_list.get_uint(i);
         if (r == origin_row_ndx_1) {
             backlink_list.set(i, origin_row_ndx_2);
+            modified = true;
         }
         else if (r == origin_row_ndx_2) {
             backlink_list.set(i, origin_row_ndx_1);
+            modified = true;
         }
     }
+    if (modified && is_sorted_list(backlink_list))
+        mark_sorted_list(backlink_list, false);
 }
 
 
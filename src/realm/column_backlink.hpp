@@ -34,8 +34,18 @@ namespace realm {
 /// The individual values in the column are either refs to Columns containing
 /// the row indexes in the origin table that links to it, or in the case where
 /// there is a single link, a tagged ref encoding the origin row position.
+///
+/// A list of more than `sorted_threshold` backlinks is kept sorted by origin
+/// row index, so that an individual backlink can be located by binary search
+/// when it is removed or updated. Such lists are marked by the context flag of
+/// their root array. Shorter lists are kept in insertion order. Versions of
+/// the library which predate sorted lists keep the mark when they modify a
+/// list, so a list which turns out to be out of order loses its mark, and is
+/// sorted again when it next grows.
 class BacklinkColumn : public IntegerColumn, public ArrayParent {
 public:
+    static constexpr size_t sorted_threshold = 256;
+
     BacklinkColumn(Allocator&, ref_type, size_t col_ndx = npos);
     ~BacklinkColumn() noexcept override
     {
@@ -46,6 +56,7 @@ public:
     bool has_backlinks(size_t row_ndx) const noexcept;
     size_t get_backlink_count(size_t row_ndx) const noexcept;
     size_t get_backlink(size_t row_ndx, size_t backlink_ndx) const noexcept;
+    bool has_sorted_backlinks(size_t row_ndx) const noexcept;
 
     void add_backlink(size_t row_ndx, size_t origin_row_ndx);
     void remove_one_backlink(size_t row_ndx, size_t origin_row_ndx);
@@ -0,0 +1,299 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/column_chunk.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include <realm/column.hpp>
+#include <realm/column_string.hpp>
+#include <realm/column_string_enum.hpp>
+#include <realm/exceptions.hpp>
+#include <realm/table.hpp>
+
+using namespace realm;
+
+namespace {
+
+// Call `fn(begin, leaf)` for every B+tree leaf of the column, where `begin` is the index of the first row of the
+// leaf
+template <class ColType, class Fn>
+void for_each_leaf(const ColType& column, size_t size, Fn fn)
+{
+    using LeafType = typename ColType::LeafType;
+    LeafType cache(column.get_alloc());
+    size_t begin = 0;
+    while (begin < size) {
+        const LeafType* leaf;
+        size_t ndx_in_leaf;
+        typename ColType::LeafInfo info{&leaf, &cache};
+        column.get_leaf(begin, ndx_in_leaf, info);
+        REALM_ASSERT_3(ndx_in_leaf, ==, 0);
+        fn(begin, *leaf);
+        begin += leaf->size();
+    }
+}
+
+ColumnChunk make_chunk(DataType type, size_t offset, size_t length)
+{
+    ColumnChunk chunk;
+    chunk.type = type;
+    chunk.offset = offset;
+    chunk.length = length;
+    return chunk;
+}
+
+// Unpack `length` values of `array`, starting at `begin`, to 64 bits, eight at a time
+void unpack(const Array& array, size_t begin, size_t length, int64_t* out)
+{
+    int64_t buf[8];
+    for (size_t i = 0; i < length; i += 8) {
+        array.get_chunk(begin + i, buf);
+        std::copy(buf, buf + std::min<size_t>(8, length - i), out + i);
+    }
+}
+
+// Point the chunk at `length` 64-bit values of `array`, starting at `begin`, copying them only if the array is
+// narrower
+void set_int_values(ColumnChunk& chunk, const Array& array, size_t begin, size_t length)
+{
+    if (array.get_width() == 64) {
+        chunk.values = array.m_data + begin * sizeof(int64_t);
+        return;
+    }
+    chunk.owned_values.resize(length * sizeof(int64_t));
+    unpack(array, begin, length, reinterpret_cast<int64_t*>(chunk.owned_values.data()));
+    chunk.values = chunk.owned_values.data();
+}
+
+// Set up the validity bitmap from a predicate telling if the value at an index is null
+template <class IsNull>
+void set_validity(ColumnChunk& chunk, IsNull is_null)
+{
+    chunk.validity.assign((chunk.length + 7) / 8, 0);
+    for (size_t i = 0; i < chunk.length; ++i) {
+        if (is_null(i))
+            ++chunk.null_count;
+        else
+            chunk.validity[i >> 3] |= uint8_t(1 << (i & 7));
+    }
+    if (chunk.null_count == 0)
+        chunk.validity.clear();
+}
+
+// Replace 64-bit values by one bit per value
+void pack_bools(ColumnChunk& chunk)
+{
+    std::vector<char> bits((chunk.length + 7) / 8, 0);
+    for (size_t i = 0; i < chunk.length; ++i) {
+        int64_t v;
+        std::memcpy(&v, chunk.values + i * sizeof v, sizeof v);
+        if (v != 0)
+            bits[i >> 3] |= char(1 << (i & 7));
+    }
+    chunk.owned_values = std::move(bits);
+    chunk.values = chunk.owned_values.data();
+}
+
+void export_int(const IntegerColumn& column, DataType type, size_t size, std::vector<ColumnChunk>& chunks)
+{
+    for_each_leaf(column, size, [&](size_t begin, const ArrayInteger& leaf) {
+        chunks.push_back(make_chunk(type, begin, leaf.size()));
+        ColumnChunk& chunk = chunks.back();
+        set_int_values(chunk, leaf, 0, chunk.length);
+        if (type == type_Bool)
+            pack_bools(chunk);
+    });
+}
+
+void export_int_null(const IntNullColumn& column, DataType type, size_t size, std::vector<ColumnChunk>& chunks)
+{
+    for_each_leaf(column, size, [&](size_t begin, const ArrayIntNull& leaf) {
+        chunks.push_back(make_chunk(type, begin, leaf.size()));
+        ColumnChunk& chunk = chunks.back();
+        // The first element of the leaf is the value which represents null
+        const Array& array = leaf;
+        set_int_values(chunk, array, 1, chunk.length);
+        int64_t null_value = array.get(0);
+        const char* values = chunk.values;
+        set_validity(chunk, [&](size_t i) {
+            int64_t v;
+            std::memcpy(&v, values + i * sizeof v, sizeof v);
+            return v == null_value;
+        });
+        if (type == type_Bool)
+            pack_bools(chunk);
+    });
+}
+
+template <class T>
+void export_float(const Column<T>& column, bool nullable, size_t size, std::vector<ColumnChunk>& chunks)
+{
+    DataType type = std::is_same<T, float>::value ? type_Float : type_Double;
+    for_each_leaf(column, size, [&](size_t begin, const BasicArray<T>& leaf) {
+        chunks.push_back(make_chunk(type, begin, leaf.size()));
+        ColumnChunk& chunk = chunks.back();
+        // Float and double leaves always store the values in place
+        chunk.values = leaf.m_data;
+        if (nullable)
+            set_validity(chunk, [&](size_t i) { return null::is_null_float(leaf.get(i)); });
+    });
+}
+
+// Append the strings produced by `get(i)` for `i` in `[0, chunk.length)` to the chunk
+template <class Get>
+void set_strings(ColumnChunk& chunk, Get get)
+{
+    chunk.offsets.reserve(chunk.length + 1);
+    chunk.offsets.push_back(0);
+    std::vector<bool> nulls(chunk.length);
+    for (size_t i = 0; i < chunk.length; ++i) {
+        StringData str = get(i);
+        nulls[i] = str.is_null();
+        chunk.owned_values.insert(chunk.owned_values.end(), str.data(), str.data() + str.size());
+        REALM_ASSERT_RELEASE(chunk.owned_values.size() <= size_t(std::numeric_limits<int32_t>::max()));
+        chunk.offsets.push_back(int32_t(chunk.owned_values.size()));
+    }
+    chunk.values = chunk.owned_values.data();
+    set_validity(chunk, [&](size_t i) { return bool(nulls[i]); });
+}
+
+void export_string(const StringColumn& column, size_t size, std::vector<ColumnChunk>& chunks)
+{
+    for (size_t begin = 0; begin < size; begin += REALM_MAX_BPNODE_SIZE) {
+        chunks.push_back(make_chunk(type_String, begin, std::min<size_t>(REALM_MAX_BPNODE_SIZE, size - begin)));
+        set_strings(chunks.back(), [&](size_t i) { return column.get(begin + i); });
+    }
+}
+
+void export_string_enum(const StringEnumColumn& column, size_t size, std::vector<ColumnChunk>& chunks)
+{
+    // Each key is read once, and the rows only hold the indexes of their keys
+    const StringColumn& keys = column.get_keys();
+    std::vector<StringData> values;
+    size_t num_keys = keys.size();
+    values.reserve(num_keys);
+    for (size_t i = 0; i < num_keys; ++i)
+        values.push_back(keys.get(i));
+
+    std::vector<int64_t> key_ndxs;
+    for_each_leaf(static_cast<const IntegerColumn&>(column), size, [&](size_t begin, const ArrayInteger& leaf) {
+        chunks.push_back(make_chunk(type_String, begin, leaf.size()));
+        key_ndxs.resize(leaf.size());
+        unpack(leaf, 0, leaf.size(), key_ndxs.data());
+        set_strings(chunks.back(), [&](size_t i) { return values[size_t(key_ndxs[i])]; });
+    });
+}
+
+template <class T>
+T read_value(const ColumnChunk& chunk, size_t ndx)
+{
+    T value;
+    std::memcpy(&value, chunk.values + ndx * sizeof value, sizeof value);
+    return value;
+}
+
+} // anonymous namespace
+
+namespace realm {
+namespace _impl {
+
+std::vector<ColumnChunk> export_column(const ColumnBase& column, ColumnType type, bool nullable, size_t size)
+{
+    std::vector<ColumnChunk> chunks;
+    switch (type) {
+        case col_type_Int:
+        case col_type_Bool:
+        case col_type_OldDateTime:
+            if (nullable) {
+                export_int_null(static_cast<const IntNullColumn&>(column), DataType(type), size, chunks); // Throws
+            }
+            else {
+                export_int(static_cast<const IntegerColumn&>(column), DataType(type), size, chunks); // Throws
+            }
+            break;
+        case col_type_Float:
+            export_float(static_cast<const FloatColumn&>(column), nullable, size, chunks); // Throws
+            break;
+        case col_type_Double:
+            export_float(static_cast<const DoubleColumn&>(column), nullable, size, chunks); // Throws
+            break;
+        case col_type_String:
+            export_string(static_cast<const StringColumn&>(column), size, chunks); // Throws
+            break;
+        case col_type_StringEnum:
+            export_string_enum(static_cast<const StringEnumColumn&>(column), size, chunks); // Throws
+            break;
+        default:
+            throw LogicError(LogicError::illegal_type);
+    }
+    return chunks;
+}
+
+void import_column(Table& table, size_t col_ndx, size_t row_ndx, const ColumnChunk& chunk)
+{
+    if (REALM_UNLIKELY(col_ndx >= table.get_column_count()))
+        throw LogicError(LogicError::column_index_out_of_range);
+    if (REALM_UNLIKELY(chunk.type != table.get_column_type(col_ndx)))
+        throw LogicError(LogicError::type_mismatch);
+    if (REALM_UNLIKELY(row_ndx > table.size() || chunk.length > table.size() - row_ndx))
+        throw LogicError(LogicError::row_index_out_of_range);
+    if (REALM_UNLIKELY(chunk.null_count != 0 && !table.is_nullable(col_ndx)))
+        throw LogicError(LogicError::column_not_nullable);
+
+    for (size_t i = 0; i < chunk.length; ++i) {
+        size_t row = row_ndx + i;
+        if (chunk.is_null(i)) {
+            table.set_null(col_ndx, row); // Throws
+            continue;
+        }
+        switch (chunk.type) {
+            case type_Int:
+                table.set_int(col_ndx, row, read_value<int64_t>(chunk, i)); // Throws
+                break;
+            case type_Bool:
+                table.set_bool(col_ndx, row, (chunk.values[i >> 3] >> (i & 7)) & 1); // Throws
+                break;
+            case type_OldDateTime:
+                table.set_olddatetime(col_ndx, row, OldDateTime(read_value<int64_t>(chunk, i))); // Throws
+                break;
+            case type_Float:
+                table.set_float(col_ndx, row, read_value<float>(chunk, i)); // Throws
+                break;
+            case type_Double:
+                table.set_double(col_ndx, row, read_value<double>(chunk, i)); // Throws
+                break;
+            case type_String: {
+                size_t begin = size_t(chunk.offsets[i]);
+                size_t end = size_t(chunk.offsets[i + 1]);
+                // An empty chunk may have no data at all, but its strings are empty rather than null
+                const char* data = chunk.values ? chunk.values + begin : "";
+                table.set_string(col_ndx, row, StringData(data, end - begin)); // Throws
+                break;
+            }
+            default:
+                throw LogicError(LogicError::illegal_type);
+        }
+    }
+}
+
+} // namespace _impl
+} // namespace realm
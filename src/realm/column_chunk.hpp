@@ -0,0 +1,90 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_COLUMN_CHUNK_HPP
+#define REALM_COLUMN_CHUNK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <realm/column_type.hpp>
+#include <realm/data_type.hpp>
+
+namespace realm {
+
+class ColumnBase;
+class Table;
+
+/// A run of consecutive values of one column in the memory layout of an
+/// Apache Arrow array, as produced by Table::export_column() and consumed
+/// by Table::import_column().
+///
+/// `values` points to `length` little-endian values: int64 for integer
+/// columns, one bit per value (least significant bit first) for boolean
+/// columns, and float32 or float64 for float and double columns. For
+/// string columns it points to the concatenated UTF-8 data, and `offsets`
+/// holds the `length + 1` offsets of the strings into it.
+///
+/// When the stored values already have this layout, `values` points
+/// directly into the Realm file (see is_zero_copy()), and it is only valid
+/// until the table is next modified or the transaction ends. Otherwise the
+/// values are unpacked into `owned_values`.
+struct ColumnChunk {
+    DataType type;
+    /// Index of the row of the first value in the table
+    size_t offset = 0;
+    size_t length = 0;
+    size_t null_count = 0;
+    /// One bit per value (least significant bit first), set if the value is
+    /// not null. Empty if there are no nulls.
+    std::vector<uint8_t> validity;
+    const char* values = nullptr;
+    std::vector<int32_t> offsets;
+    std::vector<char> owned_values;
+
+    ColumnChunk() = default;
+    ColumnChunk(ColumnChunk&&) = default;
+    ColumnChunk& operator=(ColumnChunk&&) = default;
+
+    bool is_null(size_t ndx) const noexcept
+    {
+        return !validity.empty() && (validity[ndx >> 3] & (1 << (ndx & 7))) == 0;
+    }
+
+    bool is_zero_copy() const noexcept
+    {
+        return length != 0 && values != owned_values.data();
+    }
+};
+
+namespace _impl {
+
+// Export a column as one chunk per B+tree leaf. For string columns, which
+// have leaves of varying layout, the chunks hold REALM_MAX_BPNODE_SIZE
+// values each.
+std::vector<ColumnChunk> export_column(const ColumnBase&, ColumnType, bool nullable, size_t size);
+
+// Set the values of rows `row_ndx` to `row_ndx + chunk.length` of the
+// specified column through the public Table API
+void import_column(Table&, size_t col_ndx, size_t row_ndx, const ColumnChunk&);
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_COLUMN_CHUNK_HPP
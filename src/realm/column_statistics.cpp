@@ -0,0 +1,345 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/column_statistics.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <realm/column.hpp>
+#include <realm/table.hpp>
+#include <realm/impl/sequential_getter.hpp>
+
+using namespace realm;
+
+namespace {
+
+// Number of leading zero bits in the low `bits` bits of `value`, plus one.
+unsigned hll_rank(uint_least64_t value, unsigned bits) noexcept
+{
+    unsigned rank = 1;
+    uint_least64_t mask = uint_least64_t(1) << (bits - 1);
+    while (rank <= bits && (value & mask) == 0) {
+        ++rank;
+        mask >>= 1;
+    }
+    return rank;
+}
+
+bool is_null_value(int64_t) noexcept
+{
+    return false;
+}
+
+bool is_null_value(const util::Optional<int64_t>& value) noexcept
+{
+    return !value;
+}
+
+int64_t unwrap_value(int64_t value) noexcept
+{
+    return value;
+}
+
+int64_t unwrap_value(const util::Optional<int64_t>& value) noexcept
+{
+    return *value;
+}
+
+uint_least64_t hash_double(double value) noexcept
+{
+    // Make 0.0 and -0.0 hash identically, since they compare equal
+    if (value == 0)
+        value = 0;
+    uint_least64_t bits;
+    static_assert(sizeof(bits) == sizeof(value), "");
+    std::memcpy(&bits, &value, sizeof(bits));
+    return HyperLogLog::hash_int(bits);
+}
+
+// Collects the values of a numeric column. Every value is fed to the
+// distinct-count sketch, but only a systematic sample of at most
+// `ColumnStatistics::max_histogram_sample` values is retained for the
+// histogram, so that memory use is bounded regardless of the table size.
+class NumericCollector {
+public:
+    NumericCollector(ColumnStatistics& stats, size_t num_rows)
+        : m_stats(stats)
+        , m_step(num_rows / ColumnStatistics::max_histogram_sample + 1)
+    {
+        m_sample.reserve(std::min(num_rows, ColumnStatistics::max_histogram_sample + 1));
+    }
+
+    void add_null() noexcept
+    {
+        ++m_stats.null_count;
+        ++m_ndx;
+    }
+
+    void add(double value)
+    {
+        m_sketch.add_hash(hash_double(value));
+        if (std::isnan(value)) {
+            // NaN has no place in an ordering, so it is left out of the range
+            ++m_ndx;
+            return;
+        }
+        if (!m_stats.has_range) {
+            m_stats.has_range = true;
+            m_stats.min = m_stats.max = value;
+        }
+        else {
+            m_stats.min = std::min(m_stats.min, value);
+            m_stats.max = std::max(m_stats.max, value);
+        }
+        if (m_ndx % m_step == 0)
+            m_sample.push_back(value);
+        ++m_ndx;
+    }
+
+    void finish()
+    {
+        m_stats.distinct_count = size_t(m_sketch.estimate());
+        if (m_sample.empty())
+            return;
+
+        std::sort(m_sample.begin(), m_sample.end());
+        size_t buckets = std::min(ColumnStatistics::histogram_buckets, m_sample.size());
+        m_stats.histogram.reserve(buckets + 1);
+        for (size_t i = 0; i < buckets; ++i)
+            m_stats.histogram.push_back(m_sample[i * m_sample.size() / buckets]);
+        m_stats.histogram.push_back(m_stats.max);
+        // The true extremes may not have been sampled
+        m_stats.histogram.front() = m_stats.min;
+    }
+
+private:
+    ColumnStatistics& m_stats;
+    HyperLogLog m_sketch;
+    std::vector<double> m_sample;
+    size_t m_step;
+    size_t m_ndx = 0;
+};
+
+template <class ColType>
+void collect_integers(const Table& table, size_t col_ndx, ColumnStatistics& stats)
+{
+    size_t num_rows = table.size();
+    NumericCollector collector(stats, num_rows);
+    SequentialGetter<ColType> getter(table, col_ndx);
+    for (size_t s = 0; s < num_rows;) {
+        getter.cache_next(s);
+        size_t end_in_leaf = getter.local_end(num_rows);
+        for (size_t i = s - getter.m_leaf_start; i < end_in_leaf; ++i) {
+            auto value = getter.m_leaf_ptr->get(i);
+            if (is_null_value(value))
+                collector.add_null();
+            else
+                collector.add(double(unwrap_value(value)));
+        }
+        s = getter.m_leaf_start + end_in_leaf;
+    }
+    collector.finish();
+}
+
+template <class ColType>
+void collect_floats(const Table& table, size_t col_ndx, ColumnStatistics& stats)
+{
+    size_t num_rows = table.size();
+    bool nullable = table.is_nullable(col_ndx);
+    NumericCollector collector(stats, num_rows);
+    SequentialGetter<ColType> getter(table, col_ndx);
+    for (size_t s = 0; s < num_rows;) {
+        getter.cache_next(s);
+        size_t end_in_leaf = getter.local_end(num_rows);
+        for (size_t i = s - getter.m_leaf_start; i < end_in_leaf; ++i) {
+            auto value = getter.m_leaf_ptr->get(i);
+            if (nullable && null::is_null_float(value))
+                collector.add_null();
+            else
+                collector.add(double(value));
+        }
+        s = getter.m_leaf_start + end_in_leaf;
+    }
+    collector.finish();
+}
+
+template <class Getter>
+void collect_hashes(size_t num_rows, ColumnStatistics& stats, Getter&& get_hash)
+{
+    HyperLogLog sketch;
+    for (size_t i = 0; i < num_rows; ++i) {
+        uint_least64_t hash;
+        if (get_hash(i, hash))
+            sketch.add_hash(hash);
+        else
+            ++stats.null_count;
+    }
+    stats.distinct_count = size_t(sketch.estimate());
+}
+
+} // anonymous namespace
+
+
+constexpr unsigned HyperLogLog::precision;
+constexpr size_t HyperLogLog::num_registers;
+constexpr size_t ColumnStatistics::max_histogram_sample;
+constexpr size_t ColumnStatistics::histogram_buckets;
+
+void HyperLogLog::add_hash(uint_least64_t hash) noexcept
+{
+    constexpr unsigned value_bits = 64 - precision;
+    size_t ndx = size_t(hash >> value_bits);
+    uint8_t rank = uint8_t(hll_rank(hash & ((uint_least64_t(1) << value_bits) - 1), value_bits));
+    if (rank > m_registers[ndx])
+        m_registers[ndx] = rank;
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) noexcept
+{
+    for (size_t i = 0; i < num_registers; ++i)
+        m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+}
+
+uint_least64_t HyperLogLog::estimate() const noexcept
+{
+    const double m = double(num_registers);
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t r : m_registers) {
+        sum += std::ldexp(1.0, -int(r));
+        if (r == 0)
+            ++zeros;
+    }
+    double estimate = alpha * m * m / sum;
+
+    // Small range correction: linear counting is far more accurate while
+    // many registers are still empty.
+    if (estimate <= 2.5 * m && zeros != 0)
+        estimate = m * std::log(m / double(zeros));
+
+    return uint_least64_t(estimate + 0.5);
+}
+
+uint_least64_t HyperLogLog::hash_int(uint_least64_t x) noexcept
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+
+double ColumnStatistics::selectivity_equal(double value) const noexcept
+{
+    if (row_count == 0)
+        return 0;
+    if (has_range && (value < min || value > max))
+        return 0;
+    size_t distinct = std::max(distinct_count, size_t(1));
+    return non_null_fraction() / double(distinct);
+}
+
+double ColumnStatistics::selectivity_less(double value, bool inclusive) const noexcept
+{
+    if (!has_range || histogram.size() < 2)
+        return non_null_fraction();
+    if (value < min || (value == min && !inclusive))
+        return 0;
+    if (value > max || (value == max && inclusive))
+        return non_null_fraction();
+
+    // Locate the bucket containing `value` and interpolate linearly inside it
+    auto it = std::upper_bound(histogram.begin(), histogram.end(), value);
+    size_t bucket = size_t(it - histogram.begin());
+    bucket = std::min(std::max(bucket, size_t(1)), histogram.size() - 1) - 1;
+    double lo = histogram[bucket];
+    double hi = histogram[bucket + 1];
+    double within = hi > lo ? (value - lo) / (hi - lo) : (inclusive ? 1.0 : 0.0);
+    double buckets = double(histogram.size() - 1);
+    double fraction = (double(bucket) + within) / buckets;
+    return std::min(std::max(fraction, 0.0), 1.0) * non_null_fraction();
+}
+
+double ColumnStatistics::selectivity_greater(double value, bool inclusive) const noexcept
+{
+    double result = non_null_fraction() - selectivity_less(value, !inclusive);
+    return std::max(result, 0.0);
+}
+
+ColumnStatistics ColumnStatistics::compute(const Table& table, size_t col_ndx)
+{
+    ColumnStatistics stats;
+    stats.row_count = table.size();
+    if (stats.row_count == 0)
+        return stats;
+
+    switch (table.get_real_column_type(col_ndx)) {
+        case col_type_Int:
+        case col_type_Bool:
+        case col_type_OldDateTime:
+            if (table.is_nullable(col_ndx))
+                collect_integers<IntNullColumn>(table, col_ndx, stats);
+            else
+                collect_integers<IntegerColumn>(table, col_ndx, stats);
+            break;
+        case col_type_Float:
+            collect_floats<FloatColumn>(table, col_ndx, stats);
+            break;
+        case col_type_Double:
+            collect_floats<DoubleColumn>(table, col_ndx, stats);
+            break;
+        case col_type_String:
+        case col_type_StringEnum:
+            collect_hashes(stats.row_count, stats, [&](size_t row_ndx, uint_least64_t& hash) {
+                StringData value = table.get_string(col_ndx, row_ndx);
+                hash = HyperLogLog::hash_int(value.hash());
+                return !value.is_null();
+            });
+            break;
+        case col_type_Binary:
+            collect_hashes(stats.row_count, stats, [&](size_t row_ndx, uint_least64_t& hash) {
+                BinaryData value = table.get_binary(col_ndx, row_ndx);
+                auto data = reinterpret_cast<const unsigned char*>(value.data());
+                hash = HyperLogLog::hash_int(murmur2_or_cityhash(data, value.size()));
+                return !value.is_null();
+            });
+            break;
+        case col_type_Timestamp:
+            collect_hashes(stats.row_count, stats, [&](size_t row_ndx, uint_least64_t& hash) {
+                Timestamp value = table.get_timestamp(col_ndx, row_ndx);
+                if (value.is_null())
+                    return false;
+                hash = HyperLogLog::hash_int(uint_least64_t(value.get_seconds()) ^
+                                             HyperLogLog::hash_int(uint_least64_t(value.get_nanoseconds())));
+                return true;
+            });
+            break;
+        case col_type_Table:
+        case col_type_Mixed:
+        case col_type_Link:
+        case col_type_LinkList:
+        case col_type_BackLink:
+        case col_type_Reserved4:
+            break;
+    }
+    return stats;
+}
@@ -0,0 +1,108 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_COLUMN_STATISTICS_HPP
+#define REALM_COLUMN_STATISTICS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace realm {
+
+class Table;
+
+/// A HyperLogLog sketch for estimating the number of distinct values in a
+/// column. Values are added as 64-bit hashes; the caller is responsible for
+/// hashing them with a reasonably uniform hash function (see
+/// HyperLogLog::hash_int()).
+class HyperLogLog {
+public:
+    /// 2^precision registers. With 12 bits of precision the standard error of
+    /// the estimate is about 1.6%, at a cost of 4 KiB per sketch.
+    static constexpr unsigned precision = 12;
+    static constexpr size_t num_registers = size_t(1) << precision;
+
+    void add_hash(uint_least64_t hash) noexcept;
+    void merge(const HyperLogLog&) noexcept;
+    uint_least64_t estimate() const noexcept;
+
+    /// Finalizer of SplitMix64. Spreads the bits of integers with poor
+    /// entropy (such as sequential row keys) over the whole 64-bit range.
+    static uint_least64_t hash_int(uint_least64_t) noexcept;
+
+private:
+    std::array<uint8_t, num_registers> m_registers{};
+};
+
+/// Summary of the values in a single column, as collected by
+/// Table::analyze(). The query engine uses these to estimate the selectivity
+/// of conditions before it has had a chance to probe the column.
+///
+/// Range information (`min`, `max` and `histogram`) is only available for
+/// numeric columns (integer, boolean, float and double). It is kept in the
+/// double domain, so for integers outside +/-2^53 it is approximate. This is
+/// fine for cost estimation, but it must never be used to answer queries.
+struct ColumnStatistics {
+    size_t row_count = 0;
+    size_t null_count = 0;
+    /// Estimated number of distinct non-null values.
+    size_t distinct_count = 0;
+
+    bool has_range = false;
+    double min = 0;
+    double max = 0;
+
+    /// Bucket boundaries of an equi-depth histogram over the non-null
+    /// values. Each of the `histogram.size() - 1` buckets holds roughly the
+    /// same number of values. Empty if `has_range` is false.
+    std::vector<double> histogram;
+
+    /// Estimated fraction of all rows whose value equals \a value.
+    double selectivity_equal(double value) const noexcept;
+
+    /// Estimated fraction of all rows whose value is less than (or, if \a
+    /// inclusive, less than or equal to) \a value.
+    double selectivity_less(double value, bool inclusive) const noexcept;
+
+    /// Estimated fraction of all rows whose value is greater than (or, if \a
+    /// inclusive, greater than or equal to) \a value.
+    double selectivity_greater(double value, bool inclusive) const noexcept;
+
+    /// Fraction of all rows which are not null.
+    double non_null_fraction() const noexcept
+    {
+        return row_count == 0 ? 0.0 : double(row_count - null_count) / double(row_count);
+    }
+
+    /// Compute statistics for the specified column of \a table. Columns of
+    /// types that have no meaningful statistics (links, subtables, mixed)
+    /// only get `row_count` filled in.
+    static ColumnStatistics compute(const Table& table, size_t col_ndx);
+
+    /// Maximum number of values that are sampled to build the histogram.
+    static constexpr size_t max_histogram_sample = 1 << 16;
+
+    /// Number of buckets in the equi-depth histogram.
+    static constexpr size_t histogram_buckets = 32;
+};
+
+} // namespace realm
+
+#endif // REALM_COLUMN_STATISTICS_HPP
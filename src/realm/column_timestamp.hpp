@@ -19,11 +19,62 @@
 #ifndef REALM_COLUMN_TIMESTAMP_HPP
 #define REALM_COLUMN_TIMESTAMP_HPP
 
+#include <type_traits>
+
 #include <realm/column.hpp>
 #include <realm/timestamp.hpp>
+#include <realm/util/safe_int_ops.hpp>
 
 namespace realm {
 
+namespace _impl {
+
+// The condition on the seconds of a Timestamp which is implied by `Condition` on the whole value, or void if there
+// is none that narrows the search. As the vectorized integer search only supports == and strict inequalities, the
+// condition is also given as `strict_type`, to be checked against the seconds of the needle plus `offset`, such that
+// `seconds >= s` becomes `seconds > s - 1`.
+template <class Condition>
+struct TimestampSecondsCondition {
+    using type = void;
+};
+
+template <>
+struct TimestampSecondsCondition<Equal> {
+    using type = Equal;
+    using strict_type = Equal;
+    static constexpr int64_t offset = 0;
+};
+
+template <>
+struct TimestampSecondsCondition<Greater> {
+    using type = GreaterEqual;
+    using strict_type = Greater;
+    static constexpr int64_t offset = -1;
+};
+
+template <>
+struct TimestampSecondsCondition<GreaterEqual> {
+    using type = GreaterEqual;
+    using strict_type = Greater;
+    static constexpr int64_t offset = -1;
+};
+
+template <>
+struct TimestampSecondsCondition<Less> {
+    using type = LessEqual;
+    using strict_type = Less;
+    static constexpr int64_t offset = 1;
+};
+
+template <>
+struct TimestampSecondsCondition<LessEqual> {
+    using type = LessEqual;
+    using strict_type = Less;
+    static constexpr int64_t offset = 1;
+};
+
+} // namespace _impl
+
 // Inherits from ColumnTemplate to get a compare_values() that can be called without knowing the
 // column type
 class TimestampColumn : public ColumnBaseSimple {
@@ -101,16 +152,10 @@ public:
     template <class Condition>
     size_t find(Timestamp value, size_t begin, size_t end) const noexcept
     {
-        // FIXME: Here we can do all sorts of clever optimizations. Use bithack-search on seconds, then for each match
-        // check nanoseconds, etc. Lots of possibilities. Below code is naive and slow but works.
-
-        Condition cond;
-        for (size_t t = begin; t < end; t++) {
-            Timestamp ts = get(t);
-            if (cond(ts, value, ts.is_null(), value.is_null()))
-                return t;
-        }
-        return npos;
+        using SecondsCondition = typename _impl::TimestampSecondsCondition<Condition>::type;
+        if (value.is_null())
+            return find_naive<Condition>(value, begin, end);
+        return find_by_seconds<Condition, SecondsCondition>(value, begin, end, std::is_void<SecondsCondition>());
     }
 
     void find_all(IntegerColumn& result, Timestamp value, size_t begin, size_t end) const
@@ -135,33 +180,152 @@ private:
     class CreateHandler;
 
     template <class Condition>
-    Timestamp minmax(size_t* result_index) const noexcept
+    size_t find_naive(Timestamp value, size_t begin, size_t end) const noexcept
     {
-        // Condition is realm::Greater for maximum and realm::Less for minimum. Any non-null value is both larger
-        // and smaller than a null value.
-        if (size() == 0) {
-            if (result_index)
-                *result_index = npos;
-            return Timestamp{};
+        Condition cond;
+        for (size_t t = begin; t < end; t++) {
+            Timestamp ts = get(t);
+            if (cond(ts, value, ts.is_null(), value.is_null()))
+                return t;
         }
+        return npos;
+    }
+
+    template <class Condition, class SecondsCondition>
+    size_t find_by_seconds(Timestamp value, size_t begin, size_t end, std::true_type) const noexcept
+    {
+        return find_naive<Condition>(value, begin, end);
+    }
+
+    // Search the seconds leaf by leaf, using a condition that every match of `Condition` also satisfies. A candidate
+    // whose seconds differ from those of the needle is a match, and the nanoseconds only need to be read when they
+    // are equal.
+    //
+    // The leaf is searched with the vectorized integer search for the strict condition where possible. It compares
+    // a null as the integer representing it, so a null may be a candidate, but never a match, as the needle is not
+    // null. Where that integer satisfies the condition, typically for > as nulls are represented by the upper bound
+    // of the leaf, and the range holds nulls, the nullable search, which checks one row at a time, is used instead
+    // rather than stopping at every null.
+    template <class Condition, class SecondsCondition>
+    size_t find_by_seconds(Timestamp value, size_t begin, size_t end, std::false_type) const noexcept
+    {
+        using LeafType = BpTree<util::Optional<int64_t>>::LeafType;
+        using StrictSecondsCondition = typename _impl::TimestampSecondsCondition<Condition>::strict_type;
+        LeafType cache(get_alloc());
+        int64_t needle_seconds = value.get_seconds();
+        int64_t bound = needle_seconds;
+        if (util::int_add_with_overflow_detect(bound, _impl::TimestampSecondsCondition<Condition>::offset))
+            return find_naive<Condition>(value, begin, end);
+        Condition cond;
+        StrictSecondsCondition strict_cond;
 
-        Timestamp best = get(0);
-        size_t best_index = best.is_null() ? npos : 0;
+        while (begin < end) {
+            const LeafType* leaf = nullptr;
+            BpTree<util::Optional<int64_t>>::LeafInfo info{&leaf, &cache};
+            size_t ndx_in_leaf;
+            m_seconds->get_leaf(begin, ndx_in_leaf, info);
+            size_t leaf_start = begin - ndx_in_leaf;
+            size_t leaf_end = std::min(leaf->size(), end - leaf_start);
 
-        for (size_t i = 1; i < size(); ++i) {
-            Timestamp candidate = get(i);
-            // Condition() will return false if any of the two values are null.
-            if ((best.is_null() && !candidate.is_null()) || Condition()(candidate, best, candidate.is_null(), best.is_null())) {
-                best = candidate;
-                best_index = i;
+            bool vectorized = !strict_cond(leaf->null_value(), bound) ||
+                              leaf->find_first(util::none, ndx_in_leaf, leaf_end) == not_found;
+            size_t i = ndx_in_leaf;
+            while (i < leaf_end) {
+                if (vectorized)
+                    i = leaf->template find_first_including_nulls<StrictSecondsCondition>(bound, i, leaf_end);
+                else
+                    i = leaf->template find_first<SecondsCondition>(needle_seconds, i, leaf_end);
+                if (i == not_found)
+                    break;
+                util::Optional<int64_t> seconds = leaf->get(i);
+                if (seconds) {
+                    if (*seconds != needle_seconds)
+                        return leaf_start + i;
+                    Timestamp ts(*seconds, int32_t(m_nanoseconds->get(leaf_start + i)));
+                    if (cond(ts, value, false, false))
+                        return leaf_start + i;
+                }
+                ++i;
             }
+            begin = leaf_start + leaf_end;
         }
-        if (result_index)
-            *result_index = best_index;
-        return best;
+        return npos;
     }
+
+    template <class Condition>
+    Timestamp minmax(size_t* result_index) const noexcept;
 };
 
+/// Reads the values of a TimestampColumn through cached leaves of its seconds and nanoseconds B+trees, so that
+/// reading rows in increasing order only costs a B+tree lookup when crossing into another leaf.
+class TimestampLeafCache {
+public:
+    explicit TimestampLeafCache(const TimestampColumn& column)
+        : m_column(column)
+        , m_seconds_cache(column.get_alloc())
+        , m_nanoseconds_cache(column.get_alloc())
+    {
+    }
+
+    Timestamp get(size_t row_ndx) noexcept
+    {
+        if (row_ndx < m_seconds_begin || row_ndx >= m_seconds_end) {
+            size_t ndx_in_leaf;
+            IntNullColumn::LeafInfo info{&m_seconds, &m_seconds_cache};
+            m_column.get_seconds_leaf(row_ndx, ndx_in_leaf, info);
+            m_seconds_begin = row_ndx - ndx_in_leaf;
+            m_seconds_end = m_seconds_begin + m_seconds->size();
+        }
+        util::Optional<int64_t> seconds = m_seconds->get(row_ndx - m_seconds_begin);
+        if (!seconds)
+            return Timestamp{};
+
+        if (row_ndx < m_nanoseconds_begin || row_ndx >= m_nanoseconds_end) {
+            size_t ndx_in_leaf;
+            IntegerColumn::LeafInfo info{&m_nanoseconds, &m_nanoseconds_cache};
+            m_column.get_nanoseconds_leaf(row_ndx, ndx_in_leaf, info);
+            m_nanoseconds_begin = row_ndx - ndx_in_leaf;
+            m_nanoseconds_end = m_nanoseconds_begin + m_nanoseconds->size();
+        }
+        return Timestamp(*seconds, int32_t(m_nanoseconds->get(row_ndx - m_nanoseconds_begin)));
+    }
+
+private:
+    const TimestampColumn& m_column;
+    IntNullColumn::LeafType m_seconds_cache;
+    IntegerColumn::LeafType m_nanoseconds_cache;
+    const IntNullColumn::LeafType* m_seconds = nullptr;
+    const IntegerColumn::LeafType* m_nanoseconds = nullptr;
+    size_t m_seconds_begin = 0;
+    size_t m_seconds_end = 0;
+    size_t m_nanoseconds_begin = 0;
+    size_t m_nanoseconds_end = 0;
+};
+
+template <class Condition>
+Timestamp TimestampColumn::minmax(size_t* result_index) const noexcept
+{
+    // Condition is realm::Greater for maximum and realm::Less for minimum. Any non-null value is both larger
+    // and smaller than a null value.
+    TimestampLeafCache cache(*this);
+    Timestamp best;
+    size_t best_index = npos;
+
+    size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        Timestamp candidate = cache.get(i);
+        // Condition() will return false if any of the two values are null.
+        if ((best_index == npos && !candidate.is_null()) ||
+            Condition()(candidate, best, candidate.is_null(), best.is_null())) {
+            best = candidate;
+            best_index = i;
+        }
+    }
+    if (result_index)
+        *result_index = best_index;
+    return best;
+}
+
 } // namespace realm
 
 #endif // REALM_COLUMN_TIMESTAMP_HPP
@@ -1,15 +1,122 @@
 #include <realm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
 
+namespace {
+
+// Table names may contain any character, so the characters which are special in paths are percent-encoded, as is a
+// leading dot, so that no table name can refer to a file outside the output directory.
+std::string get_file_name(const std::string& table_name)
+{
+    std::string file_name;
+    for (size_t i = 0; i < table_name.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(table_name[i]);
+        if (c < 0x20 || c == '/' || c == '\\' || c == ':' || c == '%' || (i == 0 && c == '.')) {
+            char encoded[4];
+            snprintf(encoded, sizeof encoded, "%%%02X", unsigned(c));
+            file_name += encoded;
+        }
+        else {
+            file_name += char(c);
+        }
+    }
+    return file_name + ".json";
+}
+
+// Export every table of the file into `<dir>/<table name>.json`. Each thread opens the file on its own, since
+// accessors cannot be shared between threads, and then exports tables until there are none left. Returns false if
+// any table could not be exported.
+bool export_tables(const char* path, size_t link_depth, const std::string& dir)
+{
+    size_t num_tables;
+    try {
+        num_tables = realm::Group(path).size();
+    }
+    catch (const std::exception& e) {
+        std::cerr << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    std::atomic<size_t> next_table(0);
+    std::mutex progress_mutex;
+    size_t num_done = 0;
+    size_t num_exported = 0;
+
+    auto worker = [&] {
+        try {
+            realm::Group g(path);
+            std::map<std::string, std::string> renames;
+            for (size_t i = next_table++; i < num_tables; i = next_table++) {
+                std::string name = g.get_table_name(i);
+                std::string error;
+                size_t num_rows = 0;
+                try {
+                    realm::ConstTableRef table = g.get_table(i);
+                    num_rows = table->size();
+                    std::ofstream out(dir + "/" + get_file_name(name));
+                    table->to_json(out, link_depth, &renames);
+                    out.close();
+                    if (!out)
+                        error = "write failed";
+                }
+                catch (const std::exception& e) {
+                    error = e.what();
+                }
+
+                std::lock_guard<std::mutex> lock(progress_mutex);
+                ++num_done;
+                if (error.empty())
+                    ++num_exported;
+                std::cerr << "[" << num_done << "/" << num_tables << "] " << name << ": " << num_rows << " rows"
+                          << (error.empty() ? "" : " (" + error + ")") << std::endl;
+            }
+        }
+        catch (const std::exception& e) {
+            // The tables this thread would have exported are left to the others
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            std::cerr << path << ": " << e.what() << std::endl;
+        }
+    };
+
+    size_t num_threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), num_tables));
+    std::vector<std::thread> threads;
+    try {
+        for (size_t i = 1; i < num_threads; ++i)
+            threads.emplace_back(worker);
+    }
+    catch (const std::system_error&) {
+        // Make do with the threads which could be started
+    }
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+    return num_exported == num_tables;
+}
+
+} // anonymous namespace
+
+// Usage: realm2json <file> [link depth] [output directory]
+//
+// Without an output directory, the whole file is written to stdout as a single JSON object. With one, the tables
+// are exported in parallel, each into its own file in that directory.
 int main(int argc, char const* argv[])
 {
     if (argc > 1) {
-        realm::Group g(argv[1]);
         size_t link_depth = 0;
         std::map<std::string, std::string> renames;
         if (argc > 2) {
             link_depth = strtol(argv[2], nullptr, 0);
         }
+        if (argc > 3) {
+            return export_tables(argv[1], link_depth, argv[3]) ? 0 : 1;
+        }
+        realm::Group g(argv[1]);
         g.to_json(std::cout, link_depth, &renames);
     }
     return 0;
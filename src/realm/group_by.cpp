@@ -0,0 +1,560 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/group_by.hpp>
+
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include <realm/column.hpp>
+#include <realm/column_string.hpp>
+#include <realm/column_string_enum.hpp>
+#include <realm/column_timestamp.hpp>
+#include <realm/exceptions.hpp>
+#include <realm/table.hpp>
+
+using namespace realm;
+
+namespace {
+
+// Reads a Column<T> through a cached leaf
+template <class ColType>
+class LeafCache {
+public:
+    using LeafType = typename ColType::LeafType;
+
+    explicit LeafCache(const ColType& column)
+        : m_column(column)
+        , m_cache(column.get_alloc())
+    {
+    }
+
+    auto get(size_t row_ndx) noexcept -> decltype(std::declval<const LeafType&>().get(0))
+    {
+        if (row_ndx < m_begin || row_ndx >= m_end) {
+            size_t ndx_in_leaf;
+            typename ColType::LeafInfo info{&m_leaf, &m_cache};
+            m_column.get_leaf(row_ndx, ndx_in_leaf, info);
+            m_begin = row_ndx - ndx_in_leaf;
+            m_end = m_begin + m_leaf->size();
+        }
+        return m_leaf->get(row_ndx - m_begin);
+    }
+
+private:
+    const ColType& m_column;
+    LeafType m_cache;
+    const LeafType* m_leaf = nullptr;
+    size_t m_begin = 0;
+    size_t m_end = 0;
+};
+
+void append_int(std::string& buf, bool is_null, int64_t value)
+{
+    char bytes[1 + sizeof value];
+    bytes[0] = is_null ? 1 : 0;
+    std::memcpy(bytes + 1, &value, sizeof value);
+    buf.append(bytes, sizeof bytes);
+}
+
+bool is_null_value(const util::Optional<int64_t>& v)
+{
+    return !v;
+}
+
+bool is_null_value(int64_t)
+{
+    return false;
+}
+
+bool is_null_value(float v)
+{
+    return null::is_null_float(v);
+}
+
+bool is_null_value(double v)
+{
+    return null::is_null_float(v);
+}
+
+template <class T>
+T unwrap(const util::Optional<T>& v)
+{
+    return *v;
+}
+
+template <class T>
+T unwrap(T v)
+{
+    return v;
+}
+
+} // anonymous namespace
+
+namespace realm {
+namespace _impl {
+
+class GroupKeyReader {
+public:
+    virtual ~GroupKeyReader() noexcept
+    {
+    }
+
+    // Append an encoding of the key of the specified row to `buf`. Rows have the same encoding if and only if
+    // they belong to the same group.
+    virtual void encode(size_t row_ndx, std::string& buf) = 0;
+
+    // Add the key of the specified row, which is the first row of a new group, to `out`
+    virtual void emit(size_t row_ndx, GroupByResult::KeyColumn& out) = 0;
+};
+
+class GroupAggregator {
+public:
+    virtual ~GroupAggregator() noexcept
+    {
+    }
+
+    virtual void add_group() = 0;
+    virtual void accumulate(size_t group_ndx, size_t row_ndx) = 0;
+    virtual void finish(GroupByResult::AggregateColumn& out) = 0;
+};
+
+} // namespace _impl
+} // namespace realm
+
+namespace {
+
+using GroupKeyReader = _impl::GroupKeyReader;
+using GroupAggregator = _impl::GroupAggregator;
+
+// Integer, boolean and OldDateTime keys
+template <class ColType>
+class IntKeyReader : public GroupKeyReader {
+public:
+    explicit IntKeyReader(const ColType& column)
+        : m_leaf(column)
+    {
+    }
+
+    void encode(size_t row_ndx, std::string& buf) override
+    {
+        auto v = m_leaf.get(row_ndx);
+        bool is_null = is_null_value(v);
+        append_int(buf, is_null, is_null ? 0 : unwrap(v));
+    }
+
+    void emit(size_t row_ndx, GroupByResult::KeyColumn& out) override
+    {
+        auto v = m_leaf.get(row_ndx);
+        bool is_null = is_null_value(v);
+        out.ints.push_back(is_null ? 0 : unwrap(v));
+        out.nulls.push_back(is_null);
+    }
+
+private:
+    LeafCache<ColType> m_leaf;
+};
+
+class LinkKeyReader : public GroupKeyReader {
+public:
+    explicit LinkKeyReader(const IntegerColumn& column)
+        : m_leaf(column)
+    {
+    }
+
+    void encode(size_t row_ndx, std::string& buf) override
+    {
+        // Links are stored as the target row index plus one, with zero meaning null
+        int64_t v = m_leaf.get(row_ndx);
+        append_int(buf, v == 0, v);
+    }
+
+    void emit(size_t row_ndx, GroupByResult::KeyColumn& out) override
+    {
+        int64_t v = m_leaf.get(row_ndx);
+        out.ints.push_back(v == 0 ? 0 : v - 1);
+        out.nulls.push_back(v == 0);
+    }
+
+private:
+    LeafCache<IntegerColumn> m_leaf;
+};
+
+class TimestampKeyReader : public GroupKeyReader {
+public:
+    TimestampKeyReader(const TimestampColumn& column, int64_t bucket_seconds)
+        : m_leaf(column)
+        , m_bucket_seconds(bucket_seconds)
+    {
+    }
+
+    void encode(size_t row_ndx, std::string& buf) override
+    {
+        Timestamp ts = m_leaf.get(row_ndx);
+        append_int(buf, ts.is_null(), ts.is_null() ? 0 : bucket(ts));
+    }
+
+    void emit(size_t row_ndx, GroupByResult::KeyColumn& out) override
+    {
+        Timestamp ts = m_leaf.get(row_ndx);
+        out.ints.push_back(ts.is_null() ? 0 : bucket(ts));
+        out.nulls.push_back(ts.is_null());
+    }
+
+private:
+    TimestampLeafCache m_leaf;
+    int64_t m_bucket_seconds;
+
+    // Start of the bucket containing `ts`, rounding towards minus infinity
+    int64_t bucket(Timestamp ts) const noexcept
+    {
+        int64_t seconds = ts.get_seconds();
+        int64_t rem = seconds % m_bucket_seconds;
+        if (rem < 0)
+            rem += m_bucket_seconds;
+        return seconds - rem;
+    }
+};
+
+class StringKeyReader : public GroupKeyReader {
+public:
+    explicit StringKeyReader(const StringColumn& column)
+        : m_column(column)
+    {
+    }
+
+    void encode(size_t row_ndx, std::string& buf) override
+    {
+        StringData str = m_column.get(row_ndx);
+        append_int(buf, str.is_null(), int64_t(str.size()));
+        buf.append(str.data(), str.size());
+    }
+
+    void emit(size_t row_ndx, GroupByResult::KeyColumn& out) override
+    {
+        StringData str = m_column.get(row_ndx);
+        out.strings.push_back(str.is_null() ? std::string() : std::string(str));
+        out.nulls.push_back(str.is_null());
+    }
+
+private:
+    const StringColumn& m_column;
+};
+
+// Auto-enumerated strings are grouped by the index of their key, so the strings themselves are only read once
+// for each group
+class StringEnumKeyReader : public GroupKeyReader {
+public:
+    explicit StringEnumKeyReader(const StringEnumColumn& column)
+        : m_column(column)
+        , m_leaf(column)
+    {
+    }
+
+    void encode(size_t row_ndx, std::string& buf) override
+    {
+        append_int(buf, false, m_leaf.get(row_ndx));
+    }
+
+    void emit(size_t row_ndx, GroupByResult::KeyColumn& out) override
+    {
+        StringData str = m_column.get_keys().get(size_t(m_leaf.get(row_ndx)));
+        out.strings.push_back(str.is_null() ? std::string() : std::string(str));
+        out.nulls.push_back(str.is_null());
+    }
+
+private:
+    const StringEnumColumn& m_column;
+    LeafCache<IntegerColumn> m_leaf;
+};
+
+class CountAggregator : public GroupAggregator {
+public:
+    // Counts all rows if `col_ndx` is npos
+    CountAggregator(const Table& table, size_t col_ndx)
+        : m_table(table)
+        , m_col_ndx(col_ndx)
+    {
+    }
+
+    void add_group() override
+    {
+        m_counts.push_back(0);
+    }
+
+    void accumulate(size_t group_ndx, size_t row_ndx) override
+    {
+        if (m_col_ndx == npos || !m_table.is_null(m_col_ndx, row_ndx))
+            ++m_counts[group_ndx];
+    }
+
+    void finish(GroupByResult::AggregateColumn& out) override
+    {
+        out.ints = std::move(m_counts);
+        out.nulls.assign(out.ints.size(), false);
+    }
+
+private:
+    const Table& m_table;
+    size_t m_col_ndx;
+    std::vector<int64_t> m_counts;
+};
+
+// Sum, minimum, maximum and average of an integer, float or double column. `R` is the type the values are
+// accumulated in.
+template <class ColType, class R>
+class NumericAggregator : public GroupAggregator {
+public:
+    NumericAggregator(const ColType& column, GroupAggregate::Type type)
+        : m_leaf(column)
+        , m_type(type)
+    {
+    }
+
+    void add_group() override
+    {
+        m_values.push_back(R());
+        m_counts.push_back(0);
+    }
+
+    void accumulate(size_t group_ndx, size_t row_ndx) override
+    {
+        auto v = m_leaf.get(row_ndx);
+        if (is_null_value(v))
+            return;
+        R value = R(unwrap(v));
+        R& acc = m_values[group_ndx];
+        size_t& count = m_counts[group_ndx];
+        switch (m_type) {
+            case GroupAggregate::sum:
+            case GroupAggregate::average:
+                acc += value;
+                break;
+            case GroupAggregate::minimum:
+                if (count == 0 || value < acc)
+                    acc = value;
+                break;
+            case GroupAggregate::maximum:
+                if (count == 0 || value > acc)
+                    acc = value;
+                break;
+            case GroupAggregate::count:
+                REALM_UNREACHABLE();
+        }
+        ++count;
+    }
+
+    void finish(GroupByResult::AggregateColumn& out) override
+    {
+        size_t num_groups = m_values.size();
+        out.nulls.resize(num_groups);
+        for (size_t i = 0; i < num_groups; ++i)
+            out.nulls[i] = m_type != GroupAggregate::sum && m_counts[i] == 0;
+
+        if (m_type == GroupAggregate::average) {
+            out.doubles.resize(num_groups);
+            for (size_t i = 0; i < num_groups; ++i)
+                out.doubles[i] = m_counts[i] == 0 ? 0.0 : double(m_values[i]) / double(m_counts[i]);
+        }
+        else {
+            store(out);
+        }
+    }
+
+private:
+    LeafCache<ColType> m_leaf;
+    GroupAggregate::Type m_type;
+    std::vector<R> m_values;
+    std::vector<size_t> m_counts;
+
+    void store(GroupByResult::AggregateColumn& out)
+    {
+        if (std::is_integral<R>::value)
+            out.ints.assign(m_values.begin(), m_values.end());
+        else
+            out.doubles.assign(m_values.begin(), m_values.end());
+    }
+};
+
+// Type of the result column for a key of the specified column type
+DataType get_key_type(ColumnType type, const GroupKey& key)
+{
+    switch (type) {
+        case col_type_Int:
+        case col_type_Bool:
+        case col_type_OldDateTime:
+            return type_Int;
+        case col_type_Link:
+            return type_Link;
+        case col_type_Timestamp:
+            if (key.bucket_seconds <= 0)
+                throw LogicError(LogicError::illegal_combination);
+            return type_Timestamp;
+        case col_type_String:
+        case col_type_StringEnum:
+            return type_String;
+        default:
+            throw LogicError(LogicError::illegal_type);
+    }
+}
+
+// Type of the result column for an aggregate of the specified column type
+DataType get_aggregate_type(ColumnType type, GroupAggregate::Type aggr)
+{
+    if (aggr == GroupAggregate::count)
+        return type_Int;
+    switch (type) {
+        case col_type_Int:
+            return aggr == GroupAggregate::average ? type_Double : type_Int;
+        case col_type_Float:
+        case col_type_Double:
+            return type_Double;
+        default:
+            throw LogicError(LogicError::type_mismatch);
+    }
+}
+
+std::unique_ptr<GroupKeyReader> make_key_reader(ColumnType type, bool nullable, const ColumnBase& column,
+                                                const GroupKey& key)
+{
+    switch (type) {
+        case col_type_Int:
+        case col_type_Bool:
+        case col_type_OldDateTime:
+            if (nullable)
+                return std::unique_ptr<GroupKeyReader>(
+                    new IntKeyReader<IntNullColumn>(static_cast<const IntNullColumn&>(column)));
+            return std::unique_ptr<GroupKeyReader>(
+                new IntKeyReader<IntegerColumn>(static_cast<const IntegerColumn&>(column)));
+        case col_type_Link:
+            return std::unique_ptr<GroupKeyReader>(new LinkKeyReader(static_cast<const IntegerColumn&>(column)));
+        case col_type_Timestamp:
+            return std::unique_ptr<GroupKeyReader>(
+                new TimestampKeyReader(static_cast<const TimestampColumn&>(column), key.bucket_seconds));
+        case col_type_String:
+            return std::unique_ptr<GroupKeyReader>(new StringKeyReader(static_cast<const StringColumn&>(column)));
+        case col_type_StringEnum:
+            return std::unique_ptr<GroupKeyReader>(
+                new StringEnumKeyReader(static_cast<const StringEnumColumn&>(column)));
+        default:
+            throw LogicError(LogicError::illegal_type);
+    }
+}
+
+std::unique_ptr<GroupAggregator> make_aggregator(ColumnType type, bool nullable, const ColumnBase& column,
+                                                 const GroupAggregate& aggr)
+{
+    REALM_ASSERT(aggr.type != GroupAggregate::count);
+    switch (type) {
+        case col_type_Int:
+            if (nullable)
+                return std::unique_ptr<GroupAggregator>(new NumericAggregator<IntNullColumn, int64_t>(
+                    static_cast<const IntNullColumn&>(column), aggr.type));
+            return std::unique_ptr<GroupAggregator>(
+                new NumericAggregator<IntegerColumn, int64_t>(static_cast<const IntegerColumn&>(column), aggr.type));
+        case col_type_Float:
+            return std::unique_ptr<GroupAggregator>(
+                new NumericAggregator<FloatColumn, double>(static_cast<const FloatColumn&>(column), aggr.type));
+        case col_type_Double:
+            return std::unique_ptr<GroupAggregator>(
+                new NumericAggregator<DoubleColumn, double>(static_cast<const DoubleColumn&>(column), aggr.type));
+        default:
+            throw LogicError(LogicError::type_mismatch);
+    }
+}
+
+} // anonymous namespace
+
+namespace realm {
+namespace _impl {
+
+GroupByBuilder::GroupByBuilder(const Table& table, const std::vector<GroupKey>& keys,
+                               const std::vector<GroupAggregate>& aggregates)
+{
+    // A degenerate table has no rows and no column accessors to read from
+    bool degenerate = table.is_degenerate();
+    size_t num_cols = table.get_column_count();
+    for (const GroupKey& key : keys) {
+        if (key.col_ndx >= num_cols)
+            throw LogicError(LogicError::column_index_out_of_range);
+        ColumnType type = table.get_real_column_type(key.col_ndx);
+        m_result.m_keys.emplace_back();
+        m_result.m_keys.back().type = get_key_type(type, key); // Throws
+        if (!degenerate)
+            m_keys.push_back(make_key_reader(type, table.is_nullable(key.col_ndx),
+                                             table.get_column_base(key.col_ndx), key)); // Throws
+    }
+    for (const GroupAggregate& aggr : aggregates) {
+        if (aggr.col_ndx != npos || aggr.type != GroupAggregate::count) {
+            if (aggr.col_ndx >= num_cols)
+                throw LogicError(LogicError::column_index_out_of_range);
+        }
+        ColumnType type = aggr.col_ndx == npos ? col_type_Int : table.get_real_column_type(aggr.col_ndx);
+        m_result.m_aggregates.emplace_back();
+        m_result.m_aggregates.back().type = get_aggregate_type(type, aggr.type); // Throws
+        if (degenerate)
+            continue;
+        if (aggr.type == GroupAggregate::count) {
+            m_aggregators.emplace_back(new CountAggregator(table, aggr.col_ndx));
+        }
+        else {
+            m_aggregators.push_back(make_aggregator(type, table.is_nullable(aggr.col_ndx),
+                                                    table.get_column_base(aggr.col_ndx), aggr)); // Throws
+        }
+    }
+}
+
+GroupByBuilder::~GroupByBuilder() noexcept
+{
+}
+
+void GroupByBuilder::add(size_t row_ndx)
+{
+    m_encoded_key.clear();
+    for (auto& key : m_keys)
+        key->encode(row_ndx, m_encoded_key);
+
+    size_t group_ndx;
+    auto it = m_groups.find(m_encoded_key);
+    if (it != m_groups.end()) {
+        group_ndx = it->second;
+    }
+    else {
+        group_ndx = m_result.m_size++;
+        m_groups.emplace(m_encoded_key, group_ndx);
+        for (size_t i = 0; i < m_keys.size(); ++i)
+            m_keys[i]->emit(row_ndx, m_result.m_keys[i]);
+        for (auto& aggr : m_aggregators)
+            aggr->add_group();
+    }
+
+    for (auto& aggr : m_aggregators)
+        aggr->accumulate(group_ndx, row_ndx);
+}
+
+GroupByResult GroupByBuilder::finish()
+{
+    for (size_t i = 0; i < m_aggregators.size(); ++i)
+        m_aggregators[i]->finish(m_result.m_aggregates[i]);
+    m_groups.clear();
+    return std::move(m_result);
+}
+
+} // namespace _impl
+} // namespace realm
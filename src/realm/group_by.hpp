@@ -0,0 +1,149 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_GROUP_BY_HPP
+#define REALM_GROUP_BY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <realm/data_type.hpp>
+
+namespace realm {
+
+class Table;
+
+namespace _impl {
+class GroupByBuilder;
+}
+
+/// A column to group rows by in Table::group_by(), TableViewBase::group_by()
+/// and Query::group_by().
+///
+/// Integer, boolean, OldDateTime, string, link and Timestamp columns can be
+/// used as keys. Rows with a null value form a group of their own. Rows are
+/// grouped by the target row of a link column, and Timestamp keys are
+/// grouped into buckets of `bucket_seconds` seconds, which must be positive.
+struct GroupKey {
+    size_t col_ndx;
+    int64_t bucket_seconds = 0;
+};
+
+/// An aggregate computed for every group.
+///
+/// `count` counts the rows of the group if `col_ndx` is `npos`, and the rows
+/// whose value in `col_ndx` is not null otherwise. The other operations take
+/// an integer, float or double column and ignore null values.
+struct GroupAggregate {
+    enum Type {
+        count,
+        sum,
+        minimum,
+        maximum,
+        average,
+    };
+
+    Type type;
+    size_t col_ndx;
+};
+
+/// The result of a grouped aggregation, in columnar form. There is one
+/// entry per group in every key and aggregate column, in the order in which
+/// the groups were first encountered.
+class GroupByResult {
+public:
+    struct KeyColumn {
+        /// type_Int for integer, boolean and OldDateTime keys, type_String
+        /// for strings, type_Link for links (`ints` holds the target row
+        /// index) and type_Timestamp for Timestamp keys (`ints` holds the
+        /// start of the bucket in seconds).
+        DataType type;
+        std::vector<int64_t> ints;
+        std::vector<std::string> strings;
+        std::vector<bool> nulls;
+    };
+
+    struct AggregateColumn {
+        /// type_Int if the values are in `ints`, type_Double if they are in
+        /// `doubles`. Counts, and sums, minimums and maximums of integer
+        /// columns are integers. Everything else is a double.
+        DataType type;
+        std::vector<int64_t> ints;
+        std::vector<double> doubles;
+        /// True for groups without any non-null values to aggregate, except
+        /// for counts and sums, which are then zero.
+        std::vector<bool> nulls;
+    };
+
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    const KeyColumn& key(size_t key_ndx) const noexcept
+    {
+        return m_keys[key_ndx];
+    }
+
+    const AggregateColumn& aggregate(size_t aggregate_ndx) const noexcept
+    {
+        return m_aggregates[aggregate_ndx];
+    }
+
+private:
+    size_t m_size = 0;
+    std::vector<KeyColumn> m_keys;
+    std::vector<AggregateColumn> m_aggregates;
+
+    friend class _impl::GroupByBuilder;
+};
+
+namespace _impl {
+
+class GroupKeyReader;
+class GroupAggregator;
+
+// Hash aggregation over rows of a table which are added one at a time. The
+// values are read through cached B+tree leaves, so adding rows in
+// increasing order only costs a B+tree lookup when crossing into another
+// leaf.
+class GroupByBuilder {
+public:
+    GroupByBuilder(const Table&, const std::vector<GroupKey>&, const std::vector<GroupAggregate>&);
+    ~GroupByBuilder() noexcept;
+
+    void add(size_t row_ndx);
+    GroupByResult finish();
+
+private:
+    std::vector<std::unique_ptr<GroupKeyReader>> m_keys;
+    std::vector<std::unique_ptr<GroupAggregator>> m_aggregators;
+    // Maps the encoded keys of each group to the index of the group
+    std::unordered_map<std::string, size_t> m_groups;
+    std::string m_encoded_key;
+    GroupByResult m_result;
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_GROUP_BY_HPP
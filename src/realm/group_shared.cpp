@@ -38,6 +38,7 @@
 #include <realm/link_view.hpp>
 #include <realm/replication.hpp>
 #include <realm/impl/simulated_failure.hpp>
+#include <realm/impl/snapshot_copier.hpp>
 #include <realm/disable_sync_to_disk.hpp>
 
 #ifndef _WIN32
@@ -59,12 +60,6 @@ using Durability = SharedGroupOptions::Durability;
 
 namespace {
 
-// Constants controlling the amount of uncommited writes in flight:
-#ifdef REALM_ASYNC_DAEMON
-const uint16_t max_write_slots = 100;
-const uint16_t relaxed_sync_threshold = 50;
-#endif
-
 // value   change
 // --------------------
 //  4      Unknown
@@ -78,7 +73,14 @@ const uint16_t relaxed_sync_threshold = 50;
 //  9      Fair write transactions requires an additional condition variable,
 //         `write_fairness`
 // 10      Introducing SharedInfo::history_schema_version.
-const uint_fast16_t g_shared_info_version = 10;
+// 11      Asynchronous commits are made durable by a thread of each session
+//         participant instead of by the realmd daemon. Introducing
+//         `durable_version`. `free_write_slots`, `daemon_started`,
+//         `daemon_ready` and the condition variables used to coordinate with
+//         the daemon are gone.
+// 12      Introducing `Ringbuffer::ReadCount::commit_time` and
+//         `invalidated_version`.
+const uint_fast16_t g_shared_info_version = 12;
 
 // The following functions are carefully designed for minimal overhead
 // in case of contention among read transactions. In case of contention,
@@ -180,6 +182,12 @@ inline void atomic_double_dec(std::atomic<T>& counter)
     counter.fetch_sub(2, std::memory_order_release);
 }
 
+uint64_t milliseconds_since_epoch() noexcept
+{
+    using namespace std::chrono;
+    return uint64_t(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+}
+
 template <typename T>
 bool atomic_one_if_zero(std::atomic<T>& counter)
 {
@@ -216,6 +224,8 @@ public:
         uint64_t version;
         uint64_t filesize;
         uint64_t current_top;
+        // Milliseconds since the epoch of the system clock
+        uint64_t commit_time;
         // The count field acts as synchronization point for accesses to the above
         // fields. A succesfull inc implies acquire with regard to memory consistency.
         // Release is triggered by explicitly storing into count whenever a
@@ -232,6 +242,7 @@ public:
             data[i].count.store(1, std::memory_order_relaxed);
             data[i].current_top = 0;
             data[i].filesize = 0;
+            data[i].commit_time = 0;
             data[i].next = i + 1;
         }
         old_pos = 0;
@@ -266,6 +277,7 @@ public:
             data[i].count.store(1, std::memory_order_relaxed);
             data[i].current_top = 0;
             data[i].filesize = 0;
+            data[i].commit_time = 0;
             data[i].next = i + 1;
         }
         data[new_entries - 1].next = old_pos;
@@ -321,9 +333,14 @@ public:
         return r;
     }
 
+    uint_fast32_t oldest() const noexcept
+    {
+        return old_pos.load(std::memory_order_relaxed);
+    }
+
     const ReadCount& get_oldest() const noexcept
     {
-        return get(old_pos.load(std::memory_order_relaxed));
+        return get(oldest());
     }
 
     bool is_full() const noexcept
@@ -462,8 +479,8 @@ struct alignas(8) SharedGroup::SharedInfo {
     /// compromize version agreement checking.
     uint16_t shared_info_version = g_shared_info_version; // Offset 6
 
-    uint16_t durability;           // Offset 8
-    uint16_t free_write_slots = 0; // Offset 10
+    uint16_t durability; // Offset 8
+    uint16_t filler_3;   // Offset 10
 
     /// Number of participating shared groups
     uint32_t num_participants = 0; // Offset 12
@@ -488,17 +505,9 @@ struct alignas(8) SharedGroup::SharedInfo {
     /// sync agent can be started.
     uint8_t sync_agent_present = 0; // Offset 40
 
-    /// Set when a participant decides to start the daemon, cleared by the
-    /// daemon when it decides to exit. Participants check during open() and
-    /// start the daemon if running in async mode.
-    uint8_t daemon_started = 0; // Offset 41
-
-    /// Set by the daemon when it is ready to handle commits. Participants must
-    /// wait during open() on 'daemon_becomes_ready' for this to become true.
-    /// Cleared by the daemon when it decides to exit.
-    uint8_t daemon_ready = 0; // Offset 42
-
-    uint8_t filler_1;  // Offset 43
+    uint8_t filler_4; // Offset 41
+    uint8_t filler_5; // Offset 42
+    uint8_t filler_1; // Offset 43
 
     /// Stores a history schema version (as returned by
     /// Replication::get_history_schema_version()). Must match across all
@@ -512,15 +521,22 @@ struct alignas(8) SharedGroup::SharedInfo {
     InterprocessMutex::SharedPart shared_balancemutex;
 #endif
     InterprocessMutex::SharedPart shared_controlmutex;
-    // FIXME: windows pthread support for condvar not ready
-    InterprocessCondVar::SharedPart room_to_write;
-    InterprocessCondVar::SharedPart work_to_do;
-    InterprocessCondVar::SharedPart daemon_becomes_ready;
     InterprocessCondVar::SharedPart new_commit_available;
     InterprocessCondVar::SharedPart pick_next_writer;
     std::atomic<uint32_t> next_ticket;
     uint32_t next_served = 0;
 
+    /// The version of the latest snapshot which is known to have been made
+    /// durable, see SharedGroup::get_durable_version(). Guarded by the
+    /// controlmutex.
+    uint64_t durable_version = 0;
+
+    /// Read transactions bound to snapshots of older versions than this have
+    /// been invalidated, see SharedGroupOptions::RetentionPolicy. Only
+    /// changed by writers, and before the commit is published in the
+    /// ringbuffer, but read without holding any lock.
+    std::atomic<uint64_t> invalidated_version = {0};
+
     // IMPORTANT: The ringbuffer MUST be the last field in SharedInfo - see above.
     Ringbuffer readers;
 
@@ -536,6 +552,7 @@ struct alignas(8) SharedGroup::SharedInfo {
         r.filesize = file_size;
         r.version = initial_version;
         r.current_top = top_ref;
+        r.commit_time = milliseconds_since_epoch();
     }
 
     uint_fast64_t get_current_version_unchecked() const
@@ -547,7 +564,7 @@ struct alignas(8) SharedGroup::SharedInfo {
 
 SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht, int hsv)
     : size_of_mutex(sizeof(shared_writemutex))
-    , size_of_condvar(sizeof(room_to_write))
+    , size_of_condvar(sizeof(new_commit_available))
     , shared_writemutex() // Throws
 #ifdef REALM_ASYNC_DAEMON
     , shared_balancemutex() // Throws
@@ -562,11 +579,6 @@ SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht
     InterprocessCondVar::init_shared_part(new_commit_available); // Throws
     InterprocessCondVar::init_shared_part(pick_next_writer); // Throws
     next_ticket = 0;
-#ifdef REALM_ASYNC_DAEMON
-    InterprocessCondVar::init_shared_part(room_to_write);        // Throws
-    InterprocessCondVar::init_shared_part(work_to_do);           // Throws
-    InterprocessCondVar::init_shared_part(daemon_becomes_ready); // Throws
-#endif
 
     // IMPORTANT: The offsets, types (, and meanings) of these members must
     // never change, not even when the SharedInfo layout version is bumped. The
@@ -603,8 +615,8 @@ SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht
                   std::is_same<decltype(history_type), int8_t>::value &&
                   offsetof(SharedInfo, durability) == 8 &&
                   std::is_same<decltype(durability), uint16_t>::value &&
-                  offsetof(SharedInfo, free_write_slots) == 10 &&
-                  std::is_same<decltype(free_write_slots), uint16_t>::value &&
+                  offsetof(SharedInfo, filler_3) == 10 &&
+                  std::is_same<decltype(filler_3), uint16_t>::value &&
                   offsetof(SharedInfo, num_participants) == 12 &&
                   std::is_same<decltype(num_participants), uint32_t>::value &&
                   offsetof(SharedInfo, latest_version_number) == 16 &&
@@ -615,10 +627,10 @@ SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht
                   std::is_same<decltype(number_of_versions), uint64_t>::value &&
                   offsetof(SharedInfo, sync_agent_present) == 40 &&
                   std::is_same<decltype(sync_agent_present), uint8_t>::value &&
-                  offsetof(SharedInfo, daemon_started) == 41 &&
-                  std::is_same<decltype(daemon_started), uint8_t>::value &&
-                  offsetof(SharedInfo, daemon_ready) == 42 &&
-                  std::is_same<decltype(daemon_ready), uint8_t>::value &&
+                  offsetof(SharedInfo, filler_4) == 41 &&
+                  std::is_same<decltype(filler_4), uint8_t>::value &&
+                  offsetof(SharedInfo, filler_5) == 42 &&
+                  std::is_same<decltype(filler_5), uint8_t>::value &&
                   offsetof(SharedInfo, filler_1) == 43 &&
                   std::is_same<decltype(filler_1), uint8_t>::value &&
                   offsetof(SharedInfo, history_schema_version) == 44 &&
@@ -634,102 +646,6 @@ SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht
 }
 
 
-namespace {
-
-#ifdef REALM_ASYNC_DAEMON
-
-void spawn_daemon(const std::string& file)
-{
-    // determine maximum number of open descriptors
-    errno = 0;
-    int m = int(sysconf(_SC_OPEN_MAX));
-    if (m < 0) {
-        if (errno) {
-            int err = errno; // Eliminate any risk of clobbering
-            throw std::system_error(err, std::system_category(), "sysconf(_SC_OPEN_MAX) failed");
-        }
-        throw std::runtime_error("'sysconf(_SC_OPEN_MAX)' failed with no reason");
-    }
-
-    int pid = fork();
-    if (0 == pid) { // child process:
-
-        // close all descriptors:
-        int i;
-        for (i = m - 1; i >= 0; --i)
-            close(i);
-#ifdef REALM_ENABLE_LOGFILE
-        // FIXME: Do we want to always open the log file? Should it be configurable?
-        i = ::open((file + ".log").c_str(), O_RDWR | O_CREAT | O_APPEND | O_SYNC, S_IRWXU);
-#else
-        i = ::open("/dev/null", O_RDWR);
-#endif
-        if (i >= 0) {
-            int j = dup(i);
-            static_cast<void>(j);
-        }
-#ifdef REALM_ENABLE_LOGFILE
-        std::cerr << "Detaching" << std::endl;
-#endif
-        // detach from current session:
-        setsid();
-
-        // start commit daemon executable
-        // Note that getenv (which is not thread safe) is called in a
-        // single threaded context. This is ensured by the fork above.
-        const char* async_daemon = getenv("REALM_ASYNC_DAEMON");
-        if (!async_daemon) {
-#ifndef REALM_DEBUG
-            async_daemon = REALM_INSTALL_LIBEXECDIR "/realmd";
-#else
-            async_daemon = REALM_INSTALL_LIBEXECDIR "/realmd-dbg";
-#endif
-        }
-        execl(async_daemon, async_daemon, file.c_str(), static_cast<char*>(0));
-
-// if we continue here, exec has failed so return error
-// if exec succeeds, we don't come back here.
-#if REALM_ANDROID
-        _exit(1);
-#else
-        _Exit(1);
-#endif
-        // child process ends here
-    }
-    else if (pid > 0) { // parent process, fork succeeded:
-
-        // use childs exit code to catch and report any errors:
-        int status;
-        int pid_changed;
-        do {
-            pid_changed = waitpid(pid, &status, 0);
-        } while (pid_changed == -1 && errno == EINTR);
-        if (pid_changed != pid) {
-            std::cerr << "Waitpid returned pid = " << pid_changed << " and status = " << std::hex << status
-                      << std::endl;
-            throw std::runtime_error("call to waitpid failed");
-        }
-        if (!WIFEXITED(status))
-            throw std::runtime_error("failed starting async commit (exit)");
-        if (WEXITSTATUS(status) == 1) {
-            // FIXME: Or `ld` could not find a required shared library
-            throw std::runtime_error("async commit daemon not found");
-        }
-        if (WEXITSTATUS(status) == 2)
-            throw std::runtime_error("async commit daemon failed");
-        if (WEXITSTATUS(status) == 3)
-            throw std::runtime_error("wrong db given to async daemon");
-    }
-    else { // Parent process, fork failed!
-
-        throw std::runtime_error("Failed to spawn async commit");
-    }
-}
-#endif
-
-
-} // anonymous namespace
-
 #if REALM_HAVE_STD_FILESYSTEM
 std::string SharedGroupOptions::sys_tmp_dir = std::filesystem::temp_directory_path().u8string();
 #else
@@ -768,12 +684,19 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
     if (options.durability == Durability::Async)
         throw std::runtime_error("Async mode not yet supported on Windows, iOS and watchOS");
 #endif
+    if (options.durability == Durability::Async && options.encryption_key)
+        throw std::runtime_error("Async mode not supported for encrypted files");
 
     m_db_path = path;
     m_coordination_dir = path + ".management";
     m_lockfile_path = path + ".lock";
+    m_temp_dir = options.temp_dir.empty() ? SharedGroupOptions::get_sys_tmp_dir() : options.temp_dir;
     try_make_dir(m_coordination_dir);
+    m_commit_notifier.reset(new _impl::CommitNotifier(m_coordination_dir + "/commit_listeners",
+                                                      m_temp_dir)); // Throws
     m_key = options.encryption_key;
+    m_write_backend = options.write_backend;
+    m_retention_policy = options.retention_policy;
     m_lockfile_prefix = m_coordination_dir + "/access_control";
     SlabAlloc& alloc = m_group.m_alloc;
 
@@ -951,14 +874,14 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
             throw IncompatibleLockFile(ss.str());
         }
 
-        if (info->size_of_condvar != sizeof info->room_to_write) {
+        if (info->size_of_condvar != sizeof info->new_commit_available) {
             if (retries_left) {
                 --retries_left;
                 continue;
             }
             std::stringstream ss;
-            ss << "Condtion var size doesn't match: " << info->size_of_condvar << " " << sizeof(info->room_to_write)
-               << ".";
+            ss << "Condtion var size doesn't match: " << info->size_of_condvar << " "
+               << sizeof(info->new_commit_available) << ".";
             throw IncompatibleLockFile(ss.str());
         }
 
@@ -993,8 +916,7 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
         // OK! lock file appears valid. We can now continue operations under the protection
         // of the controlmutex. The controlmutex protects the following activities:
         // - attachment of the database file
-        // - start of the async daemon
-        // - stop of the async daemon
+        // - the durable version of async commits
         // - SharedGroup beginning/ending a session
         // - Waiting for and signalling database changes
         {
@@ -1031,6 +953,7 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
             cfg.clear_file = (options.durability == Durability::MemOnly && begin_new_session);
 
             cfg.encryption_key = options.encryption_key;
+            cfg.memory_policy = options.memory_policy;
             ref_type top_ref;
             try {
                 top_ref = alloc.attach_file(path, cfg); // Throws
@@ -1175,6 +1098,7 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
                 info->number_of_versions = 1;
 
                 info->latest_version_number = version;
+                info->durable_version = version;
 
                 SharedInfo* r_info = m_reader_map.get_addr();
                 size_t file_size = alloc.get_baseline();
@@ -1192,8 +1116,10 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
                 // History type must be consistent across a session. An
                 // inconsistency is a logic error, as the user is required to
                 // make sure that all possible concurrent session participants
-                // use the same history type for the same Realm file.
-                if (info->history_type != openers_hist_type)
+                // use the same history type for the same Realm file. The
+                // SharedGroup of an async committer never accesses the
+                // history.
+                if (info->history_type != openers_hist_type && !is_backend)
                     throw LogicError(LogicError::mixed_history_type);
 
                 // History schema version must be consistent across a
@@ -1201,7 +1127,7 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
                 // required to make sure that all possible concurrent session
                 // participants use the same history schema version for the same
                 // Realm file.
-                if (info->history_schema_version != openers_hist_schema_version)
+                if (info->history_schema_version != openers_hist_schema_version && !is_backend)
                     throw LogicError(LogicError::mixed_history_schema_version);
 #ifdef _WIN32
                 uint64_t pid = GetCurrentProcessId();
@@ -1252,29 +1178,6 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
                                                    options.temp_dir);
             m_pick_next_writer.set_shared_part(info->pick_next_writer, m_lockfile_prefix, "pick_writer",
                                                    options.temp_dir);
-#ifdef REALM_ASYNC_DAEMON
-            if (options.durability == Durability::Async) {
-                m_daemon_becomes_ready.set_shared_part(info->daemon_becomes_ready, m_lockfile_prefix, "daemon_ready",
-                                                       options.temp_dir);
-                m_work_to_do.set_shared_part(info->work_to_do, m_lockfile_prefix, "work_ready", options.temp_dir);
-                m_room_to_write.set_shared_part(info->room_to_write, m_lockfile_prefix, "allow_write",
-                                                options.temp_dir);
-                // In async mode, we need to make sure the daemon is running and ready:
-                if (!is_backend) {
-                    while (info->daemon_ready == 0) {
-                        if (info->daemon_started == 0) {
-                            spawn_daemon(path);
-                            info->daemon_started = 1;
-                        }
-                        // FIXME: It might be more robust to sleep a little, then restart the loop
-                        // std::cerr << "Waiting for daemon" << std::endl;
-                        m_daemon_becomes_ready.wait(m_controlmutex, 0);
-                        // std::cerr << " - notified" << std::endl;
-                    }
-                }
-            }
-// std::cerr << "daemon should be ready" << std::endl;
-#endif // REALM_ASYNC_DAEMON
 
             // Set initial version so we can track if other instances
             // change the db
@@ -1303,15 +1206,9 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
     set_transact_stage(transact_Ready);
 // std::cerr << "open completed" << std::endl;
 
-#ifdef REALM_ASYNC_DAEMON
-    if (options.durability == Durability::Async) {
-        if (is_backend) {
-            do_async_commits();
-        }
-    }
-#else
-    static_cast<void>(is_backend);
-#endif
+    // The SharedGroup of an async committer only tracks snapshots
+    if (is_backend)
+        return;
 
     // Upgrade file format and/or history schema
     try {
@@ -1337,6 +1234,19 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
             upgrade_file_format(options.allow_file_format_upgrade, target_file_format_version,
                                 stored_hist_schema_version, openers_hist_schema_version); // Throws
         }
+
+        if (options.background_file_growth) {
+            Durability durability = Durability(m_file_map.get_addr()->durability);
+            bool sync = !get_disable_sync_to_disk() && durability != Durability::MemOnly &&
+                        durability != Durability::Unsafe;
+            m_file_grower.reset(new _impl::FileGrower(m_db_path, m_key, sync, m_group.m_alloc,
+                                                      m_writemutex)); // Throws
+        }
+
+        if (options.durability == Durability::Async) {
+            m_async_committer.reset(new _impl::AsyncCommitter(m_db_path, options.temp_dir,
+                                                              options.async_commit_latency)); // Throws
+        }
     }
     catch (...) {
         close();
@@ -1359,11 +1269,33 @@ bool SharedGroup::compact(bool bump_version_number, util::Optional<const char*>
     SharedInfo* info = m_file_map.get_addr();
     Durability dura = Durability(info->durability);
     std::string tmp_path = m_db_path + ".tmp_compaction_space";
+    bool background_file_growth = bool(m_file_grower);
+    SharedGroupOptions::WriteBackend write_backend = m_write_backend;
+    util::MemoryPolicy memory_policy = m_group.m_alloc.m_cfg.memory_policy;
+    SharedGroupOptions::RetentionPolicy retention_policy = m_retention_policy;
     const char* write_key = bool(output_encryption_key) ? *output_encryption_key : m_key;
-    {
+    std::string temp_dir = m_temp_dir;
+    std::chrono::milliseconds async_commit_latency = SharedGroupOptions().async_commit_latency;
+    if (m_async_committer) {
+        // The async committer is a session participant of its own
+        async_commit_latency = m_async_committer->get_max_latency();
+        m_async_committer.reset();
+    }
+    // The async committer must be restarted on every path which leaves this
+    // SharedGroup attached to the file without compacting it.
+    auto restart_async_committer = [&] {
+        if (dura == Durability::Async && is_attached() && !m_async_committer) {
+            m_async_committer.reset(new _impl::AsyncCommitter(m_db_path, temp_dir,
+                                                              async_commit_latency)); // Throws
+        }
+    };
+    try {
         std::unique_lock<InterprocessMutex> lock(m_controlmutex); // Throws
-        if (info->num_participants > 1)
+        if (info->num_participants > 1) {
+            lock.unlock();
+            restart_async_committer(); // Throws
             return false;
+        }
 
         // group::write() will throw if the file already exists.
         // To prevent this, we have to remove the file (should it exist)
@@ -1414,16 +1346,331 @@ bool SharedGroup::compact(bool bump_version_number, util::Optional<const char*>
         util::File::move(tmp_path, m_db_path);
 #endif
         close_internal(/* with lock held: */ std::move(lock));
-
+    }
+    catch (...) {
+        try {
+            restart_async_committer(); // Throws
+        }
+        catch (...) {
+            // Rather than leaving it attached with nothing to make its
+            // commits durable
+            close();
+        }
+        throw;
     }
     SharedGroupOptions new_options;
     new_options.durability = dura;
+    new_options.background_file_growth = background_file_growth;
+    new_options.write_backend = write_backend;
+    new_options.memory_policy = memory_policy;
+    new_options.retention_policy = retention_policy;
     new_options.encryption_key = write_key;
     new_options.allow_file_format_upgrade = false;
+    new_options.temp_dir = temp_dir;
+    new_options.async_commit_latency = async_commit_latency;
     do_open(m_db_path, true, false, new_options);
     return true;
 }
 
+void SharedGroup::backup(const std::string& path, VersionID version)
+{
+    if (m_transact_stage != transact_Ready)
+        throw LogicError(LogicError::wrong_transact_state);
+
+    const Group& group = begin_read(version); // Throws
+    auto handler = [this]() noexcept { end_read(); };
+    auto read_end_guard = make_scope_exit(handler);
+
+    if (m_key) {
+        // The pages of an encrypted file cannot be copied without the
+        // encryption metadata, so the arrays are written out instead
+        group.write(path, m_key, m_read_lock.m_version); // Throws
+        return;
+    }
+
+    File file;
+    file.open(path, File::access_ReadWrite, File::create_Must, 0); // Throws
+    try {
+        _impl::SnapshotCopier copier(m_group.m_alloc);
+        copier.collect(m_read_lock.m_top_ref);                                // Throws
+        copier.copy(m_group.m_alloc.get_file(), file, m_read_lock.m_file_size); // Throws
+
+        // The header was copied as is, and may select an older snapshot
+        using gf = _impl::GroupFriend;
+        bool sync = !get_disable_sync_to_disk();
+        GroupWriter::commit_to_file(file, m_read_lock.m_top_ref, gf::get_file_format_version(m_group),
+                                    sync); // Throws
+    }
+    catch (...) {
+        file.close();
+        File::try_remove(path);
+        throw;
+    }
+}
+
+namespace {
+
+// An incremental backup is the magic, followed by the version it starts from,
+// and then the version and the size of each changeset ahead of its contents.
+// The integers are 64 bits wide, and stored in native byte order, as the
+// database file is.
+constexpr char incremental_backup_magic[8] = {'R', 'L', 'M', 'I', 'N', 'C', '0', '1'};
+
+void write_uint64(std::ostream& out, uint64_t value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof value);
+}
+
+bool read_uint64(std::istream& in, uint64_t& value)
+{
+    in.read(reinterpret_cast<char*>(&value), sizeof value);
+    return size_t(in.gcount()) == sizeof value;
+}
+
+} // anonymous namespace
+
+SharedGroup::VersionID SharedGroup::backup_changes(VersionID since, std::ostream& out)
+{
+    if (m_transact_stage != transact_Ready)
+        throw LogicError(LogicError::wrong_transact_state);
+    _impl::History* hist = get_history();
+    if (!hist)
+        throw LogicError(LogicError::no_history);
+
+    // As long as the specified version is bound, the history holds every
+    // changeset made after it
+    ReadLockInfo since_lock;
+    grab_read_lock(since_lock, since); // Throws
+    ReadLockUnlockGuard rlug(*this, since_lock);
+
+    begin_read(); // Throws
+    auto handler = [this]() noexcept { end_read(); };
+    auto read_end_guard = make_scope_exit(handler);
+    version_type begin_version = since_lock.m_version;
+    version_type end_version = m_read_lock.m_version;
+    ref_type hist_ref = _impl::GroupFriend::get_history_ref(m_group.m_alloc, m_read_lock.m_top_ref);
+    hist->update_from_ref_and_version(hist_ref, end_version); // Throws
+
+    out.write(incremental_backup_magic, sizeof incremental_backup_magic);
+    write_uint64(out, begin_version);
+    std::string changeset;
+    for (version_type version = begin_version; version < end_version; ++version) {
+        BinaryIterator iter;
+        hist->get_changesets(version, version + 1, &iter);
+        changeset.clear();
+        for (BinaryData chunk = iter.get_next(); chunk.size() > 0; chunk = iter.get_next())
+            changeset.append(chunk.data(), chunk.size()); // Throws
+        write_uint64(out, version + 1);
+        write_uint64(out, changeset.size());
+        out.write(changeset.data(), changeset.size());
+    }
+    out.flush();
+    if (!out)
+        throw std::runtime_error("Failed to write incremental backup");
+
+    return pin_version(); // Throws
+}
+
+SharedGroup::version_type SharedGroup::restore_changes(std::istream& in, SharedGroup& target)
+{
+    char magic[sizeof incremental_backup_magic];
+    in.read(magic, sizeof magic);
+    uint64_t begin_version;
+    if (size_t(in.gcount()) != sizeof magic ||
+        !std::equal(magic, magic + sizeof magic, incremental_backup_magic) || !read_uint64(in, begin_version))
+        throw std::runtime_error("Not an incremental backup");
+
+    version_type version = target.get_version_of_latest_snapshot(); // Throws
+    if (version != begin_version) {
+        std::stringstream ss;
+        ss << "Incremental backup starts from version " << begin_version << ", but the latest version is "
+           << version << ".";
+        throw std::runtime_error(ss.str());
+    }
+
+    std::string changeset;
+    uint64_t changeset_version;
+    while (read_uint64(in, changeset_version)) {
+        uint64_t size;
+        if (!read_uint64(in, size) || util::int_cast_has_overflow<size_t>(size))
+            throw std::runtime_error("Truncated incremental backup");
+        changeset.resize(size_t(size)); // Throws
+        in.read(&changeset[0], std::streamsize(size));
+        if (uint64_t(in.gcount()) != size)
+            throw std::runtime_error("Truncated incremental backup");
+
+        WriteTransaction wt(target); // Throws
+        if (changeset_version != wt.get_version() + 1)
+            throw std::runtime_error("Incremental backup is not contiguous");
+        _impl::SimpleNoCopyInputStream changeset_in(changeset.data(), changeset.size());
+        Replication::apply_changeset(changeset_in, wt.get_group()); // Throws
+        version = wt.commit();                                       // Throws
+    }
+    return version;
+}
+
+namespace {
+
+// Add the size of each chunk in the specified free-list to the locked space of
+// the newest of the specified snapshots which is older than the version at
+// which the chunk was released, as the chunk can be reused once that snapshot,
+// and every older one, is no longer bound.
+void add_locked_space(std::vector<SharedGroup::VersionStats>& versions, const Array& free_lengths,
+                      const Array& free_versions)
+{
+    auto older = [](const SharedGroup::VersionStats& stats, uint_fast64_t version) {
+        return stats.version < version;
+    };
+    size_t n = free_lengths.size();
+    for (size_t i = 0; i < n; ++i) {
+        uint_fast64_t version = uint_fast64_t(free_versions.get(i));
+        auto j = std::lower_bound(versions.begin(), versions.end(), version, older);
+        if (j != versions.begin())
+            std::prev(j)->locked_space += size_t(free_lengths.get(i));
+    }
+}
+
+// Returns the number of the oldest of the specified snapshots which exceed the
+// limits of the policy. The last snapshot is the latest, which never lags.
+size_t count_lagging(const std::vector<SharedGroup::VersionStats>& versions,
+                     const SharedGroupOptions::RetentionPolicy& policy)
+{
+    REALM_ASSERT(!versions.empty());
+    uint_fast64_t latest_version = versions.back().version;
+    size_t locked_space = 0;
+    for (const SharedGroup::VersionStats& stats : versions)
+        locked_space += stats.locked_space;
+
+    size_t num_lagging = 0;
+    while (num_lagging < versions.size() - 1) {
+        const SharedGroup::VersionStats& stats = versions[num_lagging];
+        bool lagging = ((policy.max_versions != 0 && latest_version - stats.version + 1 > policy.max_versions) ||
+                        (policy.max_age.count() != 0 && stats.age > policy.max_age) ||
+                        (policy.max_locked_space != 0 && locked_space > policy.max_locked_space));
+        if (!lagging)
+            break;
+        // The space locked by the remaining snapshots
+        locked_space -= stats.locked_space;
+        ++num_lagging;
+    }
+    return num_lagging;
+}
+
+} // anonymous namespace
+
+std::vector<SharedGroup::VersionStats> SharedGroup::get_version_stats()
+{
+    if (m_transact_stage != transact_Ready)
+        throw LogicError(LogicError::wrong_transact_state);
+
+    // The locked space is found from the free-list of the latest snapshot
+    begin_read(); // Throws
+    auto end_read_guard = make_scope_exit([&]() noexcept { end_read(); });
+    version_type latest_version = m_read_lock.m_version;
+    std::vector<VersionStats> versions = get_bound_versions(latest_version); // Throws
+    if (versions.empty() || versions.back().version != latest_version)
+        versions.push_back({latest_version, 0, std::chrono::milliseconds(0), 0, false}); // Throws
+
+    const Array& top = m_group.m_top;
+    if (top.is_attached() && top.size() > 5) {
+        Array free_lengths(m_group.m_alloc);
+        Array free_versions(m_group.m_alloc);
+        free_lengths.init_from_ref(top.get_as_ref(4));
+        free_versions.init_from_ref(top.get_as_ref(5));
+        add_locked_space(versions, free_lengths, free_versions);
+    }
+    return versions;
+}
+
+std::vector<SharedGroup::VersionStats> SharedGroup::get_bound_versions(version_type latest_version)
+{
+    struct Entry {
+        version_type version;
+        uint64_t commit_time;
+        size_t num_readers;
+    };
+    std::vector<Entry> entries;
+    bool in_transaction = (m_transact_stage != transact_Ready);
+
+    // Each entry is locked while it is read, as by
+    // get_version_of_latest_snapshot(), but the ringbuffer may change between
+    // the entries. Entries which are cleaned up meanwhile are skipped, and the
+    // walk is bounded in case it is led astray.
+    SharedInfo* r_info = m_reader_map.get_addr();
+    uint_fast32_t last = r_info->readers.last();
+    uint_fast32_t index = r_info->readers.oldest();
+    uint_fast32_t num_entries = r_info->readers.get_num_entries();
+    for (uint_fast32_t i = 0; i < num_entries; ++i) {
+        if (grow_reader_mapping(index)) // Throws
+            r_info = m_reader_map.get_addr();
+        const Ringbuffer::ReadCount& r = r_info->readers.get(index);
+        if (atomic_double_inc_if_even(r.count)) {
+            // Not counting the lock just taken, nor the read lock of this
+            // SharedGroup
+            Entry entry{r.version, r.commit_time, r.count.load(std::memory_order_relaxed) / 2 - 1};
+            if (in_transaction && index == m_read_lock.m_reader_idx)
+                --entry.num_readers;
+            atomic_double_dec(r.count);
+            entries.push_back(entry); // Throws
+        }
+        if (index == last)
+            break;
+        index = r.next;
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.version < b.version; });
+
+    uint64_t now = milliseconds_since_epoch();
+    std::vector<VersionStats> versions;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        if (entry.version > latest_version)
+            break;
+        if (entry.num_readers == 0 || (i > 0 && entries[i - 1].version == entry.version))
+            continue;
+        // A snapshot is superseded by the commit of the next one
+        uint64_t superseded_at = (i + 1 < entries.size() ? entries[i + 1].commit_time : now);
+        std::chrono::milliseconds age(now > superseded_at ? now - superseded_at : 0);
+        versions.push_back({entry.version, entry.num_readers, age, 0, is_invalidated(entry.version)}); // Throws
+    }
+    return versions;
+}
+
+bool SharedGroup::is_invalidated(version_type version) const noexcept
+{
+    SharedInfo* info = m_file_map.get_addr();
+    return version < info->invalidated_version;
+}
+
+void SharedGroup::report_lagging_versions() noexcept
+{
+    if (m_lagging_versions.empty())
+        return;
+    std::vector<VersionStats> lagging = std::move(m_lagging_versions);
+    m_lagging_versions.clear();
+    if (!m_retention_policy.on_lagging_readers)
+        return;
+    try {
+        m_retention_policy.on_lagging_readers(lagging); // Throws
+    }
+    catch (...) {
+        // The commit has succeeded already, so it must not appear to have
+        // failed, which would make a caller retrying it commit twice.
+    }
+}
+
+SharedGroup::version_type SharedGroup::get_durable_version()
+{
+    SharedInfo* info = m_file_map.get_addr();
+    std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+    return info->durable_version;
+}
+
+void SharedGroup::wait_for_durability()
+{
+    if (m_async_committer)
+        m_async_committer->flush(); // Throws
+}
+
 uint_fast64_t SharedGroup::get_number_of_versions()
 {
     SharedInfo* info = m_file_map.get_addr();
@@ -1470,8 +1717,14 @@ void SharedGroup::close_internal(std::unique_lock<InterprocessMutex> lock) noexc
             rollback();
             break;
     }
+    m_async_committer.reset();
     m_group.detach();
     set_transact_stage(transact_Ready);
+    m_file_grower.reset();
+    if (m_pins_durable_version) {
+        release_read_lock(m_read_lock);
+        m_pins_durable_version = false;
+    }
     SharedInfo* info = m_file_map.get_addr();
     {
         bool is_sync_agent = false;
@@ -1509,13 +1762,10 @@ void SharedGroup::close_internal(std::unique_lock<InterprocessMutex> lock) noexc
         }
         lock.unlock();
     }
-#ifdef REALM_ASYNC_DAEMON
-    m_room_to_write.close();
-    m_work_to_do.close();
-    m_daemon_becomes_ready.close();
-#endif
     m_new_commit_available.close();
     m_pick_next_writer.close();
+    m_commit_listener.reset();
+    m_commit_notifier.reset();
 
     // On Windows it is important that we unmap before unlocking, else a SetEndOfFile() call from another thread may
     // interleave which is not permitted on Windows. It is permitted on *nix.
@@ -1557,6 +1807,23 @@ void SharedGroup::enable_wait_for_change()
     m_wait_for_change_enabled = true;
 }
 
+
+int SharedGroup::get_commit_notification_fd()
+{
+    REALM_ASSERT(is_attached());
+    if (!m_commit_listener)
+        m_commit_listener.reset(new _impl::CommitListener(m_coordination_dir + "/commit_listeners",
+                                                          m_temp_dir)); // Throws
+    return m_commit_listener->get_fd();
+}
+
+
+void SharedGroup::clear_commit_notifications() noexcept
+{
+    if (m_commit_listener)
+        m_commit_listener->clear();
+}
+
 void SharedGroup::set_transact_stage(SharedGroup::TransactStage stage) noexcept
 {
 #if REALM_METRICS
@@ -1592,106 +1859,48 @@ void SharedGroup::set_transact_stage(SharedGroup::TransactStage stage) noexcept
 }
 
 #ifdef REALM_ASYNC_DAEMON
-void SharedGroup::do_async_commits()
+void SharedGroup::flush_async_commits()
 {
-    bool shutdown = false;
     SharedInfo* info = m_file_map.get_addr();
 
-    // We always want to keep a read lock on the last version
-    // that was commited to disk, to protect it against being
-    // overwritten by commits being made to memory by others.
-    {
-        VersionID version_id = VersionID();      // Latest available snapshot
-        grab_read_lock(m_read_lock, version_id); // Throws
-    }
-    // we must treat version and version_index the same way:
-    {
-        std::lock_guard<InterprocessMutex> lock(m_controlmutex);
-        info->free_write_slots = max_write_slots;
-        info->daemon_ready = 1;
-        m_daemon_becomes_ready.notify_all();
-    }
-    using gf = _impl::GroupFriend;
-    gf::detach(m_group);
-
-    while (true) {
-        if (m_file.is_removed()) { // operator removed the lock file. take a hint!
-
-            shutdown = true;
-#ifdef REALM_ENABLE_LOGFILE
-            std::cerr << "Lock file removed, initiating shutdown" << std::endl;
-#endif
-        }
+    // The committers of all processes take turns, so that the file header
+    // is never written by two of them at the same time
+    std::lock_guard<InterprocessMutex> lock(m_balancemutex); // Throws
 
-        bool is_same;
-        ReadLockInfo next_read_lock = m_read_lock;
-        {
-            // detect if we're the last "client", and if so, shutdown (must be under lock):
-            std::lock_guard<InterprocessMutex> lock2(m_writemutex);
-            std::lock_guard<InterprocessMutex> lock(m_controlmutex);
-            version_type old_version = next_read_lock.m_version;
-            VersionID version_id = VersionID(); // Latest available snapshot
-            grab_read_lock(next_read_lock, version_id);
-            is_same = (next_read_lock.m_version == old_version);
-            if (is_same && (shutdown || info->num_participants == 1)) {
-#ifdef REALM_ENABLE_LOGFILE
-                std::cerr << "Daemon exiting nicely" << std::endl << std::endl;
-#endif
-                release_read_lock(next_read_lock);
-                release_read_lock(m_read_lock);
-                info->daemon_started = 0;
-                info->daemon_ready = 0;
-                return;
-            }
-        }
+    ReadLockInfo next_read_lock;
+    VersionID version_id = VersionID();        // Latest available snapshot
+    grab_read_lock(next_read_lock, version_id); // Throws
+    ReadLockUnlockGuard rlug(*this, next_read_lock);
 
-        if (!is_same) {
-
-#ifdef REALM_ENABLE_LOGFILE
-            std::cerr << "Syncing from version " << m_read_lock.m_version << " to " << next_read_lock.m_version
-                      << std::endl;
-#endif
-            GroupWriter writer(m_group);
-            writer.commit(next_read_lock.m_top_ref);
-#ifdef REALM_ENABLE_LOGFILE
-            std::cerr << "..and Done" << std::endl;
-#endif
-        }
-
-        // Now we can release the version that was previously commited
-        // to disk and just keep the lock on the latest version.
+    version_type durable_version;
+    {
+        std::lock_guard<InterprocessMutex> lock2(m_controlmutex); // Throws
+        durable_version = info->durable_version;
+    }
+    if (next_read_lock.m_version > durable_version) {
+        // The arrays of the snapshot were written by the committing process,
+        // and synchronizing the file makes them durable along with the header
+        bool sync = !get_disable_sync_to_disk();
+        GroupWriter::commit_to_file(m_group.m_alloc.get_file(), next_read_lock.m_top_ref,
+                                    info->file_format_version, sync); // Throws
+        std::lock_guard<InterprocessMutex> lock2(m_controlmutex);    // Throws
+        if (next_read_lock.m_version > info->durable_version)
+            info->durable_version = next_read_lock.m_version;
+    }
+
+    // Now the snapshot which was previously durable can be released, keeping
+    // just the read lock on the one which is now durable.
+    rlug.release();
+    if (m_pins_durable_version)
         release_read_lock(m_read_lock);
-        m_read_lock = next_read_lock;
-
-        m_balancemutex.lock();
-
-        // We have caught up with the writers, let them know that there are
-        // now free write slots, wakeup any that has been suspended.
-        uint16_t free_write_slots = info->free_write_slots;
-        info->free_write_slots = max_write_slots;
-        if (free_write_slots <= 0) {
-            m_room_to_write.notify_all();
-        }
-
-        // If we have plenty of write slots available, relax and wait a bit before syncing
-        if (free_write_slots > relaxed_sync_threshold) {
-            timespec ts;
-            timeval tv;
-            // clock_gettime(CLOCK_REALTIME, &ts); <- would like to use this, but not there on mac
-            gettimeofday(&tv, nullptr);
-            ts.tv_sec = tv.tv_sec;
-            ts.tv_nsec = tv.tv_usec * 1000;
-            ts.tv_nsec += 10000000;         // 10 msec
-            if (ts.tv_nsec >= 1000000000) { // overflow
-                ts.tv_nsec -= 1000000000;
-                ts.tv_sec += 1;
-            }
-
-            // no timeout support if the condvars are only emulated, so this will assert
-            m_work_to_do.wait(m_balancemutex, &ts);
-        }
-        m_balancemutex.unlock();
-    }
+    m_read_lock = next_read_lock;
+    m_pins_durable_version = true;
+}
+#else
+void SharedGroup::flush_async_commits()
+{
+    // Async mode is rejected by do_open()
+    REALM_UNREACHABLE();
 }
 #endif // REALM_ASYNC_DAEMON
 
@@ -1851,7 +2060,7 @@ void SharedGroup::grab_read_lock(ReadLockInfo& read_lock, VersionID version_id)
         }
         // we managed to lock an entry in the ringbuffer, but it may be so old that
         // the version doesn't match the specific request. In that case we must release and fail
-        if (r.version != version_id.version) {
+        if (r.version != version_id.version || r.version < r_info->invalidated_version) {
             atomic_double_dec(r.count); // <-- release
             throw BadVersion();
         }
@@ -1991,6 +2200,7 @@ SharedGroup::version_type SharedGroup::commit()
     do_end_read();
     m_read_lock = lock_after_commit;
     set_transact_stage(transact_Ready);
+    report_lagging_versions();
     return new_version;
 }
 
@@ -2157,23 +2367,6 @@ void SharedGroup::finish_begin_write()
         throw std::runtime_error("Crash of other process detected, session restart required");
     }
 
-#ifdef REALM_ASYNC_DAEMON
-    if (info->durability == static_cast<uint16_t>(Durability::Async)) {
-
-        m_balancemutex.lock(); // Throws
-
-        // if we are running low on write slots, kick the sync daemon
-        if (info->free_write_slots < relaxed_sync_threshold)
-            m_work_to_do.notify();
-        // if we are out of write slots, wait for the sync daemon to catch up
-        while (info->free_write_slots <= 0) {
-            m_room_to_write.wait(m_balancemutex, 0);
-        }
-
-        info->free_write_slots--;
-        m_balancemutex.unlock();
-    }
-#endif // REALM_ASYNC_DAEMON
 }
 
 
@@ -2249,6 +2442,7 @@ SharedGroup::version_type SharedGroup::commit_and_continue_as_read()
     }
 
     set_transact_stage(transact_Reading);
+    report_lagging_versions();
 
     return version;
 }
@@ -2310,6 +2504,7 @@ SharedGroup::version_type SharedGroup::get_version_of_latest_snapshot()
 void SharedGroup::low_level_commit(uint_fast64_t new_version)
 {
     SharedInfo* info = m_file_map.get_addr();
+    m_lagging_versions.clear();
 
     // Version of oldest snapshot currently (or recently) bound in a transaction
     // of the current session.
@@ -2328,9 +2523,13 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
         oldest_version = rc.version;
 
         // Allow for trimming of the history. Some types of histories do not
-        // need store changesets prior to the oldest bound snapshot.
-        if (_impl::History* hist = get_history())
-            hist->set_oldest_bound_version(oldest_version); // Throws
+        // need store changesets prior to the oldest bound snapshot. Snapshots
+        // which have been invalidated can no longer be advanced, so they do
+        // not need the history either.
+        if (_impl::History* hist = get_history()) {
+            uint_fast64_t invalidated_version = r_info->invalidated_version;
+            hist->set_oldest_bound_version(std::max(oldest_version, invalidated_version)); // Throws
+        }
     }
 
     // Do the actual commit
@@ -2341,13 +2540,32 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
     m_group.update_num_objects();
 #endif // REALM_METRICS
     // info->readers.dump();
-    GroupWriter out(m_group, Durability(info->durability)); // Throws
+    GroupWriter out(m_group, Durability(info->durability), m_write_backend); // Throws
     out.set_versions(new_version, oldest_version);
     // Recursively write all changed arrays to end of file
     ref_type new_top_ref = out.write_group(); // Throws
     m_free_space = out.get_free_space_size();
     m_locked_space = out.get_locked_space_size();
     m_used_space = out.get_file_size() - m_free_space;
+    if (m_retention_policy.is_enabled()) {
+        std::vector<VersionStats> versions = get_bound_versions(new_version); // Throws
+        versions.push_back({new_version, 0, std::chrono::milliseconds(0), 0, false}); // Throws
+        add_locked_space(versions, out.get_free_lengths(), out.get_free_versions());
+        size_t num_lagging = count_lagging(versions, m_retention_policy);
+        if (num_lagging > 0) {
+            versions.resize(num_lagging);
+            if (m_retention_policy.invalidate_lagging_readers) {
+                // Readers find out when they next grab a read lock, which
+                // happens-after the new snapshot is published below
+                uint_fast64_t invalidated_version = versions.back().version + 1;
+                if (invalidated_version > info->invalidated_version)
+                    info->invalidated_version = invalidated_version;
+                for (VersionStats& version : versions)
+                    version.invalidated = true;
+            }
+            m_lagging_versions = std::move(versions);
+        }
+    }
     // std::cout << "Writing version " << new_version << ", Topptr " << new_top_ref
     //     << " Read lock at version " << oldest_version << std::endl;
     switch (Durability(info->durability)) {
@@ -2356,12 +2574,15 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
             out.commit(new_top_ref); // Throws
             break;
         case Durability::MemOnly:
-        case Durability::Async:
             // In Durability::MemOnly mode, we just use the file as backing for
             // the shared memory. So we never actually flush the data to disk
             // (the OS may do so opportinisticly, or when swapping). So in this
             // mode the file on disk may very likely be in an invalid state.
             break;
+        case Durability::Async:
+            // The new snapshot is made durable later by an async committer,
+            // see flush_async_commits().
+            break;
     }
     size_t new_file_size = out.get_file_size();
     // Update reader info. If this fails in any way, the ringbuffer may be corrupted.
@@ -2389,6 +2610,7 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
         REALM_ASSERT(new_top_ref < new_file_size);
         r.filesize = new_file_size;
         r.version = new_version;
+        r.commit_time = milliseconds_since_epoch();
         r_info->readers.use_next();
     }
     // At this point, the ringbuffer has been succesfully updated, and the next writer
@@ -2398,9 +2620,17 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
         std::lock_guard<InterprocessMutex> lock(m_controlmutex);
         info->number_of_versions = new_version - oldest_version + 1;
         info->latest_version_number = new_version;
+        Durability durability = Durability(info->durability);
+        if (durability == Durability::Full || durability == Durability::Unsafe)
+            info->durable_version = new_version;
 
         m_new_commit_available.notify_all();
     }
+    if (m_file_grower)
+        m_file_grower->on_commit(new_file_size);
+    if (m_async_committer)
+        m_async_committer->on_commit();
+    m_commit_notifier->notify();
 }
 
 #ifdef REALM_DEBUG
@@ -28,6 +28,9 @@
 #include <realm/group.hpp>
 #include <realm/group_shared_options.hpp>
 #include <realm/handover_defs.hpp>
+#include <realm/impl/async_committer.hpp>
+#include <realm/impl/commit_notifier.hpp>
+#include <realm/impl/file_grower.hpp>
 #include <realm/impl/transact_log.hpp>
 #include <realm/metrics/metrics.hpp>
 #include <realm/replication.hpp>
@@ -272,6 +275,21 @@ public:
 
     /// re-enable waiting for change
     void enable_wait_for_change();
+
+    /// Return a file descriptor which becomes readable when a commit is made
+    /// to the database, by any thread or process, so that an event loop can
+    /// wait for changes with poll(), select() or epoll instead of dedicating
+    /// a thread to wait_for_change(). The descriptor is owned by this
+    /// SharedGroup, stays readable until clear_commit_notifications() is
+    /// called, and is closed by close(). Several commits may be reported as
+    /// one notification. Not supported on Windows and tvOS, where this
+    /// function throws std::runtime_error.
+    int get_commit_notification_fd();
+
+    /// Discard the pending commit notifications of the descriptor returned
+    /// by get_commit_notification_fd(). Should be called before the changes
+    /// are looked at, so that no commit is missed.
+    void clear_commit_notifications() noexcept;
     // Transactions:
 
     using version_type = _impl::History::version_type;
@@ -394,6 +412,32 @@ public:
     /// a read transaction will not immediately release any versions.
     uint_fast64_t get_number_of_versions();
 
+    using VersionStats = SharedGroupOptions::VersionStats;
+
+    /// Report the snapshots which are bound by read transactions or pinned
+    /// versions, and the latest snapshot, oldest first. The space locked by
+    /// each of them shows how much the file would grow less if it was
+    /// released, which allows a read transaction which is never ended to be
+    /// detected long before the file has grown large. See also
+    /// SharedGroupOptions::RetentionPolicy.
+    ///
+    /// Must not be called during a transaction.
+    std::vector<VersionStats> get_version_stats();
+
+    /// Returns the version of the latest snapshot which is known to be
+    /// durable, that is, which would be found in the database file after a
+    /// crash of the process or the system. With Durability::Async, this
+    /// trails the latest snapshot by at most the latency specified by
+    /// SharedGroupOptions::async_commit_latency. With Durability::MemOnly,
+    /// nothing is durable, and the version of the snapshot found when the
+    /// session was initiated is returned.
+    version_type get_durable_version();
+
+    /// Wait until the latest snapshot at the time of the call is durable. Has
+    /// no effect unless the SharedGroup was opened with Durability::Async, as
+    /// every commit is durable when it returns otherwise.
+    void wait_for_durability();
+
     /// Get the approximate size of the data that would be written to the file if
     /// a commit were done at this point. The reported size will always be bigger
     /// than what will eventually be needed as we reserve a bit more memory that
@@ -403,6 +447,59 @@ public:
     /// Get the size of the currently allocated slab area
     size_t get_allocated_size() const;
 
+    /// Write a copy of the specified snapshot, or the latest one, to a new
+    /// database file at the specified path, without blocking writers. The
+    /// snapshot stays bound for the duration of the copy, as if by a read
+    /// transaction. Only the parts of the file holding the arrays of the
+    /// snapshot are copied, at their current positions, and the rest of the
+    /// new file is left as holes, so the copy has the size of the database
+    /// file, but takes up no more space on disk than the live data. The copy
+    /// is made by the kernel where possible, see
+    /// util::File::copy_range_to().
+    ///
+    /// The copy of an encrypted file is written as by Group::write()
+    /// instead, and is encrypted with the same key.
+    ///
+    /// Must not be called during a transaction.
+    ///
+    /// \throw util::File::Exists if the file exists already.
+    void backup(const std::string& path, VersionID version = VersionID());
+
+    /// Write an incremental backup holding the changesets of the commits
+    /// made after the specified version, up to the latest snapshot, to the
+    /// specified stream. The backup brings a copy of the database at the
+    /// specified version, such as one made by backup(), up to date when passed
+    /// to restore_changes().
+    ///
+    /// The changesets are taken from the history of the database, which only
+    /// holds the changesets made after the oldest bound snapshot. The
+    /// specified version must therefore have stayed bound since it was
+    /// backed up, which is ensured by pinning it (pin_version()). The latest
+    /// snapshot is returned pinned, ready to be the base of the next
+    /// incremental backup, and must eventually be released with
+    /// unpin_version(), as must the specified version, once this function
+    /// has returned.
+    ///
+    /// Must not be called during a transaction.
+    ///
+    /// \throw LogicError with kind `no_history` if the SharedGroup was not
+    /// opened with a history, see make_in_realm_history().
+    ///
+    /// \throw BadVersion if the specified version is no longer bound.
+    VersionID backup_changes(VersionID since, std::ostream& out);
+
+    /// Apply an incremental backup written by backup_changes() to the
+    /// specified SharedGroup, with one commit per changeset, and return the
+    /// version of its latest snapshot after the last one. The latest snapshot
+    /// of the target must be of the version the backup was made from, and as
+    /// the version numbers of both databases then advance in step, the
+    /// versions of a database and its restored copy remain comparable.
+    ///
+    /// \throw std::runtime_error if the stream does not hold an incremental
+    /// backup, or the backup does not start from the latest snapshot of the
+    /// target.
+    static version_type restore_changes(std::istream& in, SharedGroup& target);
+
     /// Compact the database file.
     /// - The method will throw if called inside a transaction.
     /// - The method will throw if called in unattached state.
@@ -590,21 +687,30 @@ private:
     std::string m_lockfile_prefix;
     std::string m_db_path;
     std::string m_coordination_dir;
+    // Where the named pipes which cannot be created in m_coordination_dir go
+    std::string m_temp_dir;
     const char* m_key;
+    SharedGroupOptions::WriteBackend m_write_backend = SharedGroupOptions::WriteBackend::Mmap;
+    SharedGroupOptions::RetentionPolicy m_retention_policy;
+    // The lagging snapshots found by the latest commit, until they are
+    // reported by report_lagging_versions()
+    std::vector<VersionStats> m_lagging_versions;
     TransactStage m_transact_stage;
     util::InterprocessMutex m_writemutex;
 #ifdef REALM_ASYNC_DAEMON
     util::InterprocessMutex m_balancemutex;
 #endif
     util::InterprocessMutex m_controlmutex;
-#ifdef REALM_ASYNC_DAEMON
-    util::InterprocessCondVar m_room_to_write;
-    util::InterprocessCondVar m_work_to_do;
-    util::InterprocessCondVar m_daemon_becomes_ready;
-#endif
     util::InterprocessCondVar m_new_commit_available;
     util::InterprocessCondVar m_pick_next_writer;
     std::function<void(int, int)> m_upgrade_callback;
+    std::unique_ptr<_impl::CommitListener> m_commit_listener;
+    std::unique_ptr<_impl::CommitNotifier> m_commit_notifier;
+    std::unique_ptr<_impl::FileGrower> m_file_grower;
+    std::unique_ptr<_impl::AsyncCommitter> m_async_committer;
+    // Set in the SharedGroup of an AsyncCommitter when m_read_lock is held
+    // on the latest durable snapshot
+    bool m_pins_durable_version = false;
 
 #if REALM_METRICS
     std::shared_ptr<metrics::Metrics> m_metrics;
@@ -668,7 +774,24 @@ private:
     // mutex.
     void low_level_commit(uint_fast64_t new_version);
 
-    void do_async_commits();
+    // Returns the bound snapshots of versions up to the specified one, oldest
+    // first, without their locked space.
+    std::vector<VersionStats> get_bound_versions(version_type latest_version);
+
+    // True if read transactions bound to the snapshot of the specified version
+    // have been invalidated by a retention policy.
+    bool is_invalidated(version_type) const noexcept;
+
+    // Pass the lagging snapshots found by the latest commit, if any, to the
+    // callback of the retention policy. Must be called once the commit has
+    // completed and the write mutex is released. Exceptions thrown by the
+    // callback are not propagated.
+    void report_lagging_versions() noexcept;
+
+    /// Make the latest snapshot durable, if it is not already, and move the
+    /// read lock held on the latest durable snapshot to it. Only for the
+    /// SharedGroup of an AsyncCommitter.
+    void flush_async_commits();
 
     /// Upgrade file format and/or history schema
     void upgrade_file_format(bool allow_file_format_upgrade, int target_file_format_version,
@@ -1073,6 +1196,12 @@ inline bool SharedGroup::do_advance_read(O* observer, VersionID version_id, _imp
     ReadLockInfo new_read_lock;
     grab_read_lock(new_read_lock, version_id); // Throws
     REALM_ASSERT(new_read_lock.m_version >= m_read_lock.m_version);
+    // The history may have been trimmed beyond an invalidated snapshot by the
+    // commit of the new one, or any earlier commit
+    if (is_invalidated(m_read_lock.m_version)) {
+        release_read_lock(new_read_lock);
+        throw BadVersion();
+    }
     if (new_read_lock.m_version == m_read_lock.m_version) {
         release_read_lock(new_read_lock);
         // _impl::History::update_from_ref() was not called
@@ -1176,7 +1305,7 @@ public:
         sg.rollback_and_continue_as_read(obs); // Throws
     }
 
-    static void async_daemon_open(SharedGroup& sg, const std::string& file)
+    static void async_committer_open(SharedGroup& sg, const std::string& file, const std::string& temp_dir)
     {
         bool no_create = true;
         bool is_backend = true;
@@ -1184,9 +1313,15 @@ public:
         options.durability = SharedGroupOptions::Durability::Async;
         options.encryption_key = nullptr;
         options.allow_file_format_upgrade = false;
+        options.temp_dir = temp_dir;
         sg.do_open(file, no_create, is_backend, options); // Throws
     }
 
+    static void flush_async_commits(SharedGroup& sg)
+    {
+        sg.flush_async_commits(); // Throws
+    }
+
     static int get_file_format_version(const SharedGroup& sg) noexcept
     {
         return sg.get_file_format_version();
@@ -19,8 +19,12 @@
 #ifndef REALM_GROUP_SHARED_OPTIONS_HPP
 #define REALM_GROUP_SHARED_OPTIONS_HPP
 
+#include <chrono>
 #include <functional>
 #include <string>
+#include <vector>
+
+#include <realm/util/memory_policy.hpp>
 
 namespace realm {
 
@@ -31,15 +35,28 @@ struct SharedGroupOptions {
     enum class Durability : uint16_t {
         Full,
         MemOnly,
-        Async, ///< Not yet supported on windows.
+        Async, ///< Commits are made durable in the background. Not supported on
+               ///< windows, nor for encrypted files.
         Unsafe  // If you use this, you loose ACID property
     };
 
+    /// How the arrays of a commit are written to the file.
+    enum class WriteBackend {
+        /// Through memory mappings of the file, which are then flushed.
+        Mmap,
+        /// Collected in memory, and then written with a few positional
+        /// writes (`pwritev()` on Linux), followed by a single `fdatasync()`.
+        /// Not used for encrypted files, which are always written through
+        /// memory mappings.
+        Pwrite
+    };
+
     explicit SharedGroupOptions(Durability level = Durability::Full, const char* key = nullptr,
                                 bool allow_upgrade = true,
                                 std::function<void(int, int)> file_upgrade_callback = std::function<void(int, int)>(),
                                 std::string temp_directory = sys_tmp_dir, bool track_metrics = false,
-                                size_t metrics_history_size = 10000)
+                                size_t metrics_history_size = 10000, bool grow_file_in_background = false,
+                                WriteBackend backend = WriteBackend::Mmap)
         : durability(level)
         , encryption_key(key)
         , allow_file_format_upgrade(allow_upgrade)
@@ -47,7 +64,8 @@ struct SharedGroupOptions {
         , temp_dir(temp_directory)
         , enable_metrics(track_metrics)
         , metrics_buffer_size(metrics_history_size)
-
+        , background_file_growth(grow_file_in_background)
+        , write_backend(backend)
     {
     }
 
@@ -59,6 +77,8 @@ struct SharedGroupOptions {
         , temp_dir(sys_tmp_dir)
         , enable_metrics(false)
         , metrics_buffer_size(10000)
+        , background_file_growth(false)
+        , write_backend(WriteBackend::Mmap)
     {
     }
 
@@ -102,6 +122,105 @@ struct SharedGroupOptions {
     /// is exceeded without being consumed, only the most recent entries will be stored.
     size_t metrics_buffer_size;
 
+    /// If set to `true`, the file is extended on a background thread ahead of
+    /// the commits which need the space, by an amount predicted from the
+    /// growth of the most recent commits, so that large write transactions
+    /// rarely wait for the file to grow. The file may then be larger than
+    /// strictly needed. Each SharedGroup opened this way runs its own thread.
+    bool background_file_growth;
+
+    /// The way commits made through this SharedGroup are written to the
+    /// file. Each SharedGroup can use a different one. See WriteBackend.
+    WriteBackend write_backend;
+
+    /// Huge page and NUMA placement hints for the memory holding the
+    /// database, see util::MemoryPolicy. Slabs follow the policy of the
+    /// SharedGroup which allocates them, while the mappings of the file are
+    /// shared by all SharedGroups of a process, and follow the policy of the
+    /// first one to open the file.
+    util::MemoryPolicy memory_policy;
+
+    /// With Durability::Async, the longest time a commit may remain
+    /// non-durable. Commits made within this time of each other are made
+    /// durable by a single synchronization of the file. See
+    /// SharedGroup::get_durable_version().
+    std::chrono::milliseconds async_commit_latency{10};
+
+    /// A snapshot which is bound by read transactions or pinned versions, see
+    /// SharedGroup::get_version_stats().
+    struct VersionStats {
+        uint_fast64_t version;
+
+        /// The number of read transactions and pinned versions bound to the
+        /// snapshot, not counting the transaction of the SharedGroup
+        /// reporting it.
+        size_t num_readers;
+
+        /// The time since a newer snapshot was committed, zero for the latest
+        /// snapshot.
+        std::chrono::milliseconds age;
+
+        /// The space in the file released by newer snapshots which cannot be
+        /// reused until this snapshot, and every older one, is no longer
+        /// bound.
+        size_t locked_space;
+
+        /// True if the read transactions bound to the snapshot have been
+        /// invalidated, see RetentionPolicy::invalidate_lagging_readers.
+        bool invalidated;
+    };
+
+    /// Limits on how far the snapshots bound by read transactions may lag
+    /// behind the latest one before they are considered to be lagging. As
+    /// long as a snapshot is bound, the space in the file released by newer
+    /// snapshots, and the history needed to advance from it, cannot be
+    /// reused, so a single read transaction which is never ended makes the
+    /// file grow without bound.
+    ///
+    /// The limits are checked at every commit made through the SharedGroup,
+    /// and a limit of zero is no limit. Starting from the oldest one, the
+    /// bound snapshots are lagging for as long as they exceed any of them.
+    struct RetentionPolicy {
+        /// The largest number of versions from the oldest bound snapshot to
+        /// the latest one, as reported by
+        /// SharedGroup::get_number_of_versions().
+        uint_fast64_t max_versions = 0;
+
+        /// The longest time a snapshot may stay bound after a newer one has
+        /// been committed.
+        std::chrono::milliseconds max_age{0};
+
+        /// The largest amount of space in the file which may be locked by
+        /// bound snapshots. The oldest snapshots are lagging until the space
+        /// locked by the rest is within the limit.
+        size_t max_locked_space = 0;
+
+        /// Called with the lagging snapshots, oldest first, after every commit
+        /// which finds any. It is called on the committing thread once the
+        /// commit has completed and no locks are held. As the commit has
+        /// succeeded by then, exceptions thrown by the callback are ignored.
+        std::function<void(const std::vector<VersionStats>&)> on_lagging_readers;
+
+        /// If set to `true`, lagging snapshots are invalidated. A read
+        /// transaction bound to an invalidated snapshot can be continued, but
+        /// it can no longer be advanced, nor promoted to a write transaction,
+        /// which throws SharedGroup::BadVersion instead, as does an attempt
+        /// to bind to the snapshot. The history is then trimmed as if the
+        /// snapshot was no longer bound. The space locked by the snapshot is
+        /// only released when the read transactions end, as it may still be
+        /// read.
+        bool invalidate_lagging_readers = false;
+
+        bool is_enabled() const noexcept
+        {
+            return max_versions != 0 || max_age.count() != 0 || max_locked_space != 0;
+        }
+    };
+
+    /// The limits on lagging readers checked by commits made through the
+    /// SharedGroup. See RetentionPolicy.
+    RetentionPolicy retention_policy;
+
     /// sys_tmp_dir will be used if the temp_dir is empty when creating SharedGroupOptions.
     /// It must be writable and allowed to create pipe/fifo file on it.
     /// set_sys_tmp_dir is not a thread-safe call and it is only supposed to be called once
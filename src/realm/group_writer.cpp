@@ -34,135 +34,108 @@ using namespace realm;
 using namespace realm::util;
 using namespace realm::metrics;
 
-// Class controlling a memory mapped window into a file
-class GroupWriter::MapWindow {
+// Collects the arrays written during a commit in large blocks of memory, and
+// writes them to the file, sorted by position, such that arrays which are
+// adjacent in the file are passed to the kernel together.
+class GroupWriter::WriteBuffer {
 public:
-    MapWindow(size_t alignment, util::File& f, ref_type start_ref, size_t initial_size);
-    ~MapWindow();
-
-    // translate a ref to a pointer
-    // inside the window defined during construction.
-    char* translate(ref_type ref);
-    void encryption_read_barrier(void* start_addr, size_t size);
-    void encryption_write_barrier(void* start_addr, size_t size);
-    void sync();
-    // return true if the specified range is fully visible through
-    // the MapWindow
-    bool matches(ref_type start_ref, size_t size);
-    // return false if the mapping cannot be extended to hold the
-    // requested size - extends if possible and then returns true
-    bool extends_to_match(util::File& f, ref_type start_ref, size_t size);
-
-private:
-    util::File::Map<char> m_map;
-    ref_type m_base_ref;
-    ref_type aligned_to_mmap_block(ref_type start_ref);
-    size_t get_window_size(util::File& f, ref_type start_ref, size_t size);
-    size_t m_alignment;
-};
-
-// True if a requested block fall within a memory mapping.
-bool GroupWriter::MapWindow::matches(ref_type start_ref, size_t size)
-{
-    if (start_ref < m_base_ref)
-        return false;
-    if (start_ref + size > m_base_ref + m_map.get_size())
-        return false;
-    return true;
-}
-
-// When determining which part of the file to mmap, We try to pick a 1MB window containing
-// the requested block. We align windows on 1MB boundaries. We also align window size at
-// 1MB, except in cases where the referenced part of the file straddles a 1MB boundary.
-// In that case we choose a larger window.
-//
-// In cases where a 1MB window would stretch beyond the end of the file, we choose
-// a smaller window. Anything mapped after the end of file would be undefined anyways.
-ref_type GroupWriter::MapWindow::aligned_to_mmap_block(ref_type start_ref)
-{
-    // align to 1MB boundary
-    size_t page_mask = m_alignment - 1;
-    return start_ref & ~page_mask;
-}
-
-size_t GroupWriter::MapWindow::get_window_size(util::File& f, ref_type start_ref, size_t size)
-{
-    size_t window_size = start_ref + size - m_base_ref;
-    // always map at least to match alignment
-    if (window_size < m_alignment)
-        window_size = m_alignment;
-    // but never map beyond end of file
-    size_t file_size = to_size_t(f.get_size());
-    REALM_ASSERT_DEBUG_EX(start_ref + size <= file_size, start_ref + size, file_size);
-    if (window_size > file_size - m_base_ref)
-        window_size = file_size - m_base_ref;
-    return window_size;
-}
+    explicit WriteBuffer(File& file)
+        : m_file(file)
+    {
+    }
 
-// The file may grow in increments much smaller than 1MB. This can lead to a stream of requests
-// which are each just beyond the end of the last mapping we made. It is important to extend the
-// existing window to cover the new request (if possible) as opposed to adding a new window.
-// The reason is not obvious: open windows need to be sync'ed to disk at the end of the commit,
-// and we really want to use as few calls to msync() as possible.
-//
-// extends_to_match() will extend an existing mapping to accomodate a new request if possible
-// and return true. If the request falls in a different 1MB window, it'll return false.
-bool GroupWriter::MapWindow::extends_to_match(util::File& f, ref_type start_ref, size_t size)
-{
-    size_t aligned_ref = aligned_to_mmap_block(start_ref);
-    if (aligned_ref != m_base_ref)
-        return false;
-    size_t window_size = get_window_size(f, start_ref, size);
-    // FIXME: Add a remap which will work with a offset different from 0
-    m_map.sync();
-    m_map.unmap();
-    m_map.map(f, File::access_ReadWrite, window_size, 0, m_base_ref);
-    return true;
-}
+    // Copy an array, with its checksum in place of the first 4 bytes, to be
+    // written at the specified position. May write out the buffered arrays
+    // first, if too much memory is in use.
+    void add(size_t pos, uint32_t checksum, const char* data, size_t size);
 
-GroupWriter::MapWindow::MapWindow(size_t alignment, util::File& f, ref_type start_ref, size_t size)
-    : m_alignment(alignment)
-{
-    m_base_ref = aligned_to_mmap_block(start_ref);
-    size_t window_size = get_window_size(f, start_ref, size);
-    m_map.map(f, File::access_ReadWrite, window_size, 0, m_base_ref);
-}
+    // Write all buffered arrays to the file
+    void flush();
 
-GroupWriter::MapWindow::~MapWindow()
-{
-    m_map.unmap(); /* Apparently no effect - how odd */
-}
-
-void GroupWriter::MapWindow::sync()
-{
-    m_map.sync();
-}
+private:
+    static constexpr size_t block_size = 1024 * 1024;
+    static constexpr size_t max_buffered = 32 * block_size;
+
+    struct Entry {
+        size_t pos;
+        const char* data;
+        size_t size;
+    };
+
+    File& m_file;
+    std::vector<std::unique_ptr<char[]>> m_blocks; // Reused after each flush
+    std::vector<std::unique_ptr<char[]>> m_large_blocks; // One array each
+    size_t m_num_used_blocks = 0;
+    size_t m_used_in_block = block_size;
+    size_t m_buffered = 0;
+    std::vector<Entry> m_entries;
+    std::vector<File::Segment> m_segments;
+};
 
-char* GroupWriter::MapWindow::translate(ref_type ref)
-{
-    return m_map.get_addr() + (ref - m_base_ref);
-}
+constexpr size_t GroupWriter::WriteBuffer::block_size;
+constexpr size_t GroupWriter::WriteBuffer::max_buffered;
 
-void GroupWriter::MapWindow::encryption_read_barrier(void* start_addr, size_t size)
+void GroupWriter::WriteBuffer::add(size_t pos, uint32_t checksum, const char* data, size_t size)
 {
-    realm::util::encryption_read_barrier(start_addr, size, m_map.get_encrypted_mapping());
+    REALM_ASSERT_3(size, >=, 4);
+    if (m_buffered + size > max_buffered && !m_entries.empty())
+        flush(); // Throws
+
+    char* dest;
+    if (size > block_size / 4) {
+        m_large_blocks.emplace_back(new char[size]); // Throws
+        dest = m_large_blocks.back().get();
+    }
+    else {
+        if (size > block_size - m_used_in_block) {
+            if (m_num_used_blocks == m_blocks.size())
+                m_blocks.emplace_back(new char[block_size]); // Throws
+            ++m_num_used_blocks;
+            m_used_in_block = 0;
+        }
+        dest = m_blocks[m_num_used_blocks - 1].get() + m_used_in_block;
+        m_used_in_block += size;
+    }
+    memcpy(dest, &checksum, 4);
+    memcpy(dest + 4, data + 4, size - 4);
+    m_entries.push_back({pos, dest, size}); // Throws
+    m_buffered += size;
 }
 
-void GroupWriter::MapWindow::encryption_write_barrier(void* start_addr, size_t size)
+void GroupWriter::WriteBuffer::flush()
 {
-    realm::util::encryption_write_barrier(start_addr, size, m_map.get_encrypted_mapping());
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) { return a.pos < b.pos; });
+    auto i = m_entries.begin();
+    auto end = m_entries.end();
+    while (i != end) {
+        size_t begin_pos = i->pos;
+        size_t end_pos = begin_pos;
+        m_segments.clear();
+        do {
+            m_segments.push_back({i->data, i->size}); // Throws
+            end_pos += i->size;
+            ++i;
+        } while (i != end && i->pos == end_pos);
+        REALM_ASSERT(i == end || i->pos > end_pos); // No overlap
+        m_file.write_at(File::SizeType(begin_pos), m_segments.data(), m_segments.size()); // Throws
+    }
+    m_entries.clear();
+    m_large_blocks.clear();
+    m_num_used_blocks = 0;
+    m_used_in_block = block_size;
+    m_buffered = 0;
 }
 
 
-GroupWriter::GroupWriter(Group& group, Durability dura)
+GroupWriter::GroupWriter(Group& group, Durability dura, WriteBackend backend)
     : m_group(group)
     , m_alloc(group.m_alloc)
     , m_free_positions(m_alloc)
     , m_free_lengths(m_alloc)
     , m_free_versions(m_alloc)
     , m_durability(dura)
+    , m_map_windows(m_alloc.get_write_windows())
 {
-    m_map_windows.reserve(num_map_windows);
 #if REALM_IOS
     m_window_alignment = 1 * 1024 * 1024;  // 1M
 #else
@@ -178,6 +151,9 @@ GroupWriter::GroupWriter(Group& group, Durability dura)
         m_window_alignment = wanted_size;
     }
 #endif
+    m_map_windows.set_alignment(m_window_alignment);
+    if (backend == WriteBackend::Pwrite && !m_alloc.get_file().get_encryption_key())
+        m_write_buffer.reset(new WriteBuffer(m_alloc.get_file())); // Throws
     Array& top = m_group.m_top;
     bool is_shared = m_group.m_is_shared;
 
@@ -255,7 +231,13 @@ GroupWriter::GroupWriter(Group& group, Durability dura)
     }
 }
 
-GroupWriter::~GroupWriter() = default;
+GroupWriter::~GroupWriter()
+{
+    // The windows of an encrypted file are not kept, since the decrypted
+    // pages of a mapping would not reflect commits made by other processes
+    bool keep = !m_alloc.get_file().get_encryption_key();
+    m_map_windows.end_commit(keep);
+}
 
 size_t GroupWriter::get_file_size() const noexcept
 {
@@ -267,34 +249,17 @@ void GroupWriter::sync_all_mappings()
 {
     if (m_durability == Durability::Unsafe)
         return;
-    for (const auto& window : m_map_windows) {
-        window->sync();
-    }
+    m_map_windows.sync_all(m_alloc.get_file()); // Throws
 }
 
 // Get a window matching a request, either creating a new window or reusing an
-// existing one (possibly extended to accomodate the new request). Maintain a
-// cache of open windows which are sync'ed and closed following a least recently
-// used policy. Entries in the cache are kept in MRU order.
+// existing one (possibly extended to accomodate the new request). The windows
+// are kept from one commit to the next. If there are too many, the least
+// recently used is sync'ed and closed.
 GroupWriter::MapWindow* GroupWriter::get_window(ref_type start_ref, size_t size)
 {
-    auto match = std::find_if(m_map_windows.begin(), m_map_windows.end(), [=](auto& window) {
-        return window->matches(start_ref, size) || window->extends_to_match(m_alloc.get_file(), start_ref, size);
-    });
-    if (match != m_map_windows.end()) {
-        // move matching window to top (to keep LRU order)
-        std::rotate(m_map_windows.begin(), match, match + 1);
-        return m_map_windows[0].get();
-    }
-    // no window found, make room for a new one at the top
-    if (m_map_windows.size() == num_map_windows) {
-        if (m_durability != Durability::Unsafe)
-            m_map_windows.back()->sync();
-        m_map_windows.pop_back();
-    }
-    auto new_window = std::make_unique<MapWindow>(m_window_alignment, m_alloc.get_file(), start_ref, size);
-    m_map_windows.insert(m_map_windows.begin(), std::move(new_window));
-    return m_map_windows[0].get();
+    bool sync_evicted = m_durability != Durability::Unsafe;
+    return m_map_windows.get_window(m_alloc.get_file(), start_ref, size, sync_evicted); // Throws
 }
 
 #define REALM_ALLOC_DEBUG 0
@@ -500,9 +465,13 @@ ref_type GroupWriter::write_group()
 
     // The free-list now have their final form, so we can write them to the file
     // char* start_addr = m_file_map.get_addr() + reserve_ref;
-    MapWindow* window = get_window(reserve_ref, end_ref - reserve_ref);
-    char* start_addr = window->translate(reserve_ref);
-    window->encryption_read_barrier(start_addr, used);
+    MapWindow* window = nullptr;
+    char* start_addr = nullptr;
+    if (!m_write_buffer) {
+        window = get_window(reserve_ref, end_ref - reserve_ref);
+        start_addr = window->translate(reserve_ref);
+        window->encryption_read_barrier(start_addr, used);
+    }
     write_array_at(window, free_positions_ref, m_free_positions.get_header(), free_positions_size); // Throws
     write_array_at(window, free_sizes_ref, m_free_lengths.get_header(), free_sizes_size);           // Throws
     if (is_shared) {
@@ -511,7 +480,14 @@ ref_type GroupWriter::write_group()
 
     // Write top
     write_array_at(window, top_ref, top.get_header(), top_byte_size); // Throws
-    window->encryption_write_barrier(start_addr, used);
+    if (window) {
+        window->encryption_write_barrier(start_addr, used);
+    }
+    else {
+        // Also in Durability::MemOnly mode, where commit() is not called,
+        // the data must reach the file before other sessions can see it
+        m_write_buffer->flush(); // Throws
+    }
     // Return top_ref so that it can be saved in lock file used for coordination
     return top_ref;
 }
@@ -837,6 +813,11 @@ ref_type GroupWriter::write_array(const char* data, size_t size, uint32_t checks
     // Get position of free space to write in (expanding file if needed)
     size_t pos = get_free_space(size);
 
+    if (m_write_buffer) {
+        m_write_buffer->add(pos, checksum, data, size); // Throws
+        return to_ref(pos);
+    }
+
     // Write the block
     MapWindow* window = get_window(pos, size);
     char* dest_addr = window->translate(pos);
@@ -845,6 +826,7 @@ ref_type GroupWriter::write_array(const char* data, size_t size, uint32_t checks
     memcpy(dest_addr, &checksum, 4);
     memcpy(dest_addr + 4, data + 4, size - 4);
     window->encryption_write_barrier(dest_addr, size);
+    window->mark_dirty(pos, size);
     // return ref of the written array
     ref_type ref = to_ref(pos);
     return ref;
@@ -857,17 +839,28 @@ void GroupWriter::write_array_at(MapWindow* window, ref_type ref, const char* da
 
     REALM_ASSERT_3(pos + size, <=, to_size_t(m_group.m_top.get(2) / 2));
     // REALM_ASSERT_3(pos + size, <=, m_file_map.get_size());
+    uint32_t dummy_checksum = 0x41414141UL; // "AAAA" in ASCII
+    if (!window) {
+        m_write_buffer->add(pos, dummy_checksum, data, size); // Throws
+        return;
+    }
+
     char* dest_addr = window->translate(pos);
     REALM_ASSERT_RELEASE(is_aligned(dest_addr));
  
-    uint32_t dummy_checksum = 0x41414141UL; // "AAAA" in ASCII
     memcpy(dest_addr, &dummy_checksum, 4);
     memcpy(dest_addr + 4, data + 4, size - 4);
+    window->mark_dirty(pos, size);
 }
 
 
 void GroupWriter::commit(ref_type new_top_ref)
 {
+    if (m_write_buffer) {
+        commit_buffered(new_top_ref); // Throws
+        return;
+    }
+
     MapWindow* window = get_window(0, sizeof(SlabAlloc::Header));
     SlabAlloc::Header& file_header = *reinterpret_cast<SlabAlloc::Header*>(window->translate(0));
     window->encryption_read_barrier(&file_header, sizeof file_header);
@@ -903,6 +896,7 @@ void GroupWriter::commit(ref_type new_top_ref)
     // stable storage before flipping the slot selector
     window->encryption_write_barrier(&file_header.m_top_ref[slot_selector], 
                                      sizeof(file_header.m_top_ref[slot_selector]));
+    window->mark_dirty(0, sizeof file_header);
     if (!disable_sync)
         sync_all_mappings();
 
@@ -913,11 +907,57 @@ void GroupWriter::commit(ref_type new_top_ref)
     // Write new selector to disk
     // FIXME: we might optimize this to write of a single page?
     window->encryption_write_barrier(&file_header.m_flags, sizeof(file_header.m_flags));
+    window->mark_dirty(0, sizeof file_header);
     if (!disable_sync)
         window->sync();
 }
 
 
+// The same as commit(), except that the header is read and written with
+// positional reads and writes, and only the data of the file is synchronized
+void GroupWriter::commit_buffered(ref_type new_top_ref)
+{
+    // When running the test suite, device synchronization is disabled
+    bool disable_sync = get_disable_sync_to_disk() || m_durability == Durability::Unsafe;
+
+#if REALM_METRICS
+    std::unique_ptr<MetricTimer> fsync_timer = Metrics::report_fsync_time(m_group);
+#endif // REALM_METRICS
+
+    // All arrays have been written by write_group(), so a single
+    // synchronization covers them and the new top ref
+    commit_to_file(m_alloc.get_file(), new_top_ref, m_group.get_file_format_version(), !disable_sync); // Throws
+}
+
+
+void GroupWriter::commit_to_file(File& file, ref_type new_top_ref, int file_format_version, bool sync)
+{
+    SlabAlloc::Header file_header;
+    size_t n = file.read_at(0, reinterpret_cast<char*>(&file_header), sizeof file_header); // Throws
+    REALM_ASSERT_RELEASE(n == sizeof file_header);
+
+    unsigned old_flags = file_header.m_flags;
+    unsigned new_flags = old_flags ^ SlabAlloc::flags_SelectBit;
+    int slot_selector = ((new_flags & SlabAlloc::flags_SelectBit) != 0 ? 1 : 0);
+
+    using type_1 = std::remove_reference<decltype(file_header.m_file_format[0])>::type;
+    REALM_ASSERT(!util::int_cast_has_overflow<type_1>(file_format_version));
+    file_header.m_file_format[slot_selector] = type_1(file_format_version);
+    file_header.m_top_ref[slot_selector] = new_top_ref;
+
+    file.write_at(0, reinterpret_cast<const char*>(&file_header), sizeof file_header); // Throws
+    if (sync)
+        file.sync_data(); // Throws
+
+    // Flip the slot selector bit.
+    using type_2 = std::remove_reference<decltype(file_header.m_flags)>::type;
+    file_header.m_flags = type_2(new_flags);
+    file.write_at(0, reinterpret_cast<const char*>(&file_header), sizeof file_header); // Throws
+    if (sync)
+        file.sync_data(); // Throws
+}
+
+
 #ifdef REALM_DEBUG
 
 void GroupWriter::dump()
@@ -22,10 +22,12 @@
 #include <cstdint> // unint8_t etc
 #include <utility>
 #include <map>
+#include <memory>
 
 #include <realm/util/file.hpp>
 #include <realm/alloc.hpp>
 #include <realm/impl/array_writer.hpp>
+#include <realm/impl/map_window_cache.hpp>
 #include <realm/array_integer.hpp>
 #include <realm/group_shared_options.hpp>
 
@@ -52,8 +54,13 @@ public:
     // (Group::m_is_shared), the constructor also adds version tracking
     // information to the group, if it is not already present (6th and 7th entry
     // in Group::m_top).
+    //
+    // With WriteBackend::Pwrite, the arrays are collected in memory and
+    // written by write_group() with positional writes instead of through
+    // memory mappings, unless the file is encrypted.
     using Durability = SharedGroupOptions::Durability;
-    GroupWriter(Group&, Durability dura = Durability::Full);
+    using WriteBackend = SharedGroupOptions::WriteBackend;
+    GroupWriter(Group&, Durability dura = Durability::Full, WriteBackend backend = WriteBackend::Mmap);
     ~GroupWriter();
 
     void set_versions(uint64_t current, uint64_t read_lock) noexcept;
@@ -69,6 +76,14 @@ public:
     /// returned by write_group().
     void commit(ref_type new_top_ref);
 
+    /// Make the snapshot with the specified top ref the one selected by the
+    /// header of the specified unencrypted database file, using positional
+    /// reads and writes. All arrays of the snapshot must already have been
+    /// written to the file. If `sync` is true, the data of the file is
+    /// synchronized to stable storage before the slot selector is flipped,
+    /// and again after.
+    static void commit_to_file(util::File&, ref_type new_top_ref, int file_format_version, bool sync);
+
     size_t get_file_size() const noexcept;
 
     ref_type write_array(const char*, size_t, uint32_t) override;
@@ -87,8 +102,20 @@ public:
         return m_locked_space_size;
     }
 
+    /// The sizes of the chunks in the free-list of the new snapshot, and the
+    /// versions at which they were released. Valid after write_group().
+    const ArrayInteger& get_free_lengths() const noexcept
+    {
+        return m_free_lengths;
+    }
+
+    const ArrayInteger& get_free_versions() const noexcept
+    {
+        return m_free_versions;
+    }
+
 private:
-    class MapWindow;
+    using MapWindow = _impl::MapWindow;
     Group& m_group;
     SlabAlloc& m_alloc;
     ArrayInteger m_free_positions; // 4th slot in Group::m_top
@@ -127,14 +154,9 @@ private:
 
     void read_in_freelist();
     size_t recreate_freelist(size_t reserve_pos);
-    // Currently cached memory mappings. We keep as many as 16 1MB windows
-    // open for writing. The allocator will favor sequential allocation
-    // from a modest number of windows, depending upon fragmentation, so
-    // 16 windows should be more than enough. If more than 16 windows are
-    // needed, the least recently used is sync'ed and closed to make room
-    // for a new one. The windows are kept in MRU (most recently used) order.
-    const static int num_map_windows = 16;
-    std::vector<std::unique_ptr<MapWindow>> m_map_windows;
+    // Currently cached memory mappings, owned by the allocator so that they
+    // are kept from one commit to the next (see _impl::MapWindowCache).
+    _impl::MapWindowCache& m_map_windows;
 
     // Get a suitable memory mapping for later access:
     // potentially adding it to the cache, potentially closing
@@ -144,6 +166,14 @@ private:
     // Sync all cached memory mappings
     void sync_all_mappings();
 
+    // Arrays waiting to be written to the file when the Pwrite backend is
+    // used, null otherwise.
+    class WriteBuffer;
+    std::unique_ptr<WriteBuffer> m_write_buffer;
+
+    // commit() for the Pwrite backend
+    void commit_buffered(ref_type new_top_ref);
+
     /// Allocate a chunk of free space of the specified size. The
     /// specified size must be 8-byte aligned. Extend the file if
     /// required. The returned chunk is removed from the amount of
@@ -183,6 +213,7 @@ private:
     /// size, and `chunk_size` is the size of that chunk.
     FreeListElement extend_free_space(size_t requested_size);
 
+    // A null window means that the array must be added to m_write_buffer
     void write_array_at(MapWindow* window, ref_type, const char* data, size_t size);
     FreeListElement split_freelist_chunk(FreeListElement, size_t alloc_pos);
 };
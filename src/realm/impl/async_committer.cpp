@@ -0,0 +1,102 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/impl/async_committer.hpp>
+
+#include <realm/group_shared.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+AsyncCommitter::AsyncCommitter(const std::string& path, const std::string& temp_dir,
+                               std::chrono::milliseconds max_latency)
+    : m_shared_group(new SharedGroup(SharedGroup::unattached_tag())) // Throws
+    , m_temp_dir(temp_dir)
+    , m_max_latency(max_latency)
+{
+    using sgf = SharedGroupFriend;
+    sgf::async_committer_open(*m_shared_group, path, temp_dir); // Throws
+    sgf::flush_async_commits(*m_shared_group);                  // Throws
+    m_thread = std::thread([this] { run(); });                 // Throws
+}
+
+AsyncCommitter::~AsyncCommitter() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+void AsyncCommitter::on_commit() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_commit_pending)
+            return;
+        m_commit_pending = true;
+        m_first_pending = clock::now();
+    }
+    m_cond.notify_all();
+}
+
+void AsyncCommitter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    uint_fast64_t ticket = ++m_flush_requests;
+    m_cond.notify_all();
+    m_cond.wait(lock, [&] { return m_flushes_done >= ticket; });
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void AsyncCommitter::run() noexcept
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cond.wait(lock, [&] { return m_stop || m_commit_pending || m_flush_requests != m_flushes_done; });
+
+        // Let more commits arrive, unless someone is waiting
+        clock::time_point deadline = m_first_pending + m_max_latency;
+        m_cond.wait_until(lock, deadline, [&] { return m_stop || m_flush_requests != m_flushes_done; });
+
+        bool stop = m_stop;
+        uint_fast64_t requests = m_flush_requests;
+        m_commit_pending = false;
+        std::exception_ptr error;
+        lock.unlock();
+        try {
+            SharedGroupFriend::flush_async_commits(*m_shared_group); // Throws
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+        if (error)
+            m_error = error;
+        m_flushes_done = requests;
+        m_cond.notify_all();
+        if (stop)
+            return;
+    }
+}
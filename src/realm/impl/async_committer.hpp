@@ -0,0 +1,91 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_ASYNC_COMMITTER_HPP
+#define REALM_IMPL_ASYNC_COMMITTER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace realm {
+
+class SharedGroup;
+
+namespace _impl {
+
+/// Makes the commits of a SharedGroup opened with Durability::Async durable
+/// on a background thread of the same process. Commits return as soon as the
+/// new snapshot is visible to readers, and the thread makes the latest
+/// snapshot durable at most `max_latency` after the first commit which is not
+/// yet durable, so that a burst of commits costs a single synchronization of
+/// the file.
+///
+/// The committer keeps a read lock on the latest durable snapshot through a
+/// SharedGroup of its own, so that its space is not reused by later commits
+/// before a newer snapshot has been made durable. The committers of all
+/// processes in a session cooperate through the shared `durable_version`.
+class AsyncCommitter {
+public:
+    /// Makes the latest snapshot durable before returning.
+    AsyncCommitter(const std::string& path, const std::string& temp_dir,
+                   std::chrono::milliseconds max_latency); // Throws
+    ~AsyncCommitter() noexcept;
+
+    /// Must be called after every commit. Does not block on the file system.
+    void on_commit() noexcept;
+
+    /// Wait until the snapshot which was the latest when called has been made
+    /// durable. Rethrows an exception thrown by the background thread while
+    /// making a snapshot durable, if any.
+    void flush();
+
+    std::chrono::milliseconds get_max_latency() const noexcept
+    {
+        return m_max_latency;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    std::unique_ptr<SharedGroup> m_shared_group;
+    const std::string m_temp_dir;
+    const std::chrono::milliseconds m_max_latency;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_commit_pending = false;        // Protected by m_mutex
+    clock::time_point m_first_pending;    // Protected by m_mutex
+    uint_fast64_t m_flush_requests = 0;   // Protected by m_mutex
+    uint_fast64_t m_flushes_done = 0;     // Protected by m_mutex
+    std::exception_ptr m_error;           // Protected by m_mutex
+    bool m_stop = false;                  // Protected by m_mutex
+    std::thread m_thread;
+
+    void run() noexcept;
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_ASYNC_COMMITTER_HPP
@@ -0,0 +1,275 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/impl/commit_notifier.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+
+#include <realm/util/features.h>
+#include <realm/util/fifo_helper.hpp>
+#include <realm/util/file.hpp>
+
+#if !defined(_WIN32) && !REALM_TVOS
+#define REALM_HAVE_COMMIT_NOTIFIER 1
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define REALM_HAVE_COMMIT_NOTIFIER 0
+#endif
+
+using namespace realm;
+using namespace realm::_impl;
+
+#if REALM_HAVE_COMMIT_NOTIFIER
+
+namespace {
+
+const char listener_prefix[] = "listener.";
+const char lock_suffix[] = ".lock";
+
+std::atomic<unsigned long> listener_counter(0);
+
+bool is_listener_pipe(const std::string& name)
+{
+    if (name.compare(0, sizeof listener_prefix - 1, listener_prefix) != 0)
+        return false;
+    size_t suffix_size = sizeof lock_suffix - 1;
+    return name.size() < suffix_size || name.compare(name.size() - suffix_size, suffix_size, lock_suffix) != 0;
+}
+
+// Returns true if the listener which created the pipe at `path` is gone, that is, if the lock on its lock file can
+// be taken, or if there is no lock file, as that is created before the pipe and removed after it. The pipe, and the
+// lock file, are then removed.
+bool remove_if_abandoned(const std::string& path) noexcept
+{
+    try {
+        std::string lock_path = path + lock_suffix;
+        util::File lock_file;
+        try {
+            lock_file.open(lock_path, util::File::access_ReadOnly, util::File::create_Never, 0); // Throws
+        }
+        catch (const util::File::NotFound&) {
+            ::unlink(path.c_str());
+            return true;
+        }
+        if (!lock_file.try_lock_exclusive()) // Throws
+            return false;
+        // A listener which was destroyed while the lock file was being opened has removed both files already, and
+        // another listener may have taken over their names since
+        if (!lock_file.is_removed()) { // Throws
+            ::unlink(path.c_str());
+            ::unlink(lock_path.c_str());
+        }
+        return true;
+    }
+    catch (...) {
+        // Such as when the lock file may not be opened by this process. The listener is then assumed to be alive.
+        return false;
+    }
+}
+
+// Where named pipes cannot be created in `dir`, listeners are created here instead. Like the named pipes of
+// InterprocessCondVar, it is named after a hash of `dir`, as hash collisions only lead to spurious notifications.
+std::string get_fallback_dir(const std::string& dir, const std::string& temp_dir)
+{
+    return util::normalize_dir(temp_dir) + "realm_" + std::to_string(std::hash<std::string>()(dir)) +
+           ".commit_listeners";
+}
+
+} // anonymous namespace
+
+CommitListener::CommitListener(const std::string& dir, const std::string& temp_dir)
+{
+    if (!create(dir, true)) // Throws
+        create(get_fallback_dir(dir, temp_dir), false); // Throws
+}
+
+bool CommitListener::create(const std::string& dir, bool fallback_allowed)
+{
+    util::try_make_dir(dir); // Throws
+    // The lock file is locked before the pipe is created, so that a pipe is never mistaken for an abandoned one.
+    // Creating the lock file exclusively makes the name unique among all processes sharing the directory.
+    for (;;) {
+        m_path = dir + "/" + listener_prefix + std::to_string(getpid()) + "." + std::to_string(++listener_counter);
+        try {
+            m_lock_file.open(m_path + lock_suffix, util::File::access_ReadWrite, util::File::create_Must,
+                             0); // Throws
+            break;
+        }
+        catch (const util::File::Exists&) {
+        }
+    }
+    bool created;
+    try {
+        m_lock_file.lock_exclusive(); // Throws
+        created = util::try_create_fifo(m_path);
+        if (!created && !fallback_allowed)
+            util::create_fifo(m_path); // Throws
+    }
+    catch (...) {
+        ::unlink((m_path + lock_suffix).c_str());
+        throw;
+    }
+    if (!created) {
+        ::unlink((m_path + lock_suffix).c_str());
+        m_lock_file.close();
+        return false;
+    }
+    // Opening the pipe for both reading and writing means that the descriptor never reports end of file, even when
+    // no notifier has it open
+    m_fd = ::open(m_path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd == -1) {
+        int err = errno;
+        ::unlink(m_path.c_str());
+        ::unlink((m_path + lock_suffix).c_str());
+        throw std::system_error(err, std::system_category());
+    }
+    return true;
+}
+
+CommitListener::~CommitListener() noexcept
+{
+    ::close(m_fd);
+    ::unlink(m_path.c_str());
+    ::unlink((m_path + lock_suffix).c_str());
+    // The lock is released when m_lock_file is closed
+}
+
+void CommitListener::clear() noexcept
+{
+    char buffer[256];
+    while (::read(m_fd, buffer, sizeof buffer) > 0) {
+    }
+}
+
+CommitNotifier::CommitNotifier(const std::string& dir, const std::string& temp_dir)
+{
+    m_dirs[0].path = dir;
+    m_dirs[1].path = get_fallback_dir(dir, temp_dir);
+}
+
+CommitNotifier::~CommitNotifier() noexcept
+{
+    for (Directory& dir : m_dirs)
+        close_pipes(dir);
+}
+
+void CommitNotifier::notify() noexcept
+{
+    for (Directory& dir : m_dirs) {
+        update(dir);
+        for (const Pipe& pipe : dir.pipes) {
+            // A full pipe already has a notification pending
+            char c = 0;
+            static_cast<void>(::write(pipe.fd, &c, 1));
+        }
+    }
+}
+
+void CommitNotifier::update(Directory& dir) noexcept
+{
+    struct stat dir_stat;
+    if (::stat(dir.path.c_str(), &dir_stat) != 0) {
+        // No listener has ever been created there
+        close_pipes(dir);
+        return;
+    }
+
+    // The modification time of the directory only has a limited resolution, so listeners which are added in the
+    // same tick as the previous scan do not change it. Until the scan is safely later than the last change, the
+    // directory is therefore rescanned every time.
+    if (dir_stat.st_mtime != dir.mtime || dir.scan_time <= dir.mtime + 1) {
+        dir.mtime = dir_stat.st_mtime;
+        dir.scan_time = ::time(nullptr);
+        scan(dir);
+    }
+}
+
+void CommitNotifier::scan(Directory& dir) noexcept
+{
+    try {
+        std::vector<Pipe> pipes;
+        util::DirScanner scanner(dir.path, true); // Throws
+        std::string name;
+        while (scanner.next(name)) { // Throws
+            if (!is_listener_pipe(name))
+                continue;
+            std::string path = dir.path + "/" + name;
+            if (remove_if_abandoned(path))
+                continue;
+            auto i = std::find_if(dir.pipes.begin(), dir.pipes.end(), [&](const Pipe& p) { return p.name == name; });
+            if (i != dir.pipes.end()) {
+                pipes.push_back(std::move(*i));
+                dir.pipes.erase(i);
+                continue;
+            }
+            // Opening for writing only would fail or block when the listener is gone, and writing to a pipe
+            // without readers raises SIGPIPE
+            int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+            if (fd != -1)
+                pipes.push_back(Pipe{std::move(name), fd});
+        }
+        close_pipes(dir);
+        dir.pipes = std::move(pipes);
+    }
+    catch (...) {
+        // Keep notifying the listeners which were known already
+    }
+}
+
+void CommitNotifier::close_pipes(Directory& dir) noexcept
+{
+    for (const Pipe& pipe : dir.pipes)
+        ::close(pipe.fd);
+    dir.pipes.clear();
+}
+
+#else // !REALM_HAVE_COMMIT_NOTIFIER
+
+CommitListener::CommitListener(const std::string&, const std::string&)
+{
+    throw std::runtime_error("Commit notifications are not supported on this platform");
+}
+
+CommitListener::~CommitListener() noexcept
+{
+}
+
+void CommitListener::clear() noexcept
+{
+}
+
+CommitNotifier::CommitNotifier(const std::string&, const std::string&)
+{
+}
+
+CommitNotifier::~CommitNotifier() noexcept
+{
+}
+
+void CommitNotifier::notify() noexcept
+{
+}
+
+#endif // REALM_HAVE_COMMIT_NOTIFIER
@@ -0,0 +1,106 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_COMMIT_NOTIFIER_HPP
+#define REALM_IMPL_COMMIT_NOTIFIER_HPP
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <realm/util/file.hpp>
+
+namespace realm {
+namespace _impl {
+
+// Commit notifications which can be waited for with poll(), select() or
+// epoll. Every listener creates a named pipe in a directory shared by all
+// processes which have the database open, and notifiers write a byte to
+// each pipe they find there after every commit.
+//
+// Next to its pipe, every listener holds an exclusive lock on a file of the
+// same name with a `.lock` suffix for as long as it exists. A pipe whose lock
+// can be taken was left behind by a listener which is gone, and is removed.
+// Process IDs are not used for this, as they may be reused, and processes
+// in different PID namespaces may share the directory.
+//
+// Where the file system does not support named pipes, listeners are created
+// in a directory under the temporary directory instead, named after the
+// shared one, and notifiers scan both.
+//
+// Not supported on Windows and tvOS, where creating a listener throws, and
+// notifying does nothing.
+class CommitListener {
+public:
+    CommitListener(const std::string& dir, const std::string& temp_dir); // Throws
+    ~CommitListener() noexcept;
+
+    // The read end of the pipe. It is nonblocking.
+    int get_fd() const noexcept
+    {
+        return m_fd;
+    }
+
+    // Discard all pending notifications
+    void clear() noexcept;
+
+private:
+    std::string m_path;
+    util::File m_lock_file;
+    int m_fd = -1;
+
+    // Returns false if named pipes are not supported in `dir`, unless
+    // `fallback_allowed` is false, in which case it throws
+    bool create(const std::string& dir, bool fallback_allowed);
+};
+
+class CommitNotifier {
+public:
+    CommitNotifier(const std::string& dir, const std::string& temp_dir);
+    ~CommitNotifier() noexcept;
+
+    // Wake up all listeners. Failures to reach a listener are ignored.
+    void notify() noexcept;
+
+private:
+    struct Pipe {
+        std::string name;
+        int fd;
+    };
+
+    struct Directory {
+        std::string path;
+        std::vector<Pipe> pipes;
+        // The modification time of the directory when it was last scanned
+        // for listeners, and the time of the scan
+        time_t mtime = 0;
+        time_t scan_time = 0;
+    };
+
+    // The shared directory, and the fallback under the temporary directory
+    Directory m_dirs[2];
+
+    void update(Directory&) noexcept;
+    void scan(Directory&) noexcept;
+    void close_pipes(Directory&) noexcept;
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_COMMIT_NOTIFIER_HPP
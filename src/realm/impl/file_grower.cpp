@@ -0,0 +1,143 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/impl/file_grower.hpp>
+
+#include <algorithm>
+
+#include <realm/alloc_slab.hpp>
+#include <realm/util/file_mapper.hpp>
+#include <realm/util/safe_int_ops.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+constexpr size_t FileGrower::history_size;
+constexpr size_t FileGrower::lookahead_factor;
+
+FileGrower::FileGrower(const std::string& path, const char* encryption_key, bool sync, const SlabAlloc& alloc,
+                       util::InterprocessMutex& write_mutex)
+    : m_file(path, util::File::mode_Update) // Throws
+    , m_sync(sync)
+    , m_alloc(alloc)
+    , m_write_mutex(write_mutex)
+{
+    m_file.set_encryption_key(encryption_key);
+    m_thread = std::thread([this] { run(); }); // Throws
+}
+
+FileGrower::~FileGrower() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+void FileGrower::on_commit(size_t logical_file_size) noexcept
+{
+    if (m_num_commits != 0) {
+        size_t growth = logical_file_size > m_last_logical_size ? logical_file_size - m_last_logical_size : 0;
+        m_growth[m_num_commits % history_size] = growth;
+    }
+    ++m_num_commits;
+    m_last_logical_size = logical_file_size;
+
+    size_t predicted = *std::max_element(m_growth, m_growth + history_size);
+    if (predicted == 0)
+        return;
+    size_t target_size = logical_file_size;
+    if (util::int_multiply_with_overflow_detect(predicted, lookahead_factor) ||
+        util::int_add_with_overflow_detect(target_size, predicted))
+        return;
+    if (!m_alloc.matches_section_boundary(target_size))
+        target_size = m_alloc.get_upper_section_boundary(target_size);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (target_size <= m_target_size)
+            return;
+        m_target_size = target_size;
+    }
+    m_cond.notify_all();
+}
+
+void FileGrower::wait_until_idle() noexcept
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, [&] { return !m_busy && m_target_size == 0; });
+}
+
+void FileGrower::run() noexcept
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cond.wait(lock, [&] { return m_stop || m_target_size != 0; });
+        if (m_stop)
+            return;
+        size_t target_size = m_target_size;
+        m_target_size = 0;
+        m_busy = true;
+        lock.unlock();
+        try {
+            grow(target_size); // Throws
+        }
+        catch (...) {
+            // Typically out of disk space. The committing thread will run into
+            // the same problem when it actually needs the space, and report it.
+        }
+        lock.lock();
+        m_busy = false;
+        m_cond.notify_all();
+    }
+}
+
+void FileGrower::grow(size_t target_size)
+{
+    if (util::File::SizeType(target_size) <= m_file.get_size())
+        return;
+    // posix_fallocate() never shrinks the file nor changes its contents, so it
+    // may run concurrently with a writer extending or writing to the file, in
+    // this or any other process. Elsewhere the file is extended by writing
+    // zeros past its end, which must not race with a writer, so that is done
+    // while holding the write mutex.
+    if (!prealloc_atomically(target_size)) { // Throws
+        std::lock_guard<util::InterprocessMutex> lock(m_write_mutex);
+        if (util::File::SizeType(target_size) <= m_file.get_size())
+            return;
+        m_file.prealloc(target_size); // Throws
+    }
+    // A writer which finds the file extended already skips the synchronization
+    // of the new size in SlabAlloc::resize_file(), but the synchronization of
+    // its commit makes the size durable along with the data, so the write
+    // mutex is not needed here either.
+    if (m_sync)
+        m_file.sync(); // Throws
+}
+
+bool FileGrower::prealloc_atomically(size_t size)
+{
+    if (!util::File::is_prealloc_supported())
+        return false;
+    util::File::SizeType raw_size = size;
+    if (m_file.get_encryption_key())
+        raw_size = util::data_size_to_encrypted_size(raw_size);
+    return m_file.prealloc_if_supported(0, to_size_t(raw_size)); // Throws
+}
@@ -0,0 +1,102 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_FILE_GROWER_HPP
+#define REALM_IMPL_FILE_GROWER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <realm/util/file.hpp>
+#include <realm/util/interprocess_mutex.hpp>
+
+namespace realm {
+
+class SlabAlloc;
+
+namespace _impl {
+
+/// Extends the database file on a background thread ahead of the commits
+/// which need the space, so that the committing thread rarely has to wait for
+/// the file to grow. This matters most where the file cannot be preallocated
+/// by the file system, and always for encrypted files, where growing means
+/// writing out every new byte.
+///
+/// The growth of the next commits is predicted from the growth of the most
+/// recent ones. Where the system can extend the file atomically, it is done
+/// without holding the write mutex of the database, so that writers are not
+/// stalled by it, nor by the synchronization of the new size. Elsewhere the
+/// file is extended while holding the write mutex, so that it never races
+/// with a writer extending the file itself, in this or any other process.
+class FileGrower {
+public:
+    /// \param alloc The allocator of the committing SharedGroup, used to
+    /// round sizes up to section boundaries.
+    ///
+    /// \param sync Whether the new file size should be made durable.
+    FileGrower(const std::string& path, const char* encryption_key, bool sync, const SlabAlloc& alloc,
+               util::InterprocessMutex& write_mutex); // Throws
+    ~FileGrower() noexcept;
+
+    /// Must be called by the writer after every commit with the logical size
+    /// of the file after the commit. Does not block on the file system.
+    void on_commit(size_t logical_file_size) noexcept;
+
+    /// Wait until the background thread has no pending work. For testing.
+    void wait_until_idle() noexcept;
+
+    /// The number of commits of which the growth is remembered
+    static constexpr size_t history_size = 8;
+
+    /// How many times the largest recent growth the file is kept ahead of the
+    /// logical size
+    static constexpr size_t lookahead_factor = 2;
+
+private:
+    util::File m_file;
+    const bool m_sync;
+    const SlabAlloc& m_alloc;
+    util::InterprocessMutex& m_write_mutex;
+
+    // Accessed only by the committing thread
+    size_t m_growth[history_size] = {};
+    size_t m_num_commits = 0;
+    size_t m_last_logical_size = 0;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    size_t m_target_size = 0; // Protected by m_mutex
+    bool m_busy = false;      // Protected by m_mutex
+    bool m_stop = false;      // Protected by m_mutex
+    std::thread m_thread;
+
+    void run() noexcept;
+    void grow(size_t target_size);
+
+    /// Extend the file with posix_fallocate(). Returns false if the system
+    /// does not support it.
+    bool prealloc_atomically(size_t size);
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_FILE_GROWER_HPP
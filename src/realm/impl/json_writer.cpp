@@ -0,0 +1,149 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/impl/json_writer.hpp>
+
+#include <cstdio>
+#include <ctime>
+#include <limits>
+
+#include <realm/util/base64.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+
+// For each byte, the character which follows the backslash when it is escaped, or zero if it is written as is
+struct EscapeTable {
+    char codes[256] = {};
+
+    EscapeTable()
+    {
+        codes[unsigned('"')] = '"';
+        codes[unsigned('\n')] = 'n';
+        codes[unsigned('\r')] = 'r';
+        codes[unsigned('\t')] = 't';
+        codes[unsigned('\f')] = 'f';
+        codes[unsigned('\\')] = '\\';
+        codes[unsigned('\b')] = 'b';
+    }
+};
+
+const EscapeTable escape_table;
+
+} // anonymous namespace
+
+
+constexpr size_t JsonWriter::buffer_size;
+
+JsonWriter::JsonWriter(std::ostream& out)
+    : m_out(out)
+    , m_buffer(new char[buffer_size]) // Throws
+{
+}
+
+JsonWriter::~JsonWriter() noexcept
+{
+}
+
+void JsonWriter::put_int(int64_t value)
+{
+    uint64_t magnitude = value < 0 ? 0 - uint64_t(value) : uint64_t(value);
+    char digits[24];
+    char* end = digits + sizeof digits;
+    char* begin = end;
+    do {
+        *--begin = char('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0)
+        *--begin = '-';
+    put_formatted(begin, size_t(end - begin));
+}
+
+void JsonWriter::put_size(size_t value)
+{
+    char digits[24];
+    char* end = digits + sizeof digits;
+    char* begin = end;
+    do {
+        *--begin = char('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    put_formatted(begin, size_t(end - begin));
+}
+
+// The same as writing the value to a std::ostream with `std::scientific` and a precision of one more than the
+// number of significant decimal digits of the type
+void JsonWriter::put_float(float value)
+{
+    char buffer[48];
+    int size = std::snprintf(buffer, sizeof buffer, "%.*e", std::numeric_limits<float>::digits10 + 1, value);
+    put_formatted(buffer, size_t(size));
+}
+
+void JsonWriter::put_double(double value)
+{
+    char buffer[48];
+    int size = std::snprintf(buffer, sizeof buffer, "%.*e", std::numeric_limits<double>::digits10 + 1, value);
+    put_formatted(buffer, size_t(size));
+}
+
+void JsonWriter::put_escaped(StringData str)
+{
+    const char* data = str.data();
+    size_t size = str.size();
+    size_t begin = 0;
+    for (size_t i = 0; i < size; ++i) {
+        char code = escape_table.codes[static_cast<unsigned char>(data[i])];
+        if (REALM_LIKELY(code == 0))
+            continue;
+        put_formatted(data + begin, i - begin);
+        put('\\');
+        put(code);
+        begin = i + 1;
+    }
+    put_formatted(data + begin, size - begin);
+}
+
+void JsonWriter::put_base64(BinaryData data)
+{
+    size_t size = util::base64_encoded_size(data.size());
+    std::unique_ptr<char[]> encoded(new char[size]); // Throws
+    util::base64_encode(data.data(), data.size(), encoded.get(), size);
+    put_formatted(encoded.get(), size);
+}
+
+void JsonWriter::put_timestamp(Timestamp value)
+{
+    time_t rawtime = time_t(value.get_seconds());
+    struct tm* t = gmtime(&rawtime);
+    if (t) {
+        // Max size is 20 bytes (incl zero byte) "YYYY-MM-DD HH:MM:SS"\0
+        char buffer[30];
+        size_t size = strftime(buffer, 30, "%Y-%m-%d %H:%M:%S", t);
+        put_formatted(buffer, size);
+    }
+}
+
+void JsonWriter::flush()
+{
+    m_out.write(m_buffer.get(), std::streamsize(m_used));
+    m_used = 0;
+}
@@ -0,0 +1,134 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_JSON_WRITER_HPP
+#define REALM_IMPL_JSON_WRITER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <realm/alloc.hpp>
+#include <realm/binary_data.hpp>
+#include <realm/string_data.hpp>
+#include <realm/timestamp.hpp>
+
+namespace realm {
+
+class Table;
+
+namespace _impl {
+
+/// Collects JSON output in a fixed size buffer, which is written to the
+/// underlying stream whenever it fills up, instead of going through the
+/// formatting machinery of std::ostream for every value. flush() must be
+/// called at the end of the output; the destructor does not write anything.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::ostream&);
+    ~JsonWriter() noexcept;
+
+    void put(char c);
+    void put(StringData raw);
+    void put_int(int64_t value);
+    void put_size(size_t value);
+    void put_float(float value);
+    void put_double(double value);
+
+    /// Write the string with quotes, line breaks and backslashes escaped, but
+    /// without surrounding quotes
+    void put_escaped(StringData str);
+
+    /// Write the base64 encoding of the data
+    void put_base64(BinaryData data);
+
+    /// Write the seconds of the timestamp as "YYYY-MM-DD HH:MM:SS" in UTC
+    void put_timestamp(Timestamp value);
+
+    void flush();
+
+private:
+    static constexpr size_t buffer_size = 64 * 1024;
+
+    std::ostream& m_out;
+    std::unique_ptr<char[]> m_buffer;
+    size_t m_used = 0;
+
+    void put_formatted(const char* data, size_t size);
+};
+
+/// State shared by the recursive calls of Table::to_json_row() during one
+/// export
+struct JsonExportState {
+    std::map<std::string, std::string>& renames;
+
+    /// The link columns which have been followed when `link_depth` is
+    /// unlimited. Each column is recorded once.
+    std::vector<ref_type> followed;
+
+    /// The text preceding each value of a row of a table, i.e. `"name":`
+    /// with the column renamed, and a leading comma for all but the first
+    /// value. Unless the table has an "!OID" column or is a subtable, the
+    /// row index is written first, as the `_key` field, so there is one
+    /// more entry than there are columns.
+    std::unordered_map<const Table*, std::vector<std::string>> column_prefixes;
+
+    explicit JsonExportState(std::map<std::string, std::string>& r)
+        : renames(r)
+    {
+    }
+};
+
+
+// Implementation:
+
+inline void JsonWriter::put(char c)
+{
+    if (m_used == buffer_size)
+        flush();
+    m_buffer[m_used++] = c;
+}
+
+inline void JsonWriter::put(StringData raw)
+{
+    put_formatted(raw.data(), raw.size());
+}
+
+inline void JsonWriter::put_formatted(const char* data, size_t size)
+{
+    if (size > buffer_size - m_used) {
+        flush();
+        if (size > buffer_size) {
+            m_out.write(data, std::streamsize(size));
+            return;
+        }
+    }
+    std::copy(data, data + size, m_buffer.get() + m_used);
+    m_used += size;
+}
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_JSON_WRITER_HPP
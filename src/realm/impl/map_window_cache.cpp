@@ -0,0 +1,232 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/impl/map_window_cache.hpp>
+
+#include <algorithm>
+
+#include <realm/util/file_mapper.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+using namespace realm::util;
+
+// True if a requested block fall within a memory mapping.
+bool MapWindow::matches(ref_type start_ref, size_t size)
+{
+    if (start_ref < m_base_ref)
+        return false;
+    if (start_ref + size > m_base_ref + m_map.get_size())
+        return false;
+    return true;
+}
+
+// When determining which part of the file to mmap, We try to pick a 1MB window containing
+// the requested block. We align windows on 1MB boundaries. We also align window size at
+// 1MB, except in cases where the referenced part of the file straddles a 1MB boundary.
+// In that case we choose a larger window.
+//
+// In cases where a 1MB window would stretch beyond the end of the file, we choose
+// a smaller window. Anything mapped after the end of file would be undefined anyways.
+ref_type MapWindow::aligned_to_mmap_block(ref_type start_ref)
+{
+    // align to 1MB boundary
+    size_t page_mask = m_alignment - 1;
+    return start_ref & ~page_mask;
+}
+
+size_t MapWindow::get_window_size(util::File& f, ref_type start_ref, size_t size)
+{
+    size_t window_size = start_ref + size - m_base_ref;
+    // always map at least to match alignment
+    if (window_size < m_alignment)
+        window_size = m_alignment;
+    // but never map beyond end of file
+    size_t file_size = to_size_t(f.get_size());
+    REALM_ASSERT_DEBUG_EX(start_ref + size <= file_size, start_ref + size, file_size);
+    if (window_size > file_size - m_base_ref)
+        window_size = file_size - m_base_ref;
+    return window_size;
+}
+
+// The file may grow in increments much smaller than 1MB. This can lead to a stream of requests
+// which are each just beyond the end of the last mapping we made. It is important to extend the
+// existing window to cover the new request (if possible) as opposed to adding a new window.
+// The reason is not obvious: open windows need to be sync'ed to disk at the end of the commit,
+// and we really want to use as few calls to msync() as possible.
+//
+// extends_to_match() will extend an existing mapping to accomodate a new request if possible
+// and return true. If the request falls in a different 1MB window, it'll return false.
+bool MapWindow::extends_to_match(util::File& f, ref_type start_ref, size_t size)
+{
+    size_t aligned_ref = aligned_to_mmap_block(start_ref);
+    if (aligned_ref != m_base_ref)
+        return false;
+    size_t window_size = get_window_size(f, start_ref, size);
+    // Data written through an unencrypted mapping stays in the page cache
+    // when it is unmapped, and is flushed by syncing the same range of the
+    // new mapping. An encrypted mapping must be flushed before it goes away.
+    if (is_encrypted()) {
+        m_map.sync();
+        clear_dirty();
+    }
+    // FIXME: Add a remap which will work with a offset different from 0
+    m_map.unmap();
+    m_map.map(f, File::access_ReadWrite, window_size, 0, m_base_ref);
+    return true;
+}
+
+MapWindow::MapWindow(size_t alignment, util::File& f, ref_type start_ref, size_t size)
+    : m_alignment(alignment)
+{
+    m_base_ref = aligned_to_mmap_block(start_ref);
+    size_t window_size = get_window_size(f, start_ref, size);
+    m_map.map(f, File::access_ReadWrite, window_size, 0, m_base_ref);
+}
+
+MapWindow::~MapWindow()
+{
+    m_map.unmap(); /* Apparently no effect - how odd */
+}
+
+void MapWindow::mark_dirty(ref_type ref, size_t size) noexcept
+{
+    size_t begin = size_t(ref - m_base_ref);
+    size_t end = begin + size;
+    if (is_dirty()) {
+        m_dirty_begin = std::min(m_dirty_begin, begin);
+        m_dirty_end = std::max(m_dirty_end, end);
+    }
+    else {
+        m_dirty_begin = begin;
+        m_dirty_end = end;
+    }
+}
+
+void MapWindow::clear_dirty() noexcept
+{
+    m_dirty_begin = 0;
+    m_dirty_end = 0;
+}
+
+void MapWindow::sync()
+{
+    if (!is_dirty())
+        return;
+    m_map.sync(m_dirty_begin, m_dirty_end - m_dirty_begin);
+    clear_dirty();
+}
+
+void MapWindow::start_writeback(util::File& f) noexcept
+{
+    if (is_dirty())
+        f.start_writeback(File::SizeType(m_base_ref + m_dirty_begin), m_dirty_end - m_dirty_begin);
+}
+
+bool MapWindow::is_encrypted() const noexcept
+{
+    return m_map.get_encrypted_mapping() != nullptr;
+}
+
+char* MapWindow::translate(ref_type ref)
+{
+    return m_map.get_addr() + (ref - m_base_ref);
+}
+
+void MapWindow::encryption_read_barrier(void* start_addr, size_t size)
+{
+    realm::util::encryption_read_barrier(start_addr, size, m_map.get_encrypted_mapping());
+}
+
+void MapWindow::encryption_write_barrier(void* start_addr, size_t size)
+{
+    realm::util::encryption_write_barrier(start_addr, size, m_map.get_encrypted_mapping());
+}
+
+
+constexpr size_t MapWindowCache::max_windows;
+
+void MapWindowCache::set_alignment(size_t alignment) noexcept
+{
+    if (alignment == m_alignment)
+        return;
+    REALM_ASSERT(std::none_of(m_windows.begin(), m_windows.end(), [](auto& window) { return window->is_dirty(); }));
+    m_windows.clear();
+    m_alignment = alignment;
+}
+
+MapWindow* MapWindowCache::get_window(util::File& f, ref_type start_ref, size_t size, bool sync_evicted)
+{
+    auto match = std::find_if(m_windows.begin(), m_windows.end(), [&](auto& window) {
+        return window->matches(start_ref, size) || window->extends_to_match(f, start_ref, size);
+    });
+    if (match != m_windows.end()) {
+        // move matching window to top (to keep LRU order)
+        std::rotate(m_windows.begin(), match, match + 1);
+        return m_windows[0].get();
+    }
+    // no window found, make room for a new one at the top
+    if (m_windows.size() == max_windows) {
+        if (sync_evicted)
+            m_windows.back()->sync();
+        m_windows.pop_back();
+    }
+    auto new_window = std::make_unique<MapWindow>(m_alignment, f, start_ref, size);
+    m_windows.insert(m_windows.begin(), std::move(new_window));
+    return m_windows[0].get();
+}
+
+void MapWindowCache::sync_all(util::File& f)
+{
+#if defined(__linux__)
+    // msync() of each window would wait for the disk once per window
+    if (!f.get_encryption_key()) {
+        bool any_dirty = false;
+        for (const auto& window : m_windows) {
+            if (window->is_dirty()) {
+                window->start_writeback(f);
+                any_dirty = true;
+            }
+        }
+        if (any_dirty)
+            f.sync(); // Throws
+        for (const auto& window : m_windows)
+            window->clear_dirty();
+        return;
+    }
+#else
+    static_cast<void>(f);
+#endif
+    for (const auto& window : m_windows)
+        window->sync(); // Throws
+}
+
+void MapWindowCache::end_commit(bool keep) noexcept
+{
+    if (!keep) {
+        clear();
+        return;
+    }
+    for (const auto& window : m_windows)
+        window->clear_dirty();
+}
+
+void MapWindowCache::clear() noexcept
+{
+    m_windows.clear();
+}
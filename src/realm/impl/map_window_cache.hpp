@@ -0,0 +1,124 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_MAP_WINDOW_CACHE_HPP
+#define REALM_IMPL_MAP_WINDOW_CACHE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <realm/alloc.hpp>
+#include <realm/util/file.hpp>
+
+namespace realm {
+namespace _impl {
+
+/// A read-write memory mapping of an aligned part of the database file,
+/// used by GroupWriter to write arrays and the file header. The window keeps
+/// track of the range which has been written to since it was last
+/// synchronized, so that only that range needs to be flushed.
+class MapWindow {
+public:
+    MapWindow(size_t alignment, util::File& f, ref_type start_ref, size_t initial_size);
+    ~MapWindow();
+
+    // translate a ref to a pointer
+    // inside the window defined during construction.
+    char* translate(ref_type ref);
+    void encryption_read_barrier(void* start_addr, size_t size);
+    void encryption_write_barrier(void* start_addr, size_t size);
+    // Note that the specified range has been written to
+    void mark_dirty(ref_type ref, size_t size) noexcept;
+    bool is_dirty() const noexcept
+    {
+        return m_dirty_begin < m_dirty_end;
+    }
+    void clear_dirty() noexcept;
+    // Flush the range written to since the last sync
+    void sync();
+    // Start writing back the range written to since the last sync,
+    // without waiting for it (see util::File::start_writeback())
+    void start_writeback(util::File& f) noexcept;
+    bool is_encrypted() const noexcept;
+    // return true if the specified range is fully visible through
+    // the MapWindow
+    bool matches(ref_type start_ref, size_t size);
+    // return false if the mapping cannot be extended to hold the
+    // requested size - extends if possible and then returns true
+    bool extends_to_match(util::File& f, ref_type start_ref, size_t size);
+
+private:
+    util::File::Map<char> m_map;
+    ref_type m_base_ref;
+    ref_type aligned_to_mmap_block(ref_type start_ref);
+    size_t get_window_size(util::File& f, ref_type start_ref, size_t size);
+    size_t m_alignment;
+    // Relative to m_base_ref
+    size_t m_dirty_begin = 0;
+    size_t m_dirty_end = 0;
+};
+
+/// The write windows of one database file, kept in MRU (most recently used)
+/// order. They are owned by the allocator rather than by GroupWriter, so that
+/// they survive from one commit to the next, and a commit does not need to
+/// map and unmap the regions which the previous commits have written to.
+class MapWindowCache {
+public:
+    // The allocator will favor sequential allocation from a modest number of
+    // windows, depending upon fragmentation, so 16 windows should be more
+    // than enough. If more than 16 windows are needed, the least recently
+    // used is sync'ed and closed to make room for a new one.
+    static constexpr size_t max_windows = 16;
+
+    /// Drop all windows if they have a different alignment. Must be called
+    /// at the start of every commit, when no window is dirty.
+    void set_alignment(size_t alignment) noexcept;
+
+    /// Get a window matching a request, either creating a new window or
+    /// reusing an existing one (possibly extended to accomodate the new
+    /// request).
+    MapWindow* get_window(util::File& f, ref_type start_ref, size_t size, bool sync_evicted);
+
+    /// Flush everything written through the windows since the last call. On
+    /// Linux, the writeback of all the written ranges is started first, and
+    /// then waited for with a single sync of the file, instead of one sync
+    /// for each window.
+    void sync_all(util::File& f);
+
+    /// Forget the written ranges at the end of a commit. Unless \a keep is
+    /// true, the windows are unmapped as well.
+    void end_commit(bool keep) noexcept;
+
+    /// Unmap all windows without synchronizing them
+    void clear() noexcept;
+
+    size_t size() const noexcept
+    {
+        return m_windows.size();
+    }
+
+private:
+    size_t m_alignment = 0;
+    std::vector<std::unique_ptr<MapWindow>> m_windows;
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_MAP_WINDOW_CACHE_HPP
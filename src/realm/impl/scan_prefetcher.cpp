@@ -0,0 +1,161 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/impl/scan_prefetcher.hpp>
+
+#include <algorithm>
+
+#include <realm/bptree.hpp>
+#include <realm/column.hpp>
+#include <realm/util/memory_policy.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+
+// Ranges closer to each other than this are prefetched as one, as the
+// readahead of the system would read the gap anyway
+constexpr size_t max_gap = 64 * 1024;
+
+// Leaves are not touched before they are scanned, so their size is estimated
+// from the number of elements, as if the elements were 64 bits wide. The
+// remainder of wider leaves is read on demand.
+constexpr size_t max_elem_size = 8;
+
+} // anonymous namespace
+
+constexpr size_t ScanPrefetcher::window_size;
+
+
+class ScanPrefetcher::LeafCollector : public BpTreeNode::VisitHandler {
+public:
+    LeafCollector(std::vector<Range>& ranges, Allocator& alloc, size_t end) noexcept
+        : m_ranges(ranges)
+        , m_alloc(alloc)
+        , m_end(end)
+    {
+    }
+
+    bool visit(const BpTreeNode::NodeInfo& leaf_info) override
+    {
+        if (leaf_info.m_offset >= m_end)
+            return false;
+        MemRef mem = leaf_info.m_mem;
+        size_t max_byte_size = Array::header_size + leaf_info.m_size * max_elem_size;
+        add_range(m_ranges, m_alloc, mem.get_ref(), max_byte_size); // Throws
+        return true;
+    }
+
+private:
+    std::vector<Range>& m_ranges;
+    Allocator& m_alloc;
+    const size_t m_end;
+};
+
+
+void ScanPrefetcher::add_column(const ColumnBase& column)
+{
+    if (column.get_alloc().is_file_mapped())
+        m_columns.push_back(&column); // Throws
+}
+
+
+void ScanPrefetcher::advance(size_t row, size_t end)
+{
+    if (m_columns.empty() || row + window_size / 2 < m_prefetched_end)
+        return;
+    size_t begin = std::max(row, m_prefetched_end);
+    size_t window_end = std::min(row + window_size, end);
+    if (begin >= window_end)
+        return;
+    m_prefetched_end = window_end;
+
+    m_ranges.clear();
+    for (const ColumnBase* column : m_columns)
+        collect_leaves(*column, begin, window_end); // Throws
+    prefetch(m_ranges);
+}
+
+
+void ScanPrefetcher::prefetch_children(const Array& array)
+{
+    Allocator& alloc = array.get_alloc();
+    if (!alloc.is_file_mapped())
+        return;
+
+    std::vector<Range> ranges;
+    size_t max_byte_size = Array::header_size + REALM_MAX_BPNODE_SIZE * max_elem_size;
+    size_t n = array.size();
+    for (size_t i = 0; i < n; ++i) {
+        int_fast64_t value = array.get(i);
+        bool is_ref = (value != 0 && (value & 1) == 0);
+        if (is_ref)
+            add_range(ranges, alloc, to_ref(value), max_byte_size); // Throws
+    }
+    prefetch(ranges);
+}
+
+
+void ScanPrefetcher::collect_leaves(const ColumnBase& column, size_t begin, size_t end)
+{
+    Allocator& alloc = column.get_alloc();
+    ref_type ref = column.get_ref();
+    BpTreeNode root(alloc);
+    root.init_from_ref(ref);
+    if (!root.is_inner_bptree_node()) {
+        // The whole column is in a single array, which has been touched
+        // already, so its size is known
+        add_range(m_ranges, alloc, ref, root.get_byte_size()); // Throws
+        return;
+    }
+
+    size_t size = root.get_bptree_size();
+    if (begin >= size)
+        return;
+    LeafCollector handler(m_ranges, alloc, end);
+    root.visit_bptree_leaves(begin, size, handler); // Throws
+}
+
+
+void ScanPrefetcher::add_range(std::vector<Range>& ranges, Allocator& alloc, ref_type ref, size_t max_byte_size)
+{
+    if (!alloc.is_read_only(ref))
+        return;
+    const char* addr = alloc.translate(ref);
+    ranges.push_back({addr, addr + max_byte_size}); // Throws
+}
+
+
+void ScanPrefetcher::prefetch(std::vector<Range>& ranges) noexcept
+{
+    if (ranges.empty())
+        return;
+    std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+    Range run = ranges.front();
+    for (const Range& range : ranges) {
+        if (range.begin > run.end && size_t(range.begin - run.end) > max_gap) {
+            util::prefetch_pages(run.begin, size_t(run.end - run.begin));
+            run = range;
+        }
+        else {
+            run.end = std::max(run.end, range.end);
+        }
+    }
+    util::prefetch_pages(run.begin, size_t(run.end - run.begin));
+}
@@ -0,0 +1,82 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_SCAN_PREFETCHER_HPP
+#define REALM_IMPL_SCAN_PREFETCHER_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <realm/alloc.hpp>
+#include <realm/util/features.h>
+
+namespace realm {
+
+class Array;
+class ColumnBase;
+
+namespace _impl {
+
+/// Asks the system to start reading the parts of the database file which a
+/// scan over a range of rows is about to visit, ahead of the scan. Without
+/// it, a scan over a file which is not in the page cache proceeds at the pace
+/// of one page fault at a time.
+///
+/// The leaves ahead of the scan are found through the inner nodes of the
+/// B+-trees of the columns, without touching the leaves themselves. Leaves
+/// which lie close to each other in the file are prefetched as one range.
+///
+/// Does nothing for columns whose allocator is not a plain mapping of a file.
+class ScanPrefetcher {
+public:
+    /// The number of rows prefetched at a time.
+    static constexpr size_t window_size = 256 * REALM_MAX_BPNODE_SIZE;
+
+    /// Prefetch the leaves of the specified column too.
+    void add_column(const ColumnBase&);
+
+    /// Must be called with the next row to be scanned before it is scanned,
+    /// and with increasing rows. Prefetches the rows of the next window, up
+    /// to `end`, once the scan has passed the middle of the current one.
+    void advance(size_t row, size_t end);
+
+    /// Prefetch the arrays referenced by the specified array, as when they
+    /// are about to be visited in order.
+    static void prefetch_children(const Array&);
+
+private:
+    struct Range {
+        const char* begin;
+        const char* end;
+    };
+
+    class LeafCollector;
+
+    std::vector<const ColumnBase*> m_columns;
+    std::vector<Range> m_ranges;
+    size_t m_prefetched_end = 0;
+
+    void collect_leaves(const ColumnBase&, size_t begin, size_t end);
+    static void add_range(std::vector<Range>&, Allocator&, ref_type, size_t max_byte_size);
+    static void prefetch(std::vector<Range>&) noexcept;
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_SCAN_PREFETCHER_HPP
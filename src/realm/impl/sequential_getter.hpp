@@ -21,11 +21,15 @@
 
 namespace realm {
 
+class ColumnBase;
+
 class SequentialGetterBase {
 public:
     virtual ~SequentialGetterBase() noexcept
     {
     }
+
+    virtual const ColumnBase* get_column_base() const noexcept = 0;
 };
 
 template <class ColType>
@@ -52,6 +56,11 @@ public:
     {
     }
 
+    const ColumnBase* get_column_base() const noexcept override
+    {
+        return m_column;
+    }
+
     void init(const ColType* column)
     {
         REALM_ASSERT(column != nullptr);
@@ -0,0 +1,91 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/impl/snapshot_copier.hpp>
+
+#include <algorithm>
+
+#include <realm/alloc_slab.hpp>
+#include <realm/array.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+
+// Ranges closer to each other than this are copied as one, as copying the gap
+// costs less than another call into the kernel
+constexpr size_t max_gap = 64 * 1024;
+
+} // anonymous namespace
+
+
+SnapshotCopier::SnapshotCopier(Allocator& alloc) noexcept
+    : m_alloc(alloc)
+{
+}
+
+
+void SnapshotCopier::collect(ref_type top_ref)
+{
+    if (top_ref == 0)
+        return;
+
+    // Depth first, with an explicit stack
+    std::vector<ref_type> pending = {top_ref}; // Throws
+    Array array(m_alloc);
+    while (!pending.empty()) {
+        ref_type ref = pending.back();
+        pending.pop_back();
+        array.init_from_ref(ref);
+        size_t byte_size = array.get_byte_size();
+        byte_size = (byte_size + 7) & ~size_t(7); // Arrays are 8-byte aligned
+        m_ranges.push_back({size_t(ref), size_t(ref) + byte_size}); // Throws
+        if (!array.has_refs())
+            continue;
+        size_t n = array.size();
+        for (size_t i = 0; i < n; ++i) {
+            int_fast64_t value = array.get(i);
+            bool is_ref = (value != 0 && (value & 1) == 0);
+            if (is_ref)
+                pending.push_back(to_ref(value)); // Throws
+        }
+    }
+}
+
+
+void SnapshotCopier::copy(util::File& from, util::File& target, size_t file_size)
+{
+    m_ranges.push_back({0, sizeof(SlabAlloc::Header)}); // Throws
+    std::sort(m_ranges.begin(), m_ranges.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+
+    // The holes are left by growing the file before anything is written
+    target.resize(util::File::SizeType(file_size)); // Throws
+
+    Range run = m_ranges.front();
+    for (const Range& range : m_ranges) {
+        if (range.begin > run.end && range.begin - run.end > max_gap) {
+            from.copy_range_to(target, util::File::SizeType(run.begin), run.end - run.begin); // Throws
+            run = range;
+        }
+        else {
+            run.end = std::max(run.end, range.end);
+        }
+    }
+    from.copy_range_to(target, util::File::SizeType(run.begin), run.end - run.begin); // Throws
+}
@@ -0,0 +1,70 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_SNAPSHOT_COPIER_HPP
+#define REALM_IMPL_SNAPSHOT_COPIER_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <realm/alloc.hpp>
+#include <realm/util/file.hpp>
+
+namespace realm {
+namespace _impl {
+
+/// Copies the arrays of a snapshot from a database file to another file, at
+/// the same positions, so that no ref needs to be rewritten. Only the arrays
+/// reachable from the top ref of the snapshot are copied, along with the file
+/// header. The rest of the target file is left as holes, so the copy takes up
+/// no more space on disk than the live data of the snapshot, even though its
+/// size is that of the original file.
+///
+/// Arrays close to each other are copied as one range, in file order, so that
+/// the copy proceeds with large sequential transfers, which the kernel may
+/// replace by sharing the blocks between the files, see
+/// util::File::copy_range_to().
+class SnapshotCopier {
+public:
+    /// \param alloc An allocator through which all the arrays of the snapshot
+    /// are accessible, and which is not modified while the copier is used.
+    SnapshotCopier(Allocator& alloc) noexcept;
+
+    /// Find the ranges of the file occupied by the arrays reachable from the
+    /// specified top ref.
+    void collect(ref_type top_ref);
+
+    /// Copy the collected ranges and the header of `from` to `target`, which
+    /// must be empty, and make `target` `file_size` bytes large. Neither file
+    /// may be encrypted.
+    void copy(util::File& from, util::File& target, size_t file_size);
+
+private:
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    Allocator& m_alloc;
+    std::vector<Range> m_ranges;
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_SNAPSHOT_COPIER_HPP
@@ -0,0 +1,227 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/join.hpp>
+
+#include <unordered_map>
+
+#include <realm/column.hpp>
+#include <realm/column_string.hpp>
+#include <realm/column_string_enum.hpp>
+#include <realm/index_string.hpp>
+
+using namespace realm;
+using _impl::JoinColumn;
+
+namespace {
+
+// Call `fn(row_ndx, value)` for every row of the column, one B+tree leaf at a time
+template <class ColType, class Fn>
+void for_each_leaf_value(const ColType& column, size_t size, Fn fn)
+{
+    using LeafType = typename ColType::LeafType;
+    LeafType cache(column.get_alloc());
+    size_t begin = 0;
+    while (begin < size) {
+        const LeafType* leaf;
+        size_t ndx_in_leaf;
+        typename ColType::LeafInfo info{&leaf, &cache};
+        column.get_leaf(begin, ndx_in_leaf, info);
+        REALM_ASSERT_3(ndx_in_leaf, ==, 0);
+        size_t leaf_size = leaf->size();
+        for (size_t i = 0; i < leaf_size; ++i)
+            fn(begin + i, leaf->get(i));
+        begin += leaf_size;
+    }
+}
+
+// Integer, boolean and OldDateTime columns
+struct IntValues {
+    using Key = int64_t;
+
+    template <class Fn>
+    static void for_each(const JoinColumn& c, Fn fn)
+    {
+        if (c.nullable) {
+            for_each_leaf_value(static_cast<const IntNullColumn&>(*c.column), c.size,
+                                [&](size_t row_ndx, util::Optional<int64_t> v) {
+                                    if (v)
+                                        fn(row_ndx, *v);
+                                });
+        }
+        else {
+            for_each_leaf_value(static_cast<const IntegerColumn&>(*c.column), c.size, fn);
+        }
+    }
+};
+
+struct StringValues {
+    using Key = StringData;
+
+    template <class Fn>
+    static void for_each(const JoinColumn& c, Fn fn)
+    {
+        if (c.type == col_type_StringEnum) {
+            // Resolve every key of the enumeration once and then only read the key indexes of the rows
+            const StringEnumColumn& column = static_cast<const StringEnumColumn&>(*c.column);
+            const StringColumn& keys = column.get_keys();
+            std::vector<StringData> values;
+            size_t num_keys = keys.size();
+            values.reserve(num_keys);
+            for (size_t i = 0; i < num_keys; ++i)
+                values.push_back(keys.get(i));
+            for_each_leaf_value(static_cast<const IntegerColumn&>(column), c.size, [&](size_t row_ndx, int64_t v) {
+                StringData str = values[size_t(v)];
+                if (!str.is_null())
+                    fn(row_ndx, str);
+            });
+        }
+        else {
+            const StringColumn& column = static_cast<const StringColumn&>(*c.column);
+            for (size_t i = 0; i < c.size; ++i) {
+                StringData str = column.get(i);
+                if (!str.is_null())
+                    fn(i, str);
+            }
+        }
+    }
+};
+
+class JoinOutput {
+public:
+    JoinOutput(JoinResult& result, bool build_is_left)
+        : m_result(result)
+        , m_build_is_left(build_is_left)
+    {
+    }
+
+    void add(size_t build_row, size_t probe_row)
+    {
+        m_result.left_rows.push_back(m_build_is_left ? build_row : probe_row);
+        m_result.right_rows.push_back(m_build_is_left ? probe_row : build_row);
+    }
+
+private:
+    JoinResult& m_result;
+    bool m_build_is_left;
+};
+
+template <class Values>
+void join_by_hashing(const JoinColumn& build, const JoinColumn& probe, JoinOutput& out)
+{
+    using Key = typename Values::Key;
+
+    // Rows with equal values are chained through `next`, in increasing order. Each entry of the map holds the
+    // first and last link of a chain.
+    std::vector<size_t> rows;
+    std::vector<size_t> next;
+    std::unordered_map<Key, std::pair<size_t, size_t>> chains;
+    rows.reserve(build.size);
+    next.reserve(build.size);
+    Values::for_each(build, [&](size_t row_ndx, Key value) {
+        size_t link = rows.size();
+        rows.push_back(row_ndx);
+        next.push_back(npos);
+        auto res = chains.emplace(value, std::make_pair(link, link));
+        if (!res.second) {
+            next[res.first->second.second] = link;
+            res.first->second.second = link;
+        }
+    });
+    if (chains.empty())
+        return;
+
+    Values::for_each(probe, [&](size_t row_ndx, Key value) {
+        auto it = chains.find(value);
+        if (it == chains.end())
+            return;
+        for (size_t link = it->second.first; link != npos; link = next[link])
+            out.add(rows[link], row_ndx);
+    });
+}
+
+template <class Values>
+void join_by_index(const JoinColumn& indexed, const JoinColumn& probe, JoinOutput& out)
+{
+    using Key = typename Values::Key;
+
+    const StringIndex& index = *indexed.column->get_search_index();
+    InternalFindResult res;
+    Values::for_each(probe, [&](size_t row_ndx, Key value) {
+        switch (index.find_all_no_copy(value, res)) {
+            case FindRes_not_found:
+                break;
+            case FindRes_single:
+                out.add(res.payload, row_ndx);
+                break;
+            case FindRes_column: {
+                IntegerColumn matches(indexed.column->get_alloc(), ref_type(res.payload));
+                for (size_t i = res.start_ndx; i < res.end_ndx; ++i)
+                    out.add(size_t(matches.get(i)), row_ndx);
+                break;
+            }
+        }
+    });
+}
+
+template <class Values>
+void join(const JoinColumn& left, const JoinColumn& right, JoinResult& result)
+{
+    bool left_is_smaller = left.size <= right.size;
+    const JoinColumn& smaller = left_is_smaller ? left : right;
+    const JoinColumn& larger = left_is_smaller ? right : left;
+    if (larger.column->has_search_index()) {
+        // Looking up the rows of the smaller side avoids reading the larger side at all
+        JoinOutput out(result, !left_is_smaller);
+        join_by_index<Values>(larger, smaller, out);
+    }
+    else {
+        JoinOutput out(result, left_is_smaller);
+        join_by_hashing<Values>(smaller, larger, out);
+    }
+}
+
+} // anonymous namespace
+
+namespace realm {
+namespace _impl {
+
+JoinResult hash_join(const JoinColumn& left, const JoinColumn& right)
+{
+    JoinResult result;
+    if (left.size == 0 || right.size == 0)
+        return result;
+
+    switch (left.type) {
+        case col_type_Int:
+        case col_type_Bool:
+        case col_type_OldDateTime:
+            join<IntValues>(left, right, result); // Throws
+            break;
+        case col_type_String:
+        case col_type_StringEnum:
+            join<StringValues>(left, right, result); // Throws
+            break;
+        default:
+            REALM_UNREACHABLE();
+    }
+    return result;
+}
+
+} // namespace _impl
+} // namespace realm
@@ -0,0 +1,64 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_JOIN_HPP
+#define REALM_JOIN_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <realm/column_type.hpp>
+
+namespace realm {
+
+class ColumnBase;
+
+/// The matching rows of an equi-join produced by Table::join(). Row
+/// `left_rows[i]` of the table join() was called on has the same value as
+/// row `right_rows[i]` of the other table. The pairs are in no particular
+/// order.
+struct JoinResult {
+    std::vector<size_t> left_rows;
+    std::vector<size_t> right_rows;
+
+    size_t size() const noexcept
+    {
+        return left_rows.size();
+    }
+};
+
+namespace _impl {
+
+// One side of a join, as set up by Table::join()
+struct JoinColumn {
+    const ColumnBase* column;
+    ColumnType type;
+    bool nullable;
+    size_t size;
+};
+
+// Find all pairs of rows with equal, non-null values. A hash table is built
+// over the smaller side and probed with the rows of the larger side, unless
+// the larger side has a search index, in which case the rows of the smaller
+// side are looked up in it instead.
+JoinResult hash_join(const JoinColumn& left, const JoinColumn& right);
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_JOIN_HPP
@@ -22,6 +22,7 @@
 #include <realm/column_fwd.hpp>
 #include <realm/descriptor.hpp>
 #include <realm/group_shared.hpp>
+#include <realm/impl/scan_prefetcher.hpp>
 #include <realm/link_view.hpp>
 #include <realm/query_engine.hpp>
 #include <realm/query_expression.hpp>
@@ -931,7 +932,7 @@ R Query::aggregate(R (ColType::*aggregateMethod)(size_t start, size_t end, size_
     else {
 
         // Aggregate with criteria - goes through the nodes in the query system
-        init();
+        init(!m_view && limit == size_t(-1));
         QueryState<R> st;
         st.init(action, nullptr, limit);
 
@@ -979,12 +980,36 @@ void Query::aggregate_internal(Action TAction, DataType TSourceColumn, bool null
     if (end == not_found)
         end = m_table->size();
 
+    // Have the leaves of the scanned columns read from the file ahead of the scan
+    _impl::ScanPrefetcher prefetcher;
+    for (const ParentNode* child : pn->m_children) {
+        if (const ColumnBase* column = child->get_scanned_column())
+            prefetcher.add_column(*column); // Throws
+    }
+    if (source_column)
+        prefetcher.add_column(*source_column->get_column_base()); // Throws
+
+    if (pn->is_fused()) {
+        // All conditions are evaluated together, and matches are reported through the root node
+        pn->ParentNode::aggregate_local_prepare(TAction, TSourceColumn, nullable);
+        while (start < end) {
+            prefetcher.advance(start, end); // Throws
+            size_t chunk_end = std::min(start + _impl::ScanPrefetcher::window_size / 2, end);
+            if (!pn->aggregate_fused(st, start, chunk_end, source_column))
+                return;
+            start = chunk_end;
+        }
+        return;
+    }
+
     for (size_t c = 0; c < pn->m_children.size(); c++)
         pn->m_children[c]->aggregate_local_prepare(TAction, TSourceColumn, nullable);
 
     size_t td;
 
     while (start < end) {
+        prefetcher.advance(start, end); // Throws
+
         auto score_compare = [](const ParentNode* a, const ParentNode* b) { return a->cost() < b->cost(); };
         size_t best = std::distance(pn->m_children.begin(),
                                     std::min_element(pn->m_children.begin(), pn->m_children.end(), score_compare));
@@ -1149,15 +1174,40 @@ OldDateTime Query::minimum_olddatetime(size_t column_ndx, size_t* resultcount, s
                                        return_ndx);
 }
 
+// The return index is the position of the result among the matches, as for TableViewBase::minimum_timestamp()
+template <class Condition>
+Timestamp Query::minmax_timestamp(size_t column_ndx, size_t* return_ndx, size_t start, size_t end,
+                                  size_t limit) const
+{
+    Timestamp best;
+    size_t best_ndx = npos;
+    if (!m_table->is_degenerate()) {
+        TimestampLeafCache column(m_table->get_column_timestamp(column_ndx));
+        Condition compare;
+        size_t match_ndx = 0;
+        for_each(
+            [&](BasicRowExpr<const Table> row) {
+                Timestamp ts = column.get(row.get_index());
+                // Because realm::Greater(non-null, null) == false, the first non-null value is picked explicitly
+                if ((best_ndx == npos && !ts.is_null()) || compare(ts, best, ts.is_null(), best.is_null())) {
+                    best = ts;
+                    best_ndx = match_ndx;
+                }
+                ++match_ndx;
+            },
+            start, end, limit);
+    }
+    if (return_ndx)
+        *return_ndx = best_ndx;
+    return best;
+}
+
 Timestamp Query::minimum_timestamp(size_t column_ndx, size_t* return_ndx, size_t start, size_t end, size_t limit)
 {
 #if REALM_METRICS
     std::unique_ptr<MetricTimer> metric_timer = QueryInfo::track(this, QueryInfo::type_Minimum);
 #endif
-    TableView tv(*m_table, *this, start, end, limit);
-    find_all(tv, start, end, limit);
-    Timestamp ts = tv.minimum_timestamp(column_ndx, return_ndx);
-    return ts;
+    return minmax_timestamp<Less>(column_ndx, return_ndx, start, end, limit);
 }
 
 Timestamp Query::maximum_timestamp(size_t column_ndx, size_t* return_ndx, size_t start, size_t end, size_t limit)
@@ -1165,11 +1215,15 @@ Timestamp Query::maximum_timestamp(size_t column_ndx, size_t* return_ndx, size_t
 #if REALM_METRICS
     std::unique_ptr<MetricTimer> metric_timer = QueryInfo::track(this, QueryInfo::type_Maximum);
 #endif
+    return minmax_timestamp<Greater>(column_ndx, return_ndx, start, end, limit);
+}
 
-    TableView tv(*m_table, *this, start, end, limit);
-    find_all(tv, start, end, limit);
-    Timestamp ts = tv.maximum_timestamp(column_ndx, return_ndx);
-    return ts;
+GroupByResult Query::group_by(const std::vector<GroupKey>& keys, const std::vector<GroupAggregate>& aggregates,
+                              size_t start, size_t end, size_t limit) const
+{
+    _impl::GroupByBuilder builder(*m_table, keys, aggregates); // Throws
+    for_each([&](BasicRowExpr<const Table> row) { builder.add(row.get_index()); }, start, end, limit); // Throws
+    return builder.finish();
 }
 
 
@@ -1363,7 +1417,7 @@ void Query::find_all(TableViewBase& ret, size_t begin, size_t end, size_t limit)
 
     REALM_ASSERT_3(begin, <=, m_table->size());
 
-    init();
+    init(!m_view && limit == size_t(-1));
 
     if (end == size_t(-1))
         end = m_table->size();
@@ -1392,6 +1446,47 @@ void Query::find_all(TableViewBase& ret, size_t begin, size_t end, size_t limit)
     }
 }
 
+void Query::for_each(std::function<void(BasicRowExpr<const Table>)> func, size_t begin, size_t end,
+                     size_t limit) const
+{
+    if (limit == 0 || m_table->is_degenerate())
+        return;
+
+    REALM_ASSERT_3(begin, <=, m_table->size());
+
+    init();
+
+    if (end == size_t(-1))
+        end = m_table->size();
+
+    const Table& table = *m_table;
+    size_t count = 0;
+    if (m_view) {
+        for (size_t t = 0; t < m_view->size() && count < limit; t++) {
+            size_t tablerow = static_cast<size_t>(m_view->m_row_indexes.get(t));
+            if (tablerow >= begin && tablerow < end && peek_tablerow(tablerow) != not_found) {
+                func(table.get(tablerow));
+                ++count;
+            }
+        }
+    }
+    else if (!has_conditions()) {
+        for (size_t i = begin; i < end && count < limit; ++i, ++count)
+            func(table.get(i));
+    }
+    else {
+        ParentNode* node = root_node();
+        while (begin < end && count < limit) {
+            size_t res = node->find_first(begin, end);
+            if (res == not_found || res >= end)
+                break;
+            func(table.get(res));
+            ++count;
+            begin = res + 1;
+        }
+    }
+}
+
 TableView Query::find_all(size_t start, size_t end, size_t limit)
 {
 #if REALM_METRICS
@@ -1421,7 +1516,7 @@ size_t Query::do_count(size_t start, size_t end, size_t limit) const
         }
     }
 
-    init();
+    init(!m_view && limit == size_t(-1));
     size_t cnt = 0;
 
     if (m_view) {
@@ -1690,11 +1785,13 @@ std::string Query::get_description() const
     return get_description(state);
 }
 
-void Query::init() const
+void Query::init(bool full_scan) const
 {
     REALM_ASSERT(m_table);
     if (ParentNode* root = root_node()) {
         root->init();
+        if (full_scan)
+            root->prepare_full_scan(); // Throws
         std::vector<ParentNode*> v;
         root->gather_children(v);
     }
@@ -23,6 +23,7 @@
 #include <cstdio>
 #include <climits>
 #include <algorithm>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -37,6 +38,7 @@
 #include <realm/views.hpp>
 #include <realm/table_ref.hpp>
 #include <realm/binary_data.hpp>
+#include <realm/group_by.hpp>
 #include <realm/olddatetime.hpp>
 #include <realm/handover_defs.hpp>
 #include <realm/link_view_fwd.hpp>
@@ -263,6 +265,13 @@ public:
     size_t find(size_t begin_at_table_row = size_t(0));
     TableView find_all(size_t start = 0, size_t end = size_t(-1), size_t limit = size_t(-1));
 
+    /// Call \a func for each matching row, in the same order as find_all()
+    /// would produce them, without materializing a TableView or registering a
+    /// row accessor per row. The row expression passed to \a func is only
+    /// valid during the call, and \a func must not modify the table.
+    void for_each(std::function<void(BasicRowExpr<const Table>)> func, size_t start = 0,
+                  size_t end = size_t(-1), size_t limit = size_t(-1)) const;
+
     // Aggregates
     size_t count(size_t start = 0, size_t end = size_t(-1), size_t limit = size_t(-1)) const;
 
@@ -319,6 +328,10 @@ public:
     Timestamp minimum_timestamp(size_t column_ndx, size_t* return_ndx, size_t start = 0, size_t end = size_t(-1),
                                 size_t limit = size_t(-1));
 
+    // Grouped aggregates over the matching rows, see Table::group_by()
+    GroupByResult group_by(const std::vector<GroupKey>& keys, const std::vector<GroupAggregate>& aggregates,
+                           size_t start = 0, size_t end = size_t(-1), size_t limit = size_t(-1)) const;
+
     // Deletion
     size_t remove();
 
@@ -354,7 +367,9 @@ private:
     Query(Table& table, TableViewBase* tv = nullptr);
     void create();
 
-    void init() const;
+    // If `full_scan` is true, every row in the table is about to be visited,
+    // which pays for preparations such as building zone maps.
+    void init(bool full_scan = false) const;
     size_t find_internal(size_t start = 0, size_t end = size_t(-1)) const;
     size_t peek_tablerow(size_t row) const;
     void handle_pending_not();
@@ -422,6 +437,9 @@ private:
     R aggregate(R (ColClass::*method)(size_t, size_t, size_t, size_t*) const, size_t column_ndx, size_t* resultcount,
                 size_t start, size_t end, size_t limit, size_t* return_ndx = nullptr) const;
 
+    template <class Condition>
+    Timestamp minmax_timestamp(size_t column_ndx, size_t* return_ndx, size_t start, size_t end, size_t limit) const;
+
     void aggregate_internal(Action TAction, DataType TSourceColumn, bool nullable, ParentNode* pn, QueryStateBase* st,
                             size_t start, size_t end, SequentialGetterBase* source_column) const;
 
@@ -23,12 +23,82 @@
 
 using namespace realm;
 
+namespace {
+
+// Index of the lowest set bit of a non-zero mask
+inline size_t lowest_set_bit(uint64_t mask) noexcept
+{
+#if defined(__GNUC__)
+    return size_t(__builtin_ctzll(mask));
+#else
+    size_t ndx = 0;
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        ++ndx;
+    }
+    return ndx;
+#endif
+}
+
+} // anonymous namespace
+
+constexpr size_t ParentNode::block_size;
+
+uint64_t ParentNode::evaluate_block(size_t, size_t)
+{
+    REALM_UNREACHABLE();
+}
+
+uint64_t ParentNode::evaluate_fused_block(size_t start, size_t end)
+{
+    size_t n = end - start;
+    uint64_t mask = n == block_size ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+    for (ParentNode* child : m_fused_children) {
+        mask &= child->evaluate_block(start, end);
+        if (mask == 0)
+            break;
+    }
+    return mask;
+}
+
+bool ParentNode::aggregate_fused(QueryStateBase* st, size_t start, size_t end, SequentialGetterBase* source_column)
+{
+    REALM_ASSERT_DEBUG(is_fused());
+    while (start < end) {
+        size_t block_end = std::min(start + block_size, end);
+        for (uint64_t mask = evaluate_fused_block(start, block_end); mask != 0; mask &= mask - 1) {
+            bool cont = (this->*m_column_action_specializer)(st, source_column, start + lowest_set_bit(mask));
+            if (!cont)
+                return false;
+        }
+        start = block_end;
+    }
+    return true;
+}
+
 size_t ParentNode::find_first(size_t start, size_t end)
 {
+    if (is_fused()) {
+        while (start < end) {
+            size_t block_end = std::min(start + block_size, end);
+            if (uint64_t mask = evaluate_fused_block(start, block_end))
+                return start + lowest_set_bit(mask);
+            start = block_end;
+        }
+        return not_found;
+    }
+
     size_t sz = m_children.size();
-    size_t current_cond = 0;
     size_t nb_cond_to_test = sz;
 
+    // Start with the condition that is expected to be the most selective. All conditions are tested in turn, so
+    // this only affects performance.
+    size_t current_cond = 0;
+    for (size_t c = 1; c < sz; ++c) {
+        if (m_children[c]->cost() < m_children[current_cond]->cost())
+            current_cond = c;
+    }
+
     while (REALM_LIKELY(start < end)) {
         size_t m = m_children[current_cond]->find_first_local(start, end);
 
@@ -142,6 +142,156 @@ const size_t bitwidth_time_unit = 64;
 
 typedef bool (*CallbackDummy)(int64_t);
 
+namespace _impl {
+
+// Estimated fraction of rows matching a condition, based on the statistics collected by Table::analyze(). A
+// negative result means that no estimate can be made for the condition.
+template <class TConditionFunction>
+struct SelectivityEstimate {
+    static double estimate(const ColumnStatistics&, double, bool)
+    {
+        return -1;
+    }
+};
+
+template <>
+struct SelectivityEstimate<Equal> {
+    static double estimate(const ColumnStatistics& stats, double value, bool is_null)
+    {
+        if (is_null)
+            return 1.0 - stats.non_null_fraction();
+        return stats.selectivity_equal(value);
+    }
+};
+
+template <>
+struct SelectivityEstimate<NotEqual> {
+    static double estimate(const ColumnStatistics& stats, double value, bool is_null)
+    {
+        return 1.0 - SelectivityEstimate<Equal>::estimate(stats, value, is_null);
+    }
+};
+
+template <>
+struct SelectivityEstimate<Greater> {
+    static double estimate(const ColumnStatistics& stats, double value, bool is_null)
+    {
+        return is_null ? 0.0 : stats.selectivity_greater(value, false);
+    }
+};
+
+template <>
+struct SelectivityEstimate<GreaterEqual> {
+    static double estimate(const ColumnStatistics& stats, double value, bool is_null)
+    {
+        return is_null ? -1.0 : stats.selectivity_greater(value, true);
+    }
+};
+
+template <>
+struct SelectivityEstimate<Less> {
+    static double estimate(const ColumnStatistics& stats, double value, bool is_null)
+    {
+        return is_null ? 0.0 : stats.selectivity_less(value, false);
+    }
+};
+
+template <>
+struct SelectivityEstimate<LessEqual> {
+    static double estimate(const ColumnStatistics& stats, double value, bool is_null)
+    {
+        return is_null ? -1.0 : stats.selectivity_less(value, true);
+    }
+};
+
+template <class TConditionFunction>
+double estimate_selectivity(const ColumnStatistics& stats, int64_t value)
+{
+    return SelectivityEstimate<TConditionFunction>::estimate(stats, double(value), false);
+}
+
+template <class TConditionFunction>
+double estimate_selectivity(const ColumnStatistics& stats, util::Optional<int64_t> value)
+{
+    return SelectivityEstimate<TConditionFunction>::estimate(stats, value ? double(*value) : 0.0, !value);
+}
+
+template <class TConditionFunction>
+double estimate_selectivity(const ColumnStatistics& stats, float value)
+{
+    return SelectivityEstimate<TConditionFunction>::estimate(stats, double(value), null::is_null_float(value));
+}
+
+template <class TConditionFunction>
+double estimate_selectivity(const ColumnStatistics& stats, double value)
+{
+    return SelectivityEstimate<TConditionFunction>::estimate(stats, value, null::is_null_float(value));
+}
+
+// First row in [start, end) which is not in a leaf that the zone map rules out for the condition, or `end` if all
+// of them are ruled out. A null zone map rules out nothing.
+template <class TConditionFunction>
+size_t skip_leaves(const ZoneMap<int64_t>* zone_map, size_t start, size_t end, int64_t value)
+{
+    return zone_map ? zone_map->template skip<TConditionFunction>(start, end, value, false) : start;
+}
+
+template <class TConditionFunction>
+size_t skip_leaves(const ZoneMap<int64_t>* zone_map, size_t start, size_t end, const util::Optional<int64_t>& value)
+{
+    return zone_map ? zone_map->template skip<TConditionFunction>(start, end, value ? *value : 0, !value) : start;
+}
+
+template <class TConditionFunction, class T>
+size_t skip_leaves(const ZoneMap<T>* zone_map, size_t start, size_t end, T value)
+{
+    return zone_map ? zone_map->template skip<TConditionFunction>(start, end, value, null::is_null_float(value))
+                    : start;
+}
+
+// Bit `i` of the result is set if the value at `begin + i` in the leaf satisfies the condition, where `end - begin`
+// is at most 64. Values are decoded eight at a time by get_chunk(), which keeps the comparisons in a branch-free loop
+// that the compiler can vectorize.
+template <class TConditionFunction>
+uint64_t leaf_block_mask(const ArrayInteger& leaf, size_t begin, size_t end, int64_t value)
+{
+    TConditionFunction cond;
+    uint64_t mask = 0;
+    int64_t chunk[8];
+    for (size_t i = begin; i < end; i += 8) {
+        leaf.get_chunk(i, chunk);
+        size_t n = std::min(end - i, size_t(8));
+        uint64_t bits = 0;
+        for (size_t j = 0; j < n; ++j)
+            bits |= uint64_t(cond(chunk[j], value)) << j;
+        mask |= bits << (i - begin);
+    }
+    return mask;
+}
+
+template <class TConditionFunction>
+uint64_t leaf_block_mask(const ArrayIntNull& leaf, size_t begin, size_t end, const util::Optional<int64_t>& value)
+{
+    TConditionFunction cond;
+    const int64_t null_value = leaf.null_value();
+    const int64_t needle = value ? *value : 0;
+    const bool needle_is_null = !value;
+    uint64_t mask = 0;
+    int64_t chunk[8];
+    for (size_t i = begin; i < end; i += 8) {
+        // Element 0 of the underlying array is the null marker
+        leaf.Array::get_chunk(i + 1, chunk);
+        size_t n = std::min(end - i, size_t(8));
+        uint64_t bits = 0;
+        for (size_t j = 0; j < n; ++j)
+            bits |= uint64_t(cond(chunk[j], needle, chunk[j] == null_value, needle_is_null)) << j;
+        mask |= bits << (i - begin);
+    }
+    return mask;
+}
+
+} // namespace _impl
+
 class ParentNode {
     typedef ParentNode ThisType;
 
@@ -161,6 +311,16 @@ public:
         m_children = v;
         m_children.erase(m_children.begin() + i);
         m_children.insert(m_children.begin(), this);
+
+        // A conjunction of conditions which can all be evaluated a block at a time is run fused. The conditions are
+        // tested in order of their expected cost, so that a block is abandoned as early as possible.
+        m_fused_children.clear();
+        auto block_evaluable = [](const ParentNode* node) { return node->has_block_evaluation(); };
+        if (m_children.size() > 1 && std::all_of(m_children.begin(), m_children.end(), block_evaluable)) {
+            m_fused_children = m_children;
+            auto score_compare = [](const ParentNode* a, const ParentNode* b) { return a->cost() < b->cost(); };
+            std::stable_sort(m_fused_children.begin(), m_fused_children.end(), score_compare);
+        }
     }
 
     double cost() const
@@ -171,6 +331,40 @@ public:
 
     size_t find_first(size_t start, size_t end);
 
+    /// Number of rows evaluated at a time by evaluate_block().
+    static constexpr size_t block_size = 64;
+
+    // Whether evaluate_block() is implemented. Only nodes that compare a column value with a constant, and which
+    // would scan the column anyway, support it.
+    virtual bool has_block_evaluation() const
+    {
+        return false;
+    }
+
+    // Evaluate the condition of this node alone (m_child is not consulted) for the rows in [start, end), where
+    // `end - start` is at most block_size. Bit `i` of the result is set if row `start + i` matches.
+    virtual uint64_t evaluate_block(size_t start, size_t end);
+
+    // Whether find_first() and Query::aggregate_internal() evaluate all conditions of the conjunction rooted at
+    // this node together, a block of rows at a time. Decided by gather_children().
+    bool is_fused() const noexcept
+    {
+        return !m_fused_children.empty();
+    }
+
+    // Run the action prepared by ParentNode::aggregate_local_prepare() for every match in [start, end). Must only be
+    // called if is_fused(). Returns false if the action asked for the search to stop.
+    bool aggregate_fused(QueryStateBase* st, size_t start, size_t end, SequentialGetterBase* source_column);
+
+    // The column which this node reads row by row when evaluated over a range of rows, or null if it reads none, or
+    // looks the matches up in a search index.
+    const ColumnBase* get_scanned_column() const
+    {
+        if (!m_table || m_condition_column_idx == npos || m_dT == 0.0)
+            return nullptr;
+        return &m_table->get_column_base(m_condition_column_idx);
+    }
+
     virtual void init()
     {
         // Verify that the cached column accessor is still valid
@@ -182,6 +376,15 @@ public:
         m_column_action_specializer = nullptr;
     }
 
+    // Called after init() when every row of the table is about to be visited,
+    // so that preparations which only pay off over a full scan, such as
+    // building zone maps, are worth making.
+    virtual void prepare_full_scan()
+    {
+        if (m_child)
+            m_child->prepare_full_scan();
+    }
+
     void set_table(const Table& table)
     {
         if (&table == m_table)
@@ -292,16 +495,19 @@ public:
 
     std::unique_ptr<ParentNode> m_child;
     std::vector<ParentNode*> m_children;
-    size_t m_condition_column_idx = npos; // Column of search criteria
+    std::vector<ParentNode*> m_fused_children; // m_children by increasing cost if is_fused(), otherwise empty
+    size_t m_condition_column_idx = npos;      // Column of search criteria
 
-    double m_dD;       // Average row distance between each local match at current position
-    double m_dT = 0.0; // Time overhead of testing index i + 1 if we have just tested index i. > 1 for linear scans, 0
-    // for index/tableview
+    double m_dD = 100.0; // Average row distance between each local match at current position
+    double m_dT = 0.0;   // Time overhead of testing index i + 1 if we have just tested index i. > 1 for linear
+    // scans, 0 for index/tableview
 
     size_t m_probes = 0;
     size_t m_matches = 0;
 
 protected:
+    uint64_t evaluate_fused_block(size_t start, size_t end);
+
     typedef bool (ParentNode::*Column_action_specialized)(QueryStateBase*, SequentialGetterBase*, size_t);
     Column_action_specialized m_column_action_specializer;
     ConstTableRef m_table;
@@ -312,6 +518,21 @@ protected:
         return m_table->get_column_base(ndx);
     }
 
+    // Seed m_dD from the statistics collected by Table::analyze(), if any. Without them a node starts out with a
+    // fixed guess, and the query has to probe every condition before it can pick a good one to drive the search.
+    template <class TConditionFunction, class T>
+    void seed_cost_from_statistics(T value, size_t num_values = 1)
+    {
+        const ColumnStatistics* stats = m_table->get_column_statistics(m_condition_column_idx);
+        if (!stats || stats->row_count == 0)
+            return;
+        double selectivity = _impl::estimate_selectivity<TConditionFunction>(*stats, value);
+        if (selectivity < 0)
+            return;
+        selectivity = std::min(selectivity * double(num_values), 1.0);
+        m_dD = 1.0 / std::max(selectivity, 1.0 / double(stats->row_count + 1));
+    }
+
     template <class ColType>
     const ColType& get_column(size_t ndx)
     {
@@ -585,9 +806,11 @@ protected:
     using LeafType = typename ColType::LeafType;
     using LeafInfo = typename ColType::LeafInfo;
 
+    template <class TConditionFunction>
     size_t aggregate_local_impl(QueryStateBase* st, size_t start, size_t end, size_t local_limit,
-                                SequentialGetterBase* source_column, int c)
+                                SequentialGetterBase* source_column)
     {
+        constexpr int c = TConditionFunction::condition;
         REALM_ASSERT(m_children.size() > 0);
         m_local_matches = 0;
         m_local_limit = local_limit;
@@ -599,6 +822,9 @@ protected:
         // column only, with no references to other columns:
         bool fastmode = should_run_in_fastmode(source_column);
         for (size_t s = start; s < end;) {
+            s = _impl::skip_leaves<TConditionFunction>(m_zone_map, s, end, m_value);
+            if (s == end)
+                break;
             cache_leaf(s);
 
             size_t end_in_leaf;
@@ -670,6 +896,8 @@ protected:
     void init() override
     {
         ColumnNodeBase::init();
+        // The column may have moved since the query was built
+        m_condition_column_idx = m_condition_column->get_column_index();
 
         m_dT = _impl::CostHeuristic<ColType>::dT();
         m_dD = _impl::CostHeuristic<ColType>::dD();
@@ -678,6 +906,7 @@ protected:
         m_leaf_end = 0;
         m_array_ptr.reset(); // Explicitly destroy the old one first, because we're reusing the memory.
         m_array_ptr.reset(new (&m_leaf_cache_storage) LeafType(m_table->get_alloc()));
+        m_zone_map = nullptr;
     }
 
     void get_leaf(const ColType& col, size_t ndx)
@@ -698,6 +927,24 @@ protected:
         }
     }
 
+    template <class TConditionFunction>
+    uint64_t evaluate_block_impl(size_t start, size_t end)
+    {
+        uint64_t mask = 0;
+        for (size_t s = start; s < end;) {
+            s = _impl::skip_leaves<TConditionFunction>(m_zone_map, s, end, m_value);
+            if (s == end)
+                break;
+            cache_leaf(s);
+            size_t end_in_leaf = std::min(end, m_leaf_end) - m_leaf_start;
+            size_t start_in_leaf = s - m_leaf_start;
+            mask |= _impl::leaf_block_mask<TConditionFunction>(*m_leaf_ptr, start_in_leaf, end_in_leaf, m_value)
+                    << (s - start);
+            s = m_leaf_start + end_in_leaf;
+        }
+        return mask;
+    }
+
     bool should_run_in_fastmode(SequentialGetterBase* source_column) const
     {
         return (m_children.size() == 1 &&
@@ -712,6 +959,9 @@ protected:
     // Column on which search criteria are applied
     const ColType* m_condition_column = nullptr;
 
+    // Per-leaf value ranges of the condition column. Null if the column is too small to have one.
+    const ZoneMap<int64_t>* m_zone_map = nullptr;
+
     // Leaf cache
     using LeafCacheStorage = typename std::aligned_storage<sizeof(LeafType), alignof(LeafType)>::type;
     LeafCacheStorage m_leaf_cache_storage;
@@ -745,6 +995,19 @@ public:
     {
     }
 
+    void init() override
+    {
+        BaseType::init();
+        this->template seed_cost_from_statistics<TConditionFunction>(this->m_value);
+        this->m_zone_map = this->m_table->template find_zone_map<int64_t>(this->m_condition_column_idx);
+    }
+
+    void prepare_full_scan() override
+    {
+        BaseType::prepare_full_scan();
+        this->m_zone_map = this->m_table->template get_zone_map<int64_t>(this->m_condition_column_idx);
+    }
+
     void aggregate_local_prepare(Action action, DataType col_id, bool is_nullable) override
     {
         this->m_fastmode_disabled = (col_id == type_Float || col_id == type_Double);
@@ -755,8 +1018,17 @@ public:
     size_t aggregate_local(QueryStateBase* st, size_t start, size_t end, size_t local_limit,
                            SequentialGetterBase* source_column) override
     {
-        constexpr int cond = TConditionFunction::condition;
-        return this->aggregate_local_impl(st, start, end, local_limit, source_column, cond);
+        return this->template aggregate_local_impl<TConditionFunction>(st, start, end, local_limit, source_column);
+    }
+
+    bool has_block_evaluation() const override
+    {
+        return true;
+    }
+
+    uint64_t evaluate_block(size_t start, size_t end) override
+    {
+        return this->template evaluate_block_impl<TConditionFunction>(start, end);
     }
 
     size_t find_first_local(size_t start, size_t end) override
@@ -764,6 +1036,9 @@ public:
         REALM_ASSERT(this->m_table);
 
         while (start < end) {
+            start = _impl::skip_leaves<TConditionFunction>(this->m_zone_map, start, end, this->m_value);
+            if (start == end)
+                break;
 
             // Cache internal leaves
             if (start >= this->m_leaf_end || start < this->m_leaf_start) {
@@ -896,6 +1171,7 @@ public:
     {
         BaseType::init();
         m_nb_needles = m_needles.size();
+        this->template seed_cost_from_statistics<Equal>(this->m_value, std::max(m_nb_needles, size_t(1)));
 
         if (has_search_index()) {
             if (m_result) {
@@ -912,6 +1188,16 @@ public:
             m_index_end = m_result->size();
             IntegerNodeBase<ColType>::m_dT = 0;
         }
+        else if (m_nb_needles == 0) {
+            this->m_zone_map = this->m_table->template find_zone_map<int64_t>(this->m_condition_column_idx);
+        }
+    }
+
+    void prepare_full_scan() override
+    {
+        BaseType::prepare_full_scan();
+        if (!has_search_index() && m_nb_needles == 0)
+            this->m_zone_map = this->m_table->template get_zone_map<int64_t>(this->m_condition_column_idx);
     }
 
     void consume_condition(IntegerNode<ColType, Equal>* other)
@@ -929,6 +1215,17 @@ public:
         return IntegerNodeBase<ColType>::m_condition_column->has_search_index();
     }
 
+    bool has_block_evaluation() const override
+    {
+        // A search index or a set of needles is faster than scanning
+        return m_needles.empty() && this->m_condition_column && !has_search_index();
+    }
+
+    uint64_t evaluate_block(size_t start, size_t end) override
+    {
+        return this->template evaluate_block_impl<Equal>(start, end);
+    }
+
     size_t find_first_local(size_t start, size_t end) override
     {
         REALM_ASSERT(this->m_table);
@@ -959,6 +1256,10 @@ public:
 
 
         while (start < end) {
+            start = _impl::skip_leaves<Equal>(this->m_zone_map, start, end, this->m_value);
+            if (start == end)
+                break;
+
             // Cache internal leaves
             this->cache_leaf(start);
 
@@ -1096,16 +1397,56 @@ public:
     void init() override
     {
         ParentNode::init();
+        // The column may have moved since the query was built
+        m_condition_column_idx = m_condition_column.m_column->get_column_index();
         m_dD = 100.0;
+        seed_cost_from_statistics<TConditionFunction>(m_value);
+        m_zone_map = m_table->find_zone_map<TConditionValue>(m_condition_column_idx);
+        m_nullable = m_table->is_nullable(m_condition_column_idx);
+    }
+
+    void prepare_full_scan() override
+    {
+        ParentNode::prepare_full_scan();
+        m_zone_map = m_table->get_zone_map<TConditionValue>(m_condition_column_idx);
+    }
+
+    bool has_block_evaluation() const override
+    {
+        return true;
+    }
+
+    uint64_t evaluate_block(size_t start, size_t end) override
+    {
+        TConditionFunction cond;
+        bool value_is_null = m_nullable && null::is_null_float(m_value);
+        uint64_t mask = 0;
+        for (size_t s = start; s < end;) {
+            s = _impl::skip_leaves<TConditionFunction>(m_zone_map, s, end, m_value);
+            if (s == end)
+                break;
+            m_condition_column.cache_next(s);
+            size_t leaf_start = m_condition_column.m_leaf_start;
+            size_t end_in_leaf = m_condition_column.local_end(end);
+            const auto* leaf = m_condition_column.m_leaf_ptr;
+            for (size_t i = s - leaf_start; i < end_in_leaf; ++i) {
+                TConditionValue v = leaf->get(i);
+                bool v_is_null = m_nullable && null::is_null_float(v);
+                mask |= uint64_t(cond(v, m_value, v_is_null, value_is_null)) << (leaf_start + i - start);
+            }
+            s = leaf_start + end_in_leaf;
+        }
+        return mask;
     }
 
     size_t find_first_local(size_t start, size_t end) override
     {
         TConditionFunction cond;
+        bool nullable = m_table->is_nullable(m_condition_column_idx);
 
-        auto find = [&](bool nullability) {
+        auto find = [&](bool nullability, size_t begin, size_t end2) {
             bool m_value_nan = nullability ? null::is_null_float(m_value) : false;
-            for (size_t s = start; s < end; ++s) {
+            for (size_t s = begin; s < end2; ++s) {
                 TConditionValue v = m_condition_column.get_next(s);
                 REALM_ASSERT(!(null::is_null_float(v) && !nullability));
                 if (cond(v, m_value, nullability ? null::is_null_float<TConditionValue>(v) : false, m_value_nan))
@@ -1114,11 +1455,25 @@ public:
             return not_found;
         };
 
-        // This will inline the second case but no the first. Todo, use templated lambda when switching to c++14
-        if (m_table->is_nullable(m_condition_column_idx))
-            return find(true);
-        else
-            return find(false);
+        if (!m_zone_map) {
+            // This will inline the second case but no the first. Todo, use templated lambda when switching to c++14
+            if (nullable)
+                return find(true, start, end);
+            else
+                return find(false, start, end);
+        }
+
+        while (start < end) {
+            start = _impl::skip_leaves<TConditionFunction>(m_zone_map, start, end, m_value);
+            if (start == end)
+                break;
+            size_t end2 = std::min(m_zone_map->find(start)->end, end);
+            size_t s = nullable ? find(true, start, end2) : find(false, start, end2);
+            if (s != not_found)
+                return s;
+            start = end2;
+        }
+        return not_found;
     }
 
     std::string describe(util::serializer::SerialisationState& state) const override
@@ -1147,6 +1502,8 @@ public:
 protected:
     TConditionValue m_value;
     SequentialGetter<ColType> m_condition_column;
+    const ZoneMap<TConditionValue>* m_zone_map = nullptr;
+    bool m_nullable = false;
 };
 
 template <class ColType, class TConditionFunction>
@@ -1319,6 +1676,8 @@ public:
     void init() override
     {
         ParentNode::init();
+        // The column may have moved since the query was built
+        m_condition_column_idx = m_condition_column->get_column_index();
 
         m_dD = 100.0;
 
@@ -1330,6 +1689,13 @@ public:
         m_array_ptr_nanos.reset(); // Explicitly destroy the old one first, because we're reusing the memory.
         m_array_ptr_nanos.reset(new (&m_leaf_cache_storage_nanos) LeafTypeNanos(m_table->get_alloc()));
         m_condition_column_is_nullable = m_condition_column->is_nullable();
+        m_zone_map = m_table->find_zone_map<int64_t>(m_condition_column_idx);
+    }
+
+    void prepare_full_scan() override
+    {
+        ParentNode::prepare_full_scan();
+        m_zone_map = m_table->get_zone_map<int64_t>(m_condition_column_idx);
     }
 
 protected:
@@ -1386,6 +1752,9 @@ protected:
     const TimestampColumn* m_condition_column;
     bool m_condition_column_is_nullable = false;
 
+    // Per-leaf ranges of the seconds of the condition column
+    const ZoneMap<int64_t>* m_zone_map = nullptr;
+
     // Leaf cache seconds
     using LeafCacheStorageSeconds =
         typename std::aligned_storage<sizeof(LeafTypeSeconds), alignof(LeafTypeSeconds)>::type;
@@ -1413,6 +1782,10 @@ public:
     size_t find_first_local_seconds(size_t start, size_t end)
     {
         while (start < end) {
+            start = _impl::skip_leaves<Condition>(m_zone_map, start, end, m_needle_seconds);
+            if (start == end)
+                break;
+
             // Cache internal leaves
             if (start >= this->m_leaf_end_seconds || start < this->m_leaf_start_seconds) {
                 this->get_leaf_seconds(*this->m_condition_column, start);
@@ -1687,12 +2060,27 @@ public:
     size_t find_first_local(size_t start, size_t end) override
     {
         Contains cond;
-        
-        for (size_t s = start; s < end; ++s) {
+        // Leaves of medium sized strings keep all payloads in one blob, which
+        // can be searched in a single pass
+        bool bulk = m_column_type != col_type_StringEnum && m_value && !m_value->empty();
+
+        for (size_t s = start; s < end;) {
             StringData t = get_string(s);
-            
+
+            if (bulk && m_leaf_type == StringColumn::leaf_type_Medium) {
+                size_t local_end = std::min(m_end_s, end);
+                auto& leaf = static_cast<const ArrayStringLong&>(*m_leaf);
+                size_t res = leaf.find_first_containing(StringData(*m_value), m_charmap, s - m_leaf_start,
+                                                        local_end - m_leaf_start);
+                if (res != not_found)
+                    return res + m_leaf_start;
+                s = local_end;
+                continue;
+            }
+
             if (cond(StringData(m_value), m_charmap, t))
                 return s;
+            ++s;
         }
         return not_found;
     }
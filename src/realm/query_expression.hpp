@@ -352,6 +352,8 @@ private:
 
 struct ValueBase {
     static const size_t chunk_size = 8;
+    // Maximum number of rows evaluated at a time by Subexpr::evaluate_batch()
+    static const size_t batch_size = 256;
     virtual void export_bool(ValueBase& destination) const = 0;
     virtual void export_Timestamp(ValueBase& destination) const = 0;
     virtual void export_int(ValueBase& destination) const = 0;
@@ -452,7 +454,30 @@ public:
         return {};
     }
 
+    // If the expression reads a column through links, return a copy which reads the same column directly from the
+    // target table. Together with get_origin_ndxs(), this allows a condition to be evaluated on the target table
+    // with the matches mapped back to the base table through the backlinks.
+    virtual std::unique_ptr<Subexpr> clone_for_target_table() const
+    {
+        return nullptr;
+    }
+
+    // Return the rows of the base table which link to the specified rows of the target table
+    virtual std::vector<size_t> get_origin_ndxs(std::vector<size_t> target_rows) const
+    {
+        return target_rows;
+    }
+
     virtual void evaluate(size_t index, ValueBase& destination) = 0;
+
+    // Like evaluate(), but may load up to `max_rows` consecutive rows at once. Column values are then read
+    // straight from the leaf containing row `index`, so fewer rows than requested may be returned. The default
+    // implementation evaluates a single chunk.
+    virtual void evaluate_batch(size_t index, size_t max_rows, ValueBase& destination)
+    {
+        static_cast<void>(max_rows);
+        evaluate(index, destination);
+    }
 };
 
 template <typename T, typename... Args>
@@ -1266,8 +1291,12 @@ public:
             size_t min = std::min(left->m_values, right->m_values);
             init(false, min);
 
+            TOperator op;
             for (size_t i = 0; i < min; i++) {
-                m_storage.set(i, o(left->m_storage.get(i), right->m_storage.get(i)));
+                if (left->m_storage.is_null(i) || right->m_storage.is_null(i))
+                    m_storage.set_null(i);
+                else
+                    m_storage.set(i, op(left->m_storage[i], right->m_storage[i]));
             }
         }
         else if (left->m_from_link_list && right->m_from_link_list) {
@@ -1296,6 +1325,42 @@ public:
         }
     }
 
+    // Like fun(), but one of the operands is a constant, whose single value is combined with every value of the
+    // other operand
+    template <class TOperator>
+    REALM_FORCEINLINE void fun_const(const Value* left, const Value* right, bool left_is_const)
+    {
+        const Value* values = left_is_const ? right : left;
+        const Value* constant = left_is_const ? left : right;
+        size_t sz = values->m_values;
+        init(values->m_from_link_list, sz);
+
+        if (constant->m_storage.is_null(0)) {
+            for (size_t i = 0; i < sz; i++)
+                m_storage.set_null(i);
+            return;
+        }
+
+        TOperator op;
+        T c = constant->m_storage[0];
+        if (left_is_const) {
+            for (size_t i = 0; i < sz; i++) {
+                if (values->m_storage.is_null(i))
+                    m_storage.set_null(i);
+                else
+                    m_storage.set(i, op(c, values->m_storage[i]));
+            }
+        }
+        else {
+            for (size_t i = 0; i < sz; i++) {
+                if (values->m_storage.is_null(i))
+                    m_storage.set_null(i);
+                else
+                    m_storage.set(i, op(values->m_storage[i], c));
+            }
+        }
+    }
+
     template <class TOperator>
     REALM_FORCEINLINE void fun(const Value* value)
     {
@@ -1945,7 +2010,14 @@ public:
         return res;
     }
 
-    std::vector<size_t> get_origin_ndxs(size_t index, size_t column = 0) const;
+    std::vector<size_t> get_origin_ndxs(size_t index) const
+    {
+        return get_origin_ndxs(std::vector<size_t>{index});
+    }
+
+    // Return the rows of the base table which link to any of the specified rows of the target table. Rows
+    // reached through several paths are returned several times.
+    std::vector<size_t> get_origin_ndxs(std::vector<size_t> ndxs) const;
 
     size_t count_links(size_t row)
     {
@@ -2185,6 +2257,35 @@ public:
         }
     }
 
+    void evaluate_batch(size_t index, size_t max_rows, ValueBase& destination) override
+    {
+        if (links_exist()) {
+            evaluate(index, destination);
+            return;
+        }
+
+        Value<T>& d = static_cast<Value<T>&>(destination);
+        const Table* target_table = m_link_map.target_table();
+        size_t col = column_ndx();
+        size_t rows = std::min(max_rows, target_table->size() - index);
+        d.init(false, rows);
+        for (size_t t = 0; t < rows; t++) {
+            d.m_storage.set(t, target_table->get<T>(col, index + t));
+        }
+    }
+
+    std::unique_ptr<Subexpr> clone_for_target_table() const override
+    {
+        if (!links_exist())
+            return nullptr;
+        return make_subexpr<Columns<T>>(column_ndx(), m_link_map.target_table());
+    }
+
+    std::vector<size_t> get_origin_ndxs(std::vector<size_t> target_rows) const override
+    {
+        return m_link_map.get_origin_ndxs(std::move(target_rows));
+    }
+
     bool links_exist() const
     {
         return m_link_map.m_link_columns.size() > 0;
@@ -2227,6 +2328,11 @@ public:
         return m_column->get_column_index();
     }
 
+    const ColumnBase& get_column_base() const
+    {
+        return *m_column;
+    }
+
     SizeOperator<Size<T>> size()
     {
         return SizeOperator<Size<T>>(this->clone(nullptr));
@@ -2242,7 +2348,37 @@ private:
 
 template <>
 class Columns<Timestamp> : public SimpleQuerySupport<Timestamp> {
+public:
     using SimpleQuerySupport::SimpleQuerySupport;
+
+    // Read the seconds and nanoseconds straight from the leaves instead of looking each row up in both B+trees
+    void evaluate_batch(size_t index, size_t max_rows, ValueBase& destination) override
+    {
+        if (links_exist()) {
+            evaluate(index, destination);
+            return;
+        }
+
+        auto& col = static_cast<const TimestampColumn&>(get_column_base());
+        IntNullColumn::LeafType seconds_cache(col.get_alloc());
+        IntegerColumn::LeafType nanos_cache(col.get_alloc());
+        const IntNullColumn::LeafType* seconds = nullptr;
+        const IntegerColumn::LeafType* nanos = nullptr;
+        IntNullColumn::LeafInfo seconds_info{&seconds, &seconds_cache};
+        IntegerColumn::LeafInfo nanos_info{&nanos, &nanos_cache};
+        size_t seconds_ndx;
+        size_t nanos_ndx;
+        col.get_seconds_leaf(index, seconds_ndx, seconds_info);
+        col.get_nanoseconds_leaf(index, nanos_ndx, nanos_info);
+        size_t rows = std::min({max_rows, seconds->size() - seconds_ndx, nanos->size() - nanos_ndx});
+
+        Value<Timestamp>& d = static_cast<Value<Timestamp>&>(destination);
+        d.init(false, rows);
+        for (size_t t = 0; t < rows; t++) {
+            util::Optional<int64_t> s = seconds->get(seconds_ndx + t);
+            d.m_storage.set(t, s ? Timestamp(*s, int32_t(nanos->get(nanos_ndx + t))) : Timestamp{});
+        }
+    }
 };
 
 template <>
@@ -3155,6 +3291,46 @@ inline Query operator!=(null, const Subexpr2<Link>& right)
 }
 
 
+namespace _impl {
+
+// Copy `count` values, starting at `begin`, from a column leaf into `storage`
+template <class Leaf, class T>
+void read_leaf(const Leaf& leaf, size_t begin, size_t count, NullableVector<T>& storage)
+{
+    for (size_t i = 0; i < count; i++)
+        storage.set(i, leaf.get(begin + i));
+}
+
+inline void read_leaf(const ArrayInteger& leaf, size_t begin, size_t count, NullableVector<int64_t>& storage)
+{
+    size_t i = 0;
+    for (; i + ValueBase::chunk_size <= count; i += ValueBase::chunk_size)
+        leaf.get_chunk(begin + i, storage.m_first + i);
+    for (; i < count; i++)
+        storage.set(i, leaf.get(begin + i));
+}
+
+inline void read_leaf(const ArrayIntNull& leaf, size_t begin, size_t count, NullableVector<int64_t>& storage)
+{
+    // The first element of an ArrayIntNull holds the value representing null
+    int64_t null_value = leaf.null_value();
+    int64_t chunk[ValueBase::chunk_size];
+    size_t i = 0;
+    for (; i + ValueBase::chunk_size <= count; i += ValueBase::chunk_size) {
+        leaf.Array::get_chunk(begin + i + 1, chunk);
+        for (size_t j = 0; j < ValueBase::chunk_size; j++) {
+            if (chunk[j] == null_value)
+                storage.set_null(i + j);
+            else
+                storage.set(i + j, chunk[j]);
+        }
+    }
+    for (; i < count; i++)
+        storage.set(i, leaf.get(begin + i));
+}
+
+} // namespace _impl
+
 template <class T>
 class Columns : public Subexpr2<T> {
 public:
@@ -3367,6 +3543,48 @@ public:
         }
     }
 
+    void evaluate_batch(size_t index, size_t max_rows, ValueBase& destination) override
+    {
+        if (links_exist() || max_rows <= ValueBase::chunk_size) {
+            evaluate(index, destination);
+        }
+        else if (m_nullable && std::is_same<typename ColType::value_type, int64_t>::value) {
+            evaluate_leaf<IntNullColumn>(index, max_rows, destination);
+        }
+        else {
+            evaluate_leaf<ColType>(index, max_rows, destination);
+        }
+    }
+
+    // Load up to `max_rows` values, starting at row `index`, from the leaf containing that row into destination
+    template <class ColType2>
+    void evaluate_leaf(size_t index, size_t max_rows, ValueBase& destination)
+    {
+        REALM_ASSERT_DEBUG(dynamic_cast<SequentialGetter<ColType2>*>(m_sg.get()));
+
+        using U = typename util::RemoveOptional<typename ColType2::value_type>::type;
+        auto sgc = static_cast<SequentialGetter<ColType2>*>(m_sg.get());
+        sgc->cache_next(index);
+        size_t rows = std::min(max_rows, sgc->m_leaf_end - index);
+
+        Value<U> v;
+        v.init(false, rows);
+        _impl::read_leaf(*sgc->m_leaf_ptr, index - sgc->m_leaf_start, rows, v.m_storage);
+        destination.import(v);
+    }
+
+    std::unique_ptr<Subexpr> clone_for_target_table() const override
+    {
+        if (!links_exist())
+            return nullptr;
+        return make_subexpr<Columns<T>>(get_column_base().get_column_index(), m_link_map.target_table());
+    }
+
+    std::vector<size_t> get_origin_ndxs(std::vector<size_t> target_rows) const override
+    {
+        return m_link_map.get_origin_ndxs(std::move(target_rows));
+    }
+
     bool links_exist() const
     {
         return m_link_map.m_link_columns.size() > 0;
@@ -3734,6 +3952,53 @@ public:
     }
 };
 
+// Timestamps have no value which every other value compares below or above, so the first value accumulated is
+// taken as the initial result. Null values are ignored.
+template <typename Condition>
+class TimestampMinMaxOperation {
+public:
+    using ResultType = Timestamp;
+
+    void accumulate(Timestamp value)
+    {
+        if (value.is_null())
+            return;
+        if (m_count++ == 0 || Condition()(value, m_result, false, false))
+            m_result = value;
+    }
+
+    bool is_null() const
+    {
+        return m_count == 0;
+    }
+    ResultType result() const
+    {
+        return m_result;
+    }
+
+private:
+    size_t m_count = 0;
+    Timestamp m_result;
+};
+
+template <>
+class Minimum<Timestamp> : public TimestampMinMaxOperation<Less> {
+public:
+    static std::string description()
+    {
+        return "@min";
+    }
+};
+
+template <>
+class Maximum<Timestamp> : public TimestampMinMaxOperation<Greater> {
+public:
+    static std::string description()
+    {
+        return "@max";
+    }
+};
+
 template <typename T>
 class Sum : public BaseAggregateOperation<T, Sum<T>> {
 public:
@@ -3832,6 +4097,15 @@ public:
         destination.import(result);
     }
 
+    void evaluate_batch(size_t index, size_t max_rows, ValueBase& destination) override
+    {
+        Value<T> result;
+        Value<T> left;
+        m_left->evaluate_batch(index, max_rows, left);
+        result.template fun<oper>(&left);
+        destination.import(result);
+    }
+
     virtual std::string description(util::serializer::SerialisationState& state) const override
     {
         if (m_left) {
@@ -3914,13 +4188,20 @@ public:
     // destination = operator(left, right)
     void evaluate(size_t index, ValueBase& destination) override
     {
-        Value<T> result;
         Value<T> left;
         Value<T> right;
         m_left->evaluate(index, left);
         m_right->evaluate(index, right);
-        result.template fun<oper>(&left, &right);
-        destination.import(result);
+        apply(left, right, destination);
+    }
+
+    void evaluate_batch(size_t index, size_t max_rows, ValueBase& destination) override
+    {
+        Value<T> left;
+        Value<T> right;
+        m_left->evaluate_batch(index, max_rows, left);
+        m_right->evaluate_batch(index, max_rows, right);
+        apply(left, right, destination);
     }
 
     virtual std::string description(util::serializer::SerialisationState& state) const override
@@ -3949,6 +4230,21 @@ public:
 
 private:
     typedef typename oper::type T;
+
+    void apply(const Value<T>& left, const Value<T>& right, ValueBase& destination)
+    {
+        Value<T> result;
+        bool left_is_const = m_left->has_constant_evaluation();
+        if (left_is_const != m_right->has_constant_evaluation()) {
+            // A constant yields a single value, which must be applied to every row of the other operand
+            result.template fun_const<oper>(&left, &right, left_is_const);
+        }
+        else {
+            result.template fun<oper>(&left, &right);
+        }
+        destination.import(result);
+    }
+
     std::unique_ptr<TLeft> m_left;
     std::unique_ptr<TRight> m_right;
 };
@@ -3997,6 +4293,8 @@ public:
     double init() override
     {
         double dT = m_left_is_const ? 10.0 : 50.0;
+        m_has_matches = false;
+        m_matches.clear();
         if (std::is_same<TCond, Equal>::value && m_left_is_const && m_right->has_search_index()) {
             if (m_left_value.m_storage.is_null(0)) {
                 m_matches = m_right->find_all(util::Optional<Mixed>());
@@ -4014,6 +4312,13 @@ public:
             m_index_end = m_matches.size();
             dT = 0;
         }
+        else if (m_left_is_const) {
+            init_backlink_search();
+        }
+        m_batch_begin = 0;
+        m_batch_end = 0;
+        m_batch_matches.clear();
+        m_rows_evaluated = 0;
 
         return dT;
     }
@@ -4040,6 +4345,11 @@ public:
 
     size_t find_first(size_t start, size_t end) const override
     {
+        if (m_target_column && m_rows_evaluated > m_target_column->get_base_table()->size()) {
+            // Following the links row by row has now cost about as much as a scan of the target table would
+            find_matches_through_backlinks();
+        }
+
         if (m_has_matches) {
             if (m_index_end == 0)
                 return not_found;
@@ -4062,28 +4372,14 @@ public:
             return not_found;
         }
 
-        size_t match;
+        while (start < end) {
+            if (start < m_batch_begin || start >= m_batch_end)
+                evaluate_batch(start, end);
 
-        Value<T> left;
-        Value<T> right;
-
-        for (; start < end;) {
-            if (m_left_is_const) {
-                m_right->evaluate(start, right);
-                match = Value<T>::template compare_const<TCond>(&m_left_value, &right);
-            }
-            else {
-                m_left->evaluate(start, left);
-                m_right->evaluate(start, right);
-                match = Value<T>::template compare<TCond>(&left, &right);
-            }
-
-            if (match != not_found && match + start < end)
-                return start + match;
-
-            size_t rows =
-                (left.m_from_link_list || right.m_from_link_list) ? 1 : minimum(right.m_values, left.m_values);
-            start += rows;
+            auto it = std::lower_bound(m_batch_matches.begin(), m_batch_matches.end(), start);
+            if (it != m_batch_matches.end())
+                return *it < end ? *it : not_found;
+            start = m_batch_end;
         }
 
         return not_found; // no match
@@ -4130,15 +4426,115 @@ private:
         }
     }
 
+    // A condition on a column reached through links can be evaluated by scanning the target table and following
+    // the backlinks of the matching rows, rather than by following the links of every row of the base table. This
+    // is only possible if a null value does not match, since a row with a null link has no backlink to find it
+    // by. The switch is made once find_first() has evaluated as many rows as there are in the target table, so
+    // that queries which find their matches early are not slowed down by it.
+    void init_backlink_search()
+    {
+        m_target_column = m_right->clone_for_target_table();
+        if (!m_target_column)
+            return;
+        const Table* target_table = m_target_column->get_base_table();
+        m_target_column->set_base_table(target_table);
+
+        TCond c;
+        Value<T> null_value;
+        null_value.m_storage.set_null(0);
+        const Value<T>& l = m_left_value;
+        if (target_table->size() > m_right->get_base_table()->size() ||
+            c(l.m_storage[0], null_value.m_storage[0], l.m_storage.is_null(0), true))
+            m_target_column.reset();
+    }
+
+    void find_matches_through_backlinks() const
+    {
+        TCond c;
+        const Value<T>& l = m_left_value;
+        std::vector<size_t> targets;
+        Value<T> right;
+        size_t size = m_target_column->get_base_table()->size();
+        for (size_t row = 0; row < size;) {
+            m_target_column->evaluate_batch(row, std::min(size - row, ValueBase::batch_size), right);
+            size_t rows = std::max(std::min(right.m_values, size - row), size_t(1));
+            for (size_t i = 0; i < rows; i++) {
+                if (c(l.m_storage[0], right.m_storage[i], l.m_storage.is_null(0), right.m_storage.is_null(i)))
+                    targets.push_back(row + i);
+            }
+            row += rows;
+        }
+        m_target_column.reset();
+
+        m_matches = m_right->get_origin_ndxs(std::move(targets));
+        std::sort(m_matches.begin(), m_matches.end());
+        m_matches.erase(std::unique(m_matches.begin(), m_matches.end()), m_matches.end());
+        m_has_matches = true;
+        m_index_get = 0;
+        m_index_last_start = 0;
+        m_index_end = m_matches.size();
+    }
+
+    // Evaluate the condition for a batch of rows starting at `start`, and store the indexes of the matching rows
+    // in m_batch_matches, so that subsequent calls to find_first() need not evaluate them again.
+    void evaluate_batch(size_t start, size_t end) const
+    {
+        TCond c;
+        Value<T> left;
+        Value<T> right;
+        size_t max_rows = std::min(end - start, ValueBase::batch_size);
+        const Value<T>& l = m_left_is_const ? m_left_value : left;
+        if (!m_left_is_const)
+            m_left->evaluate_batch(start, max_rows, left);
+        m_right->evaluate_batch(start, max_rows, right);
+
+        m_batch_matches.clear();
+        size_t rows = 1;
+        if (l.m_from_link_list || right.m_from_link_list) {
+            // All values belong to the single row `start`
+            size_t match = m_left_is_const ? Value<T>::template compare_const<TCond>(&l, &right)
+                                           : Value<T>::template compare<TCond>(&left, &right);
+            if (match != not_found)
+                m_batch_matches.push_back(start);
+        }
+        else if (m_left_is_const) {
+            rows = right.m_values;
+            T value = l.m_storage[0];
+            bool value_is_null = l.m_storage.is_null(0);
+            for (size_t i = 0; i < rows; i++) {
+                if (c(value, right.m_storage[i], value_is_null, right.m_storage.is_null(i)))
+                    m_batch_matches.push_back(start + i);
+            }
+        }
+        else {
+            rows = std::min(left.m_values, right.m_values);
+            for (size_t i = 0; i < rows; i++) {
+                if (c(left.m_storage[i], right.m_storage[i], left.m_storage.is_null(i), right.m_storage.is_null(i)))
+                    m_batch_matches.push_back(start + i);
+            }
+        }
+
+        m_batch_begin = start;
+        m_batch_end = start + std::max(rows, size_t(1));
+        m_rows_evaluated += m_batch_end - m_batch_begin;
+    }
+
     std::unique_ptr<TLeft> m_left;
     std::unique_ptr<TRight> m_right;
     bool m_left_is_const;
     Value<T> m_left_value;
-    bool m_has_matches = false;
-    std::vector<size_t> m_matches;
+    mutable bool m_has_matches = false;
+    mutable std::vector<size_t> m_matches;
     mutable size_t m_index_get = 0;
     mutable size_t m_index_last_start = 0;
-    size_t m_index_end = 0;
+    // Rows [m_batch_begin, m_batch_end) have been evaluated, and m_batch_matches holds those that matched
+    mutable size_t m_batch_begin = 0;
+    mutable size_t m_batch_end = 0;
+    mutable std::vector<size_t> m_batch_matches;
+    mutable size_t m_index_end = 0;
+    // The column of m_right read directly from its target table, if the matches may be found through backlinks
+    mutable std::unique_ptr<Subexpr> m_target_column;
+    mutable size_t m_rows_evaluated = 0;
 };
 
 }
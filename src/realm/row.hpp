@@ -19,7 +19,9 @@
 #ifndef REALM_ROW_HPP
 #define REALM_ROW_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
 
 #include <realm/util/type_traits.hpp>
 #include <realm/mixed.hpp>
@@ -230,6 +232,76 @@ private:
     friend class Table;
 };
 
+/// Iterates over the rows of a table or a table view, producing a row
+/// expression (BasicRowExpr) for each of them. Unlike a BasicRow, neither the
+/// iterator nor the row expressions it produces are registered with the
+/// table, so they are cheap to create and destroy, but they are also not
+/// adjusted when rows are inserted or removed. They are therefore only valid
+/// until the next modification of the table.
+///
+///     for (auto row : table)
+///         sum += row.get_int(0);
+///
+/// \tparam C The type of the iterated container (`Table`, `TableView`, or a
+/// const version of either).
+///
+/// \tparam T The table type of the produced row expressions.
+template <class C, class T>
+class BasicRowIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = BasicRowExpr<T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = BasicRowExpr<T>;
+
+    BasicRowIterator() noexcept = default;
+
+    BasicRowIterator(C* container, size_t row_ndx) noexcept
+        : m_container(container)
+        , m_row_ndx(row_ndx)
+    {
+    }
+
+    BasicRowExpr<T> operator*() const noexcept
+    {
+        return m_container->get(m_row_ndx);
+    }
+
+    BasicRowIterator& operator++() noexcept
+    {
+        ++m_row_ndx;
+        return *this;
+    }
+
+    BasicRowIterator operator++(int) noexcept
+    {
+        BasicRowIterator prev = *this;
+        ++m_row_ndx;
+        return prev;
+    }
+
+    bool operator==(const BasicRowIterator& other) const noexcept
+    {
+        return m_row_ndx == other.m_row_ndx && m_container == other.m_container;
+    }
+
+    bool operator!=(const BasicRowIterator& other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+    /// The index of the current row within the iterated container.
+    size_t get_index() const noexcept
+    {
+        return m_row_ndx;
+    }
+
+private:
+    C* m_container = nullptr;
+    size_t m_row_ndx = 0;
+};
+
 // fwd decl
 class Group;
 
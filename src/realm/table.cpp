@@ -16,6 +16,7 @@
  *
  **************************************************************************/
 
+#include <cmath>
 #include <limits>
 #include <stdexcept>
 
@@ -27,6 +28,7 @@
 #include <realm/util/features.h>
 #include <realm/util/miscellaneous.hpp>
 #include <realm/impl/destroy_guard.hpp>
+#include <realm/impl/json_writer.hpp>
 #include <realm/exceptions.hpp>
 #include <realm/table.hpp>
 #include <realm/descriptor.hpp>
@@ -2453,8 +2455,8 @@ void Table::batch_erase_rows(const IntegerColumn& row_indexes, bool is_move_last
             state.rows.push_back(row); // Throws
         }
     }
-    sort(begin(state.rows), end(state.rows));
-    state.rows.erase(unique(begin(state.rows), end(state.rows)), end(state.rows));
+    std::sort(state.rows.begin(), state.rows.end());
+    state.rows.erase(std::unique(state.rows.begin(), state.rows.end()), state.rows.end());
 
     if (Group* g = get_parent_group())
         state.track_link_nullifications = g->has_cascade_notification_handler();
@@ -3966,6 +3968,59 @@ double Table::average_double(size_t col_ndx, size_t* value_count) const
 
 // minimum ----------------------------------------------
 
+namespace {
+
+// Use a zone map to find the first leaf holding the smallest (or, if not \a minimum, the largest) value of a column,
+// so that only that leaf has to be searched. Only a zone map which has already been built is used, as building one
+// takes longer than the search it would save. Returns null if there is no zone map, the column has no non-null
+// values, or the summaries cannot single out the leaf because the extreme is an infinity (a leaf containing NaN is
+// summarized as spanning all values).
+template <class T>
+const LeafSummary<T>* find_extreme_leaf(const ZoneMap<T>* zone_map, bool minimum)
+{
+    if (!zone_map)
+        return nullptr;
+    const LeafSummary<T>* best = nullptr;
+    for (const LeafSummary<T>& s : zone_map->leaves()) {
+        if (!s.has_values())
+            continue;
+        if (!best || (minimum ? s.min < best->min : best->max < s.max))
+            best = &s;
+    }
+    if (best && !std::isfinite(double(minimum ? best->min : best->max)))
+        return nullptr;
+    return best;
+}
+
+// Only the seconds are summarized, so every leaf whose extreme seconds equal the best one has to be searched
+template <class Condition>
+Timestamp timestamp_minmax(const TimestampColumn& col, const ZoneMap<int64_t>& zone_map,
+                           const LeafSummary<int64_t>& best_leaf, size_t* return_ndx)
+{
+    bool minimum = std::is_same<Condition, Less>::value;
+    int64_t best_seconds = minimum ? best_leaf.min : best_leaf.max;
+    Timestamp best;
+    size_t best_ndx = npos;
+    for (const LeafSummary<int64_t>& s : zone_map.leaves()) {
+        if (!s.has_values() || (minimum ? s.min : s.max) != best_seconds)
+            continue;
+        for (size_t i = s.begin; i < s.end; ++i) {
+            Timestamp candidate = col.get(i);
+            if (candidate.is_null())
+                continue;
+            if (best.is_null() || Condition()(candidate, best)) {
+                best = candidate;
+                best_ndx = i;
+            }
+        }
+    }
+    if (return_ndx)
+        *return_ndx = best_ndx;
+    return best;
+}
+
+} // anonymous namespace
+
 #define USE_COLUMN_AGGREGATE 1
 
 int64_t Table::minimum_int(size_t col_ndx, size_t* return_ndx) const
@@ -3974,12 +4029,17 @@ int64_t Table::minimum_int(size_t col_ndx, size_t* return_ndx) const
         return 0;
 
 #if USE_COLUMN_AGGREGATE
+    const LeafSummary<int64_t>* leaf = find_extreme_leaf(find_zone_map<int64_t>(col_ndx), true);
     if (is_nullable(col_ndx)) {
         const IntNullColumn& col = get_column<IntNullColumn, col_type_Int>(col_ndx);
+        if (leaf)
+            return col.minimum(leaf->begin, leaf->end, npos, return_ndx);
         return col.minimum(0, npos, npos, return_ndx);
     }
     else {
         const IntegerColumn& col = get_column<IntegerColumn, col_type_Int>(col_ndx);
+        if (leaf)
+            return col.minimum(leaf->begin, leaf->end, npos, return_ndx);
         return col.minimum(0, npos, npos, return_ndx);
     }
 #else
@@ -4003,6 +4063,8 @@ float Table::minimum_float(size_t col_ndx, size_t* return_ndx) const
         return 0.f;
 
     const FloatColumn& col = get_column<FloatColumn, col_type_Float>(col_ndx);
+    if (auto leaf = find_extreme_leaf(find_zone_map<float>(col_ndx), true))
+        return col.minimum(leaf->begin, leaf->end, npos, return_ndx);
     return col.minimum(0, npos, npos, return_ndx);
 }
 
@@ -4012,6 +4074,8 @@ double Table::minimum_double(size_t col_ndx, size_t* return_ndx) const
         return 0.;
 
     const DoubleColumn& col = get_column<DoubleColumn, col_type_Double>(col_ndx);
+    if (auto leaf = find_extreme_leaf(find_zone_map<double>(col_ndx), true))
+        return col.minimum(leaf->begin, leaf->end, npos, return_ndx);
     return col.minimum(0, npos, npos, return_ndx);
 }
 
@@ -4036,6 +4100,9 @@ Timestamp Table::minimum_timestamp(size_t col_ndx, size_t* return_ndx) const
         return Timestamp{};
 
     const TimestampColumn& col = get_column<TimestampColumn, col_type_Timestamp>(col_ndx);
+    const ZoneMap<int64_t>* zone_map = find_zone_map<int64_t>(col_ndx);
+    if (auto leaf = find_extreme_leaf(zone_map, true))
+        return timestamp_minmax<Less>(col, *zone_map, *leaf, return_ndx);
     return col.minimum(return_ndx);
 }
 
@@ -4047,12 +4114,17 @@ int64_t Table::maximum_int(size_t col_ndx, size_t* return_ndx) const
         return 0;
 
 #if USE_COLUMN_AGGREGATE
+    const LeafSummary<int64_t>* leaf = find_extreme_leaf(find_zone_map<int64_t>(col_ndx), false);
     if (is_nullable(col_ndx)) {
         const IntNullColumn& col = get_column_int_null(col_ndx);
+        if (leaf)
+            return col.maximum(leaf->begin, leaf->end, npos, return_ndx);
         return col.maximum(0, npos, npos, return_ndx);
     }
     else {
         const IntegerColumn& col = get_column(col_ndx);
+        if (leaf)
+            return col.maximum(leaf->begin, leaf->end, npos, return_ndx);
         return col.maximum(0, npos, npos, return_ndx);
     }
 
@@ -4077,6 +4149,8 @@ float Table::maximum_float(size_t col_ndx, size_t* return_ndx) const
         return 0.f;
 
     const FloatColumn& col = get_column<FloatColumn, col_type_Float>(col_ndx);
+    if (auto leaf = find_extreme_leaf(find_zone_map<float>(col_ndx), false))
+        return col.maximum(leaf->begin, leaf->end, npos, return_ndx);
     return col.maximum(0, npos, npos, return_ndx);
 }
 
@@ -4086,6 +4160,8 @@ double Table::maximum_double(size_t col_ndx, size_t* return_ndx) const
         return 0.;
 
     const DoubleColumn& col = get_column<DoubleColumn, col_type_Double>(col_ndx);
+    if (auto leaf = find_extreme_leaf(find_zone_map<double>(col_ndx), false))
+        return col.maximum(leaf->begin, leaf->end, npos, return_ndx);
     return col.maximum(0, npos, npos, return_ndx);
 }
 
@@ -4111,10 +4187,61 @@ Timestamp Table::maximum_timestamp(size_t col_ndx, size_t* return_ndx) const
         return Timestamp{};
 
     const TimestampColumn& col = get_column<TimestampColumn, col_type_Timestamp>(col_ndx);
+    const ZoneMap<int64_t>* zone_map = find_zone_map<int64_t>(col_ndx);
+    if (auto leaf = find_extreme_leaf(zone_map, false))
+        return timestamp_minmax<Greater>(col, *zone_map, *leaf, return_ndx);
     return col.maximum(return_ndx);
 }
 
 
+GroupByResult Table::group_by(const std::vector<GroupKey>& keys, const std::vector<GroupAggregate>& aggregates) const
+{
+    _impl::GroupByBuilder builder(*this, keys, aggregates); // Throws
+    if (m_columns.is_attached()) {
+        size_t num_rows = size();
+        for (size_t i = 0; i < num_rows; ++i)
+            builder.add(i); // Throws
+    }
+    return builder.finish();
+}
+
+
+JoinResult Table::join(size_t col_ndx, const Table& other, size_t other_col_ndx) const
+{
+    if (REALM_UNLIKELY(col_ndx >= get_column_count() || other_col_ndx >= other.get_column_count()))
+        throw LogicError(LogicError::column_index_out_of_range);
+    DataType type = get_column_type(col_ndx);
+    if (REALM_UNLIKELY(type != other.get_column_type(other_col_ndx)))
+        throw LogicError(LogicError::type_mismatch);
+    if (REALM_UNLIKELY(type != type_Int && type != type_Bool && type != type_OldDateTime && type != type_String))
+        throw LogicError(LogicError::illegal_type);
+    if (is_degenerate() || other.is_degenerate())
+        return JoinResult();
+
+    _impl::JoinColumn left{&get_column_base(col_ndx), get_real_column_type(col_ndx), is_nullable(col_ndx), size()};
+    _impl::JoinColumn right{&other.get_column_base(other_col_ndx), other.get_real_column_type(other_col_ndx),
+                            other.is_nullable(other_col_ndx), other.size()};
+    return _impl::hash_join(left, right); // Throws
+}
+
+
+std::vector<ColumnChunk> Table::export_column(size_t col_ndx) const
+{
+    if (REALM_UNLIKELY(col_ndx >= get_column_count()))
+        throw LogicError(LogicError::column_index_out_of_range);
+    if (is_degenerate())
+        return {};
+    return _impl::export_column(get_column_base(col_ndx), get_real_column_type(col_ndx), is_nullable(col_ndx),
+                                size()); // Throws
+}
+
+
+void Table::import_column(size_t col_ndx, size_t row_ndx, const ColumnChunk& chunk)
+{
+    _impl::import_column(*this, col_ndx, row_ndx, chunk); // Throws
+}
+
+
 namespace {
 
 util::Optional<int64_t> upgrade_optional_int(util::Optional<bool> value)
@@ -4852,6 +4979,29 @@ size_t Table::upper_bound_string(size_t col_ndx, StringData value) const noexcep
 }
 
 
+void Table::analyze() const
+{
+    std::vector<ColumnStatistics> statistics;
+    size_t column_count = get_column_count();
+    statistics.reserve(column_count);
+    for (size_t i = 0; i < column_count; ++i)
+        statistics.push_back(ColumnStatistics::compute(*this, i)); // Throws
+
+    m_column_statistics = std::move(statistics);
+    m_statistics_version = observe_version();
+}
+
+
+const ColumnStatistics* Table::get_column_statistics(size_t col_ndx) const noexcept
+{
+    if (m_column_statistics.empty() || m_statistics_version != observe_version())
+        return nullptr;
+    if (col_ndx >= m_column_statistics.size())
+        return nullptr;
+    return &m_column_statistics[col_ndx];
+}
+
+
 void Table::optimize(bool enforce)
 {
     // At the present time there is only one kind of optimization that
@@ -5097,14 +5247,14 @@ void Table::to_json_row(size_t row_ndx, std::ostream& out, size_t link_depth,
     std::map<std::string, std::string> renames2;
     renames = renames ? renames : &renames2;
 
-    std::vector<ref_type> followed;
-    to_json_row(row_ndx, out, link_depth, *renames, followed);
+    _impl::JsonWriter writer(out);
+    _impl::JsonExportState state(*renames);
+    to_json_row(row_ndx, writer, link_depth, state);
+    writer.flush();
 }
 
 
 namespace {
-const char to_be_escaped[] = "\"\n\r\t\f\\\b";
-const char encoding[] = "\"nrtf\\b";
 
 inline void out_olddatetime(std::ostream& out, OldDateTime value)
 {
@@ -5135,89 +5285,90 @@ inline void out_timestamp(std::ostream& out, Timestamp value)
     }
 }
 
-inline void out_string(std::ostream& out, const StringData val)
-{
-    std::string str(val);
-    size_t p = str.find_first_of(to_be_escaped);
-    while (p != std::string::npos) {
-        char c = str[p];
-        auto found = strchr(to_be_escaped, c);
-        REALM_ASSERT(found);
-        out << str.substr(0, p) << '\\' << encoding[found - to_be_escaped];
-        str = str.substr(p + 1);
-        p = str.find_first_of(to_be_escaped);
-    }
-    out << str;
-}
-
-inline void out_binary(std::ostream& out, const BinaryData bin)
+const std::string& renamed(std::map<std::string, std::string>& renames, const std::string& name)
 {
-    const char* start = bin.data();
-    const size_t len = bin.size();
-    util::StringBuffer encode_buffer;
-    encode_buffer.resize(util::base64_encoded_size(len));
-    util::base64_encode(start, len, encode_buffer.data(), encode_buffer.size());
-    out << encode_buffer.str();
-}
-
-template <class T>
-void out_floats(std::ostream& out, T value)
-{
-    std::streamsize old = out.precision();
-    out.precision(std::numeric_limits<T>::digits10 + 1);
-    out << std::scientific << value;
-    out.precision(old);
+    auto it = renames.find(name);
+    return it == renames.end() || it->second.empty() ? name : it->second;
 }
 
 } // anonymous namespace
 
 void Table::to_json(std::ostream& out, size_t link_depth, std::map<std::string, std::string>* renames) const
 {
-    // Represent table as list of objects
-    auto tv = where().find_all();
-    if (get_column_name(0) == "!OID") {
-        tv.sort(0);
-    }
-    out << "[";
+    std::map<std::string, std::string> renames2;
+    renames = renames ? renames : &renames2;
+
+    _impl::JsonWriter writer(out);
+    _impl::JsonExportState state(*renames);
 
+    // Represent table as list of objects. Links are followed independently for each row.
+    writer.put('[');
     size_t row_count = size();
-    for (size_t r = 0; r < row_count; ++r) {
-        if (r > 0)
-            out << ",";
-        to_json_row(tv.get_source_ndx(r), out, link_depth, renames);
+    if (get_column_count() != 0 && get_column_name(0) == "!OID") {
+        // Rows are written in the order of their object IDs
+        auto tv = where().find_all();
+        tv.sort(0);
+        for (size_t r = 0; r < row_count; ++r) {
+            if (r > 0)
+                writer.put(',');
+            state.followed.clear();
+            to_json_row(tv.get_source_ndx(r), writer, link_depth, state);
+        }
     }
-
-    out << "]";
+    else {
+        for (size_t r = 0; r < row_count; ++r) {
+            if (r > 0)
+                writer.put(',');
+            state.followed.clear();
+            to_json_row(r, writer, link_depth, state);
+        }
+    }
+    writer.put(']');
+    writer.flush();
 }
 
-void Table::to_json_row(size_t row_ndx, std::ostream& out, size_t link_depth,
-                        std::map<std::string, std::string>& renames, std::vector<ref_type>& followed) const
+const std::vector<std::string>& Table::get_json_prefixes(_impl::JsonExportState& state) const
 {
-    out << "{";
+    std::vector<std::string>& prefixes = state.column_prefixes[this];
+    if (!prefixes.empty())
+        return prefixes;
+
     size_t column_count = get_column_count();
     for (size_t i = 0; i < column_count; ++i) {
         std::string name = get_column_name(i);
-        if (!has_shared_type()) {
-            if (i == 0) {
-                if (name == "!OID") {
-                    name = "_key";
-                }
-                else {
-                    std::string n = "_key";
-                    if (renames[n] != "")
-                        n = renames[n];
-                    out << "\"" << n << "\":" << row_ndx << ",";
-                }
+        if (i == 0 && !has_shared_type()) {
+            if (name == "!OID") {
+                name = "_key";
+            }
+            else {
+                // The row index is written between this and the prefix of the first column
+                prefixes.push_back("\"" + renamed(state.renames, "_key") + "\":");
             }
         }
+        prefixes.push_back((i > 0 || prefixes.size() == 1 ? ",\"" : "\"") + renamed(state.renames, name) + "\":");
+    }
+    return prefixes;
+}
 
-        if (i > 0)
-            out << ",";
-
-        if (renames[name] != "")
-            name = renames[name];
+void Table::to_json_row(size_t row_ndx, _impl::JsonWriter& out, size_t link_depth,
+                        _impl::JsonExportState& state) const
+{
+    // Recording a column more than once would not change which links are followed
+    auto mark_followed = [&](ref_type ref) {
+        if (std::find(state.followed.begin(), state.followed.end(), ref) == state.followed.end())
+            state.followed.push_back(ref);
+    };
 
-        out << "\"" << name << "\":";
+    const std::vector<std::string>& prefixes = get_json_prefixes(state);
+    size_t column_count = get_column_count();
+    size_t prefix_ndx = 0;
+    out.put('{');
+    if (prefixes.size() > column_count) {
+        out.put(prefixes[prefix_ndx++]);
+        out.put_size(row_ndx);
+    }
+    for (size_t i = 0; i < column_count; ++i) {
+        out.put(prefixes[prefix_ndx++]);
 
         DataType type = get_column_type(i);
         if (type == type_Link) {
@@ -5227,24 +5378,29 @@ void Table::to_json_row(size_t row_ndx, std::ostream& out, size_t link_depth,
 
             if (!cl.is_null_link(row_ndx)) {
                 ref_type clb_ref = clb.get_ref();
-                if ((link_depth == 0) || (link_depth == not_found &&
-                                          std::find(followed.begin(), followed.end(), clb_ref) != followed.end())) {
+                if ((link_depth == 0) ||
+                    (link_depth == not_found &&
+                     std::find(state.followed.begin(), state.followed.end(), clb_ref) != state.followed.end())) {
                     size_t lnk = cl.get_link(row_ndx);
                     if (table.get_column_name(0) == "!OID") {
                         lnk = size_t(table.get_int(0, lnk));
                     }
-                    out << "{\"table\": \"" << table.get_name() << "\", \"key\": " << lnk << "}";
+                    out.put("{\"table\": \"");
+                    out.put(table.get_name());
+                    out.put("\", \"key\": ");
+                    out.put_size(lnk);
+                    out.put('}');
                 }
                 else {
-                    out << "[";
-                    followed.push_back(clb_ref);
+                    out.put('[');
+                    mark_followed(clb_ref);
                     size_t new_depth = link_depth == not_found ? not_found : link_depth - 1;
-                    table.to_json_row(cl.get_link(row_ndx), out, new_depth, renames, followed);
-                    out << "]";
+                    table.to_json_row(cl.get_link(row_ndx), out, new_depth, state);
+                    out.put(']');
                 }
             }
             else {
-                out << "null";
+                out.put("null");
             }
         }
         else if (type == type_LinkList) {
@@ -5255,63 +5411,74 @@ void Table::to_json_row(size_t row_ndx, std::ostream& out, size_t link_depth,
 
             ref_type clb_ref = clb.get_ref();
             if ((link_depth == 0) ||
-                (link_depth == not_found && std::find(followed.begin(), followed.end(), clb_ref) != followed.end())) {
-                out << "{\"table\": \"" << cll.get_target_table().get_name() << "\", \"keys\": [";
-                cll.to_json_row(row_ndx, out);
-                out << "]}";
+                (link_depth == not_found &&
+                 std::find(state.followed.begin(), state.followed.end(), clb_ref) != state.followed.end())) {
+                out.put("{\"table\": \"");
+                out.put(table.get_name());
+                out.put("\", \"keys\": [");
+                bool has_oid = table.get_column_name(0) == "!OID";
+                for (size_t link_ndx = 0; link_ndx < lv->size(); link_ndx++) {
+                    if (link_ndx > 0)
+                        out.put(',');
+                    size_t target = lv->get(link_ndx).get_index();
+                    if (has_oid)
+                        target = size_t(table.get_int(0, target));
+                    out.put_size(target);
+                }
+                out.put("]}");
             }
             else {
-                out << "[";
+                out.put('[');
                 for (size_t link_ndx = 0; link_ndx < lv->size(); link_ndx++) {
                     if (link_ndx > 0)
-                        out << ",";
-                    followed.push_back(clb_ref);
+                        out.put(',');
+                    mark_followed(clb_ref);
                     size_t new_depth = link_depth == not_found ? not_found : link_depth - 1;
-                    table.to_json_row(lv->get(link_ndx).get_index(), out, new_depth, renames, followed);
+                    table.to_json_row(lv->get(link_ndx).get_index(), out, new_depth, state);
                 }
-                out << "]";
+                out.put(']');
             }
         }
         else if (type == type_Table) {
             auto list = get_subtable(i, row_ndx);
             auto list_type = list->get_column_type(0);
             auto sz = list->size();
-            out << "[";
+            out.put('[');
             for (size_t r = 0; r < sz; r++) {
                 if (r > 0) {
-                    out << ",";
+                    out.put(',');
                 }
                 if (list->is_null(0, r)) {
-                    out << "null";
+                    out.put("null");
                     continue;
                 }
                 switch (list_type) {
                     case type_Int:
-                        out << list->get_int(0, r);
+                        out.put_int(list->get_int(0, r));
                         break;
                     case type_Bool:
-                        out << (list->get_bool(0, r) ? "true" : "false");
+                        out.put(list->get_bool(0, r) ? "true" : "false");
                         break;
                     case type_Float:
-                        out_floats<float>(out, list->get_float(0, r));
+                        out.put_float(list->get_float(0, r));
                         break;
                     case type_Double:
-                        out_floats<double>(out, list->get_double(0, r));
+                        out.put_double(list->get_double(0, r));
                         break;
                     case type_String:
-                        out << "\"";
-                        out_string(out, list->get_string(0, r));
-                        out << "\"";
+                        out.put('"');
+                        out.put_escaped(list->get_string(0, r));
+                        out.put('"');
                         break;
                     case type_Binary:
-                        out << "\"";
-                        out_binary(out, list->get_binary(0, r));
-                        out << "\"";
+                        out.put('"');
+                        out.put_base64(list->get_binary(0, r));
+                        out.put('"');
                         break;
                     case type_Timestamp:
-                        out << "\"";
-                        out_timestamp(out, list->get_timestamp(0, r));
-                        out << "\"";
+                        out.put('"');
+                        out.put_timestamp(list->get_timestamp(0, r));
+                        out.put('"');
                         break;
                     case type_OldDateTime:
                     case type_Table:
@@ -5322,40 +5489,40 @@ void Table::to_json_row(size_t row_ndx, std::ostream& out, size_t link_depth,
                         break;
                 }
             }
-            out << "]";
+            out.put(']');
         }
         else {
             if (is_null(i, row_ndx)) {
-                out << "null";
+                out.put("null");
                 continue;
             }
             switch (type) {
                 case type_Int:
-                    out << get_int(i, row_ndx);
+                    out.put_int(get_int(i, row_ndx));
                     break;
                 case type_Bool:
-                    out << (get_bool(i, row_ndx) ? "true" : "false");
+                    out.put(get_bool(i, row_ndx) ? "true" : "false");
                     break;
                 case type_Float:
-                    out_floats<float>(out, get_float(i, row_ndx));
+                    out.put_float(get_float(i, row_ndx));
                     break;
                 case type_Double:
-                    out_floats<double>(out, get_double(i, row_ndx));
+                    out.put_double(get_double(i, row_ndx));
                     break;
                 case type_String:
-                    out << "\"";
-                    out_string(out, get_string(i, row_ndx));
-                    out << "\"";
+                    out.put('"');
+                    out.put_escaped(get_string(i, row_ndx));
+                    out.put('"');
                     break;
                 case type_Binary:
-                    out << "\"";
-                    out_binary(out, get_binary(i, row_ndx));
-                    out << "\"";
+                    out.put('"');
+                    out.put_base64(get_binary(i, row_ndx));
+                    out.put('"');
                     break;
                 case type_Timestamp:
-                    out << "\"";
-                    out_timestamp(out, get_timestamp(i, row_ndx));
-                    out << "\"";
+                    out.put('"');
+                    out.put_timestamp(get_timestamp(i, row_ndx));
+                    out.put('"');
                     break;
                 case type_OldDateTime:
                 case type_Table:
@@ -5366,7 +5533,7 @@ void Table::to_json_row(size_t row_ndx, std::ostream& out, size_t link_depth,
             } // switch ends
         }
     }
-    out << "}";
+    out.put('}');
 }
 
 
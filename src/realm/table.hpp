@@ -37,6 +37,11 @@
 #include <realm/query.hpp>
 #include <realm/column.hpp>
 #include <realm/column_binary.hpp>
+#include <realm/column_chunk.hpp>
+#include <realm/column_statistics.hpp>
+#include <realm/group_by.hpp>
+#include <realm/join.hpp>
+#include <realm/zone_map.hpp>
 
 namespace realm {
 
@@ -70,6 +75,8 @@ typedef Link BackLink;
 
 namespace _impl {
 class TableFriend;
+class JsonWriter;
+struct JsonExportState;
 }
 namespace metrics {
 class QueryInfo;
@@ -368,6 +375,18 @@ public:
     RowExpr operator[](size_t row_ndx) noexcept;
     ConstRowExpr operator[](size_t row_ndx) const noexcept;
 
+    typedef BasicRowIterator<Table, Table> iterator;
+    typedef BasicRowIterator<const Table, const Table> const_iterator;
+
+    /// Iterate over the rows of this table using row expressions, which, in
+    /// contrast to Row, are not registered with the table. The iterators and
+    /// the row expressions are only valid until the table is modified. See
+    /// BasicRowIterator.
+    iterator begin() noexcept;
+    iterator end() noexcept;
+    const_iterator begin() const noexcept;
+    const_iterator end() const noexcept;
+
 
     //@{
 
@@ -715,6 +734,29 @@ public:
     void aggregate(size_t group_by_column, size_t aggr_column, AggrType op, Table& result,
                    const IntegerColumn* viewrefs = nullptr) const;
 
+    /// Group the rows of this table by the values of one or more key columns
+    /// and compute the specified aggregates for every group. See GroupKey
+    /// and GroupAggregate for the supported column types.
+    GroupByResult group_by(const std::vector<GroupKey>& keys, const std::vector<GroupAggregate>& aggregates) const;
+
+    /// Find all pairs of rows of this table and \a other whose values in
+    /// the specified columns are equal. Both columns must be of the same
+    /// type, which must be integer, boolean, OldDateTime or string. Null
+    /// values do not match anything, not even other nulls. A search index on
+    /// either column is used when it saves scanning the larger table.
+    JoinResult join(size_t col_ndx, const Table& other, size_t other_col_ndx) const;
+
+    /// Export the values of an integer, boolean, OldDateTime, float, double
+    /// or string column in the layout of Apache Arrow arrays, as a sequence
+    /// of chunks which together cover all rows. See ColumnChunk for when
+    /// the values are read in place.
+    std::vector<ColumnChunk> export_column(size_t col_ndx) const;
+
+    /// Set the values of the rows starting at \a row_ndx from a chunk
+    /// produced by export_column() or filled in the same layout. The rows
+    /// must exist already.
+    void import_column(size_t col_ndx, size_t row_ndx, const ColumnChunk& chunk);
+
     /// Report the current versioning counter for the table. The versioning counter is guaranteed to
     /// change when the contents of the table changes after advance_read() or promote_to_write(), or
     /// immediately after calls to methods which change the table. The term "change" means "change of
@@ -824,6 +866,37 @@ public:
     // enforce == false will auto-evaluate if they should be enumerated or not
     void optimize(bool enforce = false);
 
+    /// Collect statistics for every column of this table: number of nulls,
+    /// estimated number of distinct values and, for numeric columns, the
+    /// value range and an equi-depth histogram. The query engine uses them
+    /// to pick the condition that drives a query before it has probed the
+    /// columns itself. The statistics are cached in this accessor and are
+    /// discarded as soon as the table is modified.
+    void analyze() const;
+
+    /// Returns the statistics collected by the latest call to analyze(), or
+    /// null if analyze() has not been called since the table was last
+    /// modified.
+    const ColumnStatistics* get_column_statistics(size_t column_ndx) const noexcept;
+
+    /// Returns the per-leaf value summary of the specified column, building
+    /// it first if the table has been modified since it was last built. `T`
+    /// must be `int64_t` for integer, boolean and Timestamp columns (for the
+    /// latter only the seconds are summarized), and `float` or `double` for
+    /// columns of those types. Returns null for other column types and for
+    /// tables that are too small to benefit from a zone map.
+    ///
+    /// Building a zone map takes a pass over the column, so it only pays off
+    /// ahead of a scan over the whole column, or when the table is not
+    /// modified between scans.
+    template <class T>
+    const ZoneMap<T>* get_zone_map(size_t column_ndx) const;
+
+    /// Like get_zone_map(), but returns null instead of building the zone
+    /// map if none has been built since the table was last modified.
+    template <class T>
+    const ZoneMap<T>* find_zone_map(size_t column_ndx) const noexcept;
+
     /// Write this table (or a slice of this table) to the specified
     /// output stream.
     ///
@@ -1095,6 +1168,16 @@ private:
 
     mutable uint_fast64_t m_version;
 
+    // Statistics collected by analyze(). Only valid while m_version equals
+    // m_statistics_version.
+    mutable std::vector<ColumnStatistics> m_column_statistics;
+    mutable uint_fast64_t m_statistics_version = 0;
+
+    // Zone maps built by get_zone_map(), indexed by column. Only valid while
+    // m_version equals m_zone_map_version.
+    mutable std::vector<std::unique_ptr<ZoneMapBase>> m_zone_maps;
+    mutable uint_fast64_t m_zone_map_version = 0;
+
     void erase_row(size_t row_ndx, bool is_move_last_over);
     void batch_erase_rows(const IntegerColumn& row_indexes, bool is_move_last_over);
     void do_remove(size_t row_ndx, bool broken_reciprocal_backlinks);
@@ -1229,11 +1312,10 @@ private:
     void to_string_header(std::ostream& out, std::vector<size_t>& widths) const;
     void to_string_row(size_t row_ndx, std::ostream& out, const std::vector<size_t>& widths) const;
 
-    // recursive methods called by to_json, to follow links
-    void to_json(std::ostream& out, size_t link_depth, std::map<std::string, std::string>& renames,
-                 std::vector<ref_type>& followed) const;
-    void to_json_row(size_t row_ndx, std::ostream& out, size_t link_depth,
-                     std::map<std::string, std::string>& renames, std::vector<ref_type>& followed) const;
+    // recursive method called by to_json, to follow links
+    void to_json_row(size_t row_ndx, _impl::JsonWriter& out, size_t link_depth,
+                     _impl::JsonExportState& state) const;
+    const std::vector<std::string>& get_json_prefixes(_impl::JsonExportState& state) const;
     void to_json_row(size_t row_ndx, std::ostream& out, size_t link_depth = 0,
                      std::map<std::string, std::string>* renames = nullptr) const;
 
@@ -1591,6 +1673,10 @@ private:
 #endif
 
     friend class SubtableNode;
+    friend struct ColumnStatistics;
+    friend class _impl::GroupByBuilder;
+    template <class>
+    friend class ZoneMap;
     friend class _impl::TableFriend;
     friend class Query;
     friend class metrics::QueryInfo;
@@ -1666,6 +1752,31 @@ inline uint64_t Table::observe_version() const noexcept
     return m_version;
 }
 
+template <class T>
+const ZoneMap<T>* Table::get_zone_map(size_t col_ndx) const
+{
+    uint_fast64_t version = observe_version();
+    if (version != m_zone_map_version || m_zone_maps.size() != get_column_count()) {
+        m_zone_maps.clear();
+        m_zone_maps.resize(get_column_count());
+        m_zone_map_version = version;
+    }
+    REALM_ASSERT_DEBUG(col_ndx < m_zone_maps.size());
+    std::unique_ptr<ZoneMapBase>& zone_map = m_zone_maps[col_ndx];
+    if (!zone_map)
+        zone_map = ZoneMap<T>::create(*this, col_ndx); // Throws
+    // Null if `T` does not match the type of the column
+    return dynamic_cast<const ZoneMap<T>*>(zone_map.get());
+}
+
+template <class T>
+const ZoneMap<T>* Table::find_zone_map(size_t col_ndx) const noexcept
+{
+    if (observe_version() != m_zone_map_version || col_ndx >= m_zone_maps.size())
+        return nullptr;
+    return dynamic_cast<const ZoneMap<T>*>(m_zone_maps[col_ndx].get());
+}
+
 inline void Table::bump_version(bool bump_global) const noexcept
 {
     if (bump_global) {
@@ -2082,6 +2193,26 @@ inline Table::ConstRowExpr Table::operator[](size_t row_ndx) const noexcept
     return get(row_ndx);
 }
 
+inline Table::iterator Table::begin() noexcept
+{
+    return iterator(this, 0);
+}
+
+inline Table::iterator Table::end() noexcept
+{
+    return iterator(this, m_size);
+}
+
+inline Table::const_iterator Table::begin() const noexcept
+{
+    return const_iterator(this, 0);
+}
+
+inline Table::const_iterator Table::end() const noexcept
+{
+    return const_iterator(this, m_size);
+}
+
 inline size_t Table::add_empty_row(size_t num_rows)
 {
     size_t row_ndx = m_size;
@@ -21,6 +21,7 @@
 #include <realm/column.hpp>
 #include <realm/column_timestamp.hpp>
 #include <realm/column_tpl.hpp>
+#include <realm/impl/json_writer.hpp>
 #include <realm/impl/sequential_getter.hpp>
 
 #include <unordered_set>
@@ -258,7 +259,7 @@ Timestamp TableViewBase::minmax_timestamp(size_t column_ndx, size_t* return_ndx)
 {
     C compare = C();
     Timestamp best = Timestamp{};
-    TimestampColumn& column = m_table->get_column_timestamp(column_ndx);
+    TimestampLeafCache column(m_table->get_column_timestamp(column_ndx));
     size_t ndx = npos;
     for (size_t t = 0; t < size(); t++) {
         int64_t signed_row_ndx = m_row_indexes.get(t);
@@ -359,6 +360,22 @@ Timestamp TableViewBase::minimum_timestamp(size_t column_ndx, size_t* return_ndx
     return minmax_timestamp<realm::Less>(column_ndx, return_ndx);
 }
 
+GroupByResult TableViewBase::group_by(const std::vector<GroupKey>& keys,
+                                      const std::vector<GroupAggregate>& aggregates) const
+{
+    check_cookie();
+    _impl::GroupByBuilder builder(*m_table, keys, aggregates); // Throws
+    size_t num_rows = size();
+    for (size_t t = 0; t < num_rows; ++t) {
+        int64_t signed_row_ndx = m_row_indexes.get(t);
+        // skip detached references:
+        if (signed_row_ndx == detached_ref)
+            continue;
+        builder.add(size_t(signed_row_ndx)); // Throws
+    }
+    return builder.finish();
+}
+
 // Average. The number of values used to compute the result is written to `value_count` by callee
 double TableViewBase::average_int(size_t column_ndx, size_t* value_count) const
 {
@@ -395,7 +412,7 @@ size_t TableViewBase::count_double(size_t column_ndx, double target) const
 
 size_t TableViewBase::count_timestamp(size_t column_ndx, Timestamp target) const
 {
-    TimestampColumn& column = m_table->get_column_timestamp(column_ndx);
+    TimestampLeafCache column(m_table->get_column_timestamp(column_ndx));
     size_t count = 0;
     for (size_t t = 0; t < size(); t++) {
         int64_t signed_row_ndx = m_row_indexes.get(t);
@@ -423,20 +440,30 @@ void TableViewBase::aggregate(size_t group_by_column, size_t aggr_column, Table:
 void TableViewBase::to_json(std::ostream& out, size_t link_depth, std::map<std::string, std::string>* renames) const
 {
     check_cookie();
+
+    std::map<std::string, std::string> renames2;
+    renames = renames ? renames : &renames2;
+
+    _impl::JsonWriter writer(out);
+    _impl::JsonExportState state(*renames);
+
     // Represent table as list of objects
-    out << "[";
+    writer.put('[');
 
     const size_t row_count = size();
     for (size_t r = 0; r < row_count; ++r) {
         const int64_t real_row_index = get_source_ndx(r);
         if (real_row_index != detached_ref) {
             if (r > 0)
-                out << ",";
-            m_table->to_json_row(to_size_t(real_row_index), out, link_depth, renames);
+                writer.put(',');
+            // Links are followed independently for each row
+            state.followed.clear();
+            m_table->to_json_row(to_size_t(real_row_index), writer, link_depth, state);
         }
     }
 
-    out << "]";
+    writer.put(']');
+    writer.flush();
 }
 
 void TableViewBase::to_string(std::ostream& out, size_t lim) const
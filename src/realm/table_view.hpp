@@ -249,6 +249,10 @@ public:
     // document method publicly.
     void aggregate(size_t group_by_column, size_t aggr_column, Table::AggrType op, Table& result) const;
 
+    /// Group the rows of this view like Table::group_by(). Detached rows are
+    /// skipped.
+    GroupByResult group_by(const std::vector<GroupKey>& keys, const std::vector<GroupAggregate>& aggregates) const;
+
     // Get row index in the source table this view is "looking" at.
     size_t get_source_ndx(size_t row_ndx) const noexcept;
 
@@ -473,6 +477,16 @@ public:
     RowExpr operator[](size_t row_ndx) noexcept;
     ConstRowExpr operator[](size_t row_ndx) const noexcept;
 
+    // Iterating over the rows without registering row accessors with the
+    // table. The view must be in sync with the table, and the iterators are
+    // invalidated by any modification of the table (see BasicRowIterator).
+    typedef BasicRowIterator<TableView, Table> iterator;
+    typedef BasicRowIterator<const TableView, const Table> const_iterator;
+    iterator begin() noexcept;
+    iterator end() noexcept;
+    const_iterator begin() const noexcept;
+    const_iterator end() const noexcept;
+
     // Setting values
     void set_int(size_t column_ndx, size_t row_ndx, int64_t value);
     void set_bool(size_t column_ndx, size_t row_ndx, bool value);
@@ -614,6 +628,11 @@ public:
     ConstRowExpr back() const noexcept;
     ConstRowExpr operator[](size_t row_ndx) const noexcept;
 
+    // Iterating over the rows (see TableView::begin())
+    typedef BasicRowIterator<const ConstTableView, const Table> const_iterator;
+    const_iterator begin() const noexcept;
+    const_iterator end() const noexcept;
+
     // Subtables
     ConstTableRef get_subtable(size_t column_ndx, size_t row_ndx) const;
 
@@ -1452,6 +1471,36 @@ inline ConstTableView::ConstRowExpr ConstTableView::operator[](size_t row_ndx) c
     return get(row_ndx);
 }
 
+inline TableView::iterator TableView::begin() noexcept
+{
+    return iterator(this, 0);
+}
+
+inline TableView::iterator TableView::end() noexcept
+{
+    return iterator(this, size());
+}
+
+inline TableView::const_iterator TableView::begin() const noexcept
+{
+    return const_iterator(this, 0);
+}
+
+inline TableView::const_iterator TableView::end() const noexcept
+{
+    return const_iterator(this, size());
+}
+
+inline ConstTableView::const_iterator ConstTableView::begin() const noexcept
+{
+    return const_iterator(this, 0);
+}
+
+inline ConstTableView::const_iterator ConstTableView::end() const noexcept
+{
+    return const_iterator(this, size());
+}
+
 
 // Subtables
 
@@ -296,6 +296,8 @@
 #define REALM_COOKIE_CHECK
 #endif
 
+// Platforms where Durability::Async is supported. The name dates back to when
+// async commits were made durable by a separate daemon process.
 #if !REALM_IOS && !REALM_WATCHOS && !REALM_TVOS && !defined(_WIN32) && !REALM_ANDROID
 #define REALM_ASYNC_DAEMON
 #endif
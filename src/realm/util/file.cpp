@@ -37,6 +37,10 @@
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <sys/file.h> // BSD / Linux flock()
+#include <sys/uio.h>
+#endif
+#if defined(__linux__)
+#include <sys/syscall.h>
 #endif
 
 #include <realm/exceptions.hpp>
@@ -952,6 +956,196 @@ void File::sync()
 }
 
 
+void File::start_writeback(SizeType offset, size_t size) noexcept
+{
+    REALM_ASSERT_RELEASE(is_attached());
+
+#if defined(__linux__)
+    // Any failure will be reported by the sync() which must follow
+    static_cast<void>(::sync_file_range(m_fd, offset, off_t(size), SYNC_FILE_RANGE_WRITE));
+#else
+    static_cast<void>(offset);
+    static_cast<void>(size);
+#endif
+}
+
+
+void File::sync_data()
+{
+    REALM_ASSERT_RELEASE(is_attached());
+
+#if defined(__linux__)
+    if (::fdatasync(m_fd) == 0)
+        return;
+    throw std::system_error(errno, std::system_category(), "fdatasync() failed");
+#else
+    sync(); // Throws
+#endif
+}
+
+
+void File::write_at(SizeType pos, const Segment* segments, size_t num_segments)
+{
+    REALM_ASSERT_RELEASE(is_attached());
+    REALM_ASSERT_RELEASE(!m_encryption_key);
+
+#ifdef _WIN32 // Windows version
+
+    seek(pos); // Throws
+    for (size_t i = 0; i < num_segments; ++i)
+        write_static(m_fd, segments[i].data, segments[i].size); // Throws
+
+#else // POSIX version
+
+    off_t offset;
+    if (int_cast_with_overflow_detect(pos, offset))
+        throw util::overflow_error("File position overflow");
+
+#if defined(__linux__)
+    const int max_iov = IOV_MAX;
+#else
+    const int max_iov = 1;
+#endif
+    // `i` is the first segment which is not yet fully written, and `skip` is
+    // the number of bytes of it which are
+    size_t i = 0;
+    size_t skip = 0;
+    while (i < num_segments) {
+        iovec iov[max_iov];
+        int n = 0;
+        for (size_t j = i; j < num_segments && n < max_iov; ++j) {
+            size_t skip_2 = (j == i ? skip : 0);
+            iov[n].iov_base = const_cast<char*>(segments[j].data + skip_2);
+            iov[n].iov_len = segments[j].size - skip_2;
+            ++n;
+        }
+#if defined(__linux__)
+        ssize_t r = ::pwritev(m_fd, iov, n, offset);
+#else
+        ssize_t r = ::pwrite(m_fd, iov[0].iov_base, iov[0].iov_len, offset);
+#endif
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            goto error; // LCOV_EXCL_LINE
+        }
+        offset += r;
+        size_t written = size_t(r);
+        while (i < num_segments && written >= segments[i].size - skip) {
+            written -= segments[i].size - skip;
+            skip = 0;
+            ++i;
+        }
+        skip += written;
+    }
+    return;
+
+error:
+    // LCOV_EXCL_START
+    int err = errno; // Eliminate any risk of clobbering
+    if (err == ENOSPC || err == EDQUOT) {
+        std::string msg = get_errno_msg("pwrite() failed: ", err);
+        throw OutOfDiskSpace(msg);
+    }
+    throw std::system_error(err, std::system_category(), "pwrite() failed");
+// LCOV_EXCL_STOP
+
+#endif
+}
+
+
+void File::write_at(SizeType pos, const char* data, size_t size)
+{
+    Segment segment = {data, size};
+    write_at(pos, &segment, 1); // Throws
+}
+
+
+size_t File::read_at(SizeType pos, char* data, size_t size)
+{
+    REALM_ASSERT_RELEASE(is_attached());
+    REALM_ASSERT_RELEASE(!m_encryption_key);
+
+#ifdef _WIN32 // Windows version
+
+    seek(pos); // Throws
+    return read_static(m_fd, data, size); // Throws
+
+#else // POSIX version
+
+    off_t offset;
+    if (int_cast_with_overflow_detect(pos, offset))
+        throw util::overflow_error("File position overflow");
+
+    char* const data_0 = data;
+    while (0 < size) {
+        // POSIX requires that 'n' is less than or equal to SSIZE_MAX
+        size_t n = std::min(size, size_t(SSIZE_MAX));
+        ssize_t r = ::pread(m_fd, data, n, offset);
+        if (r == 0)
+            break;
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::system_category(), "pread() failed"); // LCOV_EXCL_LINE
+        }
+        REALM_ASSERT_RELEASE(size_t(r) <= n);
+        size -= size_t(r);
+        data += size_t(r);
+        offset += r;
+    }
+    return data - data_0;
+
+#endif
+}
+
+void File::copy_range_to(File& target, SizeType pos, size_t size)
+{
+    REALM_ASSERT_RELEASE(is_attached() && target.is_attached());
+    REALM_ASSERT_RELEASE(!m_encryption_key && !target.m_encryption_key);
+
+#if defined(__linux__) && defined(SYS_copy_file_range)
+    // Called through syscall(), as the wrapper is missing from older C
+    // libraries
+    loff_t offset;
+    if (int_cast_with_overflow_detect(pos, offset))
+        throw util::overflow_error("File position overflow");
+    while (0 < size) {
+        loff_t in_offset = offset, out_offset = offset;
+        long r = ::syscall(SYS_copy_file_range, m_fd, &in_offset, target.m_fd, &out_offset, size, 0u);
+        if (r < 0) {
+            int err = errno; // Eliminate any risk of clobbering
+            if (err == EINTR)
+                continue;
+            // Not supported by the kernel, or between these file systems
+            if (err == ENOSYS || err == EXDEV || err == EINVAL || err == EOPNOTSUPP)
+                break;
+            if (err == ENOSPC || err == EDQUOT) {
+                std::string msg = get_errno_msg("copy_file_range() failed: ", err);
+                throw OutOfDiskSpace(msg);
+            }
+            throw std::system_error(err, std::system_category(), "copy_file_range() failed");
+        }
+        if (r == 0)
+            throw std::runtime_error("copy_file_range() reached the end of the file");
+        offset += loff_t(r);
+        pos += SizeType(r);
+        size -= size_t(r);
+    }
+#endif
+
+    const size_t buffer_size = 1024 * 1024;
+    std::unique_ptr<char[]> buffer(new char[std::min(size, buffer_size)]); // Throws
+    while (0 < size) {
+        size_t n = std::min(size, buffer_size);
+        if (read_at(pos, buffer.get(), n) != n) // Throws
+            throw std::runtime_error("Read past the end of the file");
+        target.write_at(pos, buffer.get(), n); // Throws
+        pos += SizeType(n);
+        size -= n;
+    }
+}
+
 bool File::lock(bool exclusive, bool non_blocking)
 {
     REALM_ASSERT_RELEASE(is_attached());
@@ -1051,14 +1245,20 @@ void File::unlock() noexcept
 }
 
 
-void* File::map(AccessMode a, size_t size, int /*map_flags*/, size_t offset) const
+void* File::map(AccessMode a, size_t size, int map_flags, size_t offset) const
 {
+    if ((map_flags & map_HugePages) && !m_encryption_key)
+        return realm::util::mmap_huge_page_aligned(m_fd, size, a, offset);
     return realm::util::mmap(m_fd, size, a, offset, m_encryption_key.get());
 }
 
 #if REALM_ENABLE_ENCRYPTION
-void* File::map(AccessMode a, size_t size, EncryptedFileMapping*& mapping, int /*map_flags*/, size_t offset) const
+void* File::map(AccessMode a, size_t size, EncryptedFileMapping*& mapping, int map_flags, size_t offset) const
 {
+    if ((map_flags & map_HugePages) && !m_encryption_key) {
+        mapping = nullptr;
+        return realm::util::mmap_huge_page_aligned(m_fd, size, a, offset);
+    }
     return realm::util::mmap(m_fd, size, a, offset, m_encryption_key.get(), mapping);
 }
 #endif
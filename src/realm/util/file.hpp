@@ -319,6 +319,50 @@ public:
     /// `F_FULLFSYNC`.
     void sync();
 
+    /// Start writing the modified pages in the specified range of the file,
+    /// including pages modified through memory mappings, back to the disk,
+    /// without waiting for it to complete. This allows the writeback of
+    /// several ranges to proceed in parallel before a single call to
+    /// sync(), which is still needed for durability. Does nothing on
+    /// platforms other than Linux.
+    void start_writeback(SizeType offset, size_t size) noexcept;
+
+    /// Like sync(), but on Linux only the file data, and the metadata needed
+    /// to read it back, is flushed (`fdatasync()`). Elsewhere the same as
+    /// sync().
+    void sync_data();
+
+    /// A piece of data to be written by write_at().
+    struct Segment {
+        const char* data;
+        size_t size;
+    };
+
+    /// Write the specified segments back to back, starting at the specified
+    /// position of the file. On POSIX systems, the read/write offset of this
+    /// File instance is not affected, and on Linux as many segments as
+    /// possible are passed to the kernel at once (`pwritev()`). On Windows,
+    /// the offset is left at the end of the written data.
+    ///
+    /// The data is written as is, so this function must not be used with
+    /// encrypted files.
+    void write_at(SizeType pos, const Segment*, size_t num_segments);
+    void write_at(SizeType pos, const char* data, size_t size);
+
+    /// Read from the specified position of the file, and return the number of
+    /// bytes read, which is less than \a size only if the end of the file was
+    /// reached. Affects the read/write offset in the same way as write_at().
+    /// Must not be used with encrypted files.
+    size_t read_at(SizeType pos, char* data, size_t size);
+
+    /// Copy the specified range of this file to the same position of the
+    /// specified file, which must be large enough to hold it. On Linux, the
+    /// data is copied by the kernel (`copy_file_range()`), which shares the
+    /// blocks between the files instead where the file system supports it.
+    /// Elsewhere, and between file systems, the data is copied with large
+    /// positional reads and writes. Must not be used with encrypted files.
+    void copy_range_to(File& target, SizeType pos, size_t size);
+
     /// Place an exclusive lock on this file. This blocks the caller
     /// until all other locks have been released.
     ///
@@ -371,7 +415,13 @@ public:
         /// the default behavior. An explicit call to sync_map() will
         /// flush the buffers regardless of whether this flag is
         /// specified or not.
-        map_NoSync = 1
+        map_NoSync = 1,
+        /// Place the mapping at an address which is aligned like the
+        /// offset relative to util::huge_page_size, and ask for
+        /// transparent huge pages, so that the page cache can back the
+        /// mapping with huge pages where the file system supports it. Only
+        /// has an effect on Linux, and not for encrypted files.
+        map_HugePages = 2
     };
 
     /// Map this file into memory. The file is mapped as shared
@@ -609,6 +659,7 @@ private:
         void remap(const File&, AccessMode, size_t size, int map_flags);
         void unmap() noexcept;
         void sync();
+        void sync(size_t offset, size_t size);
 #if REALM_ENABLE_ENCRYPTION
         util::EncryptedFileMapping* m_encrypted_mapping = nullptr;
         inline util::EncryptedFileMapping* get_encrypted_mapping() const
@@ -742,6 +793,11 @@ public:
     /// attached to a memory mapped file, has undefined behavior.
     void sync();
 
+    /// Same as sync(), but only for the specified byte range of the
+    /// mapping, extended to whole pages. Encrypted mappings are always
+    /// synchronized in full.
+    void sync(size_t offset, size_t size);
+
     /// Check whether this Map instance is currently attached to a
     /// memory mapped file.
     bool is_attached() const noexcept;
@@ -1125,6 +1181,19 @@ inline void File::MapBase::sync()
     File::sync_map(m_fd, m_addr, m_size);
 }
 
+inline void File::MapBase::sync(size_t offset, size_t size)
+{
+    REALM_ASSERT(m_addr);
+    REALM_ASSERT(offset <= m_size && size <= m_size - offset);
+
+    if (get_encrypted_mapping()) {
+        File::sync_map(m_fd, m_addr, m_size);
+        return;
+    }
+    size_t begin = offset - offset % page_size();
+    File::sync_map(m_fd, static_cast<char*>(m_addr) + begin, offset + size - begin);
+}
+
 template <class T>
 inline File::Map<T>::Map(const File& f, AccessMode a, size_t size, int map_flags)
 {
@@ -1173,6 +1242,12 @@ inline void File::Map<T>::sync()
     MapBase::sync();
 }
 
+template <class T>
+inline void File::Map<T>::sync(size_t offset, size_t size)
+{
+    MapBase::sync(offset, size);
+}
+
 template <class T>
 inline bool File::Map<T>::is_attached() const noexcept
 {
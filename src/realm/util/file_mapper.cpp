@@ -29,6 +29,7 @@
 #endif
 
 #include <realm/util/errno.hpp>
+#include <realm/util/memory_policy.hpp>
 #include <realm/util/to_string.hpp>
 #include <realm/exceptions.hpp>
 #include <system_error>
@@ -754,6 +755,39 @@ void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, con
     }
 }
 
+void* mmap_huge_page_aligned(FileDesc fd, size_t size, File::AccessMode access, size_t offset)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (size >= huge_page_size) {
+        int prot = PROT_READ;
+        if (access == File::access_ReadWrite)
+            prot |= PROT_WRITE;
+
+        // Reserve enough address space to contain an address with the same
+        // alignment as the offset, and map the file over that part of it
+        size_t reserved_size = size + huge_page_size;
+        void* reserved = ::mmap(nullptr, reserved_size, PROT_NONE, MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+        if (reserved != MAP_FAILED) {
+            char* begin = static_cast<char*>(reserved);
+            char* end = begin + reserved_size;
+            char* addr = begin + ((offset - reinterpret_cast<uintptr_t>(begin)) & (huge_page_size - 1));
+            void* mapped = ::mmap(addr, size, prot, MAP_SHARED | MAP_FIXED, fd, offset);
+            if (mapped != MAP_FAILED) {
+                char* mapped_end = addr + ((size + page_size() - 1) & ~(page_size() - 1));
+                if (addr != begin)
+                    ::munmap(begin, size_t(addr - begin));
+                if (mapped_end != end)
+                    ::munmap(mapped_end, size_t(end - mapped_end));
+                static_cast<void>(::madvise(addr, size, MADV_HUGEPAGE));
+                return addr;
+            }
+            ::munmap(reserved, reserved_size);
+        }
+    }
+#endif
+    return mmap(fd, size, access, offset, nullptr);
+}
+
 void munmap(void* addr, size_t size)
 {
 #if REALM_ENABLE_ENCRYPTION
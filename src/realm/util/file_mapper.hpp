@@ -30,6 +30,9 @@ namespace realm {
 namespace util {
 
 void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key);
+// Map an unencrypted file as for File::map_HugePages. The mapping is released
+// with munmap() like any other.
+void* mmap_huge_page_aligned(FileDesc fd, size_t size, File::AccessMode access, size_t offset);
 void munmap(void* addr, size_t size);
 void* mremap(FileDesc fd, size_t file_offset, void* old_addr, size_t old_size, File::AccessMode a, size_t new_size,
              const char* encryption_key);
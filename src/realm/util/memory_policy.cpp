@@ -0,0 +1,162 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/util/memory_policy.hpp>
+
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+#include <realm/util/assert.hpp>
+#include <realm/util/file.hpp>
+
+using namespace realm;
+using namespace realm::util;
+
+namespace {
+
+#if defined(__linux__)
+
+void apply_numa_policy(void* addr, size_t size, const MemoryPolicy& policy) noexcept
+{
+    int mode;
+    switch (policy.numa) {
+        case MemoryPolicy::Numa::Default:
+            return;
+        case MemoryPolicy::Numa::Interleave:
+            mode = MPOL_INTERLEAVE;
+            break;
+        case MemoryPolicy::Numa::Bind:
+            mode = MPOL_BIND;
+            break;
+        default:
+            REALM_UNREACHABLE();
+    }
+    // The kernel ignores the nodes which are not available to the process
+    unsigned long nodes = policy.numa_nodes != 0 ? (unsigned long)policy.numa_nodes : ~0UL;
+    unsigned long max_node = 8 * sizeof nodes + 1;
+    // A failure leaves the default policy in place
+    static_cast<void>(::syscall(SYS_mbind, addr, size, mode, &nodes, max_node, 0));
+}
+
+#endif
+
+#ifndef _WIN32
+
+void advise(const void* addr, size_t size, int advice) noexcept
+{
+    if (size == 0)
+        return;
+    uintptr_t mask = uintptr_t(page_size() - 1);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(addr) & ~mask;
+    uintptr_t end = (reinterpret_cast<uintptr_t>(addr) + size + mask) & ~mask;
+    static_cast<void>(::madvise(reinterpret_cast<void*>(begin), size_t(end - begin), advice));
+}
+
+#endif
+
+} // anonymous namespace
+
+
+char* realm::util::alloc_pages(size_t size, const MemoryPolicy& policy)
+{
+    static_cast<void>(policy); // Not used on all platforms
+#ifdef _WIN32
+    void* addr = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!addr)
+        throw std::bad_alloc();
+    return static_cast<char*>(addr);
+#else
+    void* addr = MAP_FAILED;
+#if defined(__linux__)
+    if (policy.huge_pages == MemoryPolicy::HugePages::Explicit && size % huge_page_size == 0)
+        addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE | MAP_HUGETLB, -1, 0);
+#endif
+    if (addr == MAP_FAILED) {
+        addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+        if (addr == MAP_FAILED)
+            throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+        if (policy.huge_pages != MemoryPolicy::HugePages::Default)
+            static_cast<void>(::madvise(addr, size, MADV_HUGEPAGE));
+#endif
+    }
+#if defined(__linux__)
+    // Must be applied before the pages are first touched
+    apply_numa_policy(addr, size, policy);
+#endif
+    return static_cast<char*>(addr);
+#endif
+}
+
+
+void realm::util::free_pages(char* addr, size_t size) noexcept
+{
+#ifdef _WIN32
+    static_cast<void>(size);
+    BOOL r = VirtualFree(addr, 0, MEM_RELEASE);
+    REALM_ASSERT_RELEASE(r);
+#else
+    int r = ::munmap(addr, size);
+    REALM_ASSERT_RELEASE(r == 0);
+#endif
+}
+
+
+void realm::util::advise_access(const void* addr, size_t size, AccessPattern pattern) noexcept
+{
+#ifdef _WIN32
+    static_cast<void>(addr);
+    static_cast<void>(size);
+    static_cast<void>(pattern);
+#else
+    int advice = MADV_NORMAL;
+    switch (pattern) {
+        case AccessPattern::Normal:
+            break;
+        case AccessPattern::Sequential:
+            advice = MADV_SEQUENTIAL;
+            break;
+        case AccessPattern::Random:
+            advice = MADV_RANDOM;
+            break;
+    }
+    advise(addr, size, advice);
+#endif
+}
+
+
+void realm::util::prefetch_pages(const void* addr, size_t size) noexcept
+{
+#ifdef _WIN32
+    static_cast<void>(addr);
+    static_cast<void>(size);
+#else
+    advise(addr, size, MADV_WILLNEED);
+#endif
+}
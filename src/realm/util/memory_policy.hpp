@@ -0,0 +1,112 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_UTIL_MEMORY_POLICY_HPP
+#define REALM_UTIL_MEMORY_POLICY_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace realm {
+namespace util {
+
+/// How the memory used for a database is backed by physical pages, and how
+/// the file is read into them. All settings are hints, which are ignored
+/// where the system does not support them, or refuses them. Only Linux
+/// supports the huge page and NUMA settings.
+struct MemoryPolicy {
+    enum class HugePages {
+        /// As decided by the system.
+        Default,
+        /// Slabs use transparent huge pages (`madvise(MADV_HUGEPAGE)`), and
+        /// the read-only mappings of the file are placed such that the page
+        /// cache can use huge pages for them too, on file systems which
+        /// support that.
+        Transparent,
+        /// Slabs are allocated from the huge pages reserved by the
+        /// administrator (`MAP_HUGETLB`), or as for Transparent when there
+        /// are none left. The file is mapped as for Transparent.
+        Explicit
+    };
+
+    enum class Numa {
+        /// Pages are placed on the node of the thread which first touches
+        /// them.
+        Default,
+        /// Pages are spread evenly across the nodes of `numa_nodes`.
+        Interleave,
+        /// Pages are placed on the nodes of `numa_nodes` only.
+        Bind
+    };
+
+    /// How the mappings of the file are expected to be accessed.
+    enum class FileAccess {
+        /// Moderate readahead around each fault.
+        Default,
+        /// Faults read only the page touched. Suits workloads dominated by
+        /// point lookups in files larger than the page cache, where readahead
+        /// mostly evicts useful pages. Scans still prefetch the ranges they
+        /// are about to read.
+        Random
+    };
+
+    HugePages huge_pages = HugePages::Default;
+
+    /// Applies to the slabs only. The pages of the file belong to the page
+    /// cache, which ignores the policy of the mappings of a regular file.
+    Numa numa = Numa::Default;
+
+    /// Bit `i` selects NUMA node `i`. Zero selects all nodes.
+    uint64_t numa_nodes = 0;
+
+    FileAccess file_access = FileAccess::Default;
+
+    bool is_default() const noexcept
+    {
+        return huge_pages == HugePages::Default && numa == Numa::Default && file_access == FileAccess::Default;
+    }
+};
+
+/// The size of the huge pages asked for, as on x86-64 and most ARM64
+/// systems. Slabs allocated with huge pages are multiples of it.
+constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+/// Allocate zero-filled memory directly from the system, and apply the
+/// specified policy to it. The size must be a multiple of page_size(), and
+/// of huge_page_size for MemoryPolicy::HugePages::Explicit to take effect.
+char* alloc_pages(size_t size, const MemoryPolicy&); // Throws
+
+/// Release memory allocated by alloc_pages().
+void free_pages(char* addr, size_t size) noexcept;
+
+enum class AccessPattern { Normal, Sequential, Random };
+
+/// Tell the system how the specified part of a memory mapping of a file will
+/// be accessed, which affects the amount of readahead on page faults. The
+/// range is extended to whole pages. Failures are ignored.
+void advise_access(const void* addr, size_t size, AccessPattern) noexcept;
+
+/// Start reading the pages of the specified part of a memory mapping of a file
+/// into the page cache, without waiting for it. The range is extended to whole
+/// pages. Failures are ignored.
+void prefetch_pages(const void* addr, size_t size) noexcept;
+
+} // namespace util
+} // namespace realm
+
+#endif // REALM_UTIL_MEMORY_POLICY_HPP
@@ -19,10 +19,13 @@
 #include <realm/views.hpp>
 
 #include <realm/column_link.hpp>
+#include <realm/column_string.hpp>
+#include <realm/column_string_enum.hpp>
 #include <realm/exceptions.hpp>
 #include <realm/group.hpp>
 #include <realm/table.hpp>
 #include <realm/table_view.hpp>
+#include <realm/unicode.hpp>
 
 #include <typeinfo>
 
@@ -30,6 +33,63 @@ using namespace realm;
 
 namespace {
 
+// The leading characters of a string, kept inline so that most string
+// comparisons made while sorting are decided without reading the string
+// payload. Only ASCII characters are recorded, since for those the byte
+// position and the character position coincide, and the first differing
+// character decides the order for the built-in string comparison methods.
+struct StringSortPrefix {
+    static constexpr size_t max_size = 7;
+
+    // Each character is stored plus one, and 0 marks the end of the string, so
+    // that a prefix of a string orders before the string itself.
+    unsigned char chars[max_size];
+    // Number of valid entries in `chars`. Characters at or beyond this
+    // position are unknown.
+    unsigned char size;
+
+    explicit StringSortPrefix(StringData str) noexcept
+    {
+        for (size = 0; size < max_size; ++size) {
+            if (size == str.size()) {
+                chars[size++] = 0;
+                return;
+            }
+            unsigned char c = static_cast<unsigned char>(str[size]);
+            if (c >= 0x80)
+                return;
+            chars[size] = c + 1;
+        }
+    }
+
+    // Compare as StringColumn::compare_values() would. Returns false if the
+    // prefixes are not enough to decide.
+    static bool compare(const StringSortPrefix& a, const StringSortPrefix& b, int& result) noexcept
+    {
+        size_t n = std::min(a.size, b.size);
+        for (size_t i = 0; i < n; ++i) {
+            unsigned char c_a = a.chars[i];
+            unsigned char c_b = b.chars[i];
+            if (c_a == c_b) {
+                if (c_a == 0) {
+                    result = 0;
+                    return true;
+                }
+                continue;
+            }
+            if (c_a == 0 || c_b == 0) {
+                result = c_a == 0 ? 1 : -1;
+                return true;
+            }
+            char char_a = char(c_a - 1);
+            char char_b = char(c_b - 1);
+            result = utf8_compare(StringData(&char_a, 1), StringData(&char_b, 1)) ? 1 : -1;
+            return true;
+        }
+        return false;
+    }
+};
+
 } // anonymous namespace
 
 ColumnsDescriptor::ColumnsDescriptor(Table const& table, std::vector<std::vector<size_t>> column_indices)
@@ -124,8 +184,15 @@ private:
         std::vector<size_t> translated_row;
         const ColumnBase* column;
         bool ascending;
+        // For string columns, the value of each row and, if the comparison
+        // method allows it, its prefix, indexed by `index_in_view`
+        std::vector<StringData> strings;
+        std::vector<StringSortPrefix> prefixes;
     };
     std::vector<SortColumn> m_columns;
+
+    void cache_strings(SortColumn&, std::vector<IndexPair> const& rows);
+    static int compare_strings(const SortColumn&, size_t index_in_view_1, size_t index_in_view_2) noexcept;
 };
 
 ColumnsDescriptor::Sorter::Sorter(std::vector<std::vector<const ColumnBase*>> const& columns,
@@ -136,9 +203,10 @@ ColumnsDescriptor::Sorter::Sorter(std::vector<std::vector<const ColumnBase*>> co
 
     m_columns.reserve(columns.size());
     for (size_t i = 0; i < columns.size(); ++i) {
-        m_columns.push_back({{}, {}, columns[i].back(), ascending[i]});
+        m_columns.push_back({{}, {}, columns[i].back(), ascending[i], {}, {}});
         REALM_ASSERT_EX(!columns[i].empty(), i);
         if (columns[i].size() == 1) { // no link chain
+            cache_strings(m_columns.back(), rows);
             continue;
         }
 
@@ -163,9 +231,61 @@ ColumnsDescriptor::Sorter::Sorter(std::vector<std::vector<const ColumnBase*>> co
             }
             translated_rows[index_in_view] = translated_index;
         }
+        cache_strings(m_columns.back(), rows);
+    }
+}
+
+void ColumnsDescriptor::Sorter::cache_strings(SortColumn& col, std::vector<IndexPair> const& rows)
+{
+    if (rows.empty())
+        return;
+    auto string_col = dynamic_cast<const StringColumn*>(col.column);
+    auto enum_col = dynamic_cast<const StringEnumColumn*>(col.column);
+    if (!string_col && !enum_col)
+        return;
+
+    // Reading each value once up front replaces the two B+tree lookups per
+    // comparison otherwise made by compare_values()
+    size_t max_index = std::max_element(rows.begin(), rows.end(), [](auto&& a, auto&& b) {
+                           return a.index_in_view < b.index_in_view;
+                       })->index_in_view;
+    col.strings.resize(max_index + 1);
+    for (auto& row : rows) {
+        size_t index_in_view = row.index_in_view;
+        if (!col.is_null.empty() && col.is_null[index_in_view])
+            continue;
+        size_t row_ndx = col.translated_row.empty() ? row.index_in_column : col.translated_row[index_in_view];
+        col.strings[index_in_view] = string_col ? string_col->get(row_ndx) : enum_col->get(row_ndx);
+    }
+
+    // Prefixes may only decide the order when it is determined by the first
+    // differing character, which is not the case for locale based comparison
+    if (string_compare_method == STRING_COMPARE_CORE || string_compare_method == STRING_COMPARE_CORE_SIMILAR) {
+        col.prefixes.reserve(col.strings.size());
+        for (StringData str : col.strings)
+            col.prefixes.emplace_back(str);
     }
 }
 
+int ColumnsDescriptor::Sorter::compare_strings(const SortColumn& col, size_t index_in_view_1,
+                                               size_t index_in_view_2) noexcept
+{
+    StringData a = col.strings[index_in_view_1];
+    StringData b = col.strings[index_in_view_2];
+
+    if (a.is_null() || b.is_null())
+        return a.is_null() == b.is_null() ? 0 : (a.is_null() ? 1 : -1);
+
+    int result;
+    if (!col.prefixes.empty() &&
+        StringSortPrefix::compare(col.prefixes[index_in_view_1], col.prefixes[index_in_view_2], result))
+        return result;
+
+    if (a == b)
+        return 0;
+    return utf8_compare(a, b) ? 1 : -1;
+}
+
 DescriptorExport ColumnsDescriptor::export_for_handover() const
 {
     std::vector<std::vector<DescriptorLinkPath>> column_indices;
@@ -289,7 +409,12 @@ bool SortDescriptor::Sorter::operator()(IndexPair i, IndexPair j, bool total_ord
             index_j = m_columns[t].translated_row[j.index_in_view];
         }
 
-        if (int c = m_columns[t].column->compare_values(index_i, index_j))
+        int c;
+        if (!m_columns[t].strings.empty())
+            c = compare_strings(m_columns[t], i.index_in_view, j.index_in_view);
+        else
+            c = m_columns[t].column->compare_values(index_i, index_j);
+        if (c)
             return m_columns[t].ascending ? c > 0 : c < 0;
     }
     // make sort stable by using original index as final comparison
@@ -0,0 +1,192 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/zone_map.hpp>
+
+#include <cmath>
+#include <limits>
+
+#include <realm/column.hpp>
+#include <realm/column_timestamp.hpp>
+#include <realm/table.hpp>
+#include <realm/impl/sequential_getter.hpp>
+
+using namespace realm;
+
+namespace {
+
+void summarize_leaf(const ArrayInteger& leaf, LeafSummary<int64_t>& s)
+{
+    s.null_count = 0;
+    leaf.minimum(s.min);
+    leaf.maximum(s.max);
+}
+
+// ArrayIntNull::minimum() and maximum() may return the null marker if the first value is null, so the range is
+// computed here
+void summarize_leaf(const ArrayIntNull& leaf, LeafSummary<int64_t>& s)
+{
+    size_t size = leaf.size();
+    s.null_count = 0;
+    bool first = true;
+    for (size_t i = 0; i < size; ++i) {
+        util::Optional<int64_t> v = leaf.get(i);
+        if (!v) {
+            ++s.null_count;
+            continue;
+        }
+        if (first) {
+            s.min = s.max = *v;
+            first = false;
+        }
+        else {
+            s.min = std::min(s.min, *v);
+            s.max = std::max(s.max, *v);
+        }
+    }
+}
+
+template <class T>
+void summarize_leaf(const BasicArray<T>& leaf, LeafSummary<T>& s)
+{
+    size_t size = leaf.size();
+    s.null_count = 0;
+    bool first = true;
+    bool has_nan = false;
+    for (size_t i = 0; i < size; ++i) {
+        T v = leaf.get(i);
+        if (null::is_null_float(v)) {
+            ++s.null_count;
+            continue;
+        }
+        if (std::isnan(v)) {
+            has_nan = true;
+            continue;
+        }
+        if (first) {
+            s.min = s.max = v;
+            first = false;
+        }
+        else {
+            s.min = std::min(s.min, v);
+            s.max = std::max(s.max, v);
+        }
+    }
+    if (has_nan) {
+        // NaN is unordered, so a leaf containing it can never be ruled out by its range
+        s.min = -std::numeric_limits<T>::infinity();
+        s.max = std::numeric_limits<T>::infinity();
+    }
+}
+
+template <class T, class LeafType, class GetLeaf>
+std::unique_ptr<ZoneMap<T>> build(size_t num_rows, GetLeaf&& get_leaf)
+{
+    std::vector<LeafSummary<T>> leaves;
+    for (size_t begin = 0; begin < num_rows;) {
+        size_t ndx_in_leaf;
+        const LeafType* leaf = get_leaf(begin, ndx_in_leaf);
+        REALM_ASSERT_DEBUG(ndx_in_leaf == 0);
+        LeafSummary<T> s;
+        s.begin = begin;
+        s.end = begin + leaf->size();
+        s.min = s.max = T{};
+        summarize_leaf(*leaf, s);
+        leaves.push_back(s);
+        begin = s.end;
+    }
+    return std::unique_ptr<ZoneMap<T>>(new ZoneMap<T>(std::move(leaves)));
+}
+
+template <class ColType, class T>
+std::unique_ptr<ZoneMap<T>> build_from_column(const ColType& col, size_t num_rows)
+{
+    using LeafType = typename ColType::LeafType;
+    LeafType cache(col.get_alloc());
+    return build<T, LeafType>(num_rows, [&](size_t ndx, size_t& ndx_in_leaf) {
+        const LeafType* leaf = nullptr;
+        typename ColType::LeafInfo info{&leaf, &cache};
+        col.get_leaf(ndx, ndx_in_leaf, info);
+        return leaf;
+    });
+}
+
+// A column that fits in a single leaf gains nothing from a zone map
+bool worth_building(const Table& table)
+{
+    return table.size() > REALM_MAX_BPNODE_SIZE;
+}
+
+} // anonymous namespace
+
+namespace realm {
+
+template <>
+std::unique_ptr<ZoneMap<int64_t>> ZoneMap<int64_t>::create(const Table& table, size_t col_ndx)
+{
+    if (!worth_building(table))
+        return nullptr;
+
+    size_t num_rows = table.size();
+    switch (table.get_real_column_type(col_ndx)) {
+        case col_type_Int:
+        case col_type_Bool:
+        case col_type_OldDateTime:
+            if (table.is_nullable(col_ndx)) {
+                auto& col = static_cast<const IntNullColumn&>(table.get_column_base(col_ndx));
+                return build_from_column<IntNullColumn, int64_t>(col, num_rows);
+            }
+            else {
+                auto& col = static_cast<const IntegerColumn&>(table.get_column_base(col_ndx));
+                return build_from_column<IntegerColumn, int64_t>(col, num_rows);
+            }
+        case col_type_Timestamp: {
+            auto& col = static_cast<const TimestampColumn&>(table.get_column_base(col_ndx));
+            using LeafType = IntNullColumn::LeafType;
+            LeafType cache(col.get_alloc());
+            return build<int64_t, LeafType>(num_rows, [&](size_t ndx, size_t& ndx_in_leaf) {
+                const LeafType* leaf = nullptr;
+                IntNullColumn::LeafInfo info{&leaf, &cache};
+                col.get_seconds_leaf(ndx, ndx_in_leaf, info);
+                return leaf;
+            });
+        }
+        default:
+            return nullptr;
+    }
+}
+
+template <>
+std::unique_ptr<ZoneMap<float>> ZoneMap<float>::create(const Table& table, size_t col_ndx)
+{
+    if (!worth_building(table) || table.get_real_column_type(col_ndx) != col_type_Float)
+        return nullptr;
+    auto& col = static_cast<const FloatColumn&>(table.get_column_base(col_ndx));
+    return build_from_column<FloatColumn, float>(col, table.size());
+}
+
+template <>
+std::unique_ptr<ZoneMap<double>> ZoneMap<double>::create(const Table& table, size_t col_ndx)
+{
+    if (!worth_building(table) || table.get_real_column_type(col_ndx) != col_type_Double)
+        return nullptr;
+    auto& col = static_cast<const DoubleColumn&>(table.get_column_base(col_ndx));
+    return build_from_column<DoubleColumn, double>(col, table.size());
+}
+
+} // namespace realm
@@ -0,0 +1,212 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_ZONE_MAP_HPP
+#define REALM_ZONE_MAP_HPP
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <realm/query_conditions.hpp>
+
+namespace realm {
+
+class Table;
+
+/// Summary of the values stored in one leaf of a B+tree column.
+template <class T>
+struct LeafSummary {
+    size_t begin; // Index of the first row in the leaf
+    size_t end;   // One past the index of the last row in the leaf
+    size_t null_count;
+    // Range of the non-null values. Only meaningful if has_values() is true.
+    T min;
+    T max;
+
+    bool has_values() const noexcept
+    {
+        return null_count < end - begin;
+    }
+};
+
+namespace _impl {
+
+// Whether a non-null value in [min, max] may satisfy `TConditionFunction(value, needle)`. Conditions that are not
+// known here are assumed to always be able to match.
+template <class TConditionFunction>
+struct ZoneMapRange {
+    template <class T>
+    static bool may_match(const T&, const T&, const T&) noexcept
+    {
+        return true;
+    }
+};
+
+template <>
+struct ZoneMapRange<Equal> {
+    template <class T>
+    static bool may_match(const T& min, const T& max, const T& needle) noexcept
+    {
+        return !(needle < min) && !(max < needle);
+    }
+};
+
+template <>
+struct ZoneMapRange<NotEqual> {
+    template <class T>
+    static bool may_match(const T& min, const T& max, const T& needle) noexcept
+    {
+        return !(min == needle && max == needle);
+    }
+};
+
+template <>
+struct ZoneMapRange<Greater> {
+    template <class T>
+    static bool may_match(const T&, const T& max, const T& needle) noexcept
+    {
+        return needle < max;
+    }
+};
+
+template <>
+struct ZoneMapRange<GreaterEqual> {
+    template <class T>
+    static bool may_match(const T&, const T& max, const T& needle) noexcept
+    {
+        return !(max < needle);
+    }
+};
+
+template <>
+struct ZoneMapRange<Less> {
+    template <class T>
+    static bool may_match(const T& min, const T&, const T& needle) noexcept
+    {
+        return min < needle;
+    }
+};
+
+template <>
+struct ZoneMapRange<LessEqual> {
+    template <class T>
+    static bool may_match(const T& min, const T&, const T& needle) noexcept
+    {
+        return !(needle < min);
+    }
+};
+
+} // namespace _impl
+
+class ZoneMapBase {
+public:
+    virtual ~ZoneMapBase() noexcept
+    {
+    }
+};
+
+/// Per-leaf minimum, maximum and null count of a column, which lets scans
+/// skip every leaf whose values cannot satisfy a condition. Zone maps exist
+/// for integer, boolean, float, double and Timestamp columns. For Timestamp
+/// columns only the seconds are summarized, which is enough to rule out a
+/// leaf for every ordering condition.
+///
+/// Zone maps are built on demand by Table::get_zone_map() and live in the
+/// table accessor until the table is modified. Queries only build them ahead
+/// of a scan over every row, such as by Query::find_all() or an aggregate
+/// without a limit, and otherwise use those which already exist.
+template <class T>
+class ZoneMap : public ZoneMapBase {
+public:
+    using Summary = LeafSummary<T>;
+
+    explicit ZoneMap(std::vector<Summary> leaves)
+        : m_leaves(std::move(leaves))
+    {
+    }
+
+    const std::vector<Summary>& leaves() const noexcept
+    {
+        return m_leaves;
+    }
+
+    /// Returns the summary of the leaf containing the specified row, or null
+    /// if the row is out of range.
+    const Summary* find(size_t row_ndx) const noexcept
+    {
+        auto it = std::upper_bound(m_leaves.begin(), m_leaves.end(), row_ndx,
+                                   [](size_t ndx, const Summary& s) { return ndx < s.begin; });
+        if (it == m_leaves.begin())
+            return nullptr;
+        --it;
+        return row_ndx < it->end ? &*it : nullptr;
+    }
+
+    /// Returns false if no row in the summarized leaf can satisfy
+    /// `TConditionFunction()(value, needle, value_is_null, needle_is_null)`.
+    template <class TConditionFunction>
+    static bool may_match(const Summary& s, const T& needle, bool needle_is_null) noexcept
+    {
+        TConditionFunction cond;
+        if (s.null_count != 0 && cond(T{}, needle, true, needle_is_null))
+            return true;
+        if (!s.has_values())
+            return false;
+        if (needle_is_null)
+            return cond(s.min, needle, false, true);
+        return _impl::ZoneMapRange<TConditionFunction>::may_match(s.min, s.max, needle);
+    }
+
+    /// Returns the first row at or after \a start that is not inside a leaf
+    /// which is known not to contain any matches. Returns \a end if there is
+    /// no such row before \a end.
+    template <class TConditionFunction>
+    size_t skip(size_t start, size_t end, const T& needle, bool needle_is_null) const noexcept
+    {
+        const Summary* s = find(start);
+        if (!s)
+            return start;
+        const Summary* last = m_leaves.data() + m_leaves.size();
+        while (s != last && s->begin < end) {
+            if (may_match<TConditionFunction>(*s, needle, needle_is_null))
+                return std::max(start, s->begin);
+            ++s;
+        }
+        return end;
+    }
+
+    /// Build a zone map for the specified column of \a table. Returns null if
+    /// the column type has no zone map support or the column consists of a
+    /// single leaf, in which case there is nothing to skip.
+    static std::unique_ptr<ZoneMap<T>> create(const Table& table, size_t col_ndx);
+
+private:
+    std::vector<Summary> m_leaves;
+};
+
+template <>
+std::unique_ptr<ZoneMap<int64_t>> ZoneMap<int64_t>::create(const Table&, size_t);
+template <>
+std::unique_ptr<ZoneMap<float>> ZoneMap<float>::create(const Table&, size_t);
+template <>
+std::unique_ptr<ZoneMap<double>> ZoneMap<double>::create(const Table&, size_t);
+
+} // namespace realm
+
+#endif // REALM_ZONE_MAP_HPP
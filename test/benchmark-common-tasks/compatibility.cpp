@@ -42,5 +42,21 @@ SharedGroup* create_new_shared_group(std::string path, RealmDurability level, co
     return new SharedGroup(path, false, SharedGroupOptions(durability(level), key));
 }
 
+SharedGroup* create_new_shared_group(std::string path, RealmDurability level, const char* key,
+                                     bool background_file_growth)
+{
+    SharedGroupOptions options(durability(level), key);
+    options.background_file_growth = background_file_growth;
+    return new SharedGroup(path, false, options);
+}
+
+SharedGroup* create_new_shared_group(std::string path, RealmDurability level, const char* key,
+                                     realm::util::MemoryPolicy memory_policy)
+{
+    SharedGroupOptions options(durability(level), key);
+    options.memory_policy = memory_policy;
+    return new SharedGroup(path, false, options);
+}
+
 } // end namespace compatibility
 
@@ -31,6 +31,10 @@ enum class RealmDurability {
 };
 
 realm::SharedGroup* create_new_shared_group(std::string path, RealmDurability level, const char* key);
+realm::SharedGroup* create_new_shared_group(std::string path, RealmDurability level, const char* key,
+                                            bool background_file_growth);
+realm::SharedGroup* create_new_shared_group(std::string path, RealmDurability level, const char* key,
+                                            realm::util::MemoryPolicy memory_policy);
 
 } // end namespace compatibility
 
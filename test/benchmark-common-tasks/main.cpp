@@ -20,6 +20,10 @@
 #include <set>
 #include <sstream>
 
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
 #include <realm.hpp>
 #include <realm/query_expression.hpp> // only needed to compile on v2.6.0
 #include <realm/string_data.hpp>
@@ -634,6 +638,41 @@ struct BenchmarkQueryTimestampEqualNull : BenchmarkWithTimestamps {
     }
 };
 
+struct BenchmarkQueryTimestampCompareColumns : BenchmarkWithTimestamps {
+    size_t other_col_ndx = -1;
+    size_t num_greater = 0;
+    void before_all(SharedGroup& group)
+    {
+        percent_chance_of_null = 0.10f;
+        BenchmarkWithTimestamps::before_all(group);
+        WriteTransaction tr(group);
+        TableRef t = tr.get_table("Timestamps");
+        other_col_ndx = t->add_column(type_Timestamp, "other");
+        Random r;
+        for (size_t i = 0; i < t->size(); ++i) {
+            Timestamp time{r.draw_int<int64_t>(0, 1000000), r.draw_int<int32_t>(0, 1000000)};
+            t->set_timestamp(other_col_ndx, i, time);
+            Timestamp ts = t->get_timestamp(timestamps_col_ndx, i);
+            if (!ts.is_null() && ts > time)
+                ++num_greater;
+        }
+        tr.commit();
+    }
+    const char* name() const
+    {
+        return "QueryTimestampCompareColumns";
+    }
+    void operator()(SharedGroup& group)
+    {
+        ReadTransaction tr(group);
+        TableRef table(const_cast<Table*>(tr.get_table("Timestamps").get()));
+        Query query = table->column<Timestamp>(timestamps_col_ndx) > table->column<Timestamp>(other_col_ndx);
+        TableView results = query.find_all();
+        REALM_ASSERT_EX(results.size() == num_greater, results.size(), num_greater);
+        static_cast<void>(results);
+    }
+};
+
 struct BenchmarkWithIntsTable : Benchmark {
     void before_all(SharedGroup& group)
     {
@@ -703,6 +742,49 @@ struct BenchmarkIntVsDoubleColumns : Benchmark {
     }
 };
 
+struct BenchmarkQueryIntArithmetic : Benchmark {
+    size_t price_col_ndx = -1;
+    size_t qty_col_ndx = -1;
+    size_t num_matches = 0;
+    constexpr static size_t num_rows = BASE_SIZE * 4;
+    void before_all(SharedGroup& group)
+    {
+        WriteTransaction tr(group);
+        TableRef t = tr.add_table("table");
+        price_col_ndx = t->add_column(type_Int, "price");
+        qty_col_ndx = t->add_column(type_Int, "qty");
+        t->add_empty_row(num_rows);
+        Random r;
+        for (size_t i = 0; i < num_rows; ++i) {
+            int64_t price = r.draw_int<int64_t>(0, 100);
+            int64_t qty = r.draw_int<int64_t>(0, 20);
+            t->set_int(price_col_ndx, i, price);
+            t->set_int(qty_col_ndx, i, qty);
+            if (price * qty > 1000)
+                ++num_matches;
+        }
+        tr.commit();
+    }
+    const char* name() const
+    {
+        return "QueryIntArithmetic";
+    }
+    void operator()(SharedGroup& group)
+    {
+        ReadTransaction tr(group);
+        TableRef table(const_cast<Table*>(tr.get_table("table").get()));
+        Query q = table->column<Int>(price_col_ndx) * table->column<Int>(qty_col_ndx) > 1000;
+        REALM_ASSERT_3(q.count(), ==, num_matches);
+    }
+
+    void after_all(SharedGroup& group)
+    {
+        Group& g = group.begin_write();
+        g.remove_table("table");
+        group.commit();
+    }
+};
+
 struct BenchmarkQueryChainedOrInts : BenchmarkWithIntsTable {
     const size_t num_queried_matches = 1000;
     const size_t num_rows = 100000;
@@ -1324,6 +1406,135 @@ struct BenchmarkNonInitatorOpen : Benchmark {
 };
 
 
+// Commits which keep growing the file. The file is grown on the committing
+// thread, or ahead of time on a background thread.
+template <bool background_file_growth>
+struct BenchmarkGrowingCommits : Benchmark {
+    const char* name() const
+    {
+        return background_file_growth ? "GrowingCommitsBackgroundGrowth" : "GrowingCommits";
+    }
+
+    std::unique_ptr<realm::test_util::SharedGroupTestPathGuard> path;
+    std::unique_ptr<SharedGroup> sg;
+
+    void before_all(SharedGroup&)
+    {
+        std::string ident = std::string("BenchmarkCommonTasks_") + name() + "_" + to_ident_cstr(m_durability);
+        path.reset(new realm::test_util::SharedGroupTestPathGuard(ident));
+        sg.reset(create_new_shared_group(*path, m_durability, m_encryption_key, background_file_growth));
+        WriteTransaction tr(*sg);
+        TableRef t = tr.add_table(name());
+        t->add_column(type_String, "s");
+        tr.commit();
+    }
+
+    void after_all(SharedGroup&)
+    {
+        sg.reset();
+        path.reset();
+    }
+
+    void operator()(SharedGroup&)
+    {
+        std::string value(100, 'x');
+        for (size_t i = 0; i < 10; ++i) {
+            WriteTransaction tr(*sg);
+            TableRef t = tr.get_table(name());
+            size_t begin = t->add_empty_row(10000);
+            for (size_t j = 0; j < 10000; ++j)
+                t->set_string(0, begin + j, value);
+            tr.commit();
+        }
+    }
+};
+
+
+// Scans of a large table, with the default memory policy, or with
+// transparent huge pages and NUMA interleaving for the slabs and mappings
+template <bool memory_policy>
+struct BenchmarkLargeScan : Benchmark {
+    const char* name() const
+    {
+        return memory_policy ? "LargeScanHugePagesInterleave" : "LargeScan";
+    }
+
+    std::unique_ptr<realm::test_util::SharedGroupTestPathGuard> path;
+    std::unique_ptr<SharedGroup> sg;
+
+    void before_all(SharedGroup&)
+    {
+        std::string ident = std::string("BenchmarkCommonTasks_") + name() + "_" + to_ident_cstr(m_durability);
+        path.reset(new realm::test_util::SharedGroupTestPathGuard(ident));
+        realm::util::MemoryPolicy policy;
+        if (memory_policy) {
+            policy.huge_pages = realm::util::MemoryPolicy::HugePages::Transparent;
+            policy.numa = realm::util::MemoryPolicy::Numa::Interleave;
+        }
+        sg.reset(create_new_shared_group(*path, m_durability, m_encryption_key, policy));
+        WriteTransaction tr(*sg);
+        TableRef t = tr.add_table(name());
+        t->add_column(type_Int, "i");
+        t->add_column(type_Double, "d");
+        size_t num_rows = 4000000;
+        t->add_empty_row(num_rows);
+        for (size_t i = 0; i < num_rows; ++i) {
+            t->set_int(0, i, int64_t(i % 100000));
+            t->set_double(1, i, double(i));
+        }
+        tr.commit();
+    }
+
+    void after_all(SharedGroup&)
+    {
+        sg.reset();
+        path.reset();
+    }
+
+    void operator()(SharedGroup&)
+    {
+        ReadTransaction tr(*sg);
+        ConstTableRef t = tr.get_table(name());
+        size_t count = t->where().greater(0, 99990).count();
+        double sum = t->sum_double(1);
+        static_cast<void>(count);
+        static_cast<void>(sum);
+    }
+};
+
+
+#ifndef _WIN32
+struct BenchmarkCommitNotification : Benchmark {
+    const char* name() const
+    {
+        return "CommitNotification";
+    }
+
+    int fd = -1;
+
+    void before_all(SharedGroup& group)
+    {
+        fd = group.get_commit_notification_fd();
+    }
+
+    void operator()(SharedGroup& group)
+    {
+        // Each commit is waited for by polling the descriptor, as an event loop would
+        for (size_t i = 0; i < 100; ++i) {
+            {
+                WriteTransaction tr(group);
+                tr.commit();
+            }
+            pollfd pfd = {fd, POLLIN, 0};
+            if (::poll(&pfd, 1, 1000) != 1)
+                throw std::runtime_error("Commit notification missing");
+            group.clear_commit_notifications();
+        }
+    }
+};
+#endif
+
+
 const char* to_lead_cstr(RealmDurability level)
 {
     switch (level) {
@@ -1489,12 +1700,20 @@ int benchmark_common_tasks_main()
     BENCH(BenchmarkQueryInsensitiveString);
     BENCH(BenchmarkQueryInsensitiveStringIndexed);
     BENCH(BenchmarkNonInitatorOpen);
+    BENCH(BenchmarkGrowingCommits<false>);
+    BENCH(BenchmarkGrowingCommits<true>);
+    BENCH(BenchmarkLargeScan<false>);
+    BENCH(BenchmarkLargeScan<true>);
+#ifndef _WIN32
+    BENCH(BenchmarkCommitNotification);
+#endif
     BENCH(BenchmarkQueryChainedOrStrings);
     BENCH(BenchmarkQueryChainedOrInts);
     BENCH(BenchmarkQueryChainedOrIntsIndexed);
     BENCH(BenchmarkQueryIntEquality);
     BENCH(BenchmarkQueryIntEqualityIndexed);
     BENCH(BenchmarkIntVsDoubleColumns);
+    BENCH(BenchmarkQueryIntArithmetic);
     BENCH(BenchmarkQueryStringOverLinks);
     BENCH(BenchmarkQueryTimestampGreaterOverLinks);
     BENCH(BenchmarkQueryTimestampGreater);
@@ -1505,6 +1724,7 @@ int benchmark_common_tasks_main()
     BENCH(BenchmarkQueryTimestampNotEqual);
     BENCH(BenchmarkQueryTimestampNotNull);
     BENCH(BenchmarkQueryTimestampEqualNull);
+    BENCH(BenchmarkQueryTimestampCompareColumns);
 
 #undef BENCH
     return 0;
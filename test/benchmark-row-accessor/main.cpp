@@ -36,7 +36,9 @@ using namespace realm::test_util;
 ///
 /// To measure the performance of the row accessor only, the table tested on is
 /// minimal, one empty row nothing else. Bigger tables might be necessary, but
-/// beware of skewed results.
+/// beware of skewed results. The iteration benchmarks are the exception; they
+/// use a table with a million rows to compare row accessors with untracked row
+/// expressions.
 
 namespace {
 
@@ -130,6 +132,63 @@ void balloon(Timer& timer, BenchmarkResults& results, int balloon_size, DetachOr
     results.submit_single(ident, lead_text, timer);
 }
 
+enum IterationKind { TrackedRows, RowExpressions, ViewRowExpressions, QueryCallback };
+
+/// Benchmark reading a value from every row of a large table, either through
+/// row accessors which register themselves with the table, or through the
+/// untracked row expressions produced by table and table view iterators and
+/// by Query::for_each().
+///
+/// Here it is in pseduocode:
+///
+///     table = add_rows(table(int), num_rows)
+///     time {
+///       repeat 10 times {
+///         for row in rows(table) {
+///           sum += row.get_int(0)
+///         }
+///       }
+///     }
+///
+void iterate(Timer& timer, BenchmarkResults& results, IterationKind kind, const char* ident, const char* lead_text)
+{
+    const size_t num_rows = 1000000;
+    Table table;
+    table.add_column(type_Int, "int");
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i)
+        table.set_int(0, i, int64_t(i % 1000));
+    TableView view = table.where().find_all();
+    Query query = table.where().greater_equal(0, 0);
+
+    int64_t sum = 0;
+    timer.reset();
+    for (int j = 0; j < 10; ++j) {
+        switch (kind) {
+            case TrackedRows:
+                for (size_t i = 0; i < num_rows; ++i) {
+                    ConstRow row = table[i];
+                    sum += row.get_int(0);
+                }
+                break;
+            case RowExpressions:
+                for (auto row : table)
+                    sum += row.get_int(0);
+                break;
+            case ViewRowExpressions:
+                for (auto row : view)
+                    sum += row.get_int(0);
+                break;
+            case QueryCallback:
+                query.for_each([&](Table::ConstRowExpr row) { sum += row.get_int(0); });
+                break;
+        }
+    }
+    results.submit_single(ident, lead_text, timer);
+    if (sum != 10 * int64_t(num_rows / 1000) * 499500)
+        std::cerr << "Unexpected sum" << std::endl;
+}
+
 } // anonymous namepsace
 
 
@@ -158,5 +217,10 @@ int main()
     balloon(timer, results, 1000, RevAttOrder, "balloon_1000_reverse", "Balloon 1000 (reverse)");
     balloon(timer, results, 1000, RandomOrder, "balloon_1000_random", "Balloon 1000 (random)");
 
+    iterate(timer, results, TrackedRows, "iterate_rows", "Iterate Row");
+    iterate(timer, results, RowExpressions, "iterate_row_exprs", "Iterate RowExpr");
+    iterate(timer, results, ViewRowExpressions, "iterate_view_row_exprs", "Iterate view RowExpr");
+    iterate(timer, results, QueryCallback, "iterate_query_for_each", "Iterate for_each");
+
     results.submit_single("total_time", "Total time", timer_total);
 }
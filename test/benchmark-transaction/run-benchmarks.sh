@@ -10,12 +10,15 @@ Nrec=100000 # number of records
 duration=120 # run time in secords
 Nmax=10 # max number of threads
 
+# bench <database> [<extra transact options> <name suffix>]
 function bench {
     db=$1
+    opts=$2
+    name=${db}$3
 
-    out=${db}-tps.dat
+    out=${name}-tps.dat
     rm -f $out
-    echo "# Database: ${db}"  >> $out
+    echo "# Database: ${name}"  >> $out
     echo "# Duration: ${duration}" >> $out
     echo "# Readers Writers TPS(Reader) TPS(Writer) TPS(total)" >> $out
     for i in $(seq 0 $Nmax)
@@ -24,13 +27,14 @@ function bench {
         do
             echo -n "$j $i " >> $out
             rm -f test_${db}*
-            ./transact -w $i -r $j -f test_${db} -d ${db} -s -n $Nrec -t $duration >> $out
+            ./transact -w $i -r $j -f test_${db} -d ${db} -s -n $Nrec -t $duration $opts >> $out
             rm -f test_${db}*
         done
     done
 }
 
 bench "realm"
+bench "realm" "-b pwrite" "-pwrite"
 bench "sqlite"
 bench "mysql"
 bench "sqlite-wal"
@@ -58,6 +58,7 @@ struct thread_info {
 
 
 static bool verbose;
+static SharedGroupOptions::WriteBackend write_backend = SharedGroupOptions::WriteBackend::Mmap;
 
 // Shared variables and mutex to protect them
 static bool runnable = true;
@@ -86,6 +87,7 @@ void usage(const char* msg)
     std::cout << " -n   : number of rows" << std::endl;
     std::cout << " -v   : verbose" << std::endl;
     std::cout << " -s   : single run" << std::endl;
+    std::cout << " -b   : write backend for realm (mmap or pwrite)" << std::endl;
     exit(-1);
 }
 
@@ -401,7 +403,9 @@ static void* realm_writer(void* arg)
     struct timespec ts_1, ts_2;
     struct thread_info* tinfo = (struct thread_info*)arg;
     srandom(tinfo->thread_num);
-    SharedGroup sg(tinfo->datfile);
+    SharedGroupOptions options;
+    options.write_backend = write_backend;
+    SharedGroup sg(tinfo->datfile, false, options);
     while (true) {
         pthread_mutex_lock(&mtx_runnable);
         bool local_runnable = runnable;
@@ -497,7 +501,9 @@ void realm_create(const char* f, long n)
 {
     util::File::try_remove(f);
     util::File::try_remove(std::string(f) + ".lock");
-    SharedGroup sg(f);
+    SharedGroupOptions options;
+    options.write_backend = write_backend;
+    SharedGroup sg(f, false, options);
     {
         WriteTransaction wt(sg);
         BasicTableRef<TestTable> t = wt.get_or_add_table<TestTable>("test");
@@ -630,7 +636,7 @@ int main(int argc, char* argv[])
     char* datfile = NULL;
 
     verbose = false;
-    while ((c = getopt(argc, argv, "hr:w:f:n:t:d:vs")) != EOF) {
+    while ((c = getopt(argc, argv, "hr:w:f:n:t:d:vsb:")) != EOF) {
         switch (c) {
             case 'h':
                 usage("");
@@ -669,6 +675,17 @@ int main(int argc, char* argv[])
             case 's':
                 single = true;
                 break;
+            case 'b':
+                if (strcmp(optarg, "mmap") == 0) {
+                    write_backend = SharedGroupOptions::WriteBackend::Mmap;
+                }
+                else if (strcmp(optarg, "pwrite") == 0) {
+                    write_backend = SharedGroupOptions::WriteBackend::Pwrite;
+                }
+                else {
+                    usage("Unknown write backend");
+                }
+                break;
             default:
                 usage("Wrong option");
         }
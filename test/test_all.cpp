@@ -168,37 +168,6 @@ long get_num_open_files()
 }
 
 
-void fix_async_daemon_path()
-{
-// `setenv()` is POSIX. _WIN32 has `_putenv_s()` instead.
-#ifndef _WIN32
-    const char* async_daemon;
-    // When running the unit-tests in Xcode, it runs them
-    // in its own temporary directory. So we have to make sure we
-    // look for the daemon there
-    const char* xcode_env = getenv("__XCODE_BUILT_PRODUCTS_DIR_PATHS");
-    if (xcode_env) {
-#ifdef REALM_DEBUG
-        async_daemon = "realmd-dbg-noinst";
-#else
-        async_daemon = "realmd-noinst";
-#endif
-    }
-    else {
-#ifdef REALM_COVER
-        async_daemon = "../src/realm/realmd-cov-noinst";
-#else
-#ifdef REALM_DEBUG
-        async_daemon = "../src/realm/realmd-dbg-noinst";
-#else
-        async_daemon = "../src/realm/realmd-noinst";
-#endif
-#endif
-    }
-    setenv("REALM_ASYNC_DAEMON", async_daemon, 0);
-#endif // _WIN32
-}
-
 void set_random_seed()
 {
     // Select random seed for the random generator that some of our unit tests are using
@@ -561,7 +530,6 @@ int test_all(int argc, char* argv[], util::Logger* logger)
     set_always_encrypt();
 
     fix_max_open_files();
-    fix_async_daemon_path();
 
     display_build_config();
 
@@ -0,0 +1,216 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_COLUMN_CHUNK
+
+#include <cstring>
+#include <vector>
+
+#include <realm.hpp>
+#include <realm/column_chunk.hpp>
+
+#include "test.hpp"
+
+using namespace realm;
+using namespace realm::test_util;
+using unit_test::TestContext;
+
+
+// Test independence and thread-safety
+// -----------------------------------
+//
+// All tests must be thread safe and independent of each other. This
+// is required because it allows for both shuffling of the execution
+// order and for parallelized testing.
+//
+// In particular, avoid using std::rand() since it is not guaranteed
+// to be thread safe. Instead use the API offered in
+// `test/util/random.hpp`.
+//
+// All files created in tests must use the TEST_PATH macro (or one of
+// its friends) to obtain a suitable file system path. See
+// `test/util/test_path.hpp`.
+//
+//
+// Debugging and the ONLY() macro
+// ------------------------------
+//
+// A simple way of disabling all tests except one called `Foo`, is to
+// replace TEST(Foo) with ONLY(Foo) and then recompile and rerun the
+// test suite. Note that you can also use filtering by setting the
+// environment varible `UNITTEST_FILTER`. See `README.md` for more on
+// this.
+//
+// Another way to debug a particular test, is to copy that test into
+// `experiments/testcase.cpp` and then run `sh build.sh
+// check-testcase` (or one of its friends) from the command line.
+
+
+namespace {
+
+template <class T>
+T chunk_value(const ColumnChunk& chunk, size_t ndx)
+{
+    T value;
+    std::memcpy(&value, chunk.values + ndx * sizeof value, sizeof value);
+    return value;
+}
+
+// Check that the chunks cover all rows of the column and hold its values
+void check_chunks(TestContext& test_context, const Table& table, size_t col_ndx,
+                  const std::vector<ColumnChunk>& chunks)
+{
+    size_t row_ndx = 0;
+    for (const ColumnChunk& chunk : chunks) {
+        CHECK_EQUAL(chunk.type, table.get_column_type(col_ndx));
+        CHECK_EQUAL(chunk.offset, row_ndx);
+        size_t null_count = 0;
+        for (size_t i = 0; i < chunk.length; ++i, ++row_ndx) {
+            CHECK_EQUAL(chunk.is_null(i), table.is_null(col_ndx, row_ndx));
+            if (chunk.is_null(i)) {
+                ++null_count;
+                continue;
+            }
+            switch (chunk.type) {
+                case type_Int:
+                    CHECK_EQUAL(chunk_value<int64_t>(chunk, i), table.get_int(col_ndx, row_ndx));
+                    break;
+                case type_Bool:
+                    CHECK_EQUAL(((chunk.values[i >> 3] >> (i & 7)) & 1) != 0, table.get_bool(col_ndx, row_ndx));
+                    break;
+                case type_Float:
+                    CHECK_EQUAL(chunk_value<float>(chunk, i), table.get_float(col_ndx, row_ndx));
+                    break;
+                case type_Double:
+                    CHECK_EQUAL(chunk_value<double>(chunk, i), table.get_double(col_ndx, row_ndx));
+                    break;
+                case type_String: {
+                    StringData str(chunk.values + chunk.offsets[i], size_t(chunk.offsets[i + 1] - chunk.offsets[i]));
+                    CHECK_EQUAL(str, table.get_string(col_ndx, row_ndx));
+                    break;
+                }
+                default:
+                    CHECK(false);
+            }
+        }
+        CHECK_EQUAL(chunk.null_count, null_count);
+        CHECK_EQUAL(chunk.validity.empty(), null_count == 0);
+    }
+    CHECK_EQUAL(row_ndx, table.size());
+}
+
+} // unnamed namespace
+
+
+TEST(ColumnChunk_RoundTrip)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const char* strings[] = {"", "short", "a somewhat longer string which is not stored inline"};
+
+    for (bool enumerate : {false, true}) {
+        Table table;
+        table.add_column(type_Int, "small");
+        table.add_column(type_Int, "large", true);
+        table.add_column(type_Bool, "bool", true);
+        table.add_column(type_Float, "float", true);
+        table.add_column(type_Double, "double");
+        table.add_column(type_String, "string", true);
+        size_t num_cols = table.get_column_count();
+
+        const size_t num_rows = REALM_MAX_BPNODE_SIZE * 2 + 11;
+        table.add_empty_row(num_rows);
+        for (size_t i = 0; i < num_rows; ++i) {
+            table.set_int(0, i, random.draw_int<int64_t>(-5, 100));
+            if (!random.chance(1, 7))
+                table.set_int(1, i, random.draw_int<int64_t>(-1000, 1000) << 40);
+            if (!random.chance(1, 7))
+                table.set_bool(2, i, random.chance(1, 2));
+            if (!random.chance(1, 7))
+                table.set_float(3, i, random.draw_int<int>(-1000, 1000) / 4.0f);
+            table.set_double(4, i, random.draw_int<int>(-1000, 1000) / 8.0);
+            if (!random.chance(1, 7))
+                table.set_string(5, i, strings[random.draw_int<size_t>(0, 2)]);
+        }
+        if (enumerate)
+            table.optimize(true);
+
+        Table copy;
+        for (size_t col = 0; col < num_cols; ++col)
+            copy.add_column(table.get_column_type(col), table.get_column_name(col), table.is_nullable(col));
+        copy.add_empty_row(num_rows);
+        for (size_t col = 0; col < num_cols; ++col) {
+            std::vector<ColumnChunk> chunks = table.export_column(col);
+            check_chunks(test_context, table, col, chunks);
+            for (const ColumnChunk& chunk : chunks)
+                copy.import_column(col, chunk.offset, chunk);
+            check_chunks(test_context, copy, col, chunks);
+        }
+    }
+}
+
+TEST(ColumnChunk_ZeroCopy)
+{
+    Table table;
+    table.add_column(type_Int, "small");
+    table.add_column(type_Int, "large");
+    table.add_column(type_Double, "double", true);
+    table.add_empty_row(REALM_MAX_BPNODE_SIZE + 1);
+    for (size_t i = 0; i < table.size(); ++i) {
+        table.set_int(0, i, int64_t(i % 3));
+        table.set_int(1, i, int64_t(i) << 40);
+        if (i % 5 != 0)
+            table.set_double(2, i, double(i));
+    }
+
+    // Values are only copied when the leaves store them in fewer bits
+    for (const ColumnChunk& chunk : table.export_column(0))
+        CHECK(!chunk.is_zero_copy());
+    for (const ColumnChunk& chunk : table.export_column(1))
+        CHECK(chunk.is_zero_copy());
+    for (const ColumnChunk& chunk : table.export_column(2))
+        CHECK(chunk.is_zero_copy());
+    CHECK_NOT_EQUAL(table.export_column(2)[0].null_count, 0);
+    check_chunks(test_context, table, 1, table.export_column(1));
+    check_chunks(test_context, table, 2, table.export_column(2));
+}
+
+TEST(ColumnChunk_Errors)
+{
+    Table table;
+    size_t col_int = table.add_column(type_Int, "int");
+    size_t col_null = table.add_column(type_Int, "null", true);
+    size_t col_ts = table.add_column(type_Timestamp, "ts");
+    table.add_empty_row(3);
+    table.set_int(col_null, 0, 1);
+    table.set_int(col_null, 2, 3);
+
+    CHECK(table.export_column(col_int).size() == 1);
+    CHECK_LOGIC_ERROR(table.export_column(col_ts), LogicError::illegal_type);
+    CHECK_LOGIC_ERROR(table.export_column(3), LogicError::column_index_out_of_range);
+
+    std::vector<ColumnChunk> chunks = table.export_column(col_null);
+    CHECK_EQUAL(chunks[0].null_count, 1);
+    CHECK_LOGIC_ERROR(table.import_column(col_int, 0, chunks[0]), LogicError::column_not_nullable);
+    CHECK_LOGIC_ERROR(table.import_column(col_null, 1, chunks[0]), LogicError::row_index_out_of_range);
+    CHECK_LOGIC_ERROR(table.import_column(col_ts, 0, chunks[0]), LogicError::type_mismatch);
+    table.import_column(col_null, 0, chunks[0]);
+    CHECK(table.is_null(col_null, 1));
+}
+
+#endif // TEST_COLUMN_CHUNK
@@ -0,0 +1,221 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_COLUMN_STATISTICS
+
+#include <realm.hpp>
+#include <realm/column_statistics.hpp>
+
+#include "test.hpp"
+
+using namespace realm;
+
+
+// Test independence and thread-safety
+// -----------------------------------
+//
+// All tests must be thread safe and independent of each other. This
+// is required because it allows for both shuffling of the execution
+// order and for parallelized testing.
+//
+// In particular, avoid using std::rand() since it is not guaranteed
+// to be thread safe. Instead use the API offered in
+// `test/util/random.hpp`.
+//
+// All files created in tests must use the TEST_PATH macro (or one of
+// its friends) to obtain a suitable file system path. See
+// `test/util/test_path.hpp`.
+//
+//
+// Debugging and the ONLY() macro
+// ------------------------------
+//
+// A simple way of disabling all tests except one called `Foo`, is to
+// replace TEST(Foo) with ONLY(Foo) and then recompile and rerun the
+// test suite. Note that you can also use filtering by setting the
+// environment varible `UNITTEST_FILTER`. See `README.md` for more on
+// this.
+//
+// Another way to debug a particular test, is to copy that test into
+// `experiments/testcase.cpp` and then run `sh build.sh
+// check-testcase` (or one of its friends) from the command line.
+
+
+TEST(ColumnStatistics_HyperLogLog)
+{
+    HyperLogLog empty;
+    CHECK_EQUAL(empty.estimate(), 0);
+
+    HyperLogLog small;
+    for (int i = 0; i < 3; ++i) {
+        for (uint_least64_t v = 0; v < 100; ++v)
+            small.add_hash(HyperLogLog::hash_int(v));
+    }
+    CHECK_APPROXIMATELY_EQUAL(double(small.estimate()), 100.0, 0.05);
+
+    HyperLogLog a, b;
+    for (uint_least64_t v = 0; v < 50000; ++v)
+        a.add_hash(HyperLogLog::hash_int(v));
+    for (uint_least64_t v = 25000; v < 100000; ++v)
+        b.add_hash(HyperLogLog::hash_int(v));
+    CHECK_APPROXIMATELY_EQUAL(double(a.estimate()), 50000.0, 0.05);
+    a.merge(b);
+    CHECK_APPROXIMATELY_EQUAL(double(a.estimate()), 100000.0, 0.05);
+}
+
+
+TEST(ColumnStatistics_Int)
+{
+    Table table;
+    table.add_column(type_Int, "int", true);
+    table.add_empty_row(1000);
+    for (size_t i = 0; i < 1000; ++i) {
+        if (i % 10 == 0)
+            table.set_null(0, i);
+        else
+            table.set_int(0, i, int64_t(i % 100));
+    }
+
+    CHECK_NOT(table.get_column_statistics(0));
+    table.analyze();
+    const ColumnStatistics* stats = table.get_column_statistics(0);
+    CHECK_OR_RETURN(stats);
+
+    CHECK_EQUAL(stats->row_count, 1000);
+    CHECK_EQUAL(stats->null_count, 100);
+    CHECK_APPROXIMATELY_EQUAL(double(stats->distinct_count), 90.0, 0.05);
+    CHECK(stats->has_range);
+    CHECK_EQUAL(stats->min, 1);
+    CHECK_EQUAL(stats->max, 99);
+    CHECK(std::is_sorted(stats->histogram.begin(), stats->histogram.end()));
+    CHECK_EQUAL(stats->histogram.front(), 1);
+    CHECK_EQUAL(stats->histogram.back(), 99);
+
+    CHECK_APPROXIMATELY_EQUAL(stats->non_null_fraction(), 0.9, 0.001);
+    CHECK_EQUAL(stats->selectivity_equal(1000), 0);
+    CHECK_APPROXIMATELY_EQUAL(stats->selectivity_equal(50), 0.01, 0.05);
+    CHECK_EQUAL(stats->selectivity_less(1, false), 0);
+    CHECK_APPROXIMATELY_EQUAL(stats->selectivity_less(99, true), 0.9, 0.001);
+    CHECK_APPROXIMATELY_EQUAL(stats->selectivity_less(50, false), 0.45, 0.1);
+    CHECK_APPROXIMATELY_EQUAL(stats->selectivity_greater(50, false), 0.45, 0.1);
+    CHECK_EQUAL(stats->selectivity_greater(99, false), 0);
+}
+
+
+TEST(ColumnStatistics_OtherTypes)
+{
+    Table table;
+    table.add_column(type_Double, "double", true);
+    table.add_column(type_String, "string", true);
+    table.add_column(type_Timestamp, "timestamp", true);
+    table.add_column(type_Bool, "bool");
+    table.add_empty_row(100);
+    for (size_t i = 0; i < 100; ++i) {
+        if (i < 20) {
+            table.set_null(0, i);
+            table.set_null(1, i);
+            table.set_null(2, i);
+        }
+        else {
+            table.set_double(0, i, double(i) / 2);
+            table.set_string(1, i, i % 2 ? "odd" : "even");
+            table.set_timestamp(2, i, Timestamp(int64_t(i), 0));
+        }
+        table.set_bool(3, i, i % 4 == 0);
+    }
+
+    table.analyze();
+
+    const ColumnStatistics* stats = table.get_column_statistics(0);
+    CHECK_OR_RETURN(stats);
+    CHECK_EQUAL(stats->null_count, 20);
+    CHECK_APPROXIMATELY_EQUAL(double(stats->distinct_count), 80.0, 0.05);
+    CHECK_EQUAL(stats->min, 10.0);
+    CHECK_EQUAL(stats->max, 49.5);
+
+    stats = table.get_column_statistics(1);
+    CHECK_OR_RETURN(stats);
+    CHECK_EQUAL(stats->null_count, 20);
+    CHECK_EQUAL(stats->distinct_count, 2);
+    CHECK_NOT(stats->has_range);
+
+    stats = table.get_column_statistics(2);
+    CHECK_OR_RETURN(stats);
+    CHECK_EQUAL(stats->null_count, 20);
+    CHECK_APPROXIMATELY_EQUAL(double(stats->distinct_count), 80.0, 0.05);
+
+    stats = table.get_column_statistics(3);
+    CHECK_OR_RETURN(stats);
+    CHECK_EQUAL(stats->null_count, 0);
+    CHECK_EQUAL(stats->distinct_count, 2);
+    CHECK_APPROXIMATELY_EQUAL(stats->selectivity_equal(1), 0.5, 0.001);
+}
+
+
+TEST(ColumnStatistics_InvalidatedByChange)
+{
+    Group group;
+    TableRef table = group.add_table("table");
+    table->add_column(type_Int, "int");
+    table->add_empty_row(10);
+
+    table->analyze();
+    CHECK(table->get_column_statistics(0));
+    CHECK_NOT(table->get_column_statistics(1));
+
+    table->set_int(0, 5, 10);
+    CHECK_NOT(table->get_column_statistics(0));
+
+    table->analyze();
+    CHECK(table->get_column_statistics(0));
+    table->add_column(type_Int, "other");
+    CHECK_NOT(table->get_column_statistics(0));
+}
+
+
+TEST(ColumnStatistics_QueryResultsUnaffected)
+{
+    // Skewed data: column 0 is almost always 1, column 1 is rarely 7
+    Table table;
+    table.add_column(type_Int, "skewed");
+    table.add_column(type_Int, "rare");
+    table.add_column(type_Double, "double");
+    const size_t num_rows = 5000;
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        table.set_int(0, i, i % 500 == 0 ? 0 : 1);
+        table.set_int(1, i, i % 97 == 0 ? 7 : int64_t(i % 13));
+        table.set_double(2, i, double(i));
+    }
+
+    auto run = [&] {
+        Query q = table.where().equal(0, 1).equal(1, 7).greater(2, 100.0);
+        return std::make_pair(q.count(), q.find());
+    };
+
+    auto without_statistics = run();
+    table.analyze();
+    auto with_statistics = run();
+
+    CHECK_EQUAL(without_statistics.first, with_statistics.first);
+    CHECK_EQUAL(without_statistics.second, with_statistics.second);
+    CHECK_EQUAL(with_statistics.second, 111);
+}
+
+#endif // TEST_COLUMN_STATISTICS
@@ -25,6 +25,8 @@
 #include "test.hpp"
 
 using namespace realm;
+using namespace realm::test_util;
+using unit_test::TestContext;
 
 
 // Test independence and thread-safety
@@ -737,4 +739,150 @@ TEST(Timestamp_ChronoConvertions)
     CHECK_EQUAL(tp, now);
 }
 
+namespace {
+
+template <class Condition>
+size_t find_timestamp_naive(const TimestampColumn& c, Timestamp value, size_t begin, size_t end)
+{
+    Condition cond;
+    for (size_t i = begin; i < end; ++i) {
+        Timestamp ts = c.get(i);
+        if (cond(ts, value, ts.is_null(), value.is_null()))
+            return i;
+    }
+    return npos;
+}
+
+template <class Condition>
+void check_timestamp_find(TestContext& test_context, const TimestampColumn& c, Timestamp value)
+{
+    size_t size = c.size();
+    for (size_t begin : {size_t(0), size_t(1), size_t(REALM_MAX_BPNODE_SIZE - 1), size_t(REALM_MAX_BPNODE_SIZE + 3)}) {
+        for (size_t end : {size, size - 7, size_t(REALM_MAX_BPNODE_SIZE + 5)}) {
+            if (begin > end)
+                continue;
+            CHECK_EQUAL(find_timestamp_naive<Condition>(c, value, begin, end),
+                        c.find<Condition>(value, begin, end));
+        }
+    }
+}
+
+} // anonymous namespace
+
+// TimestampColumn::find() searches the seconds first and only looks at the nanoseconds when they are equal, so the
+// values are drawn from a small range to get many rows which only differ in their nanoseconds
+TEST(TimestampColumn_FindBySeconds)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    ref_type ref = TimestampColumn::create(Allocator::get_default(), 0, true);
+    TimestampColumn c(true, Allocator::get_default(), ref);
+
+    // The second leaf holds no nulls, so that every condition is searched with the vectorized search there
+    const size_t num_rows = REALM_MAX_BPNODE_SIZE * 3 + 11;
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (i / REALM_MAX_BPNODE_SIZE != 1 && random.chance(1, 10))
+            c.add(Timestamp{});
+        else
+            c.add(Timestamp(random.draw_int<int64_t>(0, 40), random.draw_int<int32_t>(0, 3)));
+    }
+
+    for (int i = 0; i < 10; ++i) {
+        Timestamp value(random.draw_int<int64_t>(0, 42), random.draw_int<int32_t>(0, 3));
+        check_timestamp_find<Equal>(test_context, c, value);
+        check_timestamp_find<Greater>(test_context, c, value);
+        check_timestamp_find<GreaterEqual>(test_context, c, value);
+        check_timestamp_find<Less>(test_context, c, value);
+        check_timestamp_find<LessEqual>(test_context, c, value);
+        check_timestamp_find<NotEqual>(test_context, c, value);
+    }
+    check_timestamp_find<Equal>(test_context, c, Timestamp{});
+    check_timestamp_find<NotEqual>(test_context, c, Timestamp{});
+    check_timestamp_find<Greater>(test_context, c, Timestamp{});
+
+    c.destroy();
+}
+
+// The seconds searched for by >= and <= are offset by one, which must not overflow
+TEST(TimestampColumn_FindBySecondsLimits)
+{
+    const int64_t min = std::numeric_limits<int64_t>::min();
+    const int64_t max = std::numeric_limits<int64_t>::max();
+    ref_type ref = TimestampColumn::create(Allocator::get_default(), 0, true);
+    TimestampColumn c(true, Allocator::get_default(), ref);
+
+    const size_t num_rows = REALM_MAX_BPNODE_SIZE * 2 + 11;
+    for (size_t i = 0; i < num_rows; ++i) {
+        switch (i % 4) {
+            case 0:
+                c.add(Timestamp{});
+                break;
+            case 1:
+                c.add(Timestamp(min, 0));
+                break;
+            case 2:
+                c.add(Timestamp(max, 0));
+                break;
+            default:
+                c.add(Timestamp(0, int32_t(i % 3)));
+                break;
+        }
+    }
+
+    for (Timestamp value : {Timestamp(min, 0), Timestamp(max, 0), Timestamp(0, 1)}) {
+        check_timestamp_find<Equal>(test_context, c, value);
+        check_timestamp_find<Greater>(test_context, c, value);
+        check_timestamp_find<GreaterEqual>(test_context, c, value);
+        check_timestamp_find<Less>(test_context, c, value);
+        check_timestamp_find<LessEqual>(test_context, c, value);
+    }
+
+    c.destroy();
+}
+
+TEST(TimestampColumn_CompareColumns)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    Table t;
+    t.add_column(type_Timestamp, "a", true);
+    t.add_column(type_Timestamp, "b", false);
+
+    const size_t num_rows = REALM_MAX_BPNODE_SIZE * 2 + 300;
+    t.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (!random.chance(1, 10))
+            t.set_timestamp(0, i, Timestamp(random.draw_int<int64_t>(0, 5), random.draw_int<int32_t>(0, 2)));
+        t.set_timestamp(1, i, Timestamp(random.draw_int<int64_t>(0, 5), random.draw_int<int32_t>(0, 2)));
+    }
+
+    auto count = [&](auto cond) {
+        size_t n = 0;
+        for (size_t i = 0; i < num_rows; ++i) {
+            Timestamp a = t.get_timestamp(0, i);
+            Timestamp b = t.get_timestamp(1, i);
+            if (cond(a, b, a.is_null(), b.is_null()))
+                ++n;
+        }
+        return n;
+    };
+
+    Columns<Timestamp> a = t.column<Timestamp>(0);
+    Columns<Timestamp> b = t.column<Timestamp>(1);
+    CHECK_EQUAL(count(Equal()), (a == b).count());
+    CHECK_EQUAL(count(NotEqual()), (a != b).count());
+    CHECK_EQUAL(count(Greater()), (a > b).count());
+    CHECK_EQUAL(count(GreaterEqual()), (a >= b).count());
+    CHECK_EQUAL(count(Less()), (a < b).count());
+    CHECK_EQUAL(count(LessEqual()), (a <= b).count());
+
+    Timestamp needle(2, 1);
+    size_t expected = 0;
+    for (size_t i = 0; i < num_rows; ++i) {
+        Timestamp ts = t.get_timestamp(0, i);
+        if (!ts.is_null() && ts > needle)
+            ++expected;
+    }
+    CHECK_EQUAL(expected, (a > needle).count());
+    CHECK_EQUAL(expected, t.where().greater(0, needle).count());
+}
+
 #endif // TEST_COLUMN_TIMESTAMP
@@ -24,6 +24,7 @@
 
 #include <realm/util/file.hpp>
 #include <realm/util/file_mapper.hpp>
+#include <realm/util/memory_policy.hpp>
 
 #include "test.hpp"
 
@@ -174,6 +175,71 @@ TEST(File_MapMultiplePages)
     }
 }
 
+TEST(File_MapSyncRange)
+{
+    const size_t count = 4096 / sizeof(size_t) * 4;
+
+    TEST_PATH(path);
+    {
+        File f(path, File::mode_Write);
+        f.set_encryption_key(crypt_key());
+        f.resize(count * sizeof(size_t));
+
+        File::Map<size_t> map(f, File::access_ReadWrite, count * sizeof(size_t));
+        realm::util::encryption_read_barrier(map, 0, count);
+        for (size_t i = 0; i < count; ++i)
+            map.get_addr()[i] = i;
+        realm::util::encryption_write_barrier(map, 0, count);
+
+        // Ranges which do not start at a page boundary, and the whole mapping
+        map.sync(sizeof(size_t) * 3, sizeof(size_t) * 1000);
+        map.sync(0, count * sizeof(size_t));
+        map.sync(count * sizeof(size_t) - 1, 1);
+        f.start_writeback(0, count * sizeof(size_t));
+        f.sync();
+    }
+    {
+        File f(path, File::mode_Read);
+        f.set_encryption_key(crypt_key());
+        File::Map<size_t> map(f, File::access_ReadOnly, count * sizeof(size_t));
+        realm::util::encryption_read_barrier(map, 0, count);
+        for (size_t i = 0; i < count; ++i) {
+            CHECK_EQUAL(map.get_addr()[i], i);
+            if (map.get_addr()[i] != i)
+                return;
+        }
+    }
+}
+
+TEST(File_MapHugePages)
+{
+    const size_t size = 2 * huge_page_size;
+    const size_t offset = 3 * 4096;
+
+    TEST_PATH(path);
+    File f(path, File::mode_Write);
+    std::unique_ptr<char[]> data(new char[offset + size]);
+    for (size_t i = 0; i < offset + size; ++i)
+        data[i] = char(i % 251);
+    f.write(data.get(), offset + size);
+
+    File::Map<char> map(f, offset, File::access_ReadOnly, size, File::map_HugePages);
+#if defined(__linux__)
+    CHECK_EQUAL(0, (reinterpret_cast<uintptr_t>(map.get_addr()) - offset) % huge_page_size);
+#endif
+    CHECK_EQUAL(0, memcmp(map.get_addr(), data.get() + offset, size));
+
+    // Slabs which ask for huge pages and NUMA placement are zero-filled
+    MemoryPolicy policy;
+    policy.huge_pages = MemoryPolicy::HugePages::Explicit;
+    policy.numa = MemoryPolicy::Numa::Interleave;
+    char* pages = alloc_pages(huge_page_size, policy);
+    CHECK_EQUAL(0, pages[0]);
+    CHECK_EQUAL(0, pages[huge_page_size - 1]);
+    pages[huge_page_size - 1] = 1;
+    free_pages(pages, huge_page_size);
+}
+
 TEST(File_ReaderAndWriter)
 {
     const size_t count = 4096 / sizeof(size_t) * 256 * 2;
@@ -318,6 +384,35 @@ TEST(File_ReadWrite)
 }
 
 
+TEST(File_CopyRangeTo)
+{
+    TEST_PATH(path_1);
+    TEST_PATH(path_2);
+    const size_t size = 3 * 1024 * 1024 + 17;
+    std::unique_ptr<char[]> data(new char[size]);
+    for (size_t i = 0; i < size; ++i)
+        data[i] = char(i % 251);
+    File f_1(path_1, File::mode_Write);
+    f_1.write_at(0, data.get(), size);
+    File f_2(path_2, File::mode_Write);
+    f_2.resize(size);
+
+    // Larger than the buffer of the fallback, and not aligned
+    const size_t begin = 4093, end = size - 5;
+    f_1.copy_range_to(f_2, begin, end - begin);
+
+    std::unique_ptr<char[]> copy(new char[size]);
+    CHECK_EQUAL(size, f_2.read_at(0, copy.get(), size));
+    bool equal = true;
+    for (size_t i = 0; i < size; ++i) {
+        char expected = (i >= begin && i < end ? data[i] : 0);
+        if (copy[i] != expected)
+            equal = false;
+    }
+    CHECK(equal);
+}
+
+
 TEST(File_Resize)
 {
     TEST_PATH(path);
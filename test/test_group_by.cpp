@@ -0,0 +1,314 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_GROUP_BY
+
+#include <map>
+#include <string>
+#include <tuple>
+
+#include <realm.hpp>
+#include <realm/group_by.hpp>
+
+#include "test.hpp"
+
+using namespace realm;
+using namespace realm::test_util;
+using unit_test::TestContext;
+
+
+// Test independence and thread-safety
+// -----------------------------------
+//
+// All tests must be thread safe and independent of each other. This
+// is required because it allows for both shuffling of the execution
+// order and for parallelized testing.
+//
+// In particular, avoid using std::rand() since it is not guaranteed
+// to be thread safe. Instead use the API offered in
+// `test/util/random.hpp`.
+//
+// All files created in tests must use the TEST_PATH macro (or one of
+// its friends) to obtain a suitable file system path. See
+// `test/util/test_path.hpp`.
+//
+//
+// Debugging and the ONLY() macro
+// ------------------------------
+//
+// A simple way of disabling all tests except one called `Foo`, is to
+// replace TEST(Foo) with ONLY(Foo) and then recompile and rerun the
+// test suite. Note that you can also use filtering by setting the
+// environment varible `UNITTEST_FILTER`. See `README.md` for more on
+// this.
+//
+// Another way to debug a particular test, is to copy that test into
+// `experiments/testcase.cpp` and then run `sh build.sh
+// check-testcase` (or one of its friends) from the command line.
+
+
+namespace {
+
+struct ExpectedGroup {
+    size_t rows = 0;
+    size_t non_null = 0;
+    int64_t sum = 0;
+    int64_t min = 0;
+    int64_t max = 0;
+    double double_sum = 0;
+};
+
+void add_value(ExpectedGroup& g, util::Optional<int64_t> value, double d)
+{
+    ++g.rows;
+    g.double_sum += d;
+    if (!value)
+        return;
+    if (g.non_null == 0 || *value < g.min)
+        g.min = *value;
+    if (g.non_null == 0 || *value > g.max)
+        g.max = *value;
+    g.sum += *value;
+    ++g.non_null;
+}
+
+const std::vector<GroupAggregate> all_aggregates(size_t int_col, size_t double_col)
+{
+    return {{GroupAggregate::count, npos},           {GroupAggregate::count, int_col},
+            {GroupAggregate::sum, int_col},          {GroupAggregate::minimum, int_col},
+            {GroupAggregate::maximum, int_col},      {GroupAggregate::average, int_col},
+            {GroupAggregate::sum, double_col}};
+}
+
+// Check that group `i` of `result` matches `g`, for the aggregates of all_aggregates()
+void check_group(TestContext& test_context, const GroupByResult& result, size_t i, const ExpectedGroup& g)
+{
+    CHECK_EQUAL(result.aggregate(0).ints[i], int64_t(g.rows));
+    CHECK_EQUAL(result.aggregate(1).ints[i], int64_t(g.non_null));
+    CHECK_EQUAL(result.aggregate(2).ints[i], g.sum);
+    CHECK(!result.aggregate(2).nulls[i]);
+    CHECK_EQUAL(result.aggregate(3).nulls[i], g.non_null == 0);
+    CHECK_EQUAL(result.aggregate(4).nulls[i], g.non_null == 0);
+    CHECK_EQUAL(result.aggregate(5).nulls[i], g.non_null == 0);
+    if (g.non_null != 0) {
+        CHECK_EQUAL(result.aggregate(3).ints[i], g.min);
+        CHECK_EQUAL(result.aggregate(4).ints[i], g.max);
+        CHECK_APPROXIMATELY_EQUAL(result.aggregate(5).doubles[i], double(g.sum) / g.non_null, 1e-9);
+    }
+    CHECK_APPROXIMATELY_EQUAL(result.aggregate(6).doubles[i], g.double_sum, 1e-9);
+}
+
+} // anonymous namespace
+
+
+TEST(GroupBy_IntKey)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    Table table;
+    size_t col_key = table.add_column(type_Int, "key", true);
+    size_t col_int = table.add_column(type_Int, "int", true);
+    size_t col_double = table.add_column(type_Double, "double");
+
+    const size_t num_rows = REALM_MAX_BPNODE_SIZE * 3 + 17;
+    table.add_empty_row(num_rows);
+    std::map<util::Optional<int64_t>, ExpectedGroup> expected;
+    std::vector<util::Optional<int64_t>> order;
+    for (size_t i = 0; i < num_rows; ++i) {
+        util::Optional<int64_t> key;
+        if (!random.chance(1, 20))
+            key = random.draw_int<int64_t>(-10, 10);
+        util::Optional<int64_t> value;
+        if (!random.chance(1, 5))
+            value = random.draw_int<int64_t>(-1000, 1000);
+        double d = random.draw_int<int>(0, 100) / 4.0;
+
+        if (key)
+            table.set_int(col_key, i, *key);
+        if (value)
+            table.set_int(col_int, i, *value);
+        table.set_double(col_double, i, d);
+
+        if (expected.find(key) == expected.end())
+            order.push_back(key);
+        add_value(expected[key], value, d);
+    }
+
+    GroupByResult result = table.group_by({{col_key}}, all_aggregates(col_int, col_double));
+    CHECK_EQUAL(result.size(), expected.size());
+    CHECK_EQUAL(result.key(0).type, type_Int);
+    CHECK_EQUAL(result.aggregate(0).type, type_Int);
+    CHECK_EQUAL(result.aggregate(5).type, type_Double);
+    CHECK_EQUAL(result.aggregate(6).type, type_Double);
+    for (size_t i = 0; i < result.size() && i < order.size(); ++i) {
+        // Groups are reported in the order in which they were first seen
+        util::Optional<int64_t> key = order[i];
+        CHECK_EQUAL(result.key(0).nulls[i], !key);
+        if (key)
+            CHECK_EQUAL(result.key(0).ints[i], *key);
+        check_group(test_context, result, i, expected[key]);
+    }
+}
+
+TEST(GroupBy_MultipleKeys)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const char* strings[] = {"alpha", "beta", "gamma", "a somewhat longer string which is not stored inline"};
+
+    for (bool enumerate : {false, true}) {
+        Table table;
+        size_t col_str = table.add_column(type_String, "str", true);
+        size_t col_bool = table.add_column(type_Bool, "bool");
+        size_t col_int = table.add_column(type_Int, "int");
+        size_t col_double = table.add_column(type_Double, "double");
+
+        const size_t num_rows = REALM_MAX_BPNODE_SIZE * 2 + 5;
+        table.add_empty_row(num_rows);
+        using Key = std::tuple<bool, std::string, bool>;
+        std::map<Key, ExpectedGroup> expected;
+        for (size_t i = 0; i < num_rows; ++i) {
+            bool is_null = random.chance(1, 10);
+            std::string str = strings[random.draw_int<size_t>(0, 3)];
+            bool b = random.chance(1, 2);
+            int64_t value = random.draw_int<int64_t>(0, 100);
+            if (!is_null)
+                table.set_string(col_str, i, str);
+            table.set_bool(col_bool, i, b);
+            table.set_int(col_int, i, value);
+            table.set_double(col_double, i, 0.5);
+            add_value(expected[Key(is_null, is_null ? std::string() : str, b)], value, 0.5);
+        }
+        if (enumerate)
+            table.optimize(true);
+
+        GroupByResult result = table.group_by({{col_str}, {col_bool}}, all_aggregates(col_int, col_double));
+        CHECK_EQUAL(result.size(), expected.size());
+        CHECK_EQUAL(result.key(0).type, type_String);
+        CHECK_EQUAL(result.key(1).type, type_Int);
+        for (size_t i = 0; i < result.size(); ++i) {
+            Key key(result.key(0).nulls[i], result.key(0).strings[i], result.key(1).ints[i] != 0);
+            auto it = expected.find(key);
+            if (CHECK(it != expected.end()))
+                check_group(test_context, result, i, it->second);
+        }
+    }
+}
+
+TEST(GroupBy_TimestampBucketsAndLinks)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    Group group;
+    TableRef target = group.add_table("target");
+    TableRef origin = group.add_table("origin");
+    target->add_column(type_Int, "int");
+    target->add_empty_row(7);
+    size_t col_ts = origin->add_column(type_Timestamp, "ts", true);
+    size_t col_link = origin->add_column_link(type_Link, "link", *target);
+    size_t col_float = origin->add_column(type_Float, "float", true);
+
+    const size_t num_rows = REALM_MAX_BPNODE_SIZE + 300;
+    const int64_t bucket = 3600;
+    origin->add_empty_row(num_rows);
+    using Key = std::tuple<bool, int64_t, size_t>;
+    std::map<Key, std::pair<size_t, float>> expected;
+    for (size_t i = 0; i < num_rows; ++i) {
+        bool ts_null = random.chance(1, 10);
+        int64_t seconds = random.draw_int<int64_t>(-3 * bucket, 3 * bucket);
+        size_t link = random.chance(1, 8) ? npos : random.draw_int<size_t>(0, 6);
+        float f = float(random.draw_int<int>(0, 10));
+        if (!ts_null)
+            origin->set_timestamp(col_ts, i, Timestamp(seconds, 0));
+        if (link != npos)
+            origin->set_link(col_link, i, link);
+        origin->set_float(col_float, i, f);
+
+        int64_t start = ts_null ? 0 : seconds - (((seconds % bucket) + bucket) % bucket);
+        auto& e = expected[Key(ts_null, start, link)];
+        ++e.first;
+        e.second = std::max(e.second, f);
+    }
+
+    GroupByResult result = origin->group_by({{col_ts, bucket}, {col_link}},
+                                            {{GroupAggregate::count, npos}, {GroupAggregate::maximum, col_float}});
+    CHECK_EQUAL(result.size(), expected.size());
+    CHECK_EQUAL(result.key(0).type, type_Timestamp);
+    CHECK_EQUAL(result.key(1).type, type_Link);
+    CHECK_EQUAL(result.aggregate(1).type, type_Double);
+    for (size_t i = 0; i < result.size(); ++i) {
+        size_t link = result.key(1).nulls[i] ? npos : size_t(result.key(1).ints[i]);
+        auto it = expected.find(Key(result.key(0).nulls[i], result.key(0).ints[i], link));
+        if (CHECK(it != expected.end())) {
+            CHECK_EQUAL(result.aggregate(0).ints[i], int64_t(it->second.first));
+            CHECK_EQUAL(result.aggregate(1).doubles[i], double(it->second.second));
+        }
+    }
+
+    CHECK_LOGIC_ERROR(origin->group_by({{col_ts}}, {}), LogicError::illegal_combination);
+    CHECK_LOGIC_ERROR(origin->group_by({{col_float}}, {}), LogicError::illegal_type);
+    CHECK_LOGIC_ERROR(origin->group_by({{col_link}}, {{GroupAggregate::sum, col_ts}}), LogicError::type_mismatch);
+    CHECK_LOGIC_ERROR(origin->group_by({{5}}, {}), LogicError::column_index_out_of_range);
+}
+
+TEST(GroupBy_QueryAndView)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    Table table;
+    size_t col_key = table.add_column(type_Int, "key");
+    size_t col_int = table.add_column(type_Int, "int");
+    size_t col_double = table.add_column(type_Double, "double");
+
+    const size_t num_rows = REALM_MAX_BPNODE_SIZE * 2 + 3;
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        table.set_int(col_key, i, random.draw_int<int64_t>(0, 4));
+        table.set_int(col_int, i, random.draw_int<int64_t>(0, 100));
+        table.set_double(col_double, i, random.draw_int<int>(0, 100) / 2.0);
+    }
+
+    Query q = table.where().greater(col_int, 30);
+    auto aggregates = all_aggregates(col_int, col_double);
+    for (size_t limit : {size_t(-1), size_t(100)}) {
+        TableView tv = q.find_all(10, num_rows - 10, limit);
+        GroupByResult from_query = q.group_by({{col_key}}, aggregates, 10, num_rows - 10, limit);
+        GroupByResult from_view = tv.group_by({{col_key}}, aggregates);
+
+        std::map<int64_t, ExpectedGroup> expected;
+        for (size_t i = 0; i < tv.size(); ++i)
+            add_value(expected[tv.get_int(col_key, i)], tv.get_int(col_int, i), tv.get_double(col_double, i));
+
+        for (const GroupByResult* result : {&from_query, &from_view}) {
+            CHECK_EQUAL(result->size(), expected.size());
+            for (size_t i = 0; i < result->size(); ++i)
+                check_group(test_context, *result, i, expected[result->key(0).ints[i]]);
+        }
+    }
+
+    // Detached rows are skipped
+    TableView tv = table.where().find_all();
+    table.remove(0);
+    GroupByResult result = tv.group_by({}, {{GroupAggregate::count, npos}});
+    CHECK_EQUAL(result.size(), 1);
+    CHECK_EQUAL(result.aggregate(0).ints[0], int64_t(num_rows - 1));
+
+    // No rows give no groups
+    result = table.where().equal(col_int, 1000).group_by({{col_key}}, aggregates);
+    CHECK_EQUAL(result.size(), 0);
+    CHECK_EQUAL(result.aggregate(5).type, type_Double);
+}
+
+#endif // TEST_GROUP_BY
@@ -0,0 +1,201 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_JOIN
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <realm.hpp>
+#include <realm/join.hpp>
+
+#include "test.hpp"
+
+using namespace realm;
+using namespace realm::test_util;
+
+
+// Test independence and thread-safety
+// -----------------------------------
+//
+// All tests must be thread safe and independent of each other. This
+// is required because it allows for both shuffling of the execution
+// order and for parallelized testing.
+//
+// In particular, avoid using std::rand() since it is not guaranteed
+// to be thread safe. Instead use the API offered in
+// `test/util/random.hpp`.
+//
+// All files created in tests must use the TEST_PATH macro (or one of
+// its friends) to obtain a suitable file system path. See
+// `test/util/test_path.hpp`.
+//
+//
+// Debugging and the ONLY() macro
+// ------------------------------
+//
+// A simple way of disabling all tests except one called `Foo`, is to
+// replace TEST(Foo) with ONLY(Foo) and then recompile and rerun the
+// test suite. Note that you can also use filtering by setting the
+// environment varible `UNITTEST_FILTER`. See `README.md` for more on
+// this.
+//
+// Another way to debug a particular test, is to copy that test into
+// `experiments/testcase.cpp` and then run `sh build.sh
+// check-testcase` (or one of its friends) from the command line.
+
+
+namespace {
+
+using RowPairs = std::vector<std::pair<size_t, size_t>>;
+
+RowPairs sorted_pairs(const JoinResult& result)
+{
+    RowPairs pairs;
+    for (size_t i = 0; i < result.size(); ++i)
+        pairs.emplace_back(result.left_rows[i], result.right_rows[i]);
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+// The pairs of rows with equal non-null values, found with nested loops
+RowPairs nested_loop_join(const Table& left, size_t left_col, const Table& right, size_t right_col)
+{
+    RowPairs pairs;
+    for (size_t i = 0; i < left.size(); ++i) {
+        if (left.is_null(left_col, i))
+            continue;
+        for (size_t j = 0; j < right.size(); ++j) {
+            if (right.is_null(right_col, j))
+                continue;
+            bool equal = left.get_column_type(left_col) == type_String
+                             ? left.get_string(left_col, i) == right.get_string(right_col, j)
+                             : left.get_int(left_col, i) == right.get_int(right_col, j);
+            if (equal)
+                pairs.emplace_back(i, j);
+        }
+    }
+    return pairs;
+}
+
+} // unnamed namespace
+
+
+TEST(Join_Int)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    Table left;
+    Table right;
+    size_t col_left = left.add_column(type_Int, "key", true);
+    size_t col_right = right.add_column(type_Int, "key");
+    const size_t num_left = REALM_MAX_BPNODE_SIZE + 17;
+    const size_t num_right = REALM_MAX_BPNODE_SIZE * 2 + 5;
+    left.add_empty_row(num_left);
+    right.add_empty_row(num_right);
+    for (size_t i = 0; i < num_left; ++i) {
+        if (!random.chance(1, 10))
+            left.set_int(col_left, i, random.draw_int<int64_t>(0, 200));
+    }
+    for (size_t i = 0; i < num_right; ++i)
+        right.set_int(col_right, i, random.draw_int<int64_t>(-50, 300));
+    RowPairs expected = nested_loop_join(left, col_left, right, col_right);
+    CHECK(!expected.empty());
+
+    // Hashing either side, and looking up the rows of the smaller side in an index on the larger one
+    for (int i = 0; i < 3; ++i) {
+        if (i == 1)
+            left.add_search_index(col_left);
+        if (i == 2)
+            right.add_search_index(col_right);
+        JoinResult result = left.join(col_left, right, col_right);
+        CHECK_EQUAL(result.left_rows.size(), result.right_rows.size());
+        CHECK(sorted_pairs(result) == expected);
+
+        JoinResult reversed = right.join(col_right, left, col_left);
+        CHECK_EQUAL(reversed.size(), expected.size());
+        RowPairs swapped;
+        for (size_t j = 0; j < reversed.size(); ++j)
+            swapped.emplace_back(reversed.right_rows[j], reversed.left_rows[j]);
+        std::sort(swapped.begin(), swapped.end());
+        CHECK(swapped == expected);
+    }
+}
+
+TEST(Join_String)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const char* strings[] = {"alpha", "beta", "gamma", "", "a somewhat longer string which is not stored inline"};
+
+    for (int i = 0; i < 4; ++i) {
+        Table left;
+        Table right;
+        size_t col_left = left.add_column(type_String, "key", true);
+        size_t col_right = right.add_column(type_String, "key", true);
+        const size_t num_left = 300;
+        const size_t num_right = REALM_MAX_BPNODE_SIZE + 40;
+        left.add_empty_row(num_left);
+        right.add_empty_row(num_right);
+        for (size_t j = 0; j < num_left; ++j) {
+            if (!random.chance(1, 10))
+                left.set_string(col_left, j, strings[random.draw_int<size_t>(0, 4)]);
+        }
+        for (size_t j = 0; j < num_right; ++j) {
+            if (!random.chance(1, 10))
+                right.set_string(col_right, j, strings[random.draw_int<size_t>(1, 4)]);
+        }
+        // Plain strings, enumerated strings on the larger side, and search indexes on either side
+        if (i == 1)
+            right.optimize(true);
+        if (i == 2)
+            right.add_search_index(col_right);
+        if (i == 3) {
+            left.optimize(true);
+            left.add_search_index(col_left);
+        }
+
+        RowPairs expected = nested_loop_join(left, col_left, right, col_right);
+        CHECK(sorted_pairs(left.join(col_left, right, col_right)) == expected);
+    }
+}
+
+TEST(Join_Errors)
+{
+    Group group;
+    TableRef left = group.add_table("left");
+    TableRef right = group.add_table("right");
+    size_t col_int = left->add_column(type_Int, "int");
+    size_t col_float = left->add_column(type_Float, "float");
+    size_t col_str = right->add_column(type_String, "str");
+    size_t col_int_2 = right->add_column(type_Int, "int");
+    size_t col_float_2 = right->add_column(type_Float, "float");
+
+    CHECK_EQUAL(left->join(col_int, *right, col_int_2).size(), 0);
+    left->add_empty_row(2);
+    CHECK_EQUAL(left->join(col_int, *right, col_int_2).size(), 0);
+    right->add_empty_row(3);
+    CHECK_EQUAL(left->join(col_int, *right, col_int_2).size(), 6);
+
+    CHECK_LOGIC_ERROR(left->join(col_int, *right, col_str), LogicError::type_mismatch);
+    CHECK_LOGIC_ERROR(left->join(col_float, *right, col_float_2), LogicError::illegal_type);
+    CHECK_LOGIC_ERROR(left->join(col_int, *right, 3), LogicError::column_index_out_of_range);
+    CHECK_LOGIC_ERROR(left->join(2, *right, col_int_2), LogicError::column_index_out_of_range);
+}
+
+#endif // TEST_JOIN
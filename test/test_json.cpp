@@ -20,10 +20,13 @@
 #ifdef TEST_JSON
 
 #include <algorithm>
+#include <cstring>
+#include <iomanip>
 #include <limits>
 #include <string>
 #include <fstream>
 #include <ostream>
+#include <sstream>
 
 #include <realm.hpp>
 #include <realm/lang_bind_helper.hpp>
@@ -511,6 +514,66 @@ TEST(Json_Nulls)
     CHECK(json_test(ss.str(), "expected_json_nulls", generate_all));
 }
 
+TEST(Json_ValueFormatting)
+{
+    Table table;
+    table.add_column(type_Int, "int");
+    table.add_column(type_Float, "float");
+    table.add_column(type_Double, "double");
+    table.add_column(type_String, "string");
+
+    const int64_t ints[] = {0, 7, -7, 1234567890123, std::numeric_limits<int64_t>::min(),
+                            std::numeric_limits<int64_t>::max()};
+    const float floats[] = {0, -0.5f, 1.0f / 3, 6.02214076e23f, -1.5e-30f, std::numeric_limits<float>::max()};
+    const double doubles[] = {0, -0.5, 1.0 / 3, 6.02214076e23, -1.5e-300, std::numeric_limits<double>::max()};
+    // Large enough for the output to be written to the stream in several blocks
+    std::string long_string(100000, 'x');
+    long_string[50000] = '"';
+    const std::string strings[] = {"", "plain", "\"quoted\"", "line\nbreak\r\ttab\f\\\b", long_string,
+                                   std::string("nul\0byte", 8)};
+    const size_t num_rows = 6;
+    table.add_empty_row(num_rows);
+
+    // The expected output is produced the way values used to be written, through std::ostream
+    std::ostringstream expected;
+    expected << "[";
+    for (size_t i = 0; i < num_rows; ++i) {
+        table.set_int(0, i, ints[i]);
+        table.set_float(1, i, floats[i]);
+        table.set_double(2, i, doubles[i]);
+        table.set_string(3, i, strings[i]);
+
+        std::string escaped;
+        for (char c : strings[i]) {
+            const char* special = "\"\n\r\t\f\\\b";
+            const char* found = c == 0 ? nullptr : std::strchr(special, c);
+            if (found) {
+                escaped += '\\';
+                escaped += "\"nrtf\\b"[found - special];
+            }
+            else {
+                escaped += c;
+            }
+        }
+        if (i > 0)
+            expected << ",";
+        expected << "{\"_key\":" << i << ",\"int\":" << ints[i] << ",\"float\":" << std::scientific
+                 << std::setprecision(std::numeric_limits<float>::digits10 + 1) << floats[i]
+                 << ",\"double\":" << std::setprecision(std::numeric_limits<double>::digits10 + 1) << doubles[i]
+                 << ",\"string\":\"" << escaped << "\"}";
+    }
+    expected << "]";
+
+    std::stringstream ss;
+    table.to_json(ss);
+    CHECK(ss.str() == expected.str());
+
+    TableView tv = table.where().find_all();
+    std::stringstream ss2;
+    tv.to_json(ss2);
+    CHECK(ss2.str() == expected.str());
+}
+
 } // anonymous namespace
 
 #endif // TEST_TABLE
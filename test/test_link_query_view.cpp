@@ -19,6 +19,8 @@
 #include "testsettings.hpp"
 #ifdef TEST_LINK_VIEW
 
+#include <algorithm>
+#include <functional>
 #include <limits>
 #include <string>
 #include <sstream>
@@ -2040,4 +2042,114 @@ TEST(BackLink_Query_MultipleLevelsAndTables)
     CHECK_TABLE_VIEW(q.find_all(), {1});
 }
 
+
+// Once a condition on a linked column has been evaluated for as many rows as the target table has, the remaining
+// matches are found by scanning the target table and following the backlinks instead
+TEST(LinkList_QueryThroughBacklinks)
+{
+    Group g;
+    TableRef origin = g.add_table("origin");
+    TableRef middle = g.add_table("middle");
+    TableRef target = g.add_table("target");
+    size_t col_int = target->add_column(type_Int, "int", true);
+    size_t col_str = target->add_column(type_String, "str", true);
+    size_t col_date = target->add_column(type_Timestamp, "date", true);
+    size_t col_link = origin->add_column_link(type_Link, "link", *target);
+    size_t col_list = origin->add_column_link(type_LinkList, "list", *target);
+    size_t col_middle = origin->add_column_link(type_Link, "middle", *middle);
+    size_t col_middle_list = middle->add_column_link(type_LinkList, "list", *target);
+
+    const size_t num_targets = 50;
+    const size_t num_middle = 20;
+    const size_t num_rows = 2000;
+    target->add_empty_row(num_targets);
+    for (size_t i = 0; i < num_targets; ++i) {
+        if (i % 9 == 0)
+            continue; // leave all values null
+        target->set_int(col_int, i, int64_t(i % 17));
+        std::string str = "str" + util::to_string(i % 13);
+        target->set_string(col_str, i, str);
+        target->set_timestamp(col_date, i, Timestamp(int64_t(i % 23), 0));
+    }
+    middle->add_empty_row(num_middle);
+    for (size_t i = 0; i < num_middle; ++i) {
+        LinkViewRef list = middle->get_linklist(col_middle_list, i);
+        for (size_t j = 0; j < i % 5; ++j)
+            list->add((i * 3 + j * 11) % num_targets);
+    }
+    origin->add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (i % 5 != 0)
+            origin->set_link(col_link, i, (i * 7) % num_targets);
+        if (i % 7 != 0)
+            origin->set_link(col_middle, i, i % num_middle);
+        LinkViewRef list = origin->get_linklist(col_list, i);
+        for (size_t j = 0; j < i % 4; ++j)
+            list->add((i * 13 + j * 31) % num_targets);
+    }
+
+    // Apply `pred` to the targets reachable from the given row of the origin table through `col`
+    auto any_target = [&](size_t row, size_t col, std::function<bool(size_t)> pred) {
+        if (col == col_link)
+            return !origin->is_null_link(col_link, row) && pred(origin->get_link(col_link, row));
+        std::vector<size_t> targets;
+        if (col == col_list) {
+            LinkViewRef list = origin->get_linklist(col_list, row);
+            for (size_t j = 0; j < list->size(); ++j)
+                targets.push_back(list->get(j).get_index());
+        }
+        else if (!origin->is_null_link(col_middle, row)) {
+            LinkViewRef list = middle->get_linklist(col_middle_list, origin->get_link(col_middle, row));
+            for (size_t j = 0; j < list->size(); ++j)
+                targets.push_back(list->get(j).get_index());
+        }
+        return std::any_of(targets.begin(), targets.end(), pred);
+    };
+    auto check = [&](Query q, size_t col, std::function<bool(size_t)> pred) {
+        std::vector<size_t> expected;
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (any_target(i, col, pred))
+                expected.push_back(i);
+        }
+        CHECK_EQUAL(q.count(), expected.size());
+        CHECK_EQUAL(q.find(), expected.empty() ? not_found : expected.front());
+        TableView tv = q.find_all();
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+            CHECK_EQUAL(tv.get_source_ndx(i), expected[i]);
+        // A range starting past the point where the strategy changes
+        auto it = std::lower_bound(expected.begin(), expected.end(), num_rows / 2);
+        CHECK_EQUAL(q.count(num_rows / 2, num_rows), size_t(expected.end() - it));
+    };
+    auto int_is = [&](size_t r, std::function<bool(int64_t)> pred) {
+        return !target->is_null(col_int, r) && pred(target->get_int(col_int, r));
+    };
+
+    check(origin->link(col_link).column<Int>(col_int) > 5, col_link,
+          [&](size_t r) { return int_is(r, [](int64_t v) { return v > 5; }); });
+    check(origin->link(col_list).column<Int>(col_int) == 3, col_list,
+          [&](size_t r) { return int_is(r, [](int64_t v) { return v == 3; }); });
+    check(origin->link(col_middle).link(col_middle_list).column<Int>(col_int) <= 2, col_middle,
+          [&](size_t r) { return int_is(r, [](int64_t v) { return v <= 2; }); });
+    check(origin->link(col_list).column<String>(col_str) == "str4", col_list,
+          [&](size_t r) { return target->get_string(col_str, r) == "str4"; });
+    check(origin->link(col_link).column<Timestamp>(col_date) > Timestamp(10, 0), col_link, [&](size_t r) {
+        return !target->is_null(col_date, r) && target->get_timestamp(col_date, r) > Timestamp(10, 0);
+    });
+
+    // Conditions matched by null must still find the rows with a null link
+    Query q = origin->link(col_link).column<Int>(col_int) == null();
+    size_t expected = 0;
+    for (size_t i = 0; i < num_rows; ++i)
+        expected += origin->is_null_link(col_link, i) || target->is_null(col_int, origin->get_link(col_link, i));
+    CHECK_EQUAL(q.count(), expected);
+    q = origin->link(col_link).column<Int>(col_int) != 3;
+    expected = 0;
+    for (size_t i = 0; i < num_rows; ++i) {
+        expected += origin->is_null_link(col_link, i) || target->is_null(col_int, origin->get_link(col_link, i)) ||
+                    target->get_int(col_int, origin->get_link(col_link, i)) != 3;
+    }
+    CHECK_EQUAL(q.count(), expected);
+}
+
 #endif
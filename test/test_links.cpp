@@ -19,8 +19,12 @@
 #include "testsettings.hpp"
 #ifdef TEST_LINKS
 
+#include <algorithm>
+#include <vector>
 
 #include <realm.hpp>
+#include <realm/column_backlink.hpp>
+#include <realm/column_linkbase.hpp>
 #include <realm/util/file.hpp>
 
 #include "test.hpp"
@@ -1982,4 +1986,144 @@ TEST(Links_DetachedAccessor)
     CHECK_LOGIC_ERROR(link_list->swap(0, 1), LogicError::detached_accessor);
 }
 
+
+TEST(Links_SortedBacklinks)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+
+    Group group;
+    TableRef origin = group.add_table("origin");
+    TableRef target = group.add_table("target");
+    size_t col_link = origin->add_column_link(type_Link, "link", *target);
+    size_t col_list = origin->add_column_link(type_LinkList, "list", *target);
+    target->add_empty_row(3);
+
+    using tf = _impl::TableFriend;
+    auto& link_backlinks = static_cast<LinkColumnBase&>(tf::get_column(*origin, col_link)).get_backlink_column();
+    auto& list_backlinks = static_cast<LinkColumnBase&>(tf::get_column(*origin, col_list)).get_backlink_column();
+
+    // Most links go to target row 0, so that its backlink lists grow past the threshold
+    auto draw_target = [&] { return random.chance(4, 5) ? 0 : random.draw_int_mod(size_t(3)); };
+
+    auto check = [&] {
+        for (size_t t = 0; t < 3; ++t) {
+            std::vector<size_t> expected_link, expected_list;
+            for (size_t i = 0; i < origin->size(); ++i) {
+                if (!origin->is_null_link(col_link, i) && origin->get_link(col_link, i) == t)
+                    expected_link.push_back(i);
+                LinkViewRef list = origin->get_linklist(col_list, i);
+                for (size_t j = 0; j < list->size(); ++j) {
+                    if (list->get(j).get_index() == t)
+                        expected_list.push_back(i);
+                }
+            }
+
+            const BacklinkColumn* columns[] = {&link_backlinks, &list_backlinks};
+            const std::vector<size_t>* expected[] = {&expected_link, &expected_list};
+            for (size_t c = 0; c < 2; ++c) {
+                size_t count = columns[c]->get_backlink_count(t);
+                std::vector<size_t> actual;
+                for (size_t i = 0; i < count; ++i)
+                    actual.push_back(columns[c]->get_backlink(t, i));
+                if (count > BacklinkColumn::sorted_threshold)
+                    CHECK(columns[c]->has_sorted_backlinks(t));
+                if (columns[c]->has_sorted_backlinks(t))
+                    CHECK(std::is_sorted(actual.begin(), actual.end()));
+                std::sort(actual.begin(), actual.end());
+                CHECK(actual == *expected[c]);
+            }
+        }
+    };
+
+    for (size_t i = 0; i < 3 * BacklinkColumn::sorted_threshold; ++i) {
+        size_t row_ndx = origin->add_empty_row();
+        origin->set_link(col_link, row_ndx, draw_target());
+        LinkViewRef list = origin->get_linklist(col_list, row_ndx);
+        size_t num_links = random.draw_int_mod(size_t(3));
+        for (size_t j = 0; j < num_links; ++j)
+            list->add(draw_target());
+    }
+    CHECK(link_backlinks.has_sorted_backlinks(0));
+    CHECK(list_backlinks.has_sorted_backlinks(0));
+    CHECK(!link_backlinks.has_sorted_backlinks(1));
+    check();
+
+    for (size_t iter = 0; iter < 200; ++iter) {
+        size_t row_ndx = random.draw_int_mod(origin->size());
+        switch (random.draw_int_mod(6)) {
+            case 0:
+                origin->set_link(col_link, row_ndx, draw_target());
+                break;
+            case 1:
+                origin->get_linklist(col_list, row_ndx)->add(draw_target());
+                break;
+            case 2:
+                origin->move_last_over(row_ndx);
+                break;
+            case 3:
+                origin->remove(row_ndx);
+                break;
+            case 4:
+                origin->swap_rows(row_ndx, random.draw_int_mod(origin->size()));
+                break;
+            case 5:
+                origin->insert_empty_row(row_ndx);
+                origin->set_link(col_link, row_ndx, draw_target());
+                break;
+        }
+        if (iter % 20 == 0)
+            check();
+    }
+    check();
+    group.verify();
+
+    origin->clear();
+    CHECK_EQUAL(0, link_backlinks.get_backlink_count(0));
+    CHECK_EQUAL(0, list_backlinks.get_backlink_count(0));
+}
+
+TEST(Links_SortedBacklinksOutOfOrder)
+{
+    // Versions of the library which do not sort backlink lists keep the mark
+    // of a sorted list when they modify it
+    Group group;
+    TableRef origin = group.add_table("origin");
+    TableRef target = group.add_table("target");
+    size_t col_link = origin->add_column_link(type_Link, "link", *target);
+    target->add_empty_row();
+    size_t n = 2 * BacklinkColumn::sorted_threshold;
+    origin->add_empty_row(n);
+    for (size_t i = 0; i < n; ++i)
+        origin->set_link(col_link, i, 0);
+
+    using tf = _impl::TableFriend;
+    auto& backlinks = static_cast<LinkColumnBase&>(tf::get_column(*origin, col_link)).get_backlink_column();
+    CHECK(backlinks.has_sorted_backlinks(0));
+    {
+        IntegerColumn list(backlinks.get_alloc(), backlinks.get_as_ref(0));
+        list.set_parent(&backlinks, 0);
+        for (size_t i = 0; i < n; ++i)
+            list.set(i, int64_t(n - 1 - i));
+    }
+
+    // Every backlink is still found, and the list loses its mark
+    for (size_t i = 0; i < n; i += 2)
+        origin->nullify_link(col_link, i);
+    CHECK_EQUAL(n / 2, backlinks.get_backlink_count(0));
+    CHECK(!backlinks.has_sorted_backlinks(0));
+    std::vector<size_t> actual;
+    for (size_t i = 0; i < n / 2; ++i)
+        actual.push_back(backlinks.get_backlink(0, i));
+    std::sort(actual.begin(), actual.end());
+    for (size_t i = 0; i < n / 2; ++i)
+        CHECK_EQUAL(2 * i + 1, actual[i]);
+
+    // ... until it is sorted again when it next grows
+    origin->set_link(col_link, 0, 0);
+    CHECK(backlinks.has_sorted_backlinks(0));
+    for (size_t i = 1; i <= n / 2; ++i)
+        CHECK_LESS(backlinks.get_backlink(0, i - 1), backlinks.get_backlink(0, i));
+    group.verify();
+}
+
 #endif // TEST_LINKS
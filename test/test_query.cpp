@@ -12316,4 +12316,355 @@ TEST(Query_NotImmediatelyBeforeKnownRange)
 }
 
 
+// Conjunctions of simple integer, float and double conditions are evaluated a block of rows at a time. Compare with
+// a row by row evaluation, using ranges and data which cross both block and leaf boundaries.
+TEST(Query_FusedConjunction)
+{
+    Table table;
+    table.add_column(type_Int, "a");
+    table.add_column(type_Int, "b", true);
+    table.add_column(type_Float, "c");
+    table.add_column(type_Double, "d", true);
+    table.add_column(type_Bool, "e");
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const size_t num_rows = 3 * REALM_MAX_BPNODE_SIZE + 123;
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        table.set_int(0, i, random.draw_int<int64_t>(-20, 20));
+        if (random.draw_int_mod(10) == 0)
+            table.set_null(1, i);
+        else
+            table.set_int(1, i, random.draw_int<int64_t>(0, 5) * 1000000000LL);
+        table.set_float(2, i, float(random.draw_int<int>(0, 100)) / 4);
+        if (random.draw_int_mod(10) == 0)
+            table.set_null(3, i);
+        else
+            table.set_double(3, i, double(random.draw_int<int>(-50, 50)));
+        table.set_bool(4, i, random.draw_bool());
+    }
+
+    auto matches = [&](size_t i) {
+        return table.get_int(0, i) > 5 && (table.is_null(1, i) || table.get_int(1, i) != 3000000000LL) &&
+               table.get_float(2, i) <= 12.5f && table.get_bool(4, i);
+    };
+    Query q =
+        table.where().greater(0, 5).not_equal(1, int64_t(3000000000LL)).less_equal(2, 12.5f).equal(4, true);
+
+    std::vector<size_t> expected;
+    int64_t sum = 0;
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (matches(i)) {
+            expected.push_back(i);
+            sum += table.get_int(0, i);
+        }
+    }
+
+    CHECK_EQUAL(q.count(), expected.size());
+    CHECK_EQUAL(q.sum_int(0), sum);
+    TableView tv = q.find_all();
+    CHECK_EQUAL(tv.size(), expected.size());
+    for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+        CHECK_EQUAL(tv.get_source_ndx(i), expected[i]);
+
+    // Limits and ranges which do not start on a block boundary
+    CHECK_EQUAL(q.find_all(0, size_t(-1), 3).size(), std::min(expected.size(), size_t(3)));
+    for (size_t start : {size_t(0), size_t(1), size_t(63), size_t(64), size_t(999), size_t(1000), num_rows - 1}) {
+        auto it = std::lower_bound(expected.begin(), expected.end(), start);
+        CHECK_EQUAL(q.find(start), it == expected.end() ? not_found : *it);
+        size_t end = std::min(start + 100, num_rows);
+        auto it_end = std::lower_bound(expected.begin(), expected.end(), end);
+        CHECK_EQUAL(q.count(start, end), size_t(it_end - it));
+    }
+
+    // Nullable double with a null needle
+    size_t double_null_and_a = 0;
+    for (size_t i = 0; i < num_rows; ++i)
+        double_null_and_a += table.is_null(3, i) && table.get_int(0, i) < 0;
+    CHECK_EQUAL(table.where().equal(3, null()).less(0, 0).count(), double_null_and_a);
+
+    // An index makes the equality condition drive the query instead
+    table.add_search_index(0);
+    CHECK_EQUAL(table.where().equal(0, 7).equal(4, true).count(),
+                table.where().equal(4, true).equal(0, 7).find_all().size());
+    size_t sevens = 0;
+    for (size_t i = 0; i < num_rows; ++i)
+        sevens += table.get_int(0, i) == 7 && table.get_bool(4, i);
+    CHECK_EQUAL(table.where().equal(0, 7).equal(4, true).count(), sevens);
+}
+
+
+// Arithmetic expressions are evaluated over batches of rows read straight from the leaves. Check that the results
+// agree with a row-by-row evaluation across leaf boundaries, with nulls and with constants on either side.
+TEST(Query_ExpressionBatches)
+{
+    Group g;
+    TableRef table = g.add_table("table");
+    TableRef target = g.add_table("target");
+    table->add_column(type_Int, "price");
+    table->add_column(type_Int, "qty", true);
+    table->add_column(type_Double, "discount", true);
+    table->add_column_link(type_Link, "link", *target);
+    target->add_column(type_Int, "value");
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const size_t num_rows = 3 * REALM_MAX_BPNODE_SIZE + 17;
+    target->add_empty_row(10);
+    for (size_t i = 0; i < 10; ++i)
+        target->set_int(0, i, int64_t(i) * 10);
+    table->add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        table->set_int(0, i, random.draw_int<int64_t>(-50, 200));
+        if (random.draw_int_mod(8) == 0)
+            table->set_null(1, i);
+        else
+            table->set_int(1, i, random.draw_int<int64_t>(0, 20));
+        if (random.draw_int_mod(8) == 0)
+            table->set_null(2, i);
+        else
+            table->set_double(2, i, random.draw_int<int>(0, 100) / 4.0);
+        if (random.draw_int_mod(4) != 0)
+            table->set_link(3, i, random.draw_int_mod(10));
+    }
+
+    auto check = [&](Query q, std::function<bool(size_t)> matches) {
+        std::vector<size_t> expected;
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (matches(i))
+                expected.push_back(i);
+        }
+        CHECK_EQUAL(q.count(), expected.size());
+        TableView tv = q.find_all();
+        CHECK_EQUAL(tv.size(), expected.size());
+        for (size_t i = 0; i < tv.size() && i < expected.size(); ++i)
+            CHECK_EQUAL(tv.get_source_ndx(i), expected[i]);
+        const size_t starts[] = {1, 255, 257, REALM_MAX_BPNODE_SIZE - 3, num_rows - 1};
+        for (size_t start : starts) {
+            auto it = std::lower_bound(expected.begin(), expected.end(), start);
+            CHECK_EQUAL(q.find(start), it == expected.end() ? not_found : *it);
+            size_t end = std::min(start + 300, num_rows);
+            auto it_end = std::lower_bound(expected.begin(), expected.end(), end);
+            CHECK_EQUAL(q.count(start, end), size_t(it_end - it));
+        }
+    };
+
+    auto price = table->column<Int>(0);
+    auto qty = table->column<Int>(1);
+    auto discount = table->column<Double>(2);
+    auto linked = table->link(3).column<Int>(0);
+    auto get_price = [&](size_t i) { return table->get_int(0, i); };
+    auto get_qty = [&](size_t i) { return table->get_int(1, i); };
+
+    check(price * qty > 1000, [&](size_t i) { return !table->is_null(1, i) && get_price(i) * get_qty(i) > 1000; });
+    check(price - 3 <= qty, [&](size_t i) { return !table->is_null(1, i) && get_price(i) - 3 <= get_qty(i); });
+    check(100 - price > 2 * qty,
+          [&](size_t i) { return !table->is_null(1, i) && 100 - get_price(i) > 2 * get_qty(i); });
+    check(qty + 1 == 5, [&](size_t i) { return !table->is_null(1, i) && get_qty(i) + 1 == 5; });
+    check(qty == null(), [&](size_t i) { return table->is_null(1, i); });
+    check(price != qty, [&](size_t i) { return table->is_null(1, i) || get_price(i) != get_qty(i); });
+    check(price * (1 - discount / 100) >= 40, [&](size_t i) {
+        return !table->is_null(2, i) && get_price(i) * (1 - table->get_double(2, i) / 100) >= 40;
+    });
+    check(linked + price > 100, [&](size_t i) {
+        if (table->is_null_link(3, i))
+            return false;
+        return target->get_int(0, table->get_link(3, i)) + get_price(i) > 100;
+    });
+
+    // Aggregates are fed from the same batches
+    int64_t sum = 0;
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (!table->is_null(1, i) && get_price(i) * get_qty(i) > 1000)
+            sum += get_price(i);
+    }
+    CHECK_EQUAL((price * qty > 1000).sum_int(0), sum);
+
+    // Cached results must not survive a modification of the table
+    Query q = price * qty > 1000;
+    size_t count = q.count();
+    bool first_matched = q.find() == 0;
+    table->set_int(0, 0, 1000);
+    table->set_int(1, 0, 1000);
+    CHECK_EQUAL(q.count(), first_matched ? count : count + 1);
+}
+
+
+TEST(Query_ForEach)
+{
+    Table table;
+    table.add_column(type_Int, "int");
+    table.add_column(type_Double, "double");
+    table.add_empty_row(3000);
+    for (size_t i = 0; i < 3000; ++i) {
+        table.set_int(0, i, int64_t(i % 7));
+        table.set_double(1, i, double(i));
+    }
+
+    auto collect = [](const Query& query, size_t start = 0, size_t end = size_t(-1), size_t limit = size_t(-1)) {
+        std::vector<size_t> rows;
+        query.for_each([&](Table::ConstRowExpr row) { rows.push_back(row.get_index()); }, start, end, limit);
+        return rows;
+    };
+    auto expected = [](TableView view) {
+        std::vector<size_t> rows;
+        for (size_t i = 0; i < view.size(); ++i)
+            rows.push_back(view.get_source_ndx(i));
+        return rows;
+    };
+
+    Query q = table.where().equal(0, 3).greater(1, 100.0);
+    CHECK(collect(q) == expected(q.find_all()));
+    CHECK(collect(q, 500, 2500) == expected(q.find_all(500, 2500)));
+    CHECK(collect(q, 0, size_t(-1), 5) == expected(q.find_all(0, size_t(-1), 5)));
+    CHECK(collect(q, 0, size_t(-1), 0).empty());
+
+    // Expression based conditions
+    Query q2 = table.column<Int>(0) * table.column<Double>(1) > 10000.0;
+    CHECK(collect(q2) == expected(q2.find_all()));
+
+    // No conditions
+    Query q3 = table.where();
+    CHECK_EQUAL(table.size(), collect(q3).size());
+    CHECK(collect(q3, 10, 20) == expected(q3.find_all(10, 20)));
+
+    // Restricted to a view
+    TableView view = table.where().less(0, 2).find_all();
+    Query q4 = table.where(&view).greater(1, 1000.0);
+    CHECK(collect(q4) == expected(q4.find_all()));
+
+    double sum = 0;
+    q.for_each([&](Table::ConstRowExpr row) { sum += row.get_double(1); });
+    CHECK_EQUAL(q.sum_double(1), sum);
+}
+
+
+TEST(Query_ContainsMediumStrings)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+
+    // Strings of 16 to 63 characters are stored in medium string leaves,
+    // which are searched in bulk. A small alphabet gives many partial and
+    // boundary spanning matches.
+    Table table;
+    table.add_column(type_String, "s", true);
+    const size_t num_rows = 3 * REALM_MAX_BPNODE_SIZE + 17;
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (random.chance(1, 10))
+            continue; // null
+        std::string str(random.draw_int(16, 63), 'a');
+        for (char& c : str)
+            c = "ab\0"[random.draw_int_mod(3)];
+        table.set_string(0, i, str);
+    }
+
+    const char* needles[] = {"a", "ab", "ba", "bbbb", "aabab", "abababababab", "ab\0b", "c"};
+    for (const char* n : needles) {
+        std::string needle = n;
+        if (needle == "ab\0b")
+            needle = std::string("ab\0b", 4);
+        TableView tv = table.where().contains(0, needle).find_all();
+        size_t matches = 0;
+        for (size_t i = 0; i < num_rows; ++i) {
+            StringData str = table.get_string(0, i);
+            if (str.contains(needle)) {
+                if (matches < tv.size())
+                    CHECK_EQUAL(i, tv.get_source_ndx(matches));
+                ++matches;
+            }
+        }
+        CHECK_EQUAL(matches, tv.size());
+
+        // Starting inside a leaf
+        size_t start = REALM_MAX_BPNODE_SIZE + 3;
+        CHECK_EQUAL(table.where().contains(0, needle).find_all(start).size(),
+                    table.where().contains(0, needle).count(start));
+    }
+
+    // Empty and null needles match every non-null and every string respectively
+    CHECK_EQUAL(num_rows - table.count_string(0, realm::null()), table.where().contains(0, "").count());
+    CHECK_EQUAL(num_rows, table.where().contains(0, realm::null()).count());
+}
+
+TEST(Query_TimestampAggregates)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    Group g;
+    TableRef target = g.add_table("target");
+    TableRef origin = g.add_table("origin");
+    size_t col_ts = target->add_column(type_Timestamp, "ts", true);
+    size_t col_int = target->add_column(type_Int, "int");
+    size_t col_list = origin->add_column_link(type_LinkList, "list", *target);
+
+    const size_t num_rows = REALM_MAX_BPNODE_SIZE * 2 + 50;
+    target->add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (!random.chance(1, 5))
+            target->set_timestamp(col_ts, i, Timestamp(random.draw_int<int64_t>(0, 100), random.draw_int<int32_t>(0, 2)));
+        target->set_int(col_int, i, random.draw_int<int64_t>(0, 9));
+    }
+
+    // Query minimum/maximum report the position among the matches, like the table view does
+    for (int64_t v = 0; v < 10; v += 3) {
+        Query q = target->where().greater_equal(col_int, v);
+        for (size_t limit : {size_t(-1), size_t(10), size_t(0)}) {
+            TableView tv = q.find_all(0, size_t(-1), limit);
+            size_t ndx_q;
+            size_t ndx_tv;
+            CHECK_EQUAL(tv.maximum_timestamp(col_ts, &ndx_tv), q.maximum_timestamp(col_ts, &ndx_q, 0, -1, limit));
+            CHECK_EQUAL(ndx_tv, ndx_q);
+            CHECK_EQUAL(tv.minimum_timestamp(col_ts, &ndx_tv), q.minimum_timestamp(col_ts, &ndx_q, 0, -1, limit));
+            CHECK_EQUAL(ndx_tv, ndx_q);
+        }
+        size_t ndx_q;
+        size_t ndx_tv;
+        TableView tv = q.find_all(100, num_rows - 100);
+        CHECK_EQUAL(tv.maximum_timestamp(col_ts, &ndx_tv), q.maximum_timestamp(col_ts, &ndx_q, 100, num_rows - 100));
+        CHECK_EQUAL(ndx_tv, ndx_q);
+    }
+
+    // Minimum and maximum of Timestamps across link lists
+    const size_t num_origins = 200;
+    origin->add_empty_row(num_origins);
+    std::vector<Timestamp> mins(num_origins);
+    std::vector<Timestamp> maxs(num_origins);
+    for (size_t i = 0; i < num_origins; ++i) {
+        LinkViewRef list = origin->get_linklist(col_list, i);
+        size_t n = size_t(random.draw_int<int>(0, 20));
+        for (size_t j = 0; j < n; ++j) {
+            size_t link = random.draw_int<size_t>(0, num_rows - 1);
+            list->add(link);
+            Timestamp ts = target->get_timestamp(col_ts, link);
+            if (ts.is_null())
+                continue;
+            if (mins[i].is_null() || ts < mins[i])
+                mins[i] = ts;
+            if (maxs[i].is_null() || ts > maxs[i])
+                maxs[i] = ts;
+        }
+    }
+
+    auto count_matches = [&](const std::vector<Timestamp>& values, auto pred) {
+        return size_t(std::count_if(values.begin(), values.end(), pred));
+    };
+    Timestamp needle(50, 1);
+    auto ts_max = origin->column<Link>(col_list).column<Timestamp>(col_ts).max();
+    auto ts_min = origin->column<Link>(col_list).column<Timestamp>(col_ts).min();
+    CHECK_EQUAL(count_matches(maxs, [&](Timestamp ts) { return !ts.is_null() && ts > needle; }),
+                (ts_max > needle).count());
+    CHECK_EQUAL(count_matches(mins, [&](Timestamp ts) { return !ts.is_null() && ts <= needle; }),
+                (ts_min <= needle).count());
+    CHECK_EQUAL(count_matches(maxs, [&](Timestamp ts) { return ts.is_null(); }),
+                (ts_max == null()).count());
+
+    size_t row = 0;
+    while (row < num_origins && mins[row].is_null())
+        ++row;
+    if (row < num_origins) {
+        TableView tv = (ts_min == mins[row]).find_all();
+        CHECK_EQUAL(count_matches(mins, [&](Timestamp ts) { return ts == mins[row]; }), tv.size());
+        CHECK_NOT_EQUAL(tv.find_by_source_ndx(row), npos);
+    }
+}
+
 #endif // TEST_QUERY
@@ -21,6 +21,7 @@
 
 #include <condition_variable>
 #include <streambuf>
+#include <sstream>
 #include <fstream>
 #include <tuple>
 #include <iostream>
@@ -35,6 +36,7 @@
 #include <sys/wait.h>
 #include <csignal>
 #include <sched.h>
+#include <poll.h>
 #define ENABLE_ROBUST_AGAINST_DEATH_DURING_WRITE
 #else
 #include <windows.h>
@@ -47,9 +49,11 @@
 #include <realm/util/safe_int_ops.hpp>
 #include <memory>
 #include <realm/util/terminate.hpp>
+#include <realm/util/fifo_helper.hpp>
 #include <realm/util/file.hpp>
 #include <realm/util/thread.hpp>
 #include <realm/util/to_string.hpp>
+#include <realm/impl/scan_prefetcher.hpp>
 #include <realm/impl/simulated_failure.hpp>
 
 #include "fuzz_group.hpp"
@@ -145,10 +149,9 @@ TEST(Shared_Unattached)
 
 namespace {
 
-// async deamon does not start when launching unit tests from osx, so async is currently disabled on osx.
-// Also: async requires interprocess communication, which does not work with our current encryption support.
+// Async is currently disabled on osx, and it is not supported on Windows, Android, and for encrypted files.
 #if !defined(_WIN32) && !REALM_PLATFORM_APPLE
-#if REALM_ANDROID || defined DISABLE_ASYNC || REALM_ENABLE_ENCRYPTION
+#if REALM_ANDROID || defined DISABLE_ASYNC
 bool allow_async = false;
 #else
 bool allow_async = true;
@@ -1986,7 +1989,6 @@ TEST(Shared_ClearColumnWithBasicArrayRootLeaf)
 }
 
 // disable shared async on windows and any Apple operating system
-// TODO: enable async daemon for OS X - think how to do it in XCode (no issue for build.sh)
 #if !defined(_WIN32) && !REALM_PLATFORM_APPLE
 // Todo. Keywords: winbug
 TEST_IF(Shared_Async, allow_async)
@@ -2012,10 +2014,6 @@ TEST_IF(Shared_Async, allow_async)
         }
     }
 
-    // Wait for async_commit process to shutdown
-    // FIXME: we need a way to determine properly if the daemon has shot down instead of just sleeping
-    millisleep(1000);
-
     // Read the db again in normal mode to verify
     {
         SharedGroup db(path);
@@ -2028,6 +2026,104 @@ TEST_IF(Shared_Async, allow_async)
 }
 
 
+TEST_IF(Shared_AsyncDurableVersion, allow_async)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    using version_type = SharedGroup::version_type;
+
+    {
+        SharedGroupOptions options(SharedGroupOptions::Durability::Async);
+        options.async_commit_latency = std::chrono::hours(1);
+        SharedGroup sg(path, false, options);
+        version_type initial_version = sg.get_durable_version();
+        {
+            WriteTransaction wt(sg);
+            auto t = wt.add_table("test");
+            t->add_column(type_Int, "i");
+            t->add_empty_row(10);
+            wt.commit();
+        }
+        // The commit is not made durable before the latency has passed
+        CHECK_EQUAL(initial_version, sg.get_durable_version());
+        version_type latest_version;
+        for (int i = 0; i < 10; ++i) {
+            WriteTransaction wt(sg);
+            wt.get_table("test")->set_int(0, i, i + 1);
+            latest_version = wt.commit();
+        }
+        CHECK_LESS(sg.get_durable_version(), latest_version);
+
+        sg.wait_for_durability();
+        CHECK_EQUAL(latest_version, sg.get_durable_version());
+
+        // The committer of another SharedGroup makes the same snapshot durable
+        SharedGroup sg_2(path, false, options);
+        {
+            WriteTransaction wt(sg_2);
+            wt.get_table("test")->add_empty_row();
+            latest_version = wt.commit();
+        }
+        sg.wait_for_durability();
+        CHECK_EQUAL(latest_version, sg_2.get_durable_version());
+    }
+
+    // Every commit is durable when it returns with full durability, and the
+    // commits made durable by the committer are found in the file
+    {
+        SharedGroup sg(path);
+        {
+            ReadTransaction rt(sg);
+            CHECK_EQUAL(rt.get_version(), sg.get_durable_version());
+            rt.get_group().verify();
+            ConstTableRef t = rt.get_table("test");
+            CHECK_EQUAL(11, t->size());
+            CHECK_EQUAL(10, t->get_int(0, 9));
+        }
+        version_type version;
+        {
+            WriteTransaction wt(sg);
+            wt.get_table("test")->set_int(0, 10, 11);
+            version = wt.commit();
+        }
+        CHECK_EQUAL(version, sg.get_durable_version());
+        sg.wait_for_durability();
+        CHECK_EQUAL(version, sg.get_durable_version());
+    }
+}
+
+
+TEST_IF(Shared_AsyncCompactFailure, allow_async)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(SharedGroupOptions::Durability::Async);
+    options.async_commit_latency = std::chrono::hours(1);
+    SharedGroup sg(path, false, options);
+    {
+        WriteTransaction wt(sg);
+        wt.add_table("test")->add_column(type_Int, "i");
+        wt.commit();
+    }
+
+    // A directory in place of the file compacted into makes compact() throw
+    std::string tmp_path = std::string(path) + ".tmp_compaction_space";
+    util::make_dir(tmp_path);
+    File(tmp_path + "/file", File::mode_Write);
+    CHECK_THROW_ANY(sg.compact());
+    util::remove_dir_recursive(tmp_path);
+
+    // The async committer has been restarted, and still makes commits durable
+    CHECK(sg.is_attached());
+    SharedGroup::version_type version;
+    {
+        WriteTransaction wt(sg);
+        wt.get_table("test")->add_empty_row();
+        version = wt.commit();
+    }
+    sg.wait_for_durability();
+    CHECK_EQUAL(version, sg.get_durable_version());
+}
+
+
 namespace {
 
 #define multiprocess_increments 100
@@ -2127,9 +2223,6 @@ void multiprocess_make_table(std::string path, std::string lock_path, std::strin
     }
 #endif
 #endif
-    // Wait for async_commit process to shutdown
-    // FIXME: No good way of doing this
-    millisleep(1000);
 #else
     {
         Group g(alone_path, Group::mode_ReadWrite);
@@ -2182,14 +2275,11 @@ void multiprocess_threaded(TestContext& test_context, std::string path, size_t n
 void multiprocess_validate_and_clear(TestContext& test_context, std::string path, std::string lock_path, size_t rows,
                                      int result)
 {
-    // Wait for async_commit process to shutdown
-    // FIXME: this is not apropriate
     static_cast<void>(lock_path);
-    millisleep(1000);
 
     // Verify - once more, in sync mode - that the changes were made
     {
-        SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+        SharedGroup sg(path);
         WriteTransaction wt(sg);
         wt.get_group().verify();
         auto t = wt.get_table("test");
@@ -2226,9 +2316,6 @@ TEST_IF(Shared_AsyncMultiprocess, allow_async)
     SHARED_GROUP_TEST_PATH(path);
     SHARED_GROUP_TEST_PATH(alone_path);
 
-    // wait for any daemon hanging around to exit
-    millisleep(1); // FIXME: Is this really acceptable?
-
 #if TEST_DURATION < 1
     multiprocess_make_table(path, path.get_lock_path(), alone_path, 4);
 
@@ -2472,6 +2559,323 @@ TEST_IF(Shared_WaitForChange, !running_with_valgrind)
 }
 
 
+#if !defined(_WIN32) && !REALM_TVOS
+
+TEST(Shared_CommitNotificationFd)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroup sg(path, false);
+    SharedGroup sg_w(path, false);
+    int fd = sg.get_commit_notification_fd();
+    CHECK_EQUAL(fd, sg.get_commit_notification_fd());
+
+    auto is_readable = [&] {
+        pollfd pfd = {fd, POLLIN, 0};
+        return ::poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN) != 0;
+    };
+    CHECK_NOT(is_readable());
+
+    // Commits of other SharedGroups and of the listening one itself are reported
+    for (int i = 0; i < 3; ++i) {
+        SharedGroup& writer = i == 1 ? sg : sg_w;
+        writer.begin_write();
+        writer.commit();
+        CHECK(is_readable());
+        sg.clear_commit_notifications();
+        CHECK_NOT(is_readable());
+    }
+
+    // Several commits may be collapsed into one notification
+    for (int i = 0; i < 10; ++i) {
+        sg_w.begin_write();
+        sg_w.commit();
+    }
+    CHECK(is_readable());
+    sg.clear_commit_notifications();
+    CHECK_NOT(is_readable());
+
+    // Listeners of a closed SharedGroup are not notified anymore, and its pipe is removed
+    {
+        SharedGroup sg_2(path, false);
+        sg_2.get_commit_notification_fd();
+        sg_2.close();
+    }
+    sg_w.begin_write();
+    sg_w.commit();
+    CHECK(is_readable());
+    sg.clear_commit_notifications();
+    std::string dir = std::string(path) + ".management/commit_listeners";
+    auto count_files = [&] {
+        size_t num_files = 0;
+        util::DirScanner scanner(dir);
+        std::string name;
+        while (scanner.next(name))
+            ++num_files;
+        return num_files;
+    };
+    CHECK_EQUAL(2, count_files()); // The pipe and its lock file
+
+    // A pipe is removed once the lock on its lock file can be taken, whatever
+    // the process ID in its name, which may belong to an unrelated process, or
+    // to none at all in the PID namespace of this process
+    util::create_fifo(dir + "/listener.1.1");
+    File(dir + "/listener.1.1.lock", File::mode_Write);
+    util::create_fifo(dir + "/listener.999999999.1");
+    File live_lock_file(dir + "/listener.999999999.1.lock", File::mode_Write);
+    live_lock_file.lock_exclusive();
+    int live_fd = ::open((dir + "/listener.999999999.1").c_str(), O_RDWR | O_NONBLOCK);
+    CHECK_NOT_EQUAL(-1, live_fd);
+    sg_w.begin_write();
+    sg_w.commit();
+    CHECK(is_readable());
+    sg.clear_commit_notifications();
+    CHECK_NOT(File::exists(dir + "/listener.1.1"));
+    CHECK_NOT(File::exists(dir + "/listener.1.1.lock"));
+    CHECK(File::exists(dir + "/listener.999999999.1"));
+    pollfd pfd = {live_fd, POLLIN, 0};
+    CHECK_EQUAL(1, ::poll(&pfd, 1, 0));
+    ::close(live_fd);
+    live_lock_file.close();
+    sg_w.begin_write();
+    sg_w.commit();
+    CHECK_EQUAL(2, count_files());
+}
+
+#endif // !defined(_WIN32) && !REALM_TVOS
+
+
+TEST(Shared_BackgroundFileGrowth)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::string value(100, 'x');
+    {
+        SharedGroupOptions options(crypt_key());
+        options.background_file_growth = true;
+        SharedGroup sg(path, false, options);
+        for (int i = 0; i < 5; ++i) {
+            WriteTransaction wt(sg);
+            TableRef table = wt.get_or_add_table("table");
+            if (table->get_column_count() == 0)
+                table->add_column(type_String, "s");
+            size_t begin = table->add_empty_row(1000);
+            for (size_t j = 0; j < 1000; ++j)
+                table->set_string(0, begin + j, value);
+            wt.commit();
+        }
+
+        // The file is extended beyond its logical size ahead of the next commit
+        size_t free_space, used_space;
+        sg.get_stats(free_space, used_space);
+        util::File file(path);
+        file.set_encryption_key(crypt_key());
+        bool grown = false;
+        for (int i = 0; i < 1000 && !grown; ++i) {
+            grown = size_t(file.get_size()) > free_space + used_space;
+            if (!grown)
+                millisleep(10);
+        }
+        CHECK(grown);
+
+        // Commits use the space which has been added ahead of time
+        for (int i = 0; i < 5; ++i) {
+            WriteTransaction wt(sg);
+            TableRef table = wt.get_table("table");
+            size_t begin = table->add_empty_row(1000);
+            for (size_t j = 0; j < 1000; ++j)
+                table->set_string(0, begin + j, value);
+            wt.commit();
+        }
+    }
+
+    SharedGroup sg(path, true, SharedGroupOptions(crypt_key()));
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    ConstTableRef table = rt.get_table("table");
+    CHECK_EQUAL(10000, table->size());
+    CHECK_EQUAL(value, table->get_string(0, 9999));
+}
+
+
+// Commits which write to many places of a fragmented file reuse the memory
+// mappings of the previous commits
+TEST(Shared_ScatteredCommits)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    const size_t num_tables = 40;
+    {
+        SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+        {
+            WriteTransaction wt(sg);
+            for (size_t i = 0; i < num_tables; ++i) {
+                std::string name = "table_" + util::to_string(i);
+                TableRef table = wt.add_table(name);
+                table->add_column(type_Int, "i");
+                table->add_column(type_String, "s");
+                table->add_empty_row(2000);
+            }
+            wt.commit();
+        }
+        SharedGroup sg_r(path, false, SharedGroupOptions(crypt_key()));
+        Random random(random_int<unsigned long>()); // Seed from slow global generator
+        for (int64_t commit = 1; commit <= 30; ++commit) {
+            // Keep a reader alive for a while, so that freed space is
+            // interleaved with live data
+            ReadTransaction rt(sg_r);
+            WriteTransaction wt(sg);
+            for (size_t i = 0; i < num_tables; ++i) {
+                TableRef table = wt.get_table(i);
+                size_t row = random.draw_int_mod(table->size());
+                table->set_int(0, row, commit);
+                std::string value(size_t(commit * 10), 'x');
+                table->set_string(1, row, value);
+                table->set_int(0, 0, commit);
+            }
+            wt.commit();
+        }
+    }
+
+    SharedGroup sg(path, true, SharedGroupOptions(crypt_key()));
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    for (size_t i = 0; i < num_tables; ++i)
+        CHECK_EQUAL(30, rt.get_table(i)->get_int(0, 0));
+}
+
+
+// Commits written with pwrite() are seen by sessions using memory mappings,
+// and the other way around
+TEST(Shared_PwriteBackend)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::string blob(300 * 1024, 'b'); // Larger than the blocks of the write buffer
+    {
+        SharedGroupOptions options(crypt_key());
+        options.write_backend = SharedGroupOptions::WriteBackend::Pwrite;
+        SharedGroup sg_p(path, false, options);
+        SharedGroup sg_m(path, false, SharedGroupOptions(crypt_key()));
+        {
+            WriteTransaction wt(sg_p);
+            TableRef table = wt.add_table("table");
+            table->add_column(type_Int, "i");
+            table->add_column(type_String, "s");
+            table->add_column(type_Binary, "b");
+            wt.commit();
+        }
+        Random random(random_int<unsigned long>()); // Seed from slow global generator
+        for (int64_t commit = 1; commit <= 20; ++commit) {
+            SharedGroup& sg = commit % 2 == 0 ? sg_m : sg_p;
+            {
+                WriteTransaction wt(sg);
+                TableRef table = wt.get_table("table");
+                size_t begin = table->add_empty_row(500);
+                for (size_t j = 0; j < table->size(); j += 1 + random.draw_int_mod(20))
+                    table->set_int(0, j, commit);
+                std::string value(size_t(commit), 's');
+                table->set_string(1, begin, value);
+                table->set_binary(2, begin, BinaryData(blob.data(), blob.size()));
+                wt.commit();
+            }
+            SharedGroup& other = commit % 2 == 0 ? sg_p : sg_m;
+            ReadTransaction rt(other);
+            rt.get_group().verify();
+            ConstTableRef table = rt.get_table("table");
+            CHECK_EQUAL(commit * 500, table->size());
+            CHECK_EQUAL(commit, table->get_int(0, 0));
+            CHECK_EQUAL(commit, table->get_string(1, size_t(commit - 1) * 500).size());
+            CHECK_EQUAL(blob.size(), table->get_binary(2, size_t(commit - 1) * 500).size());
+        }
+    }
+
+    SharedGroup sg(path, true, SharedGroupOptions(crypt_key()));
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    ConstTableRef table = rt.get_table("table");
+    CHECK_EQUAL(10000, table->size());
+    CHECK_EQUAL(20, table->get_int(0, 0));
+    CHECK_EQUAL(20, table->get_string(1, 9500).size());
+}
+
+
+// The memory policy is only a hint, so it works everywhere, and sessions with
+// different policies can share the file
+TEST(Shared_MemoryPolicy)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(crypt_key());
+    options.memory_policy.huge_pages = util::MemoryPolicy::HugePages::Transparent;
+    options.memory_policy.numa = util::MemoryPolicy::Numa::Interleave;
+    SharedGroup sg(path, false, options);
+    SharedGroup sg_2(path, false, SharedGroupOptions(crypt_key()));
+    for (int i = 0; i < 5; ++i) {
+        {
+            WriteTransaction wt(sg);
+            TableRef table = wt.get_or_add_table("table");
+            if (table->get_column_count() == 0)
+                table->add_column(type_Int, "i");
+            size_t begin = table->add_empty_row(100000);
+            for (size_t j = begin; j < table->size(); ++j)
+                table->set_int(0, j, int64_t(j));
+            wt.commit();
+        }
+        {
+            WriteTransaction wt(sg_2);
+            TableRef table = wt.get_table("table");
+            table->set_int(0, 0, i + 1);
+            wt.commit();
+        }
+    }
+
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    ConstTableRef table = rt.get_table("table");
+    CHECK_EQUAL(500000, table->size());
+    CHECK_EQUAL(5, table->get_int(0, 0));
+    CHECK_EQUAL(499999, table->get_int(0, 499999));
+    CHECK_EQUAL(0, table->where().less(0, 0).count());
+}
+
+
+TEST(Shared_ScanPrefetch)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(path_2);
+    SharedGroupOptions options(crypt_key());
+    options.memory_policy.file_access = util::MemoryPolicy::FileAccess::Random;
+    SharedGroup sg(path, false, options);
+    // Spans more than one window, in whole thousands of rows
+    const size_t num_thousands = 3 * _impl::ScanPrefetcher::window_size / 2 / 1000 + 1;
+    const size_t num_rows = num_thousands * 1000;
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("table");
+        table->add_column(type_Int, "i");
+        table->add_column(type_String, "s");
+        table->add_empty_row(num_rows);
+        for (size_t i = 0; i < num_rows; ++i) {
+            table->set_int(0, i, int64_t(i % 1000));
+            if (i % 1000 == 0)
+                table->set_string(1, i, "x");
+        }
+        wt.commit();
+    }
+
+    ReadTransaction rt(sg);
+    ConstTableRef table = rt.get_table("table");
+    // Fused conditions
+    CHECK_EQUAL(num_thousands * 10, table->where().greater_equal(0, 10).less(0, 20).count());
+    CHECK_EQUAL(5, table->where().greater_equal(0, 10).less(0, 20).find_all(0, size_t(-1), 5).size());
+    CHECK_EQUAL(num_thousands * 145, table->where().greater_equal(0, 10).less(0, 20).sum_int(0));
+    // Conditions evaluated one at a time
+    CHECK_EQUAL(num_thousands, table->where().equal(1, "x").count());
+    CHECK_EQUAL(0, table->where().equal(1, "x").sum_int(0));
+    CHECK_EQUAL(num_thousands - 1, table->where().equal(1, "x").count(1));
+
+    rt.get_group().write(path_2, crypt_key());
+    Group group(path_2, crypt_key());
+    CHECK(*table == *group.get_table("table"));
+}
+
+
 TEST(Shared_MultipleSharersOfStreamingFormat)
 {
     SHARED_GROUP_TEST_PATH(path);
@@ -3183,6 +3587,278 @@ TEST(Shared_CompactEmpty)
 }
 
 
+TEST(Shared_Backup)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(path_old);
+    SHARED_GROUP_TEST_PATH(path_latest);
+    SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+    SharedGroup sg_w(path, false, SharedGroupOptions(crypt_key()));
+    const size_t num_rows = 10 * REALM_MAX_BPNODE_SIZE;
+    {
+        WriteTransaction wt(sg_w);
+        TableRef t = wt.add_table("test");
+        t->add_column(type_Int, "i");
+        t->add_column(type_String, "s");
+        t->add_empty_row(num_rows);
+        for (size_t i = 0; i < num_rows; ++i) {
+            t->set_int(0, i, i);
+            t->set_string(1, i, "old");
+        }
+        wt.commit();
+    }
+
+    // Keep the version of the first backup bound while later commits leave
+    // free space behind
+    SharedGroup::VersionID old_version;
+    SharedGroup::VersionID pinned_version;
+    {
+        ReadTransaction rt(sg);
+        old_version = sg.get_version_of_current_transaction();
+        pinned_version = sg.pin_version();
+    }
+    for (int i = 0; i < 3; ++i) {
+        WriteTransaction wt(sg_w);
+        TableRef t = wt.get_table("test");
+        for (size_t j = 0; j < num_rows; j += 7)
+            t->set_string(1, j, "new");
+        t->add_empty_row();
+        wt.commit();
+    }
+
+    // Writers are not blocked by a backup in progress
+    sg_w.begin_write();
+    sg.backup(path_old, old_version);
+    sg_w.rollback();
+    sg.unpin_version(pinned_version);
+    sg.backup(path_latest);
+
+    CHECK_THROW(sg.backup(path_latest), File::Exists);
+    {
+        ReadTransaction rt(sg);
+        CHECK_LOGIC_ERROR(sg.backup(path_old), LogicError::wrong_transact_state);
+    }
+
+    {
+        SharedGroup sg_old(path_old, true, SharedGroupOptions(crypt_key()));
+        ReadTransaction rt(sg_old);
+        rt.get_group().verify();
+        ConstTableRef t = rt.get_table("test");
+        CHECK_EQUAL(num_rows, t->size());
+        CHECK_EQUAL(num_rows - 1, t->get_int(0, num_rows - 1));
+        CHECK_EQUAL("old", t->get_string(1, 0));
+    }
+    {
+        SharedGroup sg_latest(path_latest, true, SharedGroupOptions(crypt_key()));
+        WriteTransaction wt(sg_latest);
+        wt.get_group().verify();
+        TableRef t = wt.get_table("test");
+        CHECK_EQUAL(num_rows + 3, t->size());
+        CHECK_EQUAL("new", t->get_string(1, 0));
+        CHECK_EQUAL("old", t->get_string(1, 1));
+        // The copy is a database file like any other
+        t->add_empty_row();
+        wt.commit();
+    }
+}
+
+
+TEST(Shared_IncrementalBackup)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(path_copy);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    std::unique_ptr<Replication> hist_w(make_in_realm_history(path));
+    SharedGroup sg(*hist, SharedGroupOptions(crypt_key()));
+    SharedGroup sg_w(*hist_w, SharedGroupOptions(crypt_key()));
+    {
+        WriteTransaction wt(sg_w);
+        TableRef t = wt.add_table("test");
+        t->add_column(type_Int, "i");
+        t->add_empty_row(10);
+        wt.commit();
+    }
+
+    // A full backup of a pinned version
+    SharedGroup::VersionID base_version;
+    {
+        ReadTransaction rt(sg);
+        base_version = sg.pin_version();
+    }
+    sg.backup(path_copy, base_version);
+
+    auto modify = [&](int value) {
+        for (size_t i = 0; i < 10; ++i) {
+            WriteTransaction wt(sg_w);
+            TableRef t = wt.get_table("test");
+            t->set_int(0, i, value);
+            if (i == 0)
+                t->add_empty_row();
+            wt.commit();
+        }
+    };
+
+    // Two increments on top of it
+    modify(1);
+    std::stringstream increment_1;
+    SharedGroup::VersionID version_1 = sg.backup_changes(base_version, increment_1);
+    sg.unpin_version(base_version);
+    modify(2);
+    std::stringstream increment_2;
+    SharedGroup::VersionID version_2 = sg.backup_changes(version_1, increment_2);
+    sg.unpin_version(version_1);
+    sg.unpin_version(version_2);
+    CHECK_EQUAL(base_version.version + 10, version_1.version);
+    CHECK_EQUAL(version_1.version + 10, version_2.version);
+    {
+        ReadTransaction rt(sg);
+        CHECK_LOGIC_ERROR(sg.backup_changes(version_2, increment_2), LogicError::wrong_transact_state);
+    }
+
+    std::unique_ptr<Replication> hist_copy(make_in_realm_history(path_copy));
+    SharedGroup sg_copy(*hist_copy, SharedGroupOptions(crypt_key()));
+    // Increments must be applied in order
+    CHECK_THROW(SharedGroup::restore_changes(increment_2, sg_copy), std::runtime_error);
+    increment_2.seekg(0);
+    CHECK_EQUAL(version_1.version, SharedGroup::restore_changes(increment_1, sg_copy));
+    {
+        ReadTransaction rt(sg_copy);
+        CHECK_EQUAL(11, rt.get_table("test")->size());
+        CHECK_EQUAL(1, rt.get_table("test")->get_int(0, 9));
+    }
+    CHECK_EQUAL(version_2.version, SharedGroup::restore_changes(increment_2, sg_copy));
+    {
+        ReadTransaction rt(sg_copy);
+        rt.get_group().verify();
+        ReadTransaction rt_2(sg);
+        CHECK(rt.get_group() == rt_2.get_group());
+        CHECK_EQUAL(12, rt.get_table("test")->size());
+    }
+
+    std::stringstream not_a_backup("not a backup");
+    CHECK_THROW(SharedGroup::restore_changes(not_a_backup, sg_copy), std::runtime_error);
+
+    // The changesets are taken from the history
+    SHARED_GROUP_TEST_PATH(path_no_hist);
+    SharedGroup sg_no_hist(path_no_hist, false, SharedGroupOptions(crypt_key()));
+    std::stringstream increment_3;
+    CHECK_LOGIC_ERROR(sg_no_hist.backup_changes(SharedGroup::VersionID(), increment_3), LogicError::no_history);
+}
+
+
+TEST(Shared_RetentionPolicy)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    std::unique_ptr<Replication> hist_w(make_in_realm_history(path));
+    std::vector<SharedGroup::VersionStats> lagging;
+    SharedGroupOptions options(crypt_key());
+    options.retention_policy.max_versions = 5;
+    options.retention_policy.on_lagging_readers = [&](const std::vector<SharedGroup::VersionStats>& versions) {
+        lagging = versions;
+    };
+    SharedGroup sg(*hist, SharedGroupOptions(crypt_key()));
+    SharedGroup sg_w(*hist_w, options);
+    {
+        WriteTransaction wt(sg_w);
+        TableRef t = wt.add_table("test");
+        t->add_column(type_Int, "i");
+        t->add_empty_row(1000);
+        wt.commit();
+    }
+    auto modify = [&](int value) {
+        WriteTransaction wt(sg_w);
+        TableRef t = wt.get_table("test");
+        for (size_t i = 0; i < 1000; ++i)
+            t->set_int(0, i, value);
+        wt.commit();
+    };
+
+    // The space released while a reader stays behind is locked by it
+    const Group& group = sg.begin_read();
+    SharedGroup::version_type version = sg.get_version_of_current_transaction().version;
+    modify(1);
+    {
+        std::vector<SharedGroup::VersionStats> versions = sg_w.get_version_stats();
+        CHECK_EQUAL(2, versions.size());
+        CHECK_EQUAL(version, versions[0].version);
+        CHECK_EQUAL(1, versions[0].num_readers);
+        CHECK_GREATER(versions[0].locked_space, 0);
+        CHECK_NOT(versions[0].invalidated);
+        CHECK_EQUAL(version + 1, versions[1].version);
+        CHECK_EQUAL(0, versions[1].num_readers);
+        CHECK_EQUAL(0, versions[1].locked_space);
+        CHECK_EQUAL(0, versions[1].age.count());
+    }
+
+    // Lagging readers are reported once the limit is exceeded
+    for (int i = 2; i <= 4; ++i)
+        modify(i);
+    CHECK(lagging.empty());
+    modify(5);
+    CHECK_EQUAL(1, lagging.size());
+    CHECK_EQUAL(version, lagging[0].version);
+    CHECK_NOT(lagging[0].invalidated);
+    LangBindHelper::advance_read(sg);
+    CHECK_EQUAL(5, group.get_table("test")->get_int(0, 0));
+
+    // ... and invalidated if requested
+    options.retention_policy.invalidate_lagging_readers = true;
+    sg_w.close();
+    sg_w.open(*hist_w, options);
+    SharedGroup::VersionID pinned = sg.pin_version();
+    lagging.clear();
+    for (int i = 6; i <= 10; ++i)
+        modify(i);
+    CHECK_EQUAL(1, lagging.size());
+    CHECK_EQUAL(pinned.version, lagging[0].version);
+    CHECK_EQUAL(2, lagging[0].num_readers);
+    CHECK(lagging[0].invalidated);
+    CHECK(sg_w.get_version_stats()[0].invalidated);
+
+    // The snapshot can still be read, but not left other than by ending the
+    // transaction
+    CHECK_EQUAL(5, group.get_table("test")->get_int(0, 0));
+    CHECK_THROW(LangBindHelper::advance_read(sg), SharedGroup::BadVersion);
+    CHECK_THROW(LangBindHelper::promote_to_write(sg), SharedGroup::BadVersion);
+    CHECK_EQUAL(SharedGroup::transact_Reading, sg.get_transact_stage());
+    sg.end_read();
+    CHECK_THROW(sg.begin_read(pinned), SharedGroup::BadVersion);
+    sg.unpin_version(pinned);
+
+    // The history is trimmed past the invalidated snapshot
+    modify(11);
+    {
+        ReadTransaction rt(sg);
+        CHECK_EQUAL(11, rt.get_table("test")->get_int(0, 999));
+    }
+    sg.begin_read();
+    modify(12);
+    LangBindHelper::advance_read(sg);
+    CHECK_EQUAL(12, group.get_table("test")->get_int(0, 0));
+    group.verify();
+    sg.end_read();
+    CHECK_EQUAL(1, sg_w.get_version_stats().size());
+
+    // The commit has succeeded even if the callback throws
+    options.retention_policy.invalidate_lagging_readers = false;
+    options.retention_policy.on_lagging_readers = [&](const std::vector<SharedGroup::VersionStats>&) {
+        throw std::runtime_error("on_lagging_readers");
+    };
+    sg_w.close();
+    sg_w.open(*hist_w, options);
+    sg.begin_read();
+    for (int i = 13; i <= 17; ++i)
+        modify(i);
+    CHECK_EQUAL(1, sg_w.get_version_stats()[0].num_readers);
+    sg.end_read();
+    {
+        ReadTransaction rt(sg);
+        CHECK_EQUAL(17, rt.get_table("test")->get_int(0, 0));
+    }
+}
+
+
 TEST(Shared_VersionOfBoundSnapshot)
 {
     SHARED_GROUP_TEST_PATH(path);
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <iterator>
 #include <limits>
 #include <string>
 #include <fstream>
@@ -6259,6 +6260,57 @@ TEST(Table_RowAccessor_DetachedRowExpr)
 }
 
 
+TEST(Table_RowIterator)
+{
+    Table table;
+    table.add_column(type_Int, "int");
+    table.add_column(type_String, "string", true);
+    CHECK(table.begin() == table.end());
+
+    table.add_empty_row(10);
+    for (size_t i = 0; i < 10; ++i) {
+        table.set_int(0, i, int64_t(i));
+        if (i % 2 == 0)
+            table.set_string(1, i, "even");
+    }
+
+    int64_t sum = 0;
+    size_t ndx = 0;
+    for (auto row : table) {
+        CHECK_EQUAL(ndx, row.get_index());
+        CHECK_EQUAL(&table, row.get_table());
+        sum += row.get_int(0);
+        CHECK_EQUAL(ndx % 2 != 0, row.is_null(1));
+        ++ndx;
+    }
+    CHECK_EQUAL(10, ndx);
+    CHECK_EQUAL(45, sum);
+
+    // Setters are available through non-const iterators
+    for (auto it = table.begin(); it != table.end(); ++it)
+        (*it).set_int(0, int64_t(it.get_index()) * 2);
+
+    const Table& const_table = table;
+    Table::const_iterator it = const_table.begin();
+    CHECK_EQUAL(0, (*it++).get_int(0));
+    CHECK_EQUAL(1, it.get_index());
+    CHECK_EQUAL(2, (*it).get_int(0));
+    CHECK_EQUAL(10, std::distance(const_table.begin(), const_table.end()));
+
+    TableView view = table.where().not_equal(1, StringData()).find_all();
+    std::vector<size_t> rows;
+    for (auto row : view)
+        rows.push_back(row.get_index());
+    CHECK(rows == std::vector<size_t>({0, 2, 4, 6, 8}));
+
+    ConstTableView const_view = view;
+    sum = 0;
+    for (auto row : const_view)
+        sum += row.get_int(0);
+    CHECK_EQUAL(40, sum);
+}
+
+
 TEST(Table_RowAccessorCopyAndAssign)
 {
     Table table;
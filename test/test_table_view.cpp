@@ -19,8 +19,11 @@
 #include "testsettings.hpp"
 #ifdef TEST_TABLE_VIEW
 
+#include <algorithm>
 #include <limits>
+#include <set>
 #include <string>
+#include <vector>
 #include <sstream>
 #include <ostream>
 #include <cwchar>
@@ -931,6 +934,93 @@ TEST(TableView_SortNullString)
     CHECK(!tv.get_string(0, 3).is_null());
 }
 
+NONCONCURRENT_TEST(TableView_SortStringPrefixes)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+
+    // Includes characters with equal prefixes, upper and lower case, an
+    // embedded zero and a multi-byte character, so that orderings are decided
+    // both inside and beyond the inline prefixes used while sorting
+    const char* pieces[] = {"a", "A", "b", "B", "ab", "abcdefg", "" /* zero */, "\xc3\xa9", " ", "z"};
+    std::vector<std::string> storage;
+    std::vector<bool> nulls;
+
+    Group group;
+    Table& target = *group.add_table("target");
+    target.add_column(type_String, "s", true);
+    Table& origin = *group.add_table("origin");
+    origin.add_column_link(type_Link, "link", target);
+
+    const size_t num_rows = 500;
+    target.add_empty_row(num_rows);
+    origin.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        bool is_null = random.chance(1, 20);
+        std::string str;
+        size_t num_pieces = random.draw_int_mod(size_t(5));
+        for (size_t j = 0; j < num_pieces; ++j) {
+            size_t piece = random.draw_int_mod(sizeof pieces / sizeof pieces[0]);
+            str += piece == 6 ? std::string(1, '\0') : std::string(pieces[piece]);
+        }
+        storage.push_back(str);
+        nulls.push_back(is_null);
+        target.set_string(0, i, is_null ? StringData() : StringData(storage.back()));
+        origin.set_link(0, num_rows - 1 - i, i);
+    }
+
+    auto check = [&](bool ascending) {
+        auto value = [&](size_t i) { return nulls[i] ? StringData() : StringData(storage[i]); };
+        std::vector<size_t> expected(num_rows);
+        for (size_t i = 0; i < num_rows; ++i)
+            expected[i] = i;
+        std::stable_sort(expected.begin(), expected.end(), [&](size_t i, size_t j) {
+            StringData a = value(i), b = value(j);
+            if (a.is_null() || b.is_null())
+                return ascending ? a.is_null() && !b.is_null() : b.is_null() && !a.is_null();
+            if (a == b)
+                return false;
+            return ascending ? utf8_compare(a, b) : utf8_compare(b, a);
+        });
+
+        TableView tv = target.where().find_all();
+        tv.sort(0, ascending);
+        for (size_t i = 0; i < num_rows; ++i)
+            CHECK_EQUAL(expected[i], tv.get_source_ndx(i));
+
+        // Through a link, where equal strings are ordered by origin row instead
+        TableView tv_2 = origin.where().find_all();
+        tv_2.sort(SortDescriptor(origin, {{0, 0}}, {ascending}));
+        for (size_t i = 0; i < num_rows; ++i) {
+            StringData str = target.get_string(0, origin.get_link(0, tv_2.get_source_ndx(i)));
+            CHECK_EQUAL(value(expected[i]).is_null(), str.is_null());
+            CHECK(value(expected[i]) == str);
+        }
+    };
+
+    for (auto method : {STRING_COMPARE_CORE, STRING_COMPARE_CORE_SIMILAR}) {
+        set_string_compare_method(method, nullptr);
+        check(true);
+        check(false);
+    }
+
+    // Enumerated strings
+    set_string_compare_method(STRING_COMPARE_CORE, nullptr);
+    target.optimize(true);
+    check(true);
+
+    TableView tv = target.where().find_all();
+    tv.distinct(0);
+    std::set<std::string> distinct;
+    size_t num_nulls = 0;
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (nulls[i])
+            num_nulls = 1;
+        else
+            distinct.insert(storage[i]);
+    }
+    CHECK_EQUAL(distinct.size() + num_nulls, tv.size());
+}
+
 TEST(TableView_Delete)
 {
     TestTable table;
@@ -0,0 +1,365 @@
+/*************************************************************************
+ *
+ * Copyright 2018 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_ZONE_MAP
+
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include <realm.hpp>
+#include <realm/zone_map.hpp>
+
+#include "test.hpp"
+
+using namespace realm;
+using namespace realm::test_util;
+
+
+// Test independence and thread-safety
+// -----------------------------------
+//
+// All tests must be thread safe and independent of each other. This
+// is required because it allows for both shuffling of the execution
+// order and for parallelized testing.
+//
+// In particular, avoid using std::rand() since it is not guaranteed
+// to be thread safe. Instead use the API offered in
+// `test/util/random.hpp`.
+//
+// All files created in tests must use the TEST_PATH macro (or one of
+// its friends) to obtain a suitable file system path. See
+// `test/util/test_path.hpp`.
+//
+//
+// Debugging and the ONLY() macro
+// ------------------------------
+//
+// A simple way of disabling all tests except one called `Foo`, is to
+// replace TEST(Foo) with ONLY(Foo) and then recompile and rerun the
+// test suite. Note that you can also use filtering by setting the
+// environment varible `UNITTEST_FILTER`. See `README.md` for more on
+// this.
+//
+// Another way to debug a particular test, is to copy that test into
+// `experiments/testcase.cpp` and then run `sh build.sh
+// check-testcase` (or one of its friends) from the command line.
+
+
+namespace {
+
+const size_t num_rows = 5 * REALM_MAX_BPNODE_SIZE + 17;
+
+template <class Cond>
+size_t brute_force_count(const Table& table, size_t col_ndx, int64_t needle)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (!table.is_null(col_ndx, i) && Cond()(table.get_int(col_ndx, i), needle))
+            ++count;
+    }
+    return count;
+}
+
+} // anonymous namespace
+
+
+TEST(ZoneMap_Summaries)
+{
+    Table table;
+    table.add_column(type_Int, "int");
+    table.add_column(type_Int, "int_null", true);
+    table.add_column(type_String, "string");
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        table.set_int(0, i, int64_t(i) * 3 - 1000);
+        if (i % 7 == 0)
+            table.set_null(1, i);
+        else
+            table.set_int(1, i, int64_t(i % 1000));
+    }
+
+    const ZoneMap<int64_t>* zone_map = table.get_zone_map<int64_t>(0);
+    CHECK(zone_map);
+    CHECK(!table.get_zone_map<int64_t>(2));
+    CHECK(!table.get_zone_map<double>(0));
+    if (!zone_map)
+        return;
+    CHECK_GREATER(zone_map->leaves().size(), 1);
+
+    for (size_t col_ndx = 0; col_ndx < 2; ++col_ndx) {
+        const ZoneMap<int64_t>* zm = table.get_zone_map<int64_t>(col_ndx);
+        size_t expected_begin = 0;
+        for (const LeafSummary<int64_t>& s : zm->leaves()) {
+            CHECK_EQUAL(s.begin, expected_begin);
+            CHECK_LESS(s.begin, s.end);
+            size_t null_count = 0;
+            int64_t min = std::numeric_limits<int64_t>::max();
+            int64_t max = std::numeric_limits<int64_t>::min();
+            for (size_t i = s.begin; i < s.end; ++i) {
+                if (table.is_null(col_ndx, i)) {
+                    ++null_count;
+                    continue;
+                }
+                min = std::min(min, table.get_int(col_ndx, i));
+                max = std::max(max, table.get_int(col_ndx, i));
+            }
+            CHECK_EQUAL(s.null_count, null_count);
+            CHECK_EQUAL(s.min, min);
+            CHECK_EQUAL(s.max, max);
+            CHECK_EQUAL(zm->find(s.begin), &s);
+            CHECK_EQUAL(zm->find(s.end - 1), &s);
+            expected_begin = s.end;
+        }
+        CHECK_EQUAL(expected_begin, num_rows);
+        CHECK(!zm->find(num_rows));
+    }
+
+    // A table which fits in a single leaf has nothing to skip
+    Table small;
+    small.add_column(type_Int, "int");
+    small.add_empty_row(10);
+    CHECK(!small.get_zone_map<int64_t>(0));
+}
+
+
+TEST(ZoneMap_IntegerQueries)
+{
+    Table table;
+    table.add_column(type_Int, "clustered");
+    table.add_column(type_Int, "clustered_null", true);
+    table.add_column(type_Int, "random");
+    table.add_empty_row(num_rows);
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    for (size_t i = 0; i < num_rows; ++i) {
+        table.set_int(0, i, int64_t(i / 100));
+        if (i % 3000 < 1500)
+            table.set_null(1, i);
+        else
+            table.set_int(1, i, int64_t(i));
+        table.set_int(2, i, random.draw_int<int64_t>(0, 999));
+    }
+
+    const int64_t needles[] = {-1, 0, 7, 25, 26, 49, 50, 51, int64_t(num_rows / 100), int64_t(num_rows)};
+    for (int64_t needle : needles) {
+        for (size_t col_ndx = 0; col_ndx < 3; ++col_ndx) {
+            CHECK_EQUAL(table.where().equal(col_ndx, needle).count(),
+                        brute_force_count<Equal>(table, col_ndx, needle));
+            // Null is not equal to any value
+            size_t nulls = col_ndx == 1 ? table.where().equal(col_ndx, null()).count() : 0;
+            CHECK_EQUAL(table.where().not_equal(col_ndx, needle).count() - nulls,
+                        brute_force_count<NotEqual>(table, col_ndx, needle));
+            CHECK_EQUAL(table.where().greater(col_ndx, needle).count(),
+                        brute_force_count<Greater>(table, col_ndx, needle));
+            CHECK_EQUAL(table.where().greater_equal(col_ndx, needle).count(),
+                        brute_force_count<GreaterEqual>(table, col_ndx, needle));
+            CHECK_EQUAL(table.where().less(col_ndx, needle).count(),
+                        brute_force_count<Less>(table, col_ndx, needle));
+            CHECK_EQUAL(table.where().less_equal(col_ndx, needle).count(),
+                        brute_force_count<LessEqual>(table, col_ndx, needle));
+            CHECK_EQUAL(table.where().between(col_ndx, needle, needle + 30).find_all().size(),
+                        brute_force_count<GreaterEqual>(table, col_ndx, needle) -
+                            brute_force_count<Greater>(table, col_ndx, needle + 30));
+        }
+
+        // Aggregates driven by the condition column
+        int64_t sum = 0;
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (table.get_int(0, i) > needle)
+                sum += table.get_int(2, i);
+        }
+        CHECK_EQUAL(table.where().greater(0, needle).sum_int(2), sum);
+    }
+
+    // Null needles
+    size_t nulls = 0;
+    for (size_t i = 0; i < num_rows; ++i)
+        nulls += table.is_null(1, i);
+    CHECK_EQUAL(table.where().equal(1, null()).count(), nulls);
+    CHECK_EQUAL(table.where().not_equal(1, null()).count(), num_rows - nulls);
+
+    // The first match must not be affected by skipping
+    CHECK_EQUAL(table.where().greater(0, 25).find(), 2600);
+    CHECK_EQUAL(table.where().greater(1, 0).find(), 1500);
+    CHECK_EQUAL(table.where().greater(0, 25).find(2601), 2601);
+    CHECK_EQUAL(table.where().less(0, 3).find(150), 150);
+    CHECK_EQUAL(table.where().less(0, 3).find(300), not_found);
+}
+
+
+TEST(ZoneMap_FloatDoubleQueries)
+{
+    Table table;
+    table.add_column(type_Float, "float", true);
+    table.add_column(type_Double, "double", true);
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (i % 1000 == 5) {
+            table.set_null(0, i);
+            table.set_null(1, i);
+        }
+        else {
+            table.set_float(0, i, float(i / 100));
+            table.set_double(1, i, double(i / 100));
+        }
+    }
+    // A NaN makes the range of its leaf unknown
+    table.set_double(1, 4321, std::numeric_limits<double>::quiet_NaN());
+
+    auto brute_force = [&](size_t col_ndx, auto cond, double needle) {
+        size_t count = 0;
+        for (size_t i = 0; i < num_rows; ++i) {
+            double value = col_ndx == 0 ? double(table.get_float(0, i)) : table.get_double(1, i);
+            if (cond(value, needle, table.is_null(col_ndx, i), false))
+                ++count;
+        }
+        return count;
+    };
+
+    for (double needle : {-1.0, 0.0, 12.0, 43.0, 44.5, 50.0, 1000.0}) {
+        float f = float(needle);
+        CHECK_EQUAL(table.where().equal(0, f).count(), brute_force(0, Equal(), needle));
+        CHECK_EQUAL(table.where().equal(1, needle).count(), brute_force(1, Equal(), needle));
+        CHECK_EQUAL(table.where().not_equal(1, needle).count(), brute_force(1, NotEqual(), needle));
+        CHECK_EQUAL(table.where().greater(0, f).count(), brute_force(0, Greater(), needle));
+        CHECK_EQUAL(table.where().greater(1, needle).count(), brute_force(1, Greater(), needle));
+        CHECK_EQUAL(table.where().less_equal(1, needle).count(), brute_force(1, LessEqual(), needle));
+        CHECK_EQUAL(table.where().greater(0, f).find(), table.where().greater(1, needle).find());
+    }
+
+    CHECK_EQUAL(table.minimum_float(0), 0.0f);
+    CHECK_EQUAL(table.maximum_float(0), float((num_rows - 1) / 100));
+    size_t ndx = npos;
+    CHECK_EQUAL(table.maximum_double(1, &ndx), double((num_rows - 1) / 100));
+    CHECK_EQUAL(ndx, (num_rows - 1) / 100 * 100);
+    CHECK_EQUAL(table.minimum_double(1, &ndx), 0.0);
+    CHECK_EQUAL(ndx, 0);
+}
+
+
+TEST(ZoneMap_TimestampQueries)
+{
+    Table table;
+    table.add_column(type_Timestamp, "ts", true);
+    table.add_empty_row(num_rows);
+    // Append-only style data: seconds ascend, with ties across leaf boundaries
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (i % 777 == 3)
+            table.set_null(0, i);
+        else
+            table.set_timestamp(0, i, Timestamp(int64_t(i / 10), int32_t(i % 10)));
+    }
+
+    auto brute_force = [&](Timestamp lo, Timestamp hi) {
+        size_t count = 0;
+        for (size_t i = 0; i < num_rows; ++i) {
+            Timestamp ts = table.get_timestamp(0, i);
+            if (!ts.is_null() && !(ts < lo) && ts < hi)
+                ++count;
+        }
+        return count;
+    };
+
+    for (int64_t seconds : {0, 99, 100, 250, 499, 500}) {
+        Timestamp lo(seconds, 5);
+        Timestamp hi(seconds + 3, 0);
+        CHECK_EQUAL(table.where().greater_equal(0, lo).less(0, hi).count(), brute_force(lo, hi));
+        CHECK_EQUAL(table.where().equal(0, lo).count(), brute_force(lo, Timestamp(seconds, 6)));
+        CHECK_EQUAL(table.where().greater(0, lo).count(),
+                    brute_force(Timestamp(seconds, 6), Timestamp(std::numeric_limits<int64_t>::max(), 0)));
+    }
+    CHECK_EQUAL(table.where().equal(0, Timestamp{}).count(), table.where().equal(0, null()).count());
+
+    size_t ndx = npos;
+    CHECK_EQUAL(table.maximum_timestamp(0, &ndx), Timestamp(int64_t((num_rows - 1) / 10), int32_t((num_rows - 1) % 10)));
+    CHECK_EQUAL(ndx, num_rows - 1);
+    CHECK_EQUAL(table.minimum_timestamp(0, &ndx), Timestamp(0, 0));
+    CHECK_EQUAL(ndx, 0);
+
+    // The smallest seconds occur in several leaves, and only the last of them has the smallest nanoseconds
+    table.set_timestamp(0, 1, Timestamp(-1, -2));
+    table.set_timestamp(0, 2 * REALM_MAX_BPNODE_SIZE, Timestamp(-1, -7));
+    CHECK_EQUAL(table.minimum_timestamp(0, &ndx), Timestamp(-1, -7));
+    CHECK_EQUAL(ndx, 2 * REALM_MAX_BPNODE_SIZE);
+}
+
+
+TEST(ZoneMap_InvalidatedByModification)
+{
+    Table table;
+    table.add_column(type_Int, "int");
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i)
+        table.set_int(0, i, int64_t(i));
+
+    CHECK_EQUAL(table.where().equal(0, -5).count(), 0);
+    CHECK_EQUAL(table.minimum_int(0), 0);
+    CHECK_EQUAL(table.maximum_int(0), int64_t(num_rows - 1));
+
+    // Values which were outside the range of their leaf must be found after the update
+    table.set_int(0, 3000, -5);
+    table.set_int(0, 10, 1000000);
+    CHECK_EQUAL(table.where().equal(0, -5).count(), 1);
+    CHECK_EQUAL(table.where().greater(0, int64_t(num_rows)).find(), 10);
+    size_t ndx = npos;
+    CHECK_EQUAL(table.minimum_int(0, &ndx), -5);
+    CHECK_EQUAL(ndx, 3000);
+    CHECK_EQUAL(table.maximum_int(0, &ndx), 1000000);
+    CHECK_EQUAL(ndx, 10);
+
+    // Row removal shifts the leaf boundaries
+    table.remove(0);
+    table.insert_empty_row(0, REALM_MAX_BPNODE_SIZE);
+    const ZoneMap<int64_t>* zone_map = table.get_zone_map<int64_t>(0);
+    CHECK(zone_map);
+    if (zone_map)
+        CHECK_EQUAL(zone_map->leaves().back().end, table.size());
+    CHECK_EQUAL(table.where().equal(0, -5).find(), 2999 + REALM_MAX_BPNODE_SIZE);
+    CHECK_EQUAL(table.where().equal(0, 0).count(), REALM_MAX_BPNODE_SIZE);
+}
+
+
+TEST(ZoneMap_BuiltOnlyForFullScans)
+{
+    Table table;
+    table.add_column(type_Int, "int");
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i)
+        table.set_int(0, i, int64_t(i));
+
+    // A search which may stop early, and min/max, do not pay for a pass over
+    // the column
+    CHECK_EQUAL(table.where().equal(0, 5).find(), 5);
+    CHECK_EQUAL(table.where().equal(0, 5).count(0, size_t(-1), 1), 1);
+    CHECK_EQUAL(table.maximum_int(0), int64_t(num_rows - 1));
+    CHECK(!table.find_zone_map<int64_t>(0));
+
+    // A scan over every row builds the zone map, which is then used by the
+    // others until the table is modified
+    CHECK_EQUAL(table.where().equal(0, 5).count(), 1);
+    CHECK(table.find_zone_map<int64_t>(0));
+    CHECK_EQUAL(table.where().greater(0, int64_t(num_rows - 2)).find(), num_rows - 1);
+    CHECK_EQUAL(table.minimum_int(0), 0);
+    table.set_int(0, 5, 6);
+    CHECK(!table.find_zone_map<int64_t>(0));
+    CHECK_EQUAL(table.where().equal(0, 6).find_all().size(), 2);
+    CHECK(table.find_zone_map<int64_t>(0));
+}
+
+#endif // TEST_ZONE_MAP
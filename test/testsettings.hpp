@@ -46,15 +46,19 @@
 #define TEST_COLUMN
 #define TEST_COLUMN_BASIC
 #define TEST_COLUMN_BINARY
+#define TEST_COLUMN_CHUNK
 #define TEST_COLUMN_TIMESTAMP
 #define TEST_COLUMN_FLOAT
 #define TEST_COLUMN_MIXED
+#define TEST_COLUMN_STATISTICS
 #define TEST_COLUMN_STRING
 #define TEST_FILE
 #define TEST_FILE_LOCKS
 #define TEST_GROUP
+#define TEST_GROUP_BY
 #define TEST_UPGRADE
 #define TEST_INDEX_STRING
+#define TEST_JOIN
 #define TEST_LANG_BIND_HELPER
 #define TEST_METRICS
 #define TEST_PARSER
@@ -75,6 +79,7 @@
 #define TEST_LINKS
 #define TEST_ENCRYPTED_FILE_MAPPING
 #define TEST_DESTRUCTOR_THREAD_SAFETY
+#define TEST_ZONE_MAP
 
 #define TEST_UTIL_ANY
 #define TEST_UTIL_BASE64
@@ -95,8 +100,4 @@
 // test could perhaps be modified to trigger it (unless it's a language binding problem).
 //#define JAVA_MANY_COLUMNS_CRASH
 
-// Temporarily disable async testing until use of sleep() in the async tests have
-// been replaced with a better solution.
-#define DISABLE_ASYNC
-
 #endif